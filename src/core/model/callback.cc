@@ -19,18 +19,31 @@
  */
 
 #include "callback.h"
+#include "small-object-pool.h"
 #include "log.h"
 
 /**
  * \file
  * \ingroup callback
- * ns3::CallbackValue implementation.
+ * ns3::CallbackImplBase and ns3::CallbackValue implementation.
  */
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Callback");
 
+void *
+CallbackImplBase::operator new (std::size_t size)
+{
+  return SmallObjectPool::Allocate (size);
+}
+
+void
+CallbackImplBase::operator delete (void *p, std::size_t size)
+{
+  SmallObjectPool::Release (p, size);
+}
+
 CallbackValue::CallbackValue ()
   : m_value ()
 {
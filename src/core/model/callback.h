@@ -29,6 +29,7 @@
 #include "attribute-helper.h"
 #include "simple-ref-count.h"
 #include <typeinfo>
+#include <cstddef>
 
 /**
  * \file
@@ -151,6 +152,26 @@ public:
   /** Get the type as a string. */
   virtual std::string GetTypeid (void) const = 0;
 
+  /**
+   * Allocate a callback implementation from the SmallObjectPool.
+   *
+   * A callback implementation is created by every MakeCallback,
+   * MakeBoundCallback and Callback::Bind, often once per packet; almost
+   * all of them are small, so that they are recycled rather than
+   * allocated from the heap.
+   *
+   * \param [in] size The size of the callback implementation.
+   * \returns The memory for the callback implementation.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release a callback implementation to the SmallObjectPool.
+   *
+   * \param [in] p The memory of the callback implementation.
+   * \param [in] size The size of the callback implementation.
+   */
+  static void operator delete (void *p, std::size_t size);
+
 protected:
   /**
    * \param [in] mangled The mangled string
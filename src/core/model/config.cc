@@ -26,6 +26,7 @@
 #include "pointer.h"
 #include "log.h"
 
+#include <map>
 #include <sstream>
 
 /**
@@ -99,6 +100,8 @@ MatchContainer::Set (std::string name, const AttributeValue &value)
       Ptr<Object> object = *tmp;
       object->SetAttribute (name, value);
     }
+  // the attribute may hold an object which is part of other paths
+  InvalidateCache ();
 }
 void 
 MatchContainer::Connect (std::string name, const CallbackBase &cb)
@@ -149,7 +152,12 @@ MatchContainer::DisconnectWithoutContext (std::string name, const CallbackBase &
 } // namespace Config
 
 
-/** Helper to test if an array entry matches a config path specification. */
+/**
+ * Helper to test if an array entry matches a config path specification.
+ *
+ * The specification is parsed once, at construction, into a list of
+ * index ranges.
+ */
 class ArrayMatcher
 {
 public:
@@ -166,7 +174,19 @@ public:
    * \returns \c true if the index matches the Config Path.
    */
   bool Matches (uint32_t i) const;
+  /**
+   * \returns \c true if every alternative of the specification is an
+   *          index, a range of indexes or a wildcard.
+   */
+  bool IsIndexSpecification (void) const;
 private:
+  /**
+   * Parse one alternative of the specification.
+   *
+   * \param [in] element The alternative.
+   * \returns \c true if it could be parsed.
+   */
+  bool Parse (std::string element);
   /**
    * Convert a string to an \c uint32_t.
    *
@@ -177,77 +197,93 @@ private:
   bool StringToUint32 (std::string str, uint32_t *value) const;
   /** The Config path element. */
   std::string m_element;
+  /** Whether every index matches. */
+  bool m_any;
+  /** Whether every alternative could be parsed. */
+  bool m_valid;
+  /** The matching index ranges, bounds included. */
+  std::vector<std::pair<uint32_t, uint32_t> > m_ranges;
 };
 
 
 ArrayMatcher::ArrayMatcher (std::string element)
-  : m_element (element)
+  : m_element (element),
+    m_any (false),
+    m_valid (true)
 {
   NS_LOG_FUNCTION (this << element);
+  std::string::size_type start = 0;
+  std::string::size_type bar;
+  do
+    {
+      bar = element.find ("|", start);
+      std::string alternative = element.substr (start, bar == std::string::npos ? std::string::npos : bar - start);
+      m_valid = Parse (alternative) && m_valid;
+      start = bar + 1;
+    }
+  while (bar != std::string::npos);
 }
 bool
-ArrayMatcher::Matches (uint32_t i) const
+ArrayMatcher::Parse (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
+      m_any = true;
       return true;
     }
-  std::string::size_type tmp;
-  tmp = m_element.find ("|");
-  if (tmp != std::string::npos)
-    {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
-    }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
       uint32_t min;
       uint32_t max;
-      if (StringToUint32 (lowerBound, &min) && 
-          StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
+      if (StringToUint32 (lowerBound, &min) &&
+          StringToUint32 (upperBound, &max))
         {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          m_ranges.push_back (std::make_pair (min, max));
           return true;
         }
-      else
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
-        }
+      return false;
     }
   uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+  if (StringToUint32 (element, &value))
+    {
+      m_ranges.push_back (std::make_pair (value, value));
+      return true;
+    }
+  return false;
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  if (m_any)
     {
       NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
       return true;
     }
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator r = m_ranges.begin ();
+       r != m_ranges.end (); ++r)
+    {
+      if (i >= r->first && i <= r->second)
+        {
+          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          return true;
+        }
+    }
   NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
 }
+bool
+ArrayMatcher::IsIndexSpecification (void) const
+{
+  return m_valid;
+}
 
 bool
 ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
@@ -261,6 +297,8 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
 
 /**
  * Abstract class to parse Config paths into object references.
+ *
+ * The path is split into its elements once, at construction.
  */
 class Resolver
 {
@@ -282,25 +320,31 @@ public:
    *                  in the Config path.
    */
   void Resolve (Ptr<Object> root);
+
+  /**
+   * Split a Config path into its elements.
+   *
+   * \param [in] path The Config path.
+   * \returns The elements, without the slashes.
+   */
+  static std::vector<std::string> Tokenize (std::string path);
   
 private:
-  /** Ensure the Config path starts and ends with a '/'. */
-  void Canonicalize (void);
   /**
    * Parse the next element in the Config path.
    *
-   * \param [in] path The remaining portion of the Config path.
+   * \param [in] pos The index of the element to parse.
    * \param [in] root The object corresponding to the current positon
    *                  in the Config path.
    */
-  void DoResolve (std::string path, Ptr<Object> root);
+  void DoResolve (uint32_t pos, Ptr<Object> root);
   /**
    * Parse an index on the Config path.
    *
-   * \param [in] path The remaining Config path.
+   * \param [in] pos The index of the element to parse.
    * \param [in,out] vector The resulting list of matching objects.
    */
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void DoArrayResolve (uint32_t pos, const ObjectPtrContainerValue &vector);
   /**
    * Handle one object found on the path.
    *
@@ -323,38 +367,47 @@ private:
 
   /** Current list of path tokens. */
   std::vector<std::string> m_workStack;
-  /** The Config path. */
-  std::string m_path;
+  /** The elements of the Config path. */
+  std::vector<std::string> m_tokens;
 };
 
 Resolver::Resolver (std::string path)
-  : m_path (path)
+  : m_tokens (Tokenize (path))
 {
   NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
 }
 Resolver::~Resolver ()
 {
   NS_LOG_FUNCTION (this);
 }
-void
-Resolver::Canonicalize (void)
+std::vector<std::string>
+Resolver::Tokenize (std::string path)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (path);
 
   // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
+  std::string::size_type tmp = path.find ("/");
   if (tmp != 0)
     {
       // no slash at start
-      m_path = "/" + m_path;
+      path = "/" + path;
     }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
+  tmp = path.find_last_of ("/");
+  if (tmp != (path.size () - 1))
     {
       // no slash at end
-      m_path = m_path + "/";
+      path = path + "/";
     }
+
+  std::vector<std::string> tokens;
+  std::string::size_type start = 1;
+  std::string::size_type next;
+  while ((next = path.find ("/", start)) != std::string::npos)
+    {
+      tokens.push_back (path.substr (start, next - start));
+      start = next + 1;
+    }
+  return tokens;
 }
 
 void 
@@ -362,7 +415,7 @@ Resolver::Resolve (Ptr<Object> root)
 {
   NS_LOG_FUNCTION (this << root);
 
-  DoResolve (m_path, root);
+  DoResolve (0, root);
 }
 
 std::string
@@ -388,13 +441,11 @@ Resolver::DoResolveOne (Ptr<Object> object)
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
+Resolver::DoResolve (uint32_t pos, Ptr<Object> root)
 {
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
+  NS_LOG_FUNCTION (this << pos << root);
 
-  if (next == std::string::npos)
+  if (pos == m_tokens.size ())
     {
       //
       // If root is zero, we're beginning to see if we can use the object name 
@@ -410,8 +461,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
         }
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  const std::string &item = m_tokens[pos];
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -422,11 +472,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   //
   if (root == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
+      if (item.compare (0, 5, "Names") == 0)
         {
           m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
+          DoResolve (pos + 1, root);
           m_workStack.pop_back ();
           return;
         }
@@ -443,7 +492,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
       m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      DoResolve (pos + 1, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -473,7 +522,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
           return;
         }
       m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      DoResolve (pos + 1, object);
       m_workStack.pop_back ();
     }
   else 
@@ -512,7 +561,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
                     }
                   foundMatch = true;
                   m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
+                  DoResolve (pos + 1, object);
                   m_workStack.pop_back ();
                 }
               // attempt to cast to an object vector.
@@ -520,12 +569,12 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
                 dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
               if (vectorChecker != 0)
                 {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
+                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath ());
                   foundMatch = true;
                   ObjectPtrContainerValue vector;
                   root->GetAttribute (info.name, vector);
                   m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
+                  DoArrayResolve (pos + 1, vector);
                   m_workStack.pop_back ();
                 }
               // this could be anything else and we don't know what to do with it.
@@ -544,20 +593,15 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (uint32_t pos, const ObjectPtrContainerValue &container)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION(this << pos << &container);
+  if (pos == m_tokens.size ())
     {
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
 
-  ArrayMatcher matcher = ArrayMatcher (item);
+  ArrayMatcher matcher = ArrayMatcher (m_tokens[pos]);
   ObjectPtrContainerValue::Iterator it;
   for (it = container.Begin (); it != container.End (); ++it)
     {
@@ -566,7 +610,7 @@ Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &conta
           std::ostringstream oss;
           oss << (*it).first;
           m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
+          DoResolve (pos + 1, (*it).second);
           m_workStack.pop_back ();
         }
     }
@@ -599,7 +643,13 @@ public:
   /** \copydoc Config::GetRootNamespaceObject() */
   Ptr<Object> GetRootNamespaceObject (uint32_t i) const;
 
-private:
+  /** \copydoc Config::InvalidateCache() */
+  void InvalidateCache (void);
+  /** \copydoc Config::GetCacheGeneration() */
+  uint32_t GetCacheGeneration (void) const;
+
+  ConfigImpl ();
+
   /**
    * Break a Config path into the leading path and the last leaf token.
    * \param [in] path The Config path.
@@ -609,13 +659,38 @@ private:
    */
   void ParsePath (std::string path, std::string *root, std::string *leaf) const;
 
+private:
   /** Container type to hold the root Config path tokens. */
   typedef std::vector<Ptr<Object> > Roots;
 
   /** The list of Config path roots. */
   Roots m_roots;
+  /** The generation of the Config::Path caches; never zero. */
+  uint32_t m_generation;
 };
 
+ConfigImpl::ConfigImpl ()
+  : m_generation (1)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ConfigImpl::InvalidateCache (void)
+{
+  m_generation++;
+  if (m_generation == 0)
+    {
+      m_generation = 1;
+    }
+}
+
+uint32_t
+ConfigImpl::GetCacheGeneration (void) const
+{
+  return m_generation;
+}
+
 void 
 ConfigImpl::ParsePath (std::string path, std::string *root, std::string *leaf) const
 {
@@ -714,6 +789,7 @@ ConfigImpl::RegisterRootNamespaceObject (Ptr<Object> obj)
 {
   NS_LOG_FUNCTION (this << obj);
   m_roots.push_back (obj);
+  InvalidateCache ();
 }
 
 void 
@@ -726,6 +802,7 @@ ConfigImpl::UnregisterRootNamespaceObject (Ptr<Object> obj)
       if (*i == obj)
         {
           m_roots.erase (i);
+          InvalidateCache ();
           return;
         }
     }
@@ -873,6 +950,310 @@ Ptr<Object> GetRootNamespaceObject (uint32_t i)
   return ConfigImpl::Get ()->GetRootNamespaceObject (i);
 }
 
+void InvalidateCache (void)
+{
+  ConfigImpl::Get ()->InvalidateCache ();
+}
+
+uint32_t GetCacheGeneration (void)
+{
+  return ConfigImpl::Get ()->GetCacheGeneration ();
+}
+
+Path::Path (std::string path)
+  : m_path (path),
+    m_generation (0)
+{
+  NS_LOG_FUNCTION (this << path);
+  ConfigImpl::Get ()->ParsePath (path, &m_objects, &m_leaf);
+}
+std::string
+Path::GetPath (void) const
+{
+  return m_path;
+}
+const MatchContainer &
+Path::GetMatches (void) const
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t generation = ConfigImpl::Get ()->GetCacheGeneration ();
+  if (m_generation != generation)
+    {
+      NS_LOG_LOGIC ("resolving " << m_path);
+      m_matches = ConfigImpl::Get ()->LookupMatches (m_objects);
+      m_generation = generation;
+    }
+  return m_matches;
+}
+void
+Path::Set (const AttributeValue &value) const
+{
+  NS_LOG_FUNCTION (this << &value);
+  GetMatches ();
+  m_matches.Set (m_leaf, value);
+}
+void
+Path::Connect (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  GetMatches ();
+  m_matches.Connect (m_leaf, cb);
+}
+void
+Path::ConnectWithoutContext (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  GetMatches ();
+  m_matches.ConnectWithoutContext (m_leaf, cb);
+}
+void
+Path::Disconnect (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  GetMatches ();
+  m_matches.Disconnect (m_leaf, cb);
+}
+void
+Path::DisconnectWithoutContext (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  GetMatches ();
+  m_matches.DisconnectWithoutContext (m_leaf, cb);
+}
+
+namespace {
+
+/**
+ * \param [in] token A Config path element.
+ * \returns \c true if \p token selects exactly one element of an
+ *          object container.
+ */
+bool
+IsSingleIndex (const std::string &token)
+{
+  return token.find_first_of ("*|[") == std::string::npos
+         && ArrayMatcher (token).IsIndexSpecification ();
+}
+
+/**
+ * \param [in] token A Config path element.
+ * \returns The element as it appears in a matched path.
+ */
+std::string
+CanonicalToken (const std::string &token)
+{
+  if (!IsSingleIndex (token))
+    {
+      return token;
+    }
+  uint32_t index;
+  std::istringstream iss (token);
+  iss >> index;
+  std::ostringstream oss;
+  oss << index;
+  return oss.str ();
+}
+
+/**
+ * Check whether a matched path is selected by a path pattern with the
+ * same shape.
+ *
+ * \param [in] pattern The elements of the pattern.
+ * \param [in] matchers The ArrayMatcher of each pattern element.
+ * \param [in] path The elements of the matched path.
+ * \returns \c true if every element of \p path is selected.
+ */
+bool
+PathMatches (const std::vector<std::string> &pattern,
+             const std::vector<ArrayMatcher> &matchers,
+             const std::vector<std::string> &path)
+{
+  if (pattern.size () != path.size ())
+    {
+      return false;
+    }
+  for (uint32_t k = 0; k < pattern.size (); k++)
+    {
+      if (pattern[k] == path[k] || pattern[k] == "*")
+        {
+          continue;
+        }
+      if (!matchers[k].IsIndexSpecification ()
+          || path[k].find_first_not_of ("0123456789") != std::string::npos)
+        {
+          return false;
+        }
+      uint32_t index;
+      std::istringstream iss (path[k]);
+      iss >> index;
+      if (!matchers[k].Matches (index))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // unnamed namespace
+
+ConnectBatch::ConnectBatch ()
+{
+  NS_LOG_FUNCTION (this);
+}
+void
+ConnectBatch::Connect (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << path << &cb);
+  Entry entry;
+  entry.path = path;
+  entry.cb = cb;
+  entry.withContext = true;
+  m_entries.push_back (entry);
+}
+void
+ConnectBatch::ConnectWithoutContext (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << path << &cb);
+  Entry entry;
+  entry.path = path;
+  entry.cb = cb;
+  entry.withContext = false;
+  m_entries.push_back (entry);
+}
+uint32_t
+ConnectBatch::GetN (void) const
+{
+  return m_entries.size ();
+}
+void
+ConnectBatch::Commit (void)
+{
+  NS_LOG_FUNCTION (this);
+  ConfigImpl *impl = ConfigImpl::Get ();
+
+  // Group the connections by shape.
+  std::map<std::string, std::vector<uint32_t> > shapes;
+  for (uint32_t i = 0; i < m_entries.size (); i++)
+    {
+      std::string objects, leaf;
+      impl->ParsePath (m_entries[i].path, &objects, &leaf);
+      std::vector<std::string> tokens = Resolver::Tokenize (objects);
+      std::string shape = "/";
+      bool named = false;
+      for (std::vector<std::string>::const_iterator t = tokens.begin (); t != tokens.end (); ++t)
+        {
+          named = named || t->compare (0, 5, "Names") == 0;
+          shape += (ArrayMatcher (*t).IsIndexSpecification () ? std::string ("*") : *t) + "/";
+        }
+      if (named)
+        {
+          // the shape of a named path cannot be resolved in one go
+          if (m_entries[i].withContext)
+            {
+              impl->Connect (m_entries[i].path, m_entries[i].cb);
+            }
+          else
+            {
+              impl->ConnectWithoutContext (m_entries[i].path, m_entries[i].cb);
+            }
+          continue;
+        }
+      shapes[shape].push_back (i);
+    }
+
+  for (std::map<std::string, std::vector<uint32_t> >::const_iterator s = shapes.begin ();
+       s != shapes.end (); ++s)
+    {
+      const std::vector<uint32_t> &entries = s->second;
+      if (entries.size () == 1)
+        {
+          const Entry &entry = m_entries[entries[0]];
+          if (entry.withContext)
+            {
+              impl->Connect (entry.path, entry.cb);
+            }
+          else
+            {
+              impl->ConnectWithoutContext (entry.path, entry.cb);
+            }
+          continue;
+        }
+
+      NS_LOG_LOGIC ("resolving " << s->first << " for " << entries.size () << " connections");
+      MatchContainer matches = impl->LookupMatches (s->first);
+      std::multimap<std::string, uint32_t> byPath;
+      for (uint32_t j = 0; j < matches.GetN (); j++)
+        {
+          byPath.insert (std::make_pair (matches.GetMatchedPath (j), j));
+        }
+      std::vector<std::vector<std::string> > matchedTokens;
+
+      for (std::vector<uint32_t>::const_iterator e = entries.begin (); e != entries.end (); ++e)
+        {
+          const Entry &entry = m_entries[*e];
+          std::string objects, leaf;
+          impl->ParsePath (entry.path, &objects, &leaf);
+          std::vector<std::string> tokens = Resolver::Tokenize (objects);
+
+          std::vector<uint32_t> selected;
+          bool exact = true;
+          std::string concrete = "/";
+          for (std::vector<std::string>::const_iterator t = tokens.begin (); t != tokens.end (); ++t)
+            {
+              exact = exact && t->find_first_of ("*|[") == std::string::npos;
+              concrete += CanonicalToken (*t) + "/";
+            }
+          if (exact)
+            {
+              std::pair<std::multimap<std::string, uint32_t>::const_iterator,
+                        std::multimap<std::string, uint32_t>::const_iterator> range =
+                byPath.equal_range (concrete);
+              for (std::multimap<std::string, uint32_t>::const_iterator k = range.first;
+                   k != range.second; ++k)
+                {
+                  selected.push_back (k->second);
+                }
+            }
+          else
+            {
+              if (matchedTokens.empty ())
+                {
+                  for (uint32_t j = 0; j < matches.GetN (); j++)
+                    {
+                      matchedTokens.push_back (Resolver::Tokenize (matches.GetMatchedPath (j)));
+                    }
+                }
+              std::vector<ArrayMatcher> matchers;
+              for (std::vector<std::string>::const_iterator t = tokens.begin (); t != tokens.end (); ++t)
+                {
+                  matchers.push_back (ArrayMatcher (*t));
+                }
+              for (uint32_t j = 0; j < matches.GetN (); j++)
+                {
+                  if (PathMatches (tokens, matchers, matchedTokens[j]))
+                    {
+                      selected.push_back (j);
+                    }
+                }
+            }
+
+          for (std::vector<uint32_t>::const_iterator j = selected.begin (); j != selected.end (); ++j)
+            {
+              Ptr<Object> object = matches.Get (*j);
+              if (entry.withContext)
+                {
+                  object->TraceConnect (leaf, matches.GetMatchedPath (*j) + leaf, entry.cb);
+                }
+              else
+                {
+                  object->TraceConnectWithoutContext (leaf, entry.cb);
+                }
+            }
+        }
+    }
+  m_entries.clear ();
+}
+
 } // namespace Config
 
 } // namespace ns3
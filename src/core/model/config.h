@@ -21,6 +21,7 @@
 #define CONFIG_H
 
 #include "ptr.h"
+#include "callback.h"
 #include <string>
 #include <vector>
 
@@ -258,6 +259,129 @@ private:
  */
 MatchContainer LookupMatches (std::string path);
 
+/**
+ * \ingroup config
+ * \brief A Config path parsed once, which remembers the objects it matches.
+ *
+ * The objects are looked up on first use and reused until the cache
+ * is invalidated, which happens whenever objects are aggregated,
+ * nodes, devices, applications or channels are added, names are
+ * registered, root namespace objects change, or attributes are set
+ * through the Config system.  Other changes to the object graph must
+ * be signalled with Config::InvalidateCache.
+ *
+ * The matched objects are kept alive by the Path.
+ */
+class Path
+{
+public:
+  /**
+   * \param [in] path A Config path, ending with the name of an
+   *             attribute or trace source.
+   */
+  Path (std::string path);
+  /** \returns The Config path. */
+  std::string GetPath (void) const;
+  /**
+   * \returns The objects which match the path, without its last
+   *          element.
+   */
+  const MatchContainer &GetMatches (void) const;
+
+  /**
+   * \param [in] value The value to set.
+   * \sa ns3::Config::Set
+   */
+  void Set (const AttributeValue &value) const;
+  /**
+   * \param [in] cb The sink to connect.
+   * \sa ns3::Config::Connect
+   */
+  void Connect (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The sink to connect.
+   * \sa ns3::Config::ConnectWithoutContext
+   */
+  void ConnectWithoutContext (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The sink to disconnect.
+   * \sa ns3::Config::Disconnect
+   */
+  void Disconnect (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The sink to disconnect.
+   * \sa ns3::Config::DisconnectWithoutContext
+   */
+  void DisconnectWithoutContext (const CallbackBase &cb) const;
+
+private:
+  /** The Config path. */
+  std::string m_path;
+  /** The path without its last element. */
+  std::string m_objects;
+  /** The last element of the path. */
+  std::string m_leaf;
+  /** The cached matches. */
+  mutable MatchContainer m_matches;
+  /** The cache generation of m_matches, or 0 if never resolved. */
+  mutable uint32_t m_generation;
+};
+
+/**
+ * \ingroup config
+ * \brief Connect many trace sinks with a single lookup per path shape.
+ *
+ * Connecting one sink per node with Config::Connect walks the whole
+ * node list for every call.  A ConnectBatch collects the connections
+ * and, on Commit, resolves each distinct path shape, that is the path
+ * with its indexes replaced by wildcards, only once; every connection
+ * then picks its own objects from the result.  Paths going through the
+ * "/Names" namespace are resolved one by one.
+ */
+class ConnectBatch
+{
+public:
+  ConnectBatch ();
+  /**
+   * \param [in] path The trace source path.
+   * \param [in] cb The sink, connected with its context.
+   * \sa ns3::Config::Connect
+   */
+  void Connect (std::string path, const CallbackBase &cb);
+  /**
+   * \param [in] path The trace source path.
+   * \param [in] cb The sink, connected without context.
+   * \sa ns3::Config::ConnectWithoutContext
+   */
+  void ConnectWithoutContext (std::string path, const CallbackBase &cb);
+  /** \returns The number of connections not committed yet. */
+  uint32_t GetN (void) const;
+  /** Perform all the pending connections. */
+  void Commit (void);
+
+private:
+  /** A pending connection. */
+  struct Entry
+  {
+    std::string path;     //!< Trace source path
+    CallbackBase cb;      //!< Sink
+    bool withContext;     //!< Whether to connect with context
+  };
+  /** The pending connections. */
+  std::vector<Entry> m_entries;
+};
+
+/**
+ * \ingroup config
+ * Invalidate the objects cached by every Config::Path.
+ */
+void InvalidateCache (void);
+/**
+ * \ingroup config
+ * \returns The current cache generation, incremented by InvalidateCache.
+ */
+uint32_t GetCacheGeneration (void);
+
 /**
  * \ingroup config
  * \param [in] obj A new root object
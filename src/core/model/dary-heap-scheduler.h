@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a 4-ary implicit heap event scheduler
+ *
+ * The events are stored by value in a single contiguous array, so that
+ * Insert and RemoveNext do not allocate memory once the array has grown
+ * to the event population, unlike MapScheduler which allocates a tree
+ * node per event.
+ *
+ * Each node has four children instead of two: the heap is half as deep
+ * as a binary heap, and the four children of a node are adjacent in
+ * memory, so a RemoveNext touches fewer cache lines than with
+ * HeapScheduler.  Entries are moved into a hole rather than swapped
+ * while percolating.
+ *
+ * Remove is a linear search, as in HeapScheduler; the simulator only
+ * uses it for events removed with Simulator::Remove.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  DaryHeapScheduler ();
+  /** Destructor. */
+  virtual ~DaryHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Event list type:  vector of Events, managed as a heap. */
+  typedef std::vector<Scheduler::Event> DaryHeap;
+
+  /**
+   * Move an event up from a hole until its parent is smaller.
+   *
+   * \param [in] index The index of the hole.
+   * \param [in] ev The event to place.
+   */
+  void BottomUp (uint32_t index, const Scheduler::Event &ev);
+  /**
+   * Move an event down from a hole until its children are larger.
+   *
+   * \param [in] index The index of the hole.
+   * \param [in] ev The event to place.
+   */
+  void TopDown (uint32_t index, const Scheduler::Event &ev);
+
+  /** The event list, with the root at index 0. */
+  DaryHeap m_heap;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
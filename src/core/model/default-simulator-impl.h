@@ -30,6 +30,7 @@
 #include "ptr.h"
 
 #include <list>
+#include <string>
 
 /**
  * \file
@@ -39,10 +40,23 @@
 
 namespace ns3 {
 
+class SimulatorProfiler;
+
 /**
  * \ingroup simulator
  *
  * The default single process simulator implementation.
+ *
+ * Setting the \c ProfileFile attribute, for instance with
+ *
+ * \code
+ *   Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileFile",
+ *                       StringValue ("events.txt"));
+ * \endcode
+ *
+ * before the first use of the Simulator, profiles the events with a
+ * SimulatorProfiler.  The report and the flamegraph input are written
+ * at Simulator::Destroy ().
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -132,6 +146,11 @@ private:
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
+
+  /** The profile report file name; empty if not profiling. */
+  std::string m_profileFile;
+  /** The event profiler, or 0 if not profiling. */
+  SimulatorProfiler *m_profiler;
 };
 
 } // namespace ns3
@@ -19,6 +19,7 @@
  */
 
 #include "event-impl.h"
+#include "small-object-pool.h"
 #include "log.h"
 
 /**
@@ -66,4 +67,16 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+void *
+EventImpl::operator new (std::size_t size)
+{
+  return SmallObjectPool::Allocate (size);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  SmallObjectPool::Release (p, size);
+}
+
 } // namespace ns3
@@ -0,0 +1,354 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "memory-accounting.h"
+#include "simulator.h"
+#include "fatal-error.h"
+#include "log.h"
+
+#include <algorithm>
+#include <fstream>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::MemoryAccounting implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MemoryAccounting");
+
+namespace {
+
+/** The live objects and bytes of a TypeId. */
+struct TypeCount
+{
+  int64_t objects;  /**< Number of live objects. */
+  int64_t bytes;    /**< Number of live bytes. */
+};
+
+/**
+ * The counts of each TypeId, indexed by TypeId uid.
+ *
+ * Allocated by MemoryAccounting::Enable, for all possible uids so that
+ * it never moves while other threads update it.
+ */
+TypeCount *g_types = 0;
+
+/** The list of all the counters. */
+MemoryAccounting::Counter *g_counters = 0;
+
+/** The number of counters. */
+uint32_t g_nCounters = 0;
+
+#ifdef HAVE_PTHREAD_H
+/** Protects the list of the per-thread counts. */
+pthread_mutex_t g_threadCountsMutex = PTHREAD_MUTEX_INITIALIZER;
+/** Releases the per-thread counts when their thread exits. */
+pthread_key_t g_threadCountsKey;
+/** Whether g_threadCountsKey was created. */
+bool g_threadCountsKeyCreated = false;
+#endif /* HAVE_PTHREAD_H */
+
+/** The periodic report file, or 0. */
+std::ofstream *g_periodicFile = 0;
+
+/** The periodic report interval. */
+Time g_periodicInterval;
+
+/**
+ * Get the size of the objects of a type.
+ * \param [in] tid The type.
+ * \returns The size of the type, or of its closest parent with a known
+ *          size, or 0.
+ */
+int64_t
+GetTypeSize (TypeId tid)
+{
+  while (tid.GetSize () == (std::size_t)(-1))
+    {
+      if (!tid.HasParent () || tid.GetParent () == tid)
+        {
+          return 0;
+        }
+      tid = tid.GetParent ();
+    }
+  return tid.GetSize ();
+}
+
+} // unnamed namespace
+
+/** A report line: objects, bytes and name. */
+struct MemoryAccounting::Line
+{
+  int64_t objects;   /**< Number of live objects. */
+  int64_t bytes;     /**< Number of live bytes. */
+  std::string name;  /**< Type or counter name. */
+};
+
+bool MemoryAccounting::m_enabled = false;
+MemoryAccounting::ThreadCounts *MemoryAccounting::m_threadCounts = 0;
+__thread MemoryAccounting::ThreadCounts *MemoryAccounting::s_threadCounts __attribute__ ((tls_model ("initial-exec"))) = 0;
+
+MemoryAccounting::Counter::Counter (const char *name)
+  : m_name (name),
+    m_index (g_nCounters++),
+    m_next (g_counters)
+{
+  if (m_index >= MAX_COUNTERS)
+    {
+      NS_FATAL_ERROR ("MemoryAccounting::Counter: too many counters, " << name);
+    }
+  g_counters = this;
+}
+
+MemoryAccounting::ThreadCounts *
+MemoryAccounting::RegisterThread (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock (&g_threadCountsMutex);
+  if (!g_threadCountsKeyCreated)
+    {
+      pthread_key_create (&g_threadCountsKey, &MemoryAccounting::ReleaseThread);
+      g_threadCountsKeyCreated = true;
+    }
+#endif /* HAVE_PTHREAD_H */
+  ThreadCounts *counts = m_threadCounts;
+  while (counts != 0 && counts->inUse)
+    {
+      counts = counts->next;
+    }
+  if (counts == 0)
+    {
+      counts = new ThreadCounts ();
+      counts->next = m_threadCounts;
+      m_threadCounts = counts;
+    }
+  counts->inUse = true;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock (&g_threadCountsMutex);
+  pthread_setspecific (g_threadCountsKey, counts);
+#endif /* HAVE_PTHREAD_H */
+  s_threadCounts = counts;
+  return counts;
+}
+
+void
+MemoryAccounting::ReleaseThread (void *counts)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock (&g_threadCountsMutex);
+#endif /* HAVE_PTHREAD_H */
+  static_cast<ThreadCounts *> (counts)->inUse = false;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock (&g_threadCountsMutex);
+#endif /* HAVE_PTHREAD_H */
+  // a later update from this thread registers it again
+  s_threadCounts = 0;
+}
+
+void
+MemoryAccounting::Sum (const Counter *counter, int64_t *objects, int64_t *bytes)
+{
+  *objects = 0;
+  *bytes = 0;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock (&g_threadCountsMutex);
+#endif /* HAVE_PTHREAD_H */
+  for (ThreadCounts *counts = m_threadCounts; counts != 0; counts = counts->next)
+    {
+      *objects += __atomic_load_n (&counts->objects[counter->m_index], __ATOMIC_RELAXED);
+      *bytes += __atomic_load_n (&counts->bytes[counter->m_index], __ATOMIC_RELAXED);
+    }
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock (&g_threadCountsMutex);
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+MemoryAccounting::Enable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (g_types == 0)
+    {
+      g_types = new TypeCount [0x10000] ();
+    }
+  m_enabled = true;
+}
+
+void
+MemoryAccounting::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_enabled = false;
+}
+
+void
+MemoryAccounting::ObjectCreated (TypeId tid)
+{
+  TypeCount *count = &g_types[tid.GetUid ()];
+  __sync_fetch_and_add (&count->objects, 1);
+  __sync_fetch_and_add (&count->bytes, GetTypeSize (tid));
+}
+
+void
+MemoryAccounting::ObjectDestroyed (TypeId tid)
+{
+  TypeCount *count = &g_types[tid.GetUid ()];
+  __sync_fetch_and_sub (&count->objects, 1);
+  __sync_fetch_and_sub (&count->bytes, GetTypeSize (tid));
+}
+
+int64_t
+MemoryAccounting::GetObjects (std::string name)
+{
+  NS_LOG_FUNCTION (name);
+  for (Counter *counter = g_counters; counter != 0; counter = counter->m_next)
+    {
+      if (name == counter->m_name)
+        {
+          int64_t objects, bytes;
+          Sum (counter, &objects, &bytes);
+          return objects;
+        }
+    }
+  TypeId tid;
+  if (g_types == 0 || !TypeId::LookupByNameFailSafe (name, &tid))
+    {
+      return 0;
+    }
+  return g_types[tid.GetUid ()].objects;
+}
+
+int64_t
+MemoryAccounting::GetBytes (std::string name)
+{
+  NS_LOG_FUNCTION (name);
+  for (Counter *counter = g_counters; counter != 0; counter = counter->m_next)
+    {
+      if (name == counter->m_name)
+        {
+          int64_t objects, bytes;
+          Sum (counter, &objects, &bytes);
+          return bytes;
+        }
+    }
+  TypeId tid;
+  if (g_types == 0 || !TypeId::LookupByNameFailSafe (name, &tid))
+    {
+      return 0;
+    }
+  return g_types[tid.GetUid ()].bytes;
+}
+
+bool
+MemoryAccounting::CompareBytes (const Line &a, const Line &b)
+{
+  return a.bytes > b.bytes;
+}
+
+std::vector<MemoryAccounting::Line>
+MemoryAccounting::GetLines (void)
+{
+  std::vector<Line> lines;
+  if (g_types != 0)
+    {
+      for (uint32_t i = 0; i < TypeId::GetRegisteredN (); i++)
+        {
+          TypeId tid = TypeId::GetRegistered (i);
+          const TypeCount &count = g_types[tid.GetUid ()];
+          if (count.objects != 0)
+            {
+              Line line = { count.objects, count.bytes, tid.GetName () };
+              lines.push_back (line);
+            }
+        }
+    }
+  for (Counter *counter = g_counters; counter != 0; counter = counter->m_next)
+    {
+      Line line = { 0, 0, counter->m_name };
+      Sum (counter, &line.objects, &line.bytes);
+      if (line.objects != 0)
+        {
+          lines.push_back (line);
+        }
+    }
+  std::stable_sort (lines.begin (), lines.end (), CompareBytes);
+  return lines;
+}
+
+void
+MemoryAccounting::Report (std::ostream &os)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::vector<Line> lines = GetLines ();
+  int64_t objects = 0;
+  int64_t bytes = 0;
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      objects += i->objects;
+      bytes += i->bytes;
+    }
+  os << "# live objects: " << objects << ", live bytes: " << bytes << std::endl;
+  os << "# objects bytes name" << std::endl;
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      os << i->objects << " " << i->bytes << " " << i->name << std::endl;
+    }
+}
+
+void
+MemoryAccounting::EnablePeriodicReport (std::string filename, Time interval)
+{
+  NS_LOG_FUNCTION (filename << interval);
+  NS_ASSERT_MSG (interval.IsStrictlyPositive (), "MemoryAccounting::EnablePeriodicReport(): interval must be positive");
+  delete g_periodicFile;
+  g_periodicFile = new std::ofstream (filename.c_str ());
+  if (!g_periodicFile->good ())
+    {
+      NS_FATAL_ERROR ("MemoryAccounting::EnablePeriodicReport(): cannot open " << filename);
+    }
+  *g_periodicFile << "# time-s objects bytes name" << std::endl;
+  g_periodicInterval = interval;
+  Simulator::ScheduleNow (&MemoryAccounting::PeriodicReport);
+}
+
+void
+MemoryAccounting::PeriodicReport (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::vector<Line> lines = GetLines ();
+  double now = Simulator::Now ().GetSeconds ();
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      *g_periodicFile << now << " " << i->objects << " " << i->bytes << " " << i->name << std::endl;
+    }
+  if (Simulator::IsFinished ())
+    {
+      // Nothing else to sample.
+      delete g_periodicFile;
+      g_periodicFile = 0;
+      return;
+    }
+  Simulator::Schedule (g_periodicInterval, &MemoryAccounting::PeriodicReport);
+}
+
+} // namespace ns3
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include "type-id.h"
+#include "nstime.h"
+
+#include <string>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::MemoryAccounting declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Count the live objects and bytes of a simulation by type.
+ *
+ * Once enabled, every Object created is counted under its TypeId,
+ * with the size its NS_OBJECT_ENSURE_REGISTERED() recorded (or the
+ * size of its closest registered parent).  Memory which is not held
+ * in Objects, such as packets, packet buffers or container entries,
+ * is counted by a Counter the code owning it updates.
+ *
+ * Object accounting is off by default, and the only cost left is then
+ * a test of a global flag.  Counters are always maintained, so that
+ * memory allocated while accounting is disabled and released while it
+ * is enabled, or the other way around, does not make them drift; each
+ * thread adds to its own copy of the counts, which the reports sum.
+ * An update is two stores to a thread-local array: on bench-packets,
+ * which updates the packet and buffer counters on every allocation,
+ * the difference with skipping them while accounting is disabled is
+ * within the noise of the measurement.
+ *
+ * Accounting should be enabled before the objects to count are
+ * created:
+ *
+ * \code
+ *   MemoryAccounting::Enable ();
+ *   MemoryAccounting::EnablePeriodicReport ("memory.txt", Seconds (1));
+ *   ...
+ *   Simulator::Run ();
+ *   MemoryAccounting::Report (std::cout);
+ * \endcode
+ */
+class MemoryAccounting
+{
+public:
+  /**
+   * \brief A count of objects and bytes maintained by the code which
+   * allocates them.
+   *
+   * Counters are meant to be static variables; they are listed in the
+   * reports under their name.  A program may have up to 64 counters.
+   */
+  class Counter
+  {
+  public:
+    /**
+     * Constructor.
+     * \param [in] name The name of the counter in the reports.
+     */
+    Counter (const char *name);
+    /**
+     * Account for allocated or released memory.
+     *
+     * The counts of the calling thread are updated without
+     * synchronization, whether accounting is enabled or not, so
+     * that they stay exact; the update costs two stores.
+     *
+     * \param [in] objects The number of objects allocated, or
+     *        released if negative.
+     * \param [in] bytes The number of bytes allocated, or released if
+     *        negative.
+     */
+    inline void Add (int64_t objects, int64_t bytes);
+
+  private:
+    friend class MemoryAccounting;
+
+    /** The name of the counter. */
+    const char *m_name;
+    /** The index of the counter in the per-thread counts. */
+    uint32_t m_index;
+    /** The next counter in the list of all counters. */
+    Counter *m_next;
+  };
+
+  /** Start counting the Objects. */
+  static void Enable (void);
+  /** Stop counting the Objects; the counts are kept. */
+  static void Disable (void);
+  /**
+   * Check if accounting is enabled.
+   * \returns \c true if accounting is enabled.
+   */
+  static inline bool IsEnabled (void);
+
+  /**
+   * Account for the creation of an Object.
+   * \param [in] tid The TypeId of the Object.
+   */
+  static void ObjectCreated (TypeId tid);
+  /**
+   * Account for the destruction of an Object counted by ObjectCreated.
+   * \param [in] tid The TypeId of the Object.
+   */
+  static void ObjectDestroyed (TypeId tid);
+
+  /**
+   * Get the number of live objects of a type or counter.
+   * \param [in] name The TypeId or Counter name.
+   * \returns The number of live objects.
+   */
+  static int64_t GetObjects (std::string name);
+  /**
+   * Get the number of live bytes of a type or counter.
+   * \param [in] name The TypeId or Counter name.
+   * \returns The number of live bytes.
+   */
+  static int64_t GetBytes (std::string name);
+
+  /**
+   * Print the live objects and bytes of every type and counter with
+   * live objects, by decreasing number of bytes.
+   *
+   * \param [in,out] os The output stream.
+   */
+  static void Report (std::ostream &os);
+
+  /**
+   * Append the live objects and bytes of every type and counter to
+   * \p filename every \p interval of simulation time.
+   *
+   * Each sample is a "time-s objects bytes name" line per type.  The
+   * sampling stops when the sampling event is the last one left, so
+   * that it does not keep the simulation running.
+   *
+   * \param [in] filename The output file name.
+   * \param [in] interval The sampling interval.
+   */
+  static void EnablePeriodicReport (std::string filename, Time interval);
+
+private:
+  /** A report line. */
+  struct Line;
+
+  /** The maximum number of counters. */
+  static const uint32_t MAX_COUNTERS = 64;
+
+  /** The counter updates made by one thread. */
+  struct ThreadCounts
+  {
+    int64_t objects[MAX_COUNTERS];  //!< Objects added, by counter index.
+    int64_t bytes[MAX_COUNTERS];    //!< Bytes added, by counter index.
+    bool inUse;                     //!< Whether a live thread updates the counts.
+    ThreadCounts *next;             //!< The next entry in the list of all counts.
+  };
+
+  /**
+   * Give the calling thread its counts, reusing those of a thread
+   * which exited if any.
+   * \returns The counts of the calling thread.
+   */
+  static ThreadCounts *RegisterThread (void);
+  /**
+   * Release the counts of an exiting thread; they keep counting in
+   * the sums.
+   * \param [in] counts The counts of the thread.
+   */
+  static void ReleaseThread (void *counts);
+  /**
+   * Sum the counts of a counter over all the threads.
+   * \param [in] counter The counter.
+   * \param [out] objects The number of live objects.
+   * \param [out] bytes The number of live bytes.
+   */
+  static void Sum (const Counter *counter, int64_t *objects, int64_t *bytes);
+
+  /**
+   * Collect the types and counters with live objects.
+   * \returns The report lines, by decreasing bytes.
+   */
+  static std::vector<Line> GetLines (void);
+  /**
+   * Sort report lines by decreasing bytes.
+   * \param [in] a The first line.
+   * \param [in] b The second line.
+   * \returns \c true if \p a goes first.
+   */
+  static bool CompareBytes (const Line &a, const Line &b);
+  /** Sample for EnablePeriodicReport. */
+  static void PeriodicReport (void);
+
+  /** \c true if accounting is enabled. */
+  static bool m_enabled;
+  /** The counts of all the threads which updated a counter. */
+  static ThreadCounts *m_threadCounts;
+  /**
+   * The counts of the calling thread, or 0 before its first update.
+   * The initial-exec model makes Counter::Add read it with a single
+   * load instead of a call to __tls_get_addr.
+   */
+  static __thread ThreadCounts *s_threadCounts __attribute__ ((tls_model ("initial-exec")));
+};
+
+bool
+MemoryAccounting::IsEnabled (void)
+{
+  return m_enabled;
+}
+
+void
+MemoryAccounting::Counter::Add (int64_t objects, int64_t bytes)
+{
+  ThreadCounts *counts = s_threadCounts;
+  if (counts == 0)
+    {
+      counts = RegisterThread ();
+    }
+  // Only this thread writes its counts: relaxed stores are plain moves,
+  // which Sum may read concurrently.
+  __atomic_store_n (&counts->objects[m_index], counts->objects[m_index] + objects, __ATOMIC_RELAXED);
+  __atomic_store_n (&counts->bytes[m_index], counts->bytes[m_index] + bytes, __ATOMIC_RELAXED);
+}
+
+} // namespace ns3
+
+#endif /* MEMORY_ACCOUNTING_H */
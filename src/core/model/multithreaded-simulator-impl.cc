@@ -0,0 +1,894 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+#include "simulator.h"
+#include "scheduler.h"
+#include "event-impl.h"
+
+#include "ptr.h"
+#include "pointer.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+#include <pthread.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the
+// concurrent execution of the partitions.
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+/** The state of one partition. */
+struct MultithreadedSimulatorImpl::Partition
+{
+  /** The simulator which owns the partition. */
+  MultithreadedSimulatorImpl *impl;
+  /** The index of the partition. */
+  uint32_t index;
+  /** The event list. */
+  Ptr<Scheduler> events;
+  /** Timestamp of the event being run. */
+  uint64_t currentTs;
+  /** Context of the event being run. */
+  uint32_t currentContext;
+  /** Uid of the event being run. */
+  uint32_t currentUid;
+  /** Next event uid. */
+  uint32_t uid;
+  /** Sequence number of the events sent to other partitions. */
+  uint32_t sent;
+  /** Lock-free stack of the events received from other partitions. */
+  InboundEvent * volatile inbound;
+  /** Whether an event of the partition called Stop(). */
+  bool stop;
+  /**
+   * The thread running this partition, except for partition 0; it is
+   * kept from the first Run() to Destroy().
+   */
+  Ptr<SystemThread> thread;
+};
+
+/** An event scheduled by a partition for another one. */
+struct MultithreadedSimulatorImpl::InboundEvent
+{
+  /** The event. */
+  EventImpl *event;
+  /** The absolute timestamp. */
+  uint64_t ts;
+  /** The context. */
+  uint32_t context;
+  /** The index of the sending partition. */
+  uint32_t source;
+  /** The sequence number within the sending partition. */
+  uint32_t sequence;
+  /** The next entry in the stack. */
+  InboundEvent *next;
+};
+
+/**
+ * The synchronization of the worker threads.
+ *
+ * SystemCondition forgets the signals sent while nobody waits, so
+ * the window barrier is built directly on pthread.
+ */
+struct MultithreadedSimulatorImpl::Workers
+{
+  /** Protects all the fields below. */
+  pthread_mutex_t mutex;
+  /** Signalled when a new window starts. */
+  pthread_cond_t start;
+  /** Signalled when the last worker completes its window. */
+  pthread_cond_t done;
+  /** Incremented on every window. */
+  uint64_t generation;
+  /** The number of workers still running the current window. */
+  uint32_t busy;
+  /** Whether the workers must exit. */
+  bool terminate;
+};
+
+__thread MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::s_current = 0;
+
+namespace {
+
+/**
+ * Order the events received by a partition independently of the
+ * thread interleaving.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \return \c true if \p a must be inserted first.
+ */
+template <typename T>
+bool
+InboundLess (const T *a, const T *b)
+{
+  if (a->ts != b->ts)
+    {
+      return a->ts < b->ts;
+    }
+  if (a->source != b->source)
+    {
+      return a->source < b->source;
+    }
+  return a->sequence < b->sequence;
+}
+
+} // unnamed namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("LookAhead",
+                   "The length of the windows run concurrently by the "
+                   "partitions; the minimum delay of the events scheduled "
+                   "across partitions.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_lookAhead),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_windowEnd (0),
+    m_workers (new Workers),
+    m_stop (false),
+    m_stopTs (GetMaximumSimulationTime ().GetTimeStep ()),
+    m_started (false),
+    m_running (false),
+    // uids are allocated from 4, see DefaultSimulatorImpl
+    m_uid (4),
+    m_pendingFloor (4),
+    m_currentTs (0),
+    m_currentContext (0xffffffff)
+{
+  NS_LOG_FUNCTION (this);
+  pthread_mutex_init (&m_workers->mutex, 0);
+  pthread_cond_init (&m_workers->start, 0);
+  pthread_cond_init (&m_workers->done, 0);
+  m_workers->generation = 0;
+  m_workers->busy = 0;
+  m_workers->terminate = false;
+  m_main = SystemThread::Self ();
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  pthread_cond_destroy (&m_workers->done);
+  pthread_cond_destroy (&m_workers->start);
+  pthread_mutex_destroy (&m_workers->mutex);
+  delete m_workers;
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  StopWorkers ();
+  for (std::vector<Partition *>::iterator i = m_partitions.begin ();
+       i != m_partitions.end (); ++i)
+    {
+      Partition *p = *i;
+      DrainInbound (p);
+      while (!p->events->IsEmpty ())
+        {
+          Scheduler::Event next = p->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      delete p;
+    }
+  m_partitions.clear ();
+  if (m_pending != 0)
+    {
+      while (!m_pending->IsEmpty ())
+        {
+          Scheduler::Event next = m_pending->RemoveNext ();
+          next.impl->Unref ();
+        }
+      m_pending = 0;
+    }
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (!m_running, "Cannot change the scheduler while running");
+  m_schedulerFactory = schedulerFactory;
+
+  Ptr<Scheduler> pending = m_schedulerFactory.Create<Scheduler> ();
+  if (m_pending != 0)
+    {
+      while (!m_pending->IsEmpty ())
+        {
+          pending->Insert (m_pending->RemoveNext ());
+        }
+    }
+  m_pending = pending;
+
+  for (std::vector<Partition *>::iterator i = m_partitions.begin ();
+       i != m_partitions.end (); ++i)
+    {
+      Ptr<Scheduler> events = m_schedulerFactory.Create<Scheduler> ();
+      while (!(*i)->events->IsEmpty ())
+        {
+          events->Insert ((*i)->events->RemoveNext ());
+        }
+      (*i)->events = events;
+    }
+  if (m_partitions.empty ())
+    {
+      AddPartitions (0);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::AddPartitions (uint32_t partition)
+{
+  NS_LOG_FUNCTION (this << partition);
+  while (m_partitions.size () <= partition)
+    {
+      Partition *p = new Partition;
+      p->impl = this;
+      p->index = m_partitions.size ();
+      p->events = m_schedulerFactory.Create<Scheduler> ();
+      p->currentTs = m_currentTs;
+      p->currentContext = 0xffffffff;
+      p->currentUid = 0;
+      p->uid = m_uid;
+      p->sent = 0;
+      p->inbound = 0;
+      p->stop = false;
+      m_partitions.push_back (p);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetPartition (uint32_t context, uint32_t partition)
+{
+  NS_LOG_FUNCTION (this << context << partition);
+  NS_ASSERT_MSG (context != 0xffffffff, "Cannot move the \"no context\" value");
+  if (m_started)
+    {
+      NS_FATAL_ERROR ("MultithreadedSimulatorImpl::SetPartition(): "
+                      "partitions must be set before the simulation runs");
+    }
+  AddPartitions (partition);
+  if (m_partitionOf.size () <= context)
+    {
+      m_partitionOf.resize (context + 1, 0);
+    }
+  m_partitionOf[context] = partition;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  return Lookup (context)->index;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitions.size ();
+}
+
+void
+MultithreadedSimulatorImpl::SetLookAhead (Time lookAhead)
+{
+  NS_LOG_FUNCTION (this << lookAhead);
+  NS_ASSERT_MSG (!m_running, "Cannot change the look-ahead while running");
+  m_lookAhead = lookAhead;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return m_lookAhead;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::Lookup (uint32_t context) const
+{
+  if (context < m_partitionOf.size ())
+    {
+      return m_partitions[m_partitionOf[context]];
+    }
+  return m_partitions[0];
+}
+
+uint32_t
+MultithreadedSimulatorImpl::NextUid (Partition *p)
+{
+  if (p == 0)
+    {
+      return m_uid++;
+    }
+  return p->uid++;
+}
+
+// The partitions have their own system id, so that the identifiers
+// allocated by each thread, such as packet uids, do not collide.
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  Partition *self = s_current;
+  if (self == 0)
+    {
+      return 0;
+    }
+  return self->index;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  if (!m_pending->IsEmpty ())
+    {
+      return false;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin ();
+       i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty () || (*i)->inbound != 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::DistributePending (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin ();
+       i != m_partitions.end (); ++i)
+    {
+      (*i)->uid = std::max ((*i)->uid, m_uid);
+    }
+  while (!m_pending->IsEmpty ())
+    {
+      Scheduler::Event ev = m_pending->RemoveNext ();
+      Lookup (ev.key.m_context)->events->Insert (ev);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::DrainInbound (Partition *p)
+{
+  // Only called between windows, when no partition can push: the
+  // exchange below is what the producers' compare-and-swap pairs with.
+  InboundEvent *head = __sync_lock_test_and_set (&p->inbound, (InboundEvent *) 0);
+  if (head == 0)
+    {
+      return;
+    }
+  std::vector<InboundEvent *> received;
+  for (InboundEvent *in = head; in != 0; in = in->next)
+    {
+      received.push_back (in);
+    }
+  std::sort (received.begin (), received.end (), &InboundLess<InboundEvent>);
+  for (std::vector<InboundEvent *>::iterator i = received.begin ();
+       i != received.end (); ++i)
+    {
+      Scheduler::Event ev;
+      ev.impl = (*i)->event;
+      ev.key.m_ts = (*i)->ts;
+      ev.key.m_context = (*i)->context;
+      ev.key.m_uid = NextUid (p);
+      p->events->Insert (ev);
+      delete *i;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (Partition *p)
+{
+  s_current = p;
+  while (!p->stop && !p->events->IsEmpty ())
+    {
+      if (p->events->PeekNext ().key.m_ts >= m_windowEnd)
+        {
+          break;
+        }
+      Scheduler::Event next = p->events->RemoveNext ();
+
+      NS_ASSERT (next.key.m_ts >= p->currentTs);
+      p->currentTs = next.key.m_ts;
+      p->currentContext = next.key.m_context;
+      p->currentUid = next.key.m_uid;
+      next.impl->Invoke ();
+      next.impl->Unref ();
+    }
+  s_current = 0;
+}
+
+void
+MultithreadedSimulatorImpl::WorkerEntry (Partition *p)
+{
+  p->impl->WorkerRun (p);
+}
+
+void
+MultithreadedSimulatorImpl::WorkerRun (Partition *p)
+{
+  // the workers are started by the first Run(), before any window.
+  uint64_t seen = 0;
+  for (;;)
+    {
+      pthread_mutex_lock (&m_workers->mutex);
+      while (m_workers->generation == seen)
+        {
+          pthread_cond_wait (&m_workers->start, &m_workers->mutex);
+        }
+      seen = m_workers->generation;
+      bool terminate = m_workers->terminate;
+      pthread_mutex_unlock (&m_workers->mutex);
+      if (terminate)
+        {
+          return;
+        }
+
+      ProcessWindow (p);
+
+      pthread_mutex_lock (&m_workers->mutex);
+      m_workers->busy--;
+      if (m_workers->busy == 0)
+        {
+          pthread_cond_signal (&m_workers->done);
+        }
+      pthread_mutex_unlock (&m_workers->mutex);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::StopWorkers (void)
+{
+  NS_LOG_FUNCTION (this);
+  pthread_mutex_lock (&m_workers->mutex);
+  m_workers->terminate = true;
+  m_workers->generation++;
+  pthread_cond_broadcast (&m_workers->start);
+  pthread_mutex_unlock (&m_workers->mutex);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin ();
+       i != m_partitions.end (); ++i)
+    {
+      if ((*i)->thread != 0)
+        {
+          (*i)->thread->Join ();
+          (*i)->thread = 0;
+        }
+    }
+  m_workers->terminate = false;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Set the current threadId as the main threadId
+  m_main = SystemThread::Self ();
+  uint32_t n = m_partitions.size ();
+  uint64_t maxTs = GetMaximumSimulationTime ().GetTimeStep ();
+  uint64_t lookAhead = maxTs;
+  if (n > 1)
+    {
+      if (!m_lookAhead.IsStrictlyPositive ())
+        {
+          NS_FATAL_ERROR ("MultithreadedSimulatorImpl::Run(): "
+                          "a positive look-ahead is needed to run "
+                          << n << " partitions");
+        }
+      lookAhead = m_lookAhead.GetTimeStep ();
+    }
+  m_stop = false;
+  m_started = true;
+  DistributePending ();
+
+  // The workers are kept across Run() calls: the state of their
+  // thread, such as the packet uid counter, lives as long as the
+  // partition.
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Partition *p = m_partitions[i];
+      if (p->thread == 0)
+        {
+          p->thread = Create<SystemThread> (MakeBoundCallback (&MultithreadedSimulatorImpl::WorkerEntry, p));
+          p->thread->Start ();
+        }
+    }
+
+  m_running = true;
+  for (;;)
+    {
+      uint64_t next = maxTs;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          Partition *p = m_partitions[i];
+          DrainInbound (p);
+          if (!p->events->IsEmpty ())
+            {
+              next = std::min (next, p->events->PeekNext ().key.m_ts);
+            }
+        }
+      if (next == maxTs)
+        {
+          m_stopTs = maxTs;
+          break;
+        }
+      if (next >= m_stopTs)
+        {
+          m_stop = true;
+          m_stopTs = maxTs;
+          break;
+        }
+      m_windowEnd = (next > maxTs - lookAhead) ? maxTs : next + lookAhead;
+      m_windowEnd = std::min (m_windowEnd, m_stopTs);
+
+      pthread_mutex_lock (&m_workers->mutex);
+      m_workers->busy = n - 1;
+      m_workers->generation++;
+      pthread_cond_broadcast (&m_workers->start);
+      pthread_mutex_unlock (&m_workers->mutex);
+
+      ProcessWindow (m_partitions[0]);
+
+      pthread_mutex_lock (&m_workers->mutex);
+      while (m_workers->busy != 0)
+        {
+          pthread_cond_wait (&m_workers->done, &m_workers->mutex);
+        }
+      pthread_mutex_unlock (&m_workers->mutex);
+
+      for (uint32_t i = 0; i < n; i++)
+        {
+          if (m_partitions[i]->stop)
+            {
+              m_partitions[i]->stop = false;
+              m_stop = true;
+            }
+        }
+      if (m_stop)
+        {
+          break;
+        }
+    }
+  m_running = false;
+
+  // Events received during the last window are kept for the next Run.
+  for (uint32_t i = 0; i < n; i++)
+    {
+      DrainInbound (m_partitions[i]);
+      m_currentTs = std::max (m_currentTs, m_partitions[i]->currentTs);
+      m_uid = std::max (m_uid, m_partitions[i]->uid);
+    }
+  m_pendingFloor = m_uid;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  Partition *self = s_current;
+  if (self != 0)
+    {
+      // the other partitions complete the window, which only depends
+      // on the timestamps of the events
+      self->stop = true;
+    }
+  else
+    {
+      m_stop = true;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  Partition *self = s_current;
+  if (self == 0)
+    {
+      NS_ASSERT_MSG (!m_running && SystemThread::Equals (m_main),
+                     "Simulator::Stop Thread-unsafe invocation!");
+      m_stopTs = std::min (m_stopTs, (uint64_t) (delay + TimeStep (m_currentTs)).GetTimeStep ());
+      return;
+    }
+  uint64_t ts = (uint64_t) (delay + TimeStep (self->currentTs)).GetTimeStep ();
+  if (ts < m_windowEnd)
+    {
+      // the other partitions may already be past the stop time
+      Simulator::Schedule (delay, &Simulator::Stop);
+      return;
+    }
+  // The windows are clipped to the earliest stop time requested by any
+  // partition; m_stopTs is only read by the main thread between windows.
+  uint64_t stopTs;
+  do
+    {
+      stopTs = m_stopTs;
+    }
+  while (ts < stopTs && !__sync_bool_compare_and_swap (&m_stopTs, stopTs, ts));
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  Partition *self = s_current;
+  uint64_t now = self ? self->currentTs : m_currentTs;
+  Time tAbsolute = delay + TimeStep (now);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (now));
+  NS_ASSERT_MSG (self != 0 || (!m_running && SystemThread::Equals (m_main)),
+                 "Simulator::Schedule Thread-unsafe invocation!");
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = (uint64_t) tAbsolute.GetTimeStep ();
+  ev.key.m_context = GetContext ();
+  ev.key.m_uid = NextUid (self);
+  if (self != 0)
+    {
+      self->events->Insert (ev);
+    }
+  else
+    {
+      m_pending->Insert (ev);
+    }
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  Partition *self = s_current;
+  if (self == 0)
+    {
+      NS_ASSERT_MSG (!m_running && SystemThread::Equals (m_main),
+                     "Simulator::ScheduleWithContext Thread-unsafe invocation!");
+      Scheduler::Event ev;
+      ev.impl = event;
+      ev.key.m_ts = (uint64_t) (delay + TimeStep (m_currentTs)).GetTimeStep ();
+      ev.key.m_context = context;
+      ev.key.m_uid = NextUid (0);
+      m_pending->Insert (ev);
+      return;
+    }
+
+  uint64_t ts = (uint64_t) (delay + TimeStep (self->currentTs)).GetTimeStep ();
+  Partition *target = Lookup (context);
+  if (target == self)
+    {
+      Scheduler::Event ev;
+      ev.impl = event;
+      ev.key.m_ts = ts;
+      ev.key.m_context = context;
+      ev.key.m_uid = NextUid (self);
+      self->events->Insert (ev);
+      return;
+    }
+
+  if (ts < m_windowEnd)
+    {
+      NS_FATAL_ERROR ("MultithreadedSimulatorImpl::ScheduleWithContext(): "
+                      "event for context " << context << " in partition "
+                      << target->index << " is scheduled " << delay
+                      << " after the current time of partition " << self->index
+                      << ", less than the look-ahead " << m_lookAhead);
+    }
+  InboundEvent *in = new InboundEvent;
+  in->event = event;
+  in->ts = ts;
+  in->context = context;
+  in->source = self->index;
+  in->sequence = self->sent++;
+  InboundEvent *head;
+  do
+    {
+      head = target->inbound;
+      in->next = head;
+    }
+  while (!__sync_bool_compare_and_swap (&target->inbound, head, in));
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  CriticalSection cs (m_destroyMutex);
+  EventId id (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  Partition *self = s_current;
+  return TimeStep (self ? self->currentTs : m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs ()) - Now ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  if (!m_running && id.GetUid () >= m_pendingFloor)
+    {
+      m_pending->Remove (event);
+    }
+  else
+    {
+      Partition *p = Lookup (id.GetContext ());
+      NS_ASSERT_MSG (s_current == p || (!m_running && SystemThread::Equals (m_main)),
+                     "Simulator::Remove of an event of another partition");
+      p->events->Remove (event);
+    }
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0 ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  if (!m_running && id.GetUid () >= m_pendingFloor)
+    {
+      // still waiting in m_pending
+      return false;
+    }
+  const Partition *p = Lookup (id.GetContext ());
+  if (id.GetTs () < p->currentTs ||
+      (id.GetTs () == p->currentTs &&
+       id.GetUid () <= p->currentUid))
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  Partition *self = s_current;
+  return self ? self->currentContext : m_currentContext;
+}
+
+} // namespace ns3
@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "system-thread.h"
+#include "ns3/system-mutex.h"
+#include "nstime.h"
+
+#include "ptr.h"
+
+#include <list>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * A conservative parallel simulator implementation for shared-memory
+ * machines.
+ *
+ * Event contexts (node ids) are mapped onto partitions with
+ * SetPartition(); every partition has its own event list and is run
+ * by its own thread.  Unmapped contexts, including the "no context"
+ * value 0xffffffff, belong to partition 0.
+ *
+ * The simulation advances in windows: the next window starts at the
+ * earliest pending event over all partitions and lasts for the
+ * look-ahead, during which all the partitions run their own events
+ * concurrently.  An event scheduled for a context of another partition
+ * must therefore be at least the look-ahead in the future, which is
+ * checked; such events are pushed on a lock-free queue of the target
+ * partition and inserted into its event list, in a deterministic order,
+ * between two windows.  The look-ahead is usually the smallest delay of
+ * the channels which connect nodes of different partitions, as computed
+ * by ns3::SimulatorPartitionHelper.
+ *
+ * Stop() called from an event ends the simulation deterministically:
+ * the calling partition stops after the event, and the others complete
+ * the current window.  Stop(delay) called outside Run(), or from an
+ * event with a stop time beyond the current window, clips the windows
+ * to the stop time, so that every partition runs exactly the events
+ * before it; a stop time within the current window is handled like an
+ * event calling Stop().
+ *
+ * The engine does not make the models thread-safe: objects reachable
+ * from more than one partition must only be touched through events
+ * scheduled on the partition which owns them, and since reference
+ * counts are not atomic, a partition must not keep a reference to an
+ * object which it passed to another partition: the channels which
+ * ns3::SimulatorPartitionHelper cuts hand the receiving partition a
+ * deep copy of each packet.  EventIds must only be cancelled or
+ * removed from the partition of their context, or while the
+ * simulation is not running.
+ *
+ * Every partition keeps its thread from the first Run() to Destroy(),
+ * and GetSystemId() returns the index of the calling partition, so
+ * that the identifiers allocated from thread-local counters, such as
+ * packet uids, are unique.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * Assign a context to a partition.
+   *
+   * Partitions are numbered from zero and created on demand.  This
+   * must be called before the simulation first runs.
+   *
+   * \param [in] context The context, usually a node id.
+   * \param [in] partition The partition which runs the events of
+   *             the context.
+   */
+  void SetPartition (uint32_t context, uint32_t partition);
+  /**
+   * \param [in] context The context, usually a node id.
+   * \return The partition which runs the events of the context.
+   */
+  uint32_t GetPartition (uint32_t context) const;
+  /** \return The number of partitions, hence of threads. */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * Set the window length.
+   *
+   * \param [in] lookAhead The minimum delay of the events scheduled
+   *             across partitions; must be strictly positive when there
+   *             is more than one partition.
+   */
+  void SetLookAhead (Time lookAhead);
+  /** \return The window length. */
+  Time GetLookAhead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  struct Partition;
+  struct InboundEvent;
+  struct Workers;
+
+  /**
+   * Create the partitions up to and including \p partition.
+   * \param [in] partition The highest partition index needed.
+   */
+  void AddPartitions (uint32_t partition);
+  /**
+   * \param [in] context The context.
+   * \return The partition of the context.
+   */
+  Partition *Lookup (uint32_t context) const;
+  /** Move the events scheduled outside Run() into their partitions. */
+  void DistributePending (void);
+  /**
+   * Insert the events received from other partitions.
+   * \param [in,out] p The partition.
+   */
+  void DrainInbound (Partition *p);
+  /**
+   * Run the events of one partition which fall in the current window.
+   * \param [in,out] p The partition.
+   */
+  void ProcessWindow (Partition *p);
+  /**
+   * Main loop of a worker thread.
+   * \param [in] p The partition run by the thread.
+   */
+  void WorkerRun (Partition *p);
+  /** Terminate the worker threads and wait for them. */
+  void StopWorkers (void);
+  /**
+   * Entry point of the worker threads.
+   * \param [in] p The partition run by the thread.
+   */
+  static void WorkerEntry (Partition *p);
+  /**
+   * Allocate the uid of a new event.
+   * \param [in] p The partition which will hold the event, or 0 for
+   *             the events scheduled outside Run().
+   * \return The uid.
+   */
+  uint32_t NextUid (Partition *p);
+
+  /** Container type for the events to run at Destroy. */
+  typedef std::list<EventId> DestroyEvents;
+  /** The events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /** Protects m_destroyEvents against concurrent ScheduleDestroy. */
+  SystemMutex m_destroyMutex;
+
+  /** The factory used to create the per-partition event lists. */
+  ObjectFactory m_schedulerFactory;
+  /** The events scheduled while the simulation is not running. */
+  Ptr<Scheduler> m_pending;
+  /** The partitions. */
+  std::vector<Partition *> m_partitions;
+  /** The partition of each context; unmapped contexts run on partition 0. */
+  std::vector<uint32_t> m_partitionOf;
+  /** The window length. */
+  Time m_lookAhead;
+  /** The end, exclusive, of the current window. */
+  uint64_t m_windowEnd;
+  /** The worker threads and their synchronization. */
+  Workers *m_workers;
+
+  /** Whether the last Run() ended on a stop; only used by the main thread. */
+  bool m_stop;
+  /** The stop time set by Stop(delay); the windows end there at the latest. */
+  uint64_t m_stopTs;
+  /** Whether Run() was entered at least once. */
+  bool m_started;
+  /** Whether the simulation is running. */
+  bool m_running;
+  /** Next uid for the events scheduled outside Run(). */
+  uint32_t m_uid;
+  /** The lowest uid of the events held in m_pending. */
+  uint32_t m_pendingFloor;
+  /** Timestamp of the last event run, outside Run(). */
+  uint64_t m_currentTs;
+  /** Context used outside Run(). */
+  uint32_t m_currentContext;
+  /** Main execution thread. */
+  SystemThread::ThreadId m_main;
+
+  /** The partition run by the calling thread, if any. */
+  static __thread Partition *s_current;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
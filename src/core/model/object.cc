@@ -25,6 +25,8 @@
 #include "attribute.h"
 #include "log.h"
 #include "string.h"
+#include "config.h"
+#include "memory-accounting.h"
 #include <vector>
 #include <sstream>
 #include <cstdlib>
@@ -97,12 +99,14 @@ Object::Object ()
   : m_tid (Object::GetTypeId ()),
     m_disposed (false),
     m_initialized (false),
+    m_accounted (false),
     m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
     m_getObjectCount (0)
 {
   NS_LOG_FUNCTION (this);
   m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
+  ClearCache (m_aggregates);
 }
 Object::~Object () 
 {
@@ -120,6 +124,7 @@ Object::~Object ()
           m_aggregates->n--;
         }
     }
+  ClearCache (m_aggregates);
   // finally, if all objects have been removed from the list,
   // delete the aggregate list
   if (m_aggregates->n == 0)
@@ -127,16 +132,27 @@ Object::~Object ()
       std::free (m_aggregates);
     }
   m_aggregates = 0;
+  if (m_accounted)
+    {
+      MemoryAccounting::ObjectDestroyed (m_tid);
+    }
 }
 Object::Object (const Object &o)
   : m_tid (o.m_tid),
     m_disposed (false),
     m_initialized (false),
+    m_accounted (false),
     m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
     m_getObjectCount (0)
 {
   m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
+  ClearCache (m_aggregates);
+  if (MemoryAccounting::IsEnabled ())
+    {
+      MemoryAccounting::ObjectCreated (m_tid);
+      m_accounted = true;
+    }
 }
 void
 Object::Construct (const AttributeConstructionList &attributes)
@@ -151,6 +167,14 @@ Object::DoGetObject (TypeId tid) const
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
+  uint16_t uid = tid.GetUid ();
+  struct Aggregates::CacheEntry *entry =
+    &m_aggregates->cache[uid & (Aggregates::CACHE_SIZE - 1)];
+  if (entry->uid == uid)
+    {
+      return const_cast<Object *> (entry->object);
+    }
+
   uint32_t n = m_aggregates->n;
   TypeId objectTid = Object::GetTypeId ();
   for (uint32_t i = 0; i < n; i++)
@@ -173,13 +197,26 @@ Object::DoGetObject (TypeId tid) const
           current->m_getObjectCount++;
           // then, update the sort
           UpdateSortedArray (m_aggregates, i);
+          // remember the match for the next lookup of the same type
+          entry->uid = uid;
+          entry->object = current;
           // finally, return the match
           return const_cast<Object *> (current);
         }
     }
+  // negative results are cached too: GetObject is commonly used
+  // to probe for optional aggregates
+  entry->uid = uid;
+  entry->object = 0;
   return 0;
 }
 void
+Object::ClearCache (struct Aggregates *aggregates)
+{
+  NS_LOG_FUNCTION (aggregates);
+  std::memset (aggregates->cache, 0, sizeof (aggregates->cache));
+}
+void
 Object::Initialize (void)
 {
   /**
@@ -264,6 +301,7 @@ Object::AggregateObject (Ptr<Object> o)
   struct Aggregates *aggregates = 
     (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
   aggregates->n = total;
+  ClearCache (aggregates);
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0], 
@@ -290,6 +328,9 @@ Object::AggregateObject (Ptr<Object> o)
       current->m_aggregates = aggregates;
     }
 
+  // New interfaces may now be reached through Config paths.
+  Config::InvalidateCache ();
+
   // Finally, call NotifyNewAggregate on all the objects aggregates together.
   // We purposedly use the old aggregate buffers to iterate over the objects
   // because this allows us to assume that they will not change from under 
@@ -332,7 +373,17 @@ Object::SetTypeId (TypeId tid)
 {
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (Check ());
+  if (m_accounted)
+    {
+      MemoryAccounting::ObjectDestroyed (m_tid);
+      m_accounted = false;
+    }
   m_tid = tid;
+  if (MemoryAccounting::IsEnabled ())
+    {
+      MemoryAccounting::ObjectCreated (tid);
+      m_accounted = true;
+    }
 }
 
 void
@@ -327,13 +327,38 @@ private:
    * chunk of memory than the struct to allow space for a larger
    * variable sized buffer whose size is indicated by the element
    * \c n
+   *
+   * The structure also holds a small direct-mapped cache of recent
+   * DoGetObject() results, indexed by TypeId uid, so that repeated
+   * lookups of the same type do not walk the buffer and the TypeId
+   * parent chains again.  Since the structure is shared by all the
+   * aggregated Objects and is replaced whenever the aggregation
+   * changes, the cache never needs to be explicitly invalidated
+   * except when an Object leaves it upon destruction.
    */
   struct Aggregates {
     /** The number of entries in \c buffer. */
     uint32_t n;
+    /** A cached lookup result. */
+    struct CacheEntry {
+      /** The uid of the TypeId looked up, or 0 for an empty slot. */
+      uint16_t uid;
+      /** The matching Object, or 0 if none was found. */
+      Object *object;
+    };
+    /** The number of slots in \c cache; must be a power of two. */
+    enum { CACHE_SIZE = 8 };
+    /** The lookup cache. */
+    struct CacheEntry cache[CACHE_SIZE];
     /** The array of Objects. */
     Object *buffer[1];
   };
+  /**
+   * Empty the lookup cache of a list of aggregated Objects.
+   *
+   * \param [in,out] aggregates The list of aggregated Objects.
+   */
+  static void ClearCache (struct Aggregates *aggregates);
 
   /**
    * Find an Object of TypeId tid in the aggregates of this Object.
@@ -412,6 +437,11 @@ private:
    * \c false otherwise
    */
   bool m_initialized;
+  /**
+   * Set to \c true when MemoryAccounting counted this Object under
+   * m_tid, \c false otherwise.
+   */
+  bool m_accounted;
   /**
    * A pointer to an array of 'aggregates'.
    *
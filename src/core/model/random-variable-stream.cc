@@ -34,6 +34,7 @@
 #include "rng-stream.h"
 #include "rng-seed-manager.h"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 /**
@@ -136,6 +137,15 @@ RandomVariableStream::Peek(void) const
   NS_LOG_FUNCTION (this);
   return m_rng;
 }
+void
+RandomVariableStream::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      values[i] = GetValue ();
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(UniformRandomVariable);
 
@@ -207,6 +217,25 @@ UniformRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
+void
+UniformRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  Peek ()->RandU01 (values, n);
+  double min = m_min;
+  double max = m_max;
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      values[i] = min + values[i] * (max - min);
+    }
+  if (IsAntithetic ())
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          values[i] = min + (max - values[i]);
+        }
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
@@ -444,6 +473,39 @@ ExponentialRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_bound);
 }
+void
+ExponentialRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  double mean = m_mean;
+  double bound = m_bound;
+  bool antithetic = IsAntithetic ();
+  std::size_t done = 0;
+  while (done < n)
+    {
+      //
+      // Each uniform gives at most one value, so drawing as many as
+      // there are values left never consumes one GetValue (void) would
+      // not have consumed.  Rejected values are compacted away.
+      //
+      std::size_t todo = n - done;
+      double *u = values + done;
+      Peek ()->RandU01 (u, todo);
+      for (std::size_t i = 0; i < todo; ++i)
+        {
+          double v = u[i];
+          if (antithetic)
+            {
+              v = (1 - v);
+            }
+          double r = -mean*std::log (v);
+          if (bound == 0 || r <= bound)
+            {
+              values[done++] = r;
+            }
+        }
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ParetoRandomVariable);
 
@@ -748,6 +810,66 @@ NormalRandomVariable::GetValue (void)
   NS_LOG_FUNCTION (this);
   return GetValue (m_mean, m_variance, m_bound);
 }
+void
+NormalRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  double mean = m_mean;
+  double bound = m_bound;
+  double sigma = std::sqrt (m_variance);
+  bool antithetic = IsAntithetic ();
+  std::size_t done = 0;
+  if (done < n && m_nextValid)
+    {
+      m_nextValid = false;
+      values[done++] = m_next;
+    }
+  //
+  // Each pair of uniforms gives at most two values, so drawing one pair
+  // per two values left never consumes a pair GetValue (void) would not
+  // have consumed.  The pair logic below is the one of GetValue (void).
+  //
+  double u[64];
+  while (done < n)
+    {
+      std::size_t pairs = std::min<std::size_t> ((n - done + 1) / 2, sizeof (u) / sizeof (u[0]) / 2);
+      Peek ()->RandU01 (u, 2 * pairs);
+      for (std::size_t i = 0; i < pairs && done < n; ++i)
+        {
+          double u1 = u[2 * i];
+          double u2 = u[2 * i + 1];
+          if (antithetic)
+            {
+              u1 = (1 - u1);
+              u2 = (1 - u2);
+            }
+          double v1 = 2 * u1 - 1;
+          double v2 = 2 * u2 - 1;
+          double w = v1 * v1 + v2 * v2;
+          if (w <= 1.0)
+            {
+              double y = std::sqrt ((-2 * std::log (w)) / w);
+              m_next = mean + v2 * y * sigma;
+              m_nextValid = std::fabs (m_next - mean) <= bound;
+              double x1 = mean + v1 * y * sigma;
+              if (std::fabs (x1 - mean) <= bound)
+                {
+                  values[done++] = x1;
+                }
+              else if (m_nextValid)
+                {
+                  m_nextValid = false;
+                  values[done++] = m_next;
+                }
+              if (done < n && m_nextValid)
+                {
+                  m_nextValid = false;
+                  values[done++] = m_next;
+                }
+            }
+        }
+    }
+}
 uint32_t 
 NormalRandomVariable::GetInteger (void)
 {
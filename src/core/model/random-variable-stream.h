@@ -30,6 +30,7 @@
 #include "object.h"
 #include "attribute-helper.h"
 #include <stdint.h>
+#include <cstddef>
 
 /**
  * \file
@@ -149,6 +150,21 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Fill a buffer with the next random values drawn from the
+   * distribution.
+   *
+   * The values are the ones \p n calls to GetValue(void) would
+   * return, in the same order, so batching does not change the
+   * sequence of a stream.  The default implementation just calls
+   * GetValue(void); distributions which can draw their uniform
+   * variates in bulk override it.
+   *
+   * \param [out] values The buffer to fill.
+   * \param [in] n The number of values to draw.
+   */
+  virtual void GetValues (double *values, std::size_t n);
+
 protected:
   /**
    * \brief Get the pointer to the underlying RNG stream.
@@ -293,6 +309,7 @@ public:
    * \note The upper limit is included in the output range.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, std::size_t n);
   
 private:
   /** The lower bound on values that can be returned by this RNG stream. */
@@ -585,6 +602,7 @@ public:
   // Inherited from RandomVariableStream
   virtual double GetValue (void);
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, std::size_t n);
 
 private:
   /** The mean value of the unbounded exponential distribution. */
@@ -1243,6 +1261,9 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  // Inherited from RandomVariableStream
+  virtual void GetValues (double *values, std::size_t n);
+
 private:
   /** The mean value for the normal distribution returned by this RNG stream. */
   double m_mean;
@@ -34,6 +34,7 @@
 
 
 #include <cmath>
+#include <algorithm>
 
 
 /**
@@ -90,6 +91,10 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
+  m_injected = 0;
+  m_jitterSamples = 0;
+  m_jitterSum = 0;
+  m_jitterMax = 0;
 
   m_main = SystemThread::Self();
 
@@ -107,6 +112,7 @@ void
 RealtimeSimulatorImpl::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  DrainInjected ();
   while (!m_events->IsEmpty ())
     {
       Scheduler::Event next = m_events->RemoveNext ();
@@ -228,6 +234,14 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
         //
         // tsNext is the simulation time of the next event we want to execute.
         //
+        //
+        // The condition is reset before the injected events are drained: a
+        // thread injecting after the drain below finds the queue empty and
+        // signals, so that the wait is interrupted.
+        //
+        m_synchronizer->SetCondition (false);
+        DrainInjected ();
+
         tsNow = m_synchronizer->GetCurrentRealtime ();
         tsNext = NextTs ();
 
@@ -249,14 +263,6 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
             tsDelay = tsNext - tsNow;
           }
 
-        //
-        // We've figured out how long we need to delay in order to pace the 
-        // simulation time with the real time.  We're going to sleep, but need
-        // to work with the synchronizer to make sure we're awakened if something 
-        // external happens (like a packet is received).  This next line resets
-        // the synchronizer so that any future event will cause it to interrupt.
-        //
-        m_synchronizer->SetCondition (false);
       }
 
       //
@@ -359,20 +365,24 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // We check the simulation time against the current real time to make this
     // judgement.
     //
-    if (m_synchronizationMode == SYNC_HARD_LIMIT)
+    uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
+    uint64_t tsJitter;
+
+    if (tsFinal >= m_currentTs)
+      {
+        tsJitter = tsFinal - m_currentTs;
+      }
+    else
       {
-        uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
-        uint64_t tsJitter;
+        tsJitter = m_currentTs - tsFinal;
+      }
 
-        if (tsFinal >= m_currentTs)
-          {
-            tsJitter = tsFinal - m_currentTs;
-          }
-        else
-          {
-            tsJitter = m_currentTs - tsFinal;
-          }
+    m_jitterSamples++;
+    m_jitterSum += tsJitter;
+    m_jitterMax = std::max (m_jitterMax, tsJitter);
 
+    if (m_synchronizationMode == SYNC_HARD_LIMIT)
+      {
         if (tsJitter > static_cast<uint64_t>(m_hardLimit.GetTimeStep ()))
           {
             NS_FATAL_ERROR ("RealtimeSimulatorImpl::ProcessOneEvent (): "
@@ -399,7 +409,7 @@ RealtimeSimulatorImpl::IsFinished (void) const
   bool rc;
   {
     CriticalSection cs (m_mutex);
-    rc = m_events->IsEmpty () || m_stop;
+    rc = (m_events->IsEmpty () && m_injected == 0) || m_stop;
   }
 
   return rc;
@@ -417,6 +427,77 @@ RealtimeSimulatorImpl::NextTs (void) const
   return ev.key.m_ts;
 }
 
+void
+RealtimeSimulatorImpl::Inject (uint32_t context, uint64_t ts, EventImpl *impl)
+{
+  NS_LOG_FUNCTION (this << context << ts << impl);
+
+  InjectedEvent *node = new InjectedEvent;
+  node->ev.impl = impl;
+  node->ev.key.m_ts = ts;
+  node->ev.key.m_context = context;
+  node->ev.key.m_uid = 0;
+
+  InjectedEvent *head;
+  do
+    {
+      head = m_injected;
+      node->next = head;
+    }
+  while (!__sync_bool_compare_and_swap (&m_injected, head, node));
+
+  //
+  // Only the first event of a batch wakes the simulation thread up; it
+  // will find the following ones in the queue.
+  //
+  if (head == 0)
+    {
+      m_synchronizer->Signal ();
+    }
+}
+
+void
+RealtimeSimulatorImpl::DrainInjected (void)
+{
+  InjectedEvent *head;
+  do
+    {
+      head = m_injected;
+      if (head == 0)
+        {
+          return;
+        }
+    }
+  while (!__sync_bool_compare_and_swap (&m_injected, head, (InjectedEvent *)0));
+
+  // Put the batch back in injection order to keep the uids in that order.
+  InjectedEvent *batch = 0;
+  while (head != 0)
+    {
+      InjectedEvent *next = head->next;
+      head->next = batch;
+      batch = head;
+      head = next;
+    }
+
+  while (batch != 0)
+    {
+      InjectedEvent *next = batch->next;
+      Scheduler::Event ev = batch->ev;
+      if (ev.key.m_ts < m_currentTs)
+        {
+          NS_LOG_LOGIC ("injected event at " << ev.key.m_ts << " moved to " << m_currentTs);
+          ev.key.m_ts = m_currentTs;
+        }
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+      delete batch;
+      batch = next;
+    }
+}
+
 void
 RealtimeSimulatorImpl::Run (void)
 {
@@ -442,6 +523,8 @@ RealtimeSimulatorImpl::Run (void)
       {
         CriticalSection cs (m_mutex);
 
+        m_synchronizer->SetCondition (false);
+        DrainInjected ();
         if (!m_events->IsEmpty ())
           {
             process = true;
@@ -543,6 +626,15 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
 {
   NS_LOG_FUNCTION (this << context << delay << impl);
 
+  if (!SystemThread::Equals (m_main) && m_running)
+    {
+      //
+      // The simulator is pacing, so we have a meaningful realtime clock.
+      //
+      Inject (context, m_synchronizer->GetCurrentRealtime () + delay.GetTimeStep (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
     uint64_t ts;
@@ -609,6 +701,12 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
 {
   NS_LOG_FUNCTION (this << context << time << impl);
 
+  if (!SystemThread::Equals (m_main) && m_running)
+    {
+      Inject (context, m_synchronizer->GetCurrentRealtime () + time.GetTimeStep (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
@@ -617,6 +715,7 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
     Scheduler::Event ev;
     ev.impl = impl;
     ev.key.m_ts = ts;
+    ev.key.m_context = context;
     ev.key.m_uid = m_uid;
     m_uid++;
     m_unscheduledEvents++;
@@ -636,6 +735,13 @@ void
 RealtimeSimulatorImpl::ScheduleRealtimeNowWithContext (uint32_t context, EventImpl *impl)
 {
   NS_LOG_FUNCTION (this << context << impl);
+
+  if (!SystemThread::Equals (m_main) && m_running)
+    {
+      Inject (context, m_synchronizer->GetCurrentRealtime (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
@@ -665,6 +771,37 @@ RealtimeSimulatorImpl::ScheduleRealtimeNow (EventImpl *impl)
   ScheduleRealtimeNowWithContext (GetContext (), impl);
 }
 
+uint64_t
+RealtimeSimulatorImpl::GetJitterSamples (void) const
+{
+  return m_jitterSamples;
+}
+
+Time
+RealtimeSimulatorImpl::GetMeanJitter (void) const
+{
+  if (m_jitterSamples == 0)
+    {
+      return TimeStep (0);
+    }
+  return TimeStep (m_jitterSum / m_jitterSamples);
+}
+
+Time
+RealtimeSimulatorImpl::GetMaxJitter (void) const
+{
+  return TimeStep (m_jitterMax);
+}
+
+void
+RealtimeSimulatorImpl::ResetJitterStatistics (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_jitterSamples = 0;
+  m_jitterSum = 0;
+  m_jitterMax = 0;
+}
+
 Time
 RealtimeSimulatorImpl::RealtimeNow (void) const
 {
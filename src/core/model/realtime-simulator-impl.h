@@ -154,6 +154,34 @@ public:
    */
   Time GetHardLimit (void) const;
 
+  /**
+   * \name Scheduling jitter statistics.
+   *
+   * The jitter of an event is the difference between the real time
+   * at which it starts and its simulation time.  These are only
+   * updated by the simulation thread, so they should be read
+   * while the simulator is stopped or from within an event.
+   */
+  /**@{*/
+  /**
+   * Get the number of events measured.
+   * \returns The number of jitter samples.
+   */
+  uint64_t GetJitterSamples (void) const;
+  /**
+   * Get the mean scheduling jitter.
+   * \returns The mean jitter, or zero if no event was measured.
+   */
+  Time GetMeanJitter (void) const;
+  /**
+   * Get the largest scheduling jitter.
+   * \returns The maximum jitter.
+   */
+  Time GetMaxJitter (void) const;
+  /** Reset the jitter statistics. */
+  void ResetJitterStatistics (void);
+  /**@}*/
+
 private:
   /**
    * Is the simulator running?
@@ -172,6 +200,23 @@ private:
   uint64_t NextTs (void) const;
   /** Process the next event. */
   void ProcessOneEvent (void);
+  /**
+   * Queue an event scheduled by a thread other than the simulation
+   * thread, without taking #m_mutex.
+   *
+   * The synchronizer is only signalled when the queue was empty: the
+   * simulation thread picks up everything queued since then at once.
+   *
+   * \param [in] context The event context.
+   * \param [in] ts The event timestamp.
+   * \param [in] impl The event.
+   */
+  void Inject (uint32_t context, uint64_t ts, EventImpl *impl);
+  /**
+   * Move the injected events into the event list.
+   * Should be called with #m_mutex locked.
+   */
+  void DrainInjected (void);
   /** Destructor implementation. */
   virtual void DoDispose (void);
 
@@ -218,6 +263,25 @@ private:
 
   /** Main SystemThread. */
   SystemThread::ThreadId m_main;
+
+  /** A node of the injected event queue. */
+  struct InjectedEvent
+  {
+    Scheduler::Event ev;  /**< The event, without its uid. */
+    InjectedEvent *next;  /**< The previously injected event. */
+  };
+  /**
+   * The events injected by other threads, most recent first.
+   * Pushed with a compare-and-swap, emptied by DrainInjected.
+   */
+  InjectedEvent * volatile m_injected;
+
+  /** Number of jitter samples. */
+  uint64_t m_jitterSamples;
+  /** Sum of the jitter samples, in time steps. */
+  uint64_t m_jitterSum;
+  /** Largest jitter sample, in time steps. */
+  uint64_t m_jitterMax;
 };
 
 } // namespace ns3
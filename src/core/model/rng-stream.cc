@@ -366,6 +366,45 @@ double RngStream::RandU01 ()
   return u;
 }
 
+void
+RngStream::RandU01 (double *u, std::size_t n)
+{
+  //
+  // The same recurrence as above, with the state held in integers for
+  // the whole batch.  The products fit in 64 bits, and adding m - s
+  // instead of subtracting s keeps them positive, so that the
+  // remainders by the constant moduli compile to multiplications.
+  // The double version computes the same remainders exactly, so the
+  // sequence is the same bit for bit.
+  //
+  const uint64_t im1 = 4294967087ULL;
+  const uint64_t im2 = 4294944443ULL;
+  uint64_t s0 = static_cast<uint64_t> (m_currentState[0]);
+  uint64_t s1 = static_cast<uint64_t> (m_currentState[1]);
+  uint64_t s2 = static_cast<uint64_t> (m_currentState[2]);
+  uint64_t s3 = static_cast<uint64_t> (m_currentState[3]);
+  uint64_t s4 = static_cast<uint64_t> (m_currentState[4]);
+  uint64_t s5 = static_cast<uint64_t> (m_currentState[5]);
+
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      uint64_t p1 = (1403580ULL * s1 + 810728ULL * (im1 - s0)) % im1;
+      uint64_t p2 = (527612ULL * s5 + 1370589ULL * (im2 - s3)) % im2;
+      s0 = s1; s1 = s2; s2 = p1;
+      s3 = s4; s4 = s5; s5 = p2;
+      double d1 = static_cast<double> (p1);
+      double d2 = static_cast<double> (p2);
+      u[i] = ((d1 > d2) ? (d1 - d2) * norm : (d1 - d2 + m1) * norm);
+    }
+
+  m_currentState[0] = static_cast<double> (s0);
+  m_currentState[1] = static_cast<double> (s1);
+  m_currentState[2] = static_cast<double> (s2);
+  m_currentState[3] = static_cast<double> (s3);
+  m_currentState[4] = static_cast<double> (s4);
+  m_currentState[5] = static_cast<double> (s5);
+}
+
 RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
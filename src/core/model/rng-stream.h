@@ -20,6 +20,7 @@
 #ifndef RNGSTREAM_H
 #define RNGSTREAM_H
 #include <string>
+#include <cstddef>
 #include <stdint.h>
 
 /**
@@ -70,6 +71,16 @@ public:
    * \returns The next random.
    */
   double RandU01 (void);
+  /**
+   * Generate the next \p n random numbers for this stream, in order.
+   *
+   * This produces exactly the values \p n calls to RandU01() would,
+   * at a lower cost per value.
+   *
+   * \param [out] u The buffer to fill.
+   * \param [in] n The number of values to generate.
+   */
+  void RandU01 (double *u, std::size_t n);
 
 private:
   /**
@@ -0,0 +1,339 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "simulator-profiler.h"
+#include "event-impl.h"
+#include "nstime.h"
+#include "log.h"
+
+#include <ctime>       // clock_gettime
+#include <sys/time.h>  // gettimeofday
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#if (__GNUC__ >= 3)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::SimulatorProfiler implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SimulatorProfiler");
+
+namespace {
+
+/**
+ * Read a monotonic clock.
+ * \returns The time, in ns.
+ */
+uint64_t
+ProfileClock (void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+#endif
+}
+
+/**
+ * Get the readable name of a type.
+ * \param [in] type The type.
+ * \returns The demangled name of \p type.
+ */
+std::string
+TypeName (const std::type_info *type)
+{
+  std::string name = type->name ();
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (name.c_str (), NULL, NULL, &status);
+  if (status == 0)
+    {
+      name = demangled;
+    }
+  std::free (demangled);
+#endif
+  return name;
+}
+
+/**
+ * Get the class of the member function an event calls.
+ *
+ * MakeEvent names its EventImpl after the function signature, so for
+ * a member function the name holds "(ns3::Class::*)".
+ *
+ * \param [in] name The demangled EventImpl type name.
+ * \returns The class name, or "functions" for other events.
+ */
+std::string
+TargetName (const std::string &name)
+{
+  std::string::size_type end = name.find ("::*)");
+  if (end == std::string::npos)
+    {
+      return "functions";
+    }
+  std::string::size_type start = name.rfind ('(', end);
+  if (start == std::string::npos)
+    {
+      return "functions";
+    }
+  return name.substr (start + 1, end - start - 1);
+}
+
+/**
+ * Sort report lines by decreasing time.
+ * \param [in] a The first line.
+ * \param [in] b The second line.
+ * \returns \c true if \p a goes first.
+ */
+bool
+CompareTime (const std::pair<std::string, uint64_t> &a, const std::pair<std::string, uint64_t> &b)
+{
+  return a.second > b.second;
+}
+
+/**
+ * An event list which measures the operations of another one.
+ */
+class ProfilingScheduler : public Scheduler
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] scheduler The measured event list.
+   * \param [in] stats Where to record the measurements.
+   */
+  ProfilingScheduler (Ptr<Scheduler> scheduler, SimulatorProfiler::SchedulerStats *stats)
+    : m_scheduler (scheduler),
+      m_stats (stats)
+  {
+  }
+
+  // Inherited from Scheduler
+  virtual void Insert (const Event &ev)
+  {
+    uint64_t start = ProfileClock ();
+    m_scheduler->Insert (ev);
+    m_stats->insertNs += ProfileClock () - start;
+    m_stats->inserts++;
+    m_stats->depth++;
+    m_stats->maxDepth = std::max (m_stats->maxDepth, m_stats->depth);
+  }
+  virtual bool IsEmpty (void) const
+  {
+    return m_scheduler->IsEmpty ();
+  }
+  virtual Event PeekNext (void) const
+  {
+    return m_scheduler->PeekNext ();
+  }
+  virtual Event RemoveNext (void)
+  {
+    uint64_t start = ProfileClock ();
+    Event ev = m_scheduler->RemoveNext ();
+    m_stats->removeNs += ProfileClock () - start;
+    m_stats->removes++;
+    m_stats->depth--;
+    return ev;
+  }
+  virtual void Remove (const Event &ev)
+  {
+    uint64_t start = ProfileClock ();
+    m_scheduler->Remove (ev);
+    m_stats->removeNs += ProfileClock () - start;
+    m_stats->removes++;
+    m_stats->depth--;
+  }
+
+private:
+  /** The measured event list. */
+  Ptr<Scheduler> m_scheduler;
+  /** The measurements. */
+  SimulatorProfiler::SchedulerStats *m_stats;
+};
+
+} // unnamed namespace
+
+SimulatorProfiler::SimulatorProfiler ()
+  : m_count (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_scheduler.inserts = 0;
+  m_scheduler.insertNs = 0;
+  m_scheduler.removes = 0;
+  m_scheduler.removeNs = 0;
+  m_scheduler.depth = 0;
+  m_scheduler.maxDepth = 0;
+}
+
+SimulatorProfiler::~SimulatorProfiler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ptr<Scheduler>
+SimulatorProfiler::Wrap (Ptr<Scheduler> scheduler)
+{
+  NS_LOG_FUNCTION (this << scheduler);
+  return CreateObject<ProfilingScheduler> (scheduler, &m_scheduler);
+}
+
+void
+SimulatorProfiler::Invoke (EventImpl *event, uint64_t ts)
+{
+  const std::type_info *type = event->IsCancelled () ? 0 : &typeid (*event);
+  uint64_t start = ProfileClock ();
+  event->Invoke ();
+  uint64_t ns = ProfileClock () - start;
+
+  std::map<const std::type_info *, EventStats>::iterator i = m_events.find (type);
+  if (i == m_events.end ())
+    {
+      EventStats stats;
+      stats.count = 0;
+      stats.ns = 0;
+      i = m_events.insert (std::make_pair (type, stats)).first;
+    }
+  i->second.count++;
+  i->second.ns += ns;
+
+  if (m_count % SAMPLE_PERIOD == 0)
+    {
+      m_depth.push_back (std::make_pair (ts, m_scheduler.depth));
+    }
+  m_count++;
+}
+
+uint64_t
+SimulatorProfiler::GetEventCount (void) const
+{
+  return m_count;
+}
+
+std::vector<SimulatorProfiler::Line>
+SimulatorProfiler::GetLines (void) const
+{
+  // Identical types may have several type_info in different libraries.
+  std::map<std::string, EventStats> merged;
+  for (std::map<const std::type_info *, EventStats>::const_iterator i = m_events.begin ();
+       i != m_events.end (); ++i)
+    {
+      std::string name = i->first == 0 ? "(cancelled)" : TypeName (i->first);
+      EventStats &stats = merged[name];
+      stats.count += i->second.count;
+      stats.ns += i->second.ns;
+    }
+
+  std::vector<std::pair<std::string, uint64_t> > order;
+  for (std::map<std::string, EventStats>::const_iterator i = merged.begin (); i != merged.end (); ++i)
+    {
+      order.push_back (std::make_pair (i->first, i->second.ns));
+    }
+  std::stable_sort (order.begin (), order.end (), CompareTime);
+
+  std::vector<Line> lines;
+  for (std::vector<std::pair<std::string, uint64_t> >::const_iterator i = order.begin ();
+       i != order.end (); ++i)
+    {
+      lines.push_back (Line (i->first, merged[i->first]));
+    }
+  return lines;
+}
+
+void
+SimulatorProfiler::Report (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Line> lines = GetLines ();
+  uint64_t total = 0;
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      total += i->second.ns;
+    }
+
+  os << "# events: " << m_count << ", time in events: " << total / 1000000.0 << " ms" << std::endl;
+  os << "# event list: " << m_scheduler.inserts << " inserts, "
+     << (m_scheduler.inserts ? m_scheduler.insertNs / m_scheduler.inserts : 0) << " ns each; "
+     << m_scheduler.removes << " removes, "
+     << (m_scheduler.removes ? m_scheduler.removeNs / m_scheduler.removes : 0) << " ns each; "
+     << "maximum depth " << m_scheduler.maxDepth << std::endl;
+  os << "#" << std::endl;
+  os << "# count total-ms mean-ns share-% target event" << std::endl;
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      os << i->second.count
+         << " " << i->second.ns / 1000000.0
+         << " " << i->second.ns / i->second.count
+         << " " << (total ? 100.0 * i->second.ns / total : 0.0)
+         << " " << TargetName (i->first)
+         << " " << i->first << std::endl;
+    }
+  os << "#" << std::endl;
+  os << "# time-s event-list-depth" << std::endl;
+  for (std::vector<std::pair<uint64_t, uint32_t> >::const_iterator i = m_depth.begin ();
+       i != m_depth.end (); ++i)
+    {
+      os << TimeStep (i->first).GetSeconds () << " " << i->second << std::endl;
+    }
+}
+
+void
+SimulatorProfiler::ReportFolded (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Line> lines = GetLines ();
+  for (std::vector<Line>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      os << TargetName (i->first) << ";" << i->first << " " << i->second.ns << std::endl;
+    }
+}
+
+void
+SimulatorProfiler::Write (const std::string &filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ofstream report (filename.c_str ());
+  if (!report.good ())
+    {
+      NS_LOG_WARN ("cannot write the event profile to " << filename);
+      return;
+    }
+  Report (report);
+  std::string folded = filename + ".folded";
+  std::ofstream flamegraph (folded.c_str ());
+  if (!flamegraph.good ())
+    {
+      NS_LOG_WARN ("cannot write the event flamegraph input to " << folded);
+      return;
+    }
+  ReportFolded (flamegraph);
+}
+
+} // namespace ns3
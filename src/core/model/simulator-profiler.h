@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SIMULATOR_PROFILER_H
+#define SIMULATOR_PROFILER_H
+
+#include "scheduler.h"
+#include "ptr.h"
+
+#include <map>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <typeinfo>
+#include <utility>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::SimulatorProfiler declaration.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup simulator
+ * \brief Attribute the cost of a simulation to the kinds of event run.
+ *
+ * Events are grouped by the C++ type of their EventImpl, that is by
+ * the signature of the function MakeEvent wrapped, which names the
+ * class of the member function for member events.  For each group the
+ * profiler counts the events and their cumulative wall-clock time.  It
+ * also measures the cost of the event list Insert and Remove
+ * operations, and samples the depth of the event list every
+ * SAMPLE_PERIOD events.
+ *
+ * The report lists the groups sorted by decreasing time.  The
+ * flamegraph input has one line per group, in the "collapsed stack"
+ * format of flamegraph.pl, with the member function class as the
+ * first frame so that the time is also summed per class.
+ *
+ * DefaultSimulatorImpl uses a profiler when its \c ProfileFile
+ * attribute is set.
+ */
+class SimulatorProfiler
+{
+public:
+  /** Number of events between two samples of the event list depth. */
+  static const uint32_t SAMPLE_PERIOD = 1024;
+
+  /** Constructor. */
+  SimulatorProfiler ();
+  /** Destructor. */
+  ~SimulatorProfiler ();
+
+  /**
+   * Measure the operations on an event list.
+   *
+   * \param [in] scheduler The event list.
+   * \returns An event list which forwards to \p scheduler.
+   */
+  Ptr<Scheduler> Wrap (Ptr<Scheduler> scheduler);
+
+  /**
+   * Invoke and measure an event.
+   *
+   * \param [in] event The event.
+   * \param [in] ts The event timestamp.
+   */
+  void Invoke (EventImpl *event, uint64_t ts);
+
+  /**
+   * Get the number of events measured.
+   * \returns The number of events.
+   */
+  uint64_t GetEventCount (void) const;
+
+  /**
+   * Print the report.
+   * \param [in,out] os The output stream.
+   */
+  void Report (std::ostream &os) const;
+  /**
+   * Print the flamegraph input.
+   * \param [in,out] os The output stream.
+   */
+  void ReportFolded (std::ostream &os) const;
+  /**
+   * Write the report to \p filename, and the flamegraph input to
+   * \p filename with a \c .folded suffix.
+   *
+   * \param [in] filename The report file name.
+   */
+  void Write (const std::string &filename) const;
+
+  /** Measurements of the event list operations. */
+  struct SchedulerStats
+  {
+    uint64_t inserts;   /**< Number of Insert calls. */
+    uint64_t insertNs;  /**< Time in Insert, in ns. */
+    uint64_t removes;   /**< Number of RemoveNext and Remove calls. */
+    uint64_t removeNs;  /**< Time in RemoveNext and Remove, in ns. */
+    uint32_t depth;     /**< Current number of events in the list. */
+    uint32_t maxDepth;  /**< Largest number of events in the list. */
+  };
+
+private:
+  /** Measurements of a group of events. */
+  struct EventStats
+  {
+    uint64_t count;  /**< Number of events. */
+    uint64_t ns;     /**< Time in the events, in ns. */
+  };
+  /** A report line: the group name and its measurements. */
+  typedef std::pair<std::string, EventStats> Line;
+
+  /**
+   * Merge the groups by name and sort them by decreasing time.
+   * \returns The report lines.
+   */
+  std::vector<Line> GetLines (void) const;
+
+  /**
+   * Event groups, by EventImpl type; cancelled events are under 0.
+   * \internal
+   * Types are few, so that the map stays small and hot.
+   */
+  std::map<const std::type_info *, EventStats> m_events;
+  /** Total number of events. */
+  uint64_t m_count;
+  /** Event list measurements. */
+  SchedulerStats m_scheduler;
+  /** Samples of the event list depth: timestamp and depth. */
+  std::vector<std::pair<uint64_t, uint32_t> > m_depth;
+};
+
+} // namespace ns3
+
+#endif /* SIMULATOR_PROFILER_H */
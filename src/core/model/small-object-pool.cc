@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "small-object-pool.h"
+#include "ns3/core-config.h"
+
+#include <new>
+#include <stdint.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::SmallObjectPool implementation.
+ */
+
+namespace ns3 {
+
+/** Granularity of the pooled sizes, in bytes. */
+static const std::size_t POOL_GRANULE = 16;
+/** Number of pooled size classes. */
+static const std::size_t POOL_CLASSES = 16;
+/**
+ * Maximum number of free blocks per size class and thread: a thread
+ * which releases the events other threads allocated, such as the
+ * simulation thread for the events injected by device reader threads,
+ * would otherwise keep all of them.
+ */
+static const uint32_t POOL_MAX_CACHED = 4096;
+/**
+ * Free lists of released blocks, by size class.  Each free block
+ * starts with a pointer to the next one.
+ */
+static __thread void *g_pool[POOL_CLASSES];
+/** Number of blocks in each free list. */
+static __thread uint32_t g_cached[POOL_CLASSES];
+
+#ifdef HAVE_PTHREAD_H
+/** Set once the free lists of the calling thread are released at its exit. */
+static __thread bool g_threadRegistered = false;
+/** The key whose destructor releases the free lists of a thread. */
+static pthread_key_t g_threadKey;
+/** Creates g_threadKey once. */
+static pthread_once_t g_threadKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Release the free lists of a thread when it exits.
+ * \param [in] value The value of g_threadKey, unused.
+ */
+static void
+ReleaseThread (void *value)
+{
+  g_threadRegistered = false;
+  SmallObjectPool::Purge ();
+}
+
+/** Create g_threadKey. */
+static void
+CreateThreadKey (void)
+{
+  pthread_key_create (&g_threadKey, &ReleaseThread);
+}
+
+/**
+ * Make sure the free lists of the calling thread are released when it
+ * exits; those of the main thread last as long as the program.
+ */
+static void
+RegisterThread (void)
+{
+  pthread_once (&g_threadKeyOnce, &CreateThreadKey);
+  pthread_setspecific (g_threadKey, &g_threadRegistered);
+  g_threadRegistered = true;
+}
+#endif /* HAVE_PTHREAD_H */
+
+void *
+SmallObjectPool::Allocate (std::size_t size)
+{
+  std::size_t sizeClass = (size - 1) / POOL_GRANULE;
+  if (sizeClass >= POOL_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  void *block = g_pool[sizeClass];
+  if (block != 0)
+    {
+      g_pool[sizeClass] = *static_cast<void **> (block);
+      g_cached[sizeClass]--;
+      return block;
+    }
+  return ::operator new ((sizeClass + 1) * POOL_GRANULE);
+}
+
+void
+SmallObjectPool::Release (void *p, std::size_t size)
+{
+  std::size_t sizeClass = (size - 1) / POOL_GRANULE;
+  if (sizeClass >= POOL_CLASSES || g_cached[sizeClass] >= POOL_MAX_CACHED)
+    {
+      ::operator delete (p);
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (!g_threadRegistered)
+    {
+      RegisterThread ();
+    }
+#endif
+  *static_cast<void **> (p) = g_pool[sizeClass];
+  g_pool[sizeClass] = p;
+  g_cached[sizeClass]++;
+}
+
+void
+SmallObjectPool::Purge (void)
+{
+  for (std::size_t i = 0; i < POOL_CLASSES; i++)
+    {
+      while (g_pool[i] != 0)
+        {
+          void *block = g_pool[i];
+          g_pool[i] = *static_cast<void **> (block);
+          ::operator delete (block);
+        }
+      g_cached[i] = 0;
+    }
+}
+
+} // namespace ns3
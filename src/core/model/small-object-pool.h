@@ -0,0 +1,67 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SMALL_OBJECT_POOL_H
+#define SMALL_OBJECT_POOL_H
+
+#include <cstddef>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::SmallObjectPool declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Recycle the memory of small objects allocated at a high rate.
+ *
+ * Events and callback implementations are allocated and released for
+ * almost every packet, and most of them have one of a few sizes.
+ * Released blocks are kept on per-thread free lists, one per 16-byte
+ * size class up to 256 bytes, and reused by the next allocation of the
+ * same size class.  Larger blocks use the global operator new.  Each
+ * list keeps a bounded number of blocks, and returns them to the system
+ * when its thread exits, or on Purge().
+ *
+ * The lists are per thread because the real-time and multithreaded
+ * simulators allocate from several threads; a block may be released by
+ * another thread than the one which allocated it.
+ *
+ * Classes use the pool through class-specific operator new and delete.
+ */
+class SmallObjectPool
+{
+public:
+  /**
+   * \param [in] size The size of the object.
+   * \returns The memory for the object.
+   */
+  static void * Allocate (std::size_t size);
+  /**
+   * \param [in] p The memory of the object, as returned by Allocate().
+   * \param [in] size The size of the object, as passed to Allocate().
+   */
+  static void Release (void *p, std::size_t size);
+  /** Return the free blocks of the calling thread to the system. */
+  static void Purge (void);
+};
+
+} // namespace ns3
+
+#endif /* SMALL_OBJECT_POOL_H */
@@ -21,7 +21,7 @@
 #ifndef TRACED_CALLBACK_H
 #define TRACED_CALLBACK_H
 
-#include <list>
+#include <vector>
 #include "callback.h"
 
 /**
@@ -46,6 +46,21 @@ namespace ns3 {
  * calling one of the \c operator() forms with the appropriate
  * number of arguments.
  *
+ * Most trace sources have no sink, or a single one: the first Callback
+ * of the chain is stored inline and the others in a vector, so that
+ * invoking an unconnected TracedCallback costs a single test.  When
+ * building the arguments of a trace is itself costly, the call site
+ * can skip it by checking IsEmpty() first:
+ *
+ * \code
+ *   if (!m_dropTrace.IsEmpty ())
+ *     {
+ *       Ipv4Header header;
+ *       packet->PeekHeader (header);
+ *       m_dropTrace (header, packet);
+ *     }
+ * \endcode
+ *
  * \tparam T1 \explicit Type of the first argument to the functor.
  * \tparam T2 \explicit Type of the second argument to the functor.
  * \tparam T3 \explicit Type of the third argument to the functor.
@@ -93,6 +108,12 @@ public:
    * \param [in] path Context path which was used to connect the Callback.
    */
   void Disconnect (const CallbackBase & callback, std::string path);
+  /**
+   * Check whether the chain is empty.
+   *
+   * \returns \c true if no Callback is connected.
+   */
+  bool IsEmpty (void) const;
   /**
    * \name Functors taking various numbers of arguments.
    *
@@ -234,9 +255,18 @@ private:
    * \tparam T7 \deduced Type of the seventh argument to the functor.
    * \tparam T8 \deduced Type of the eighth argument to the functor.
    */
-  typedef std::list<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
-  /** The chain of Callbacks. */
-  CallbackList m_callbackList;
+  typedef std::vector<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
+  /**
+   * Append a Callback to the chain.
+   *
+   * \param [in] cb The Callback.
+   */
+  void Append (const Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> &cb);
+
+  /** The first Callback of the chain, null if the chain is empty. */
+  Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> m_first;
+  /** The rest of the chain. */
+  CallbackList m_more;
 };
 
 } // namespace ns3
@@ -253,7 +283,8 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::TracedCallback ()
-  : m_callbackList () 
+  : m_first (),
+    m_more ()
 {
 }
 template<typename T1, typename T2,
@@ -266,7 +297,7 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::ConnectWithoutContext (const CallbackBa
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> cb;
   if (!cb.Assign (callback))
     NS_FATAL_ERROR_NO_MSG();
-  m_callbackList.push_back (cb);
+  Append (cb);
 }
 template<typename T1, typename T2,
          typename T3, typename T4,
@@ -279,7 +310,7 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Connect (const CallbackBase & callback,
   if (!cb.Assign (callback))
     NS_FATAL_ERROR ("when connecting to " << path);
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
-  m_callbackList.push_back (realCb);
+  Append (realCb);
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -288,18 +319,27 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DisconnectWithoutContext (const CallbackBase & callback)
 {
-  for (typename CallbackList::iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); /* empty */)
+  CallbackList kept;
+  if (!m_first.IsNull () && !m_first.IsEqual (callback))
     {
-      if ((*i).IsEqual (callback))
-        {
-          i = m_callbackList.erase (i);
-        }
-      else
+      kept.push_back (m_first);
+    }
+  for (typename CallbackList::const_iterator i = m_more.begin ();
+       i != m_more.end (); i++)
+    {
+      if (!(*i).IsEqual (callback))
         {
-          i++;
+          kept.push_back (*i);
         }
     }
+  m_more.clear ();
+  if (kept.empty ())
+    {
+      m_first.Nullify ();
+      return;
+    }
+  m_first = kept.front ();
+  m_more.assign (kept.begin () + 1, kept.end ());
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -314,6 +354,31 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Disconnect (const CallbackBase & callba
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
   DisconnectWithoutContext (realCb);
 }
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+bool
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::IsEmpty (void) const
+{
+  return m_first.IsNull ();
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+void
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Append (const Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> &cb)
+{
+  if (m_first.IsNull ())
+    {
+      m_first = cb;
+    }
+  else
+    {
+      m_more.push_back (cb);
+    }
+}
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
@@ -321,10 +386,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (void) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
     {
-      (*i)();
+      return;
+    }
+  m_first ();
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
+    {
+      m_more[i] ();
     }
 }
 template<typename T1, typename T2, 
@@ -334,10 +404,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
+    {
+      return;
+    }
+  m_first (a1);
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
     {
-      (*i)(a1);
+      m_more[i] (a1);
     }
 }
 template<typename T1, typename T2, 
@@ -347,10 +422,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
+    {
+      return;
+    }
+  m_first (a1, a2);
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
     {
-      (*i)(a1, a2);
+      m_more[i] (a1, a2);
     }
 }
 template<typename T1, typename T2, 
@@ -360,10 +440,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
     {
-      (*i)(a1, a2, a3);
+      return;
+    }
+  m_first (a1, a2, a3);
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
+    {
+      m_more[i] (a1, a2, a3);
     }
 }
 template<typename T1, typename T2, 
@@ -373,10 +458,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
+    {
+      return;
+    }
+  m_first (a1, a2, a3, a4);
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
     {
-      (*i)(a1, a2, a3, a4);
+      m_more[i] (a1, a2, a3, a4);
     }
 }
 template<typename T1, typename T2, 
@@ -386,10 +476,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
+    {
+      return;
+    }
+  m_first (a1, a2, a3, a4, a5);
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5);
+      m_more[i] (a1, a2, a3, a4, a5);
     }
 }
 template<typename T1, typename T2, 
@@ -399,10 +494,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
     {
-      (*i)(a1, a2, a3, a4, a5, a6);
+      return;
+    }
+  m_first (a1, a2, a3, a4, a5, a6);
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
+    {
+      m_more[i] (a1, a2, a3, a4, a5, a6);
     }
 }
 template<typename T1, typename T2, 
@@ -412,10 +512,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
+    {
+      return;
+    }
+  m_first (a1, a2, a3, a4, a5, a6, a7);
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7);
+      m_more[i] (a1, a2, a3, a4, a5, a6, a7);
     }
 }
 template<typename T1, typename T2, 
@@ -425,10 +530,15 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_first.IsNull ())
+    {
+      return;
+    }
+  m_first (a1, a2, a3, a4, a5, a6, a7, a8);
+  // by index: a sink may connect another one
+  for (typename CallbackList::size_type i = 0; i < m_more.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7, a8);
+      m_more[i] (a1, a2, a3, a4, a5, a6, a7, a8);
     }
 }
 
@@ -20,6 +20,7 @@
 #include <ctime>       // clock_t
 #include <sys/time.h>  // gettimeofday
                        // clock_getres: glibc < 2.17, link with librt
+#include <algorithm>   // std::max
 
 #include "log.h"
 #include "system-condition.h"
@@ -44,6 +45,12 @@ WallClockSynchronizer::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::WallClockSynchronizer")
     .SetParent<Synchronizer> ()
     .SetGroupName ("Core")
+    .AddAttribute ("SpinThreshold",
+                   "Delays shorter than this are busy-waited, and longer "
+                   "delays sleep until this much time is left.",
+                   TimeValue (MicroSeconds (100)),
+                   MakeTimeAccessor (&WallClockSynchronizer::m_spinThreshold),
+                   MakeTimeChecker (Time (0)))
   ;
   return tid;
 }
@@ -202,8 +209,6 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
 // If we want to be more accurate than a jiffy (we do) then we need to sleep
 // for some number of jiffies and then busy wait for any leftover time.
 //
-  uint64_t numberJiffies = ns / m_jiffy;
-  NS_LOG_INFO ("Synchronize numberJiffies = " << numberJiffies);
 //
 // This is where the real world interjects its very ugly head.  The code 
 // immediately below reflects the fact that a sleep is actually quite probably
@@ -216,27 +221,28 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
 // early (most of the time), then we can busy-wait until the requested
 // completion time actually comes around (most of the time).
 //
+// On modern kernels clock_getres () reports a one nanosecond resolution, so
+// three jiffies is no margin at all while the wakeup latency of a sleep is
+// still tens of microseconds.  The margin is therefore the larger of three
+// jiffies and the SpinThreshold attribute: shorter delays are spun away,
+// longer ones sleep until the margin is left and spin the rest.
+//
 // The tradeoff here is, of course, that the less time we spend sleeping, the
 // more accurately we will sync up; but the more CPU time we will spend busy
 // waiting (doing nothing).
 //
-// I'm not really sure about this number -- a boss of mine once said, "pick
-// a number and it'll be wrong."  But this works for now.
-//
-// \todo Hardcoded tunable parameter below.
-//
-  if (numberJiffies > 3)
+  uint64_t nsSpin = std::max (3 * m_jiffy, (uint64_t)m_spinThreshold.GetNanoSeconds ());
+  if (ns > nsSpin)
     {
-      NS_LOG_INFO ("SleepWait for " << numberJiffies * m_jiffy << " ns");
-      NS_LOG_INFO ("SleepWait until " << nsCurrent + numberJiffies * m_jiffy 
-                                      << " ns");
+      NS_LOG_INFO ("SleepWait for " << ns - nsSpin << " ns");
+      NS_LOG_INFO ("SleepWait until " << nsCurrent + ns - nsSpin << " ns");
 //
 // SleepWait is interruptible.  If it returns true it meant that the sleep
 // went until the end.  If it returns false, it means that the sleep was 
 // interrupted by a Signal.  In this case, we need to return and let the 
 // simulator re-evaluate what to do.
 //
-      if (SleepWait ((numberJiffies - 3) * m_jiffy) == false)
+      if (SleepWait (ns - nsSpin) == false)
         {
           NS_LOG_INFO ("SleepWait interrupted");
           return false;
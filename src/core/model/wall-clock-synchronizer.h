@@ -21,6 +21,7 @@
 
 #include "system-condition.h"
 #include "synchronizer.h"
+#include "nstime.h"
 
 /**
  * @file
@@ -57,6 +58,11 @@ namespace ns3 {
  * to use the function @c clock_nanosleep() to sleep until a simulation Time
  * specified by the caller. 
  *
+ * Since the wakeup latency of a sleep is much larger than the clock
+ * resolution, delays shorter than the @c SpinThreshold attribute are
+ * busy-waited, and longer delays sleep until that much time is left
+ * and busy-wait the rest.
+ *
  * @todo Add more on jiffies, sleep, processes, etc.
  *
  * @internal
@@ -188,6 +194,8 @@ protected:
 
   /** Size of the system clock tick, as reported by @c clock_getres, in ns. */
   uint64_t m_jiffy;
+  /** Delays shorter than this are busy-waited. */
+  Time m_spinThreshold;
   /** Time recorded by DoEventStart. */
   uint64_t m_nsEventStart;
 
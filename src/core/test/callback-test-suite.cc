@@ -688,6 +688,63 @@ MakeCallbackTemplatesTestCase::DoRun (void)
   that.CheckParentalRights ();
 }
 
+// ===========================================================================
+// Test the recycling of callback implementations
+// ===========================================================================
+class CallbackPoolTestCase : public TestCase
+{
+public:
+  CallbackPoolTestCase ();
+  virtual ~CallbackPoolTestCase () {}
+
+  void Target (int a) { m_sum += a; }
+
+  /** A bound argument larger than the pooled blocks. */
+  struct Large
+  {
+    int values[100];  //!< Payload
+    /**
+     * \param [in] o The other argument.
+     * \returns \c true if the arguments differ.
+     */
+    bool operator != (const Large &o) const { return values[0] != o.values[0]; }
+  };
+  static void LargeTarget (int *sum, Large large, int a) { *sum += large.values[99] + a; }
+
+private:
+  virtual void DoRun (void);
+
+  int m_sum;
+};
+
+CallbackPoolTestCase::CallbackPoolTestCase ()
+  : TestCase ("Check the recycling of callback implementations")
+{
+}
+
+void
+CallbackPoolTestCase::DoRun (void)
+{
+  m_sum = 0;
+  CallbackImplBase *first;
+  {
+    Callback<void, int> cb = MakeCallback (&CallbackPoolTestCase::Target, this);
+    first = PeekPointer (cb.GetImpl ());
+    cb (1);
+  }
+  Callback<void, int> cb = MakeCallback (&CallbackPoolTestCase::Target, this);
+  NS_TEST_ASSERT_MSG_EQ (PeekPointer (cb.GetImpl ()), first, "Released callback not recycled");
+  cb (2);
+  NS_TEST_ASSERT_MSG_EQ (m_sum, 3, "Recycled callback not invoked");
+
+  Large large;
+  large.values[0] = 0;
+  large.values[99] = 10;
+  Callback<void, int> big = MakeBoundCallback (&CallbackPoolTestCase::LargeTarget, &m_sum, large);
+  big (4);
+  NS_TEST_ASSERT_MSG_EQ (m_sum, 17, "Large callback not invoked");
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -705,6 +762,7 @@ CallbackTestSuite::CallbackTestSuite ()
   AddTestCase (new MakeBoundCallbackTestCase, TestCase::QUICK);
   AddTestCase (new NullifyCallbackTestCase, TestCase::QUICK);
   AddTestCase (new MakeCallbackTemplatesTestCase, TestCase::QUICK);
+  AddTestCase (new CallbackPoolTestCase, TestCase::QUICK);
 }
 
 static CallbackTestSuite CallbackTestSuite;
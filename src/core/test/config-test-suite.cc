@@ -721,6 +721,147 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// Test that a Config::Path reuses its matches until the cache is
+// invalidated.
+// ===========================================================================
+class PathCacheConfigTestCase : public TestCase
+{
+public:
+  PathCacheConfigTestCase ();
+  virtual ~PathCacheConfigTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+PathCacheConfigTestCase::PathCacheConfigTestCase ()
+  : TestCase ("Check the caching of the matches of a Config::Path")
+{
+}
+
+void
+PathCacheConfigTestCase::DoRun (void)
+{
+  IntegerValue iv;
+
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<DerivedConfigTestObject> b = CreateObject<DerivedConfigTestObject> ();
+  root->SetNodeB (b);
+  Ptr<ConfigTestObject> obj0 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> obj1 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> obj2 = CreateObject<ConfigTestObject> ();
+  b->AddNodeA (obj0);
+  b->AddNodeA (obj1);
+
+  Config::Path path ("/NodeB/NodesA/*/A");
+  NS_TEST_ASSERT_MSG_EQ (path.GetMatches ().GetN (), 2, "Unexpected number of matches");
+  NS_TEST_ASSERT_MSG_EQ (path.GetMatches ().GetMatchedPath (1), "/NodeB/NodesA/1/", "Unexpected matched path");
+
+  //
+  // Filling an object vector directly is not seen until the cache is
+  // invalidated.
+  //
+  b->AddNodeA (obj2);
+  NS_TEST_ASSERT_MSG_EQ (path.GetMatches ().GetN (), 2, "Matches were not cached");
+  Config::InvalidateCache ();
+  NS_TEST_ASSERT_MSG_EQ (path.GetMatches ().GetN (), 3, "Matches were not invalidated");
+
+  path.Set (IntegerValue (-5));
+  obj2->GetAttribute ("A", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), -5, "Object Attribute \"A\" not set through the path");
+
+  //
+  // Aggregation invalidates the cache by itself.
+  //
+  Config::Path derivedPath ("/NodeB/$DerivedConfigObject/X");
+  NS_TEST_ASSERT_MSG_EQ (derivedPath.GetMatches ().GetN (), 0, "Unexpected match");
+  Ptr<DerivedConfigObject> derived = CreateObject<DerivedConfigObject> ();
+  b->AggregateObject (derived);
+  NS_TEST_ASSERT_MSG_EQ (derivedPath.GetMatches ().GetN (), 1, "Aggregation did not invalidate the matches");
+  derivedPath.Set (IntegerValue (42));
+  derived->GetAttribute ("X", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 42, "Object Attribute \"X\" not set through the path");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
+// ===========================================================================
+// Test that a Config::ConnectBatch connects the same sinks as the
+// equivalent Config::Connect calls.
+// ===========================================================================
+class ConnectBatchConfigTestCase : public TestCase
+{
+public:
+  ConnectBatchConfigTestCase ();
+  virtual ~ConnectBatchConfigTestCase () {}
+
+  void Trace (int16_t oldValue, int16_t newValue) { m_count++; }
+  void TraceWithPath (std::string path, int16_t old, int16_t newValue) { m_paths.push_back (path); }
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_count;
+  std::vector<std::string> m_paths;
+};
+
+ConnectBatchConfigTestCase::ConnectBatchConfigTestCase ()
+  : TestCase ("Check batched trace connections")
+{
+}
+
+void
+ConnectBatchConfigTestCase::DoRun (void)
+{
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<ConfigTestObject> b = CreateObject<ConfigTestObject> ();
+  root->SetNodeB (b);
+  std::vector<Ptr<ConfigTestObject> > objects;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      objects.push_back (CreateObject<ConfigTestObject> ());
+      b->AddNodeA (objects[i]);
+    }
+
+  Config::ConnectBatch batch;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      std::ostringstream oss;
+      oss << "/NodeB/NodesA/" << i << "/Source";
+      batch.Connect (oss.str (), MakeCallback (&ConnectBatchConfigTestCase::TraceWithPath, this));
+    }
+  batch.ConnectWithoutContext ("/NodeB/NodesA/[1-2]/Source",
+                               MakeCallback (&ConnectBatchConfigTestCase::Trace, this));
+  batch.ConnectWithoutContext ("NodeB/NodesA/03/Source",
+                               MakeCallback (&ConnectBatchConfigTestCase::Trace, this));
+  NS_TEST_ASSERT_MSG_EQ (batch.GetN (), 6, "Unexpected number of pending connections");
+
+  //
+  // Nothing is connected before the commit.
+  //
+  m_count = 0;
+  objects[0]->SetAttribute ("Source", IntegerValue (-2));
+  NS_TEST_ASSERT_MSG_EQ (m_paths.size (), 0, "Trace connected before the commit");
+
+  batch.Commit ();
+  NS_TEST_ASSERT_MSG_EQ (batch.GetN (), 0, "Connections still pending after the commit");
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      m_paths.clear ();
+      objects[i]->SetAttribute ("Source", IntegerValue (-3));
+      std::ostringstream oss;
+      oss << "/NodeB/NodesA/" << i << "/Source";
+      NS_TEST_ASSERT_MSG_EQ (m_paths.size (), 1, "Trace " << i << " did not fire once");
+      NS_TEST_ASSERT_MSG_EQ (m_paths[0], oss.str (), "Trace " << i << " did not provide expected context");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_count, 3, "Traces without context did not fire as expected");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +878,8 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new PathCacheConfigTestCase, TestCase::QUICK);
+  AddTestCase (new ConnectBatchConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
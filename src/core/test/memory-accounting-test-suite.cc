@@ -0,0 +1,232 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "ns3/memory-accounting.h"
+#include "ns3/object.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/** An Object type to count. */
+class AccountedObject : public Object
+{
+public:
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::AccountedObject")
+      .SetParent<Object> ()
+      .SetGroupName ("Core")
+      .AddConstructor<AccountedObject> ()
+    ;
+    return tid;
+  }
+  /** Some payload, so that the type size stands out. */
+  uint8_t m_payload[100];
+};
+
+/** A derived type which is not registered with its size. */
+class UnsizedObject : public AccountedObject
+{
+public:
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::UnsizedObject")
+      .SetParent<AccountedObject> ()
+      .SetGroupName ("Core")
+    ;
+    return tid;
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED (AccountedObject);
+
+/** A Counter for the test. */
+MemoryAccounting::Counter g_testCounter ("test-counter");
+
+} // unnamed namespace
+
+/**
+ * Check the objects and bytes counted by MemoryAccounting.
+ */
+class MemoryAccountingTestCase : public TestCase
+{
+public:
+  MemoryAccountingTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Release the objects. */
+  void Release (void);
+  /** The counted objects. */
+  std::vector<Ptr<AccountedObject> > m_objects;
+};
+
+MemoryAccountingTestCase::MemoryAccountingTestCase ()
+  : TestCase ("Check the counts of objects and counters")
+{
+}
+
+void
+MemoryAccountingTestCase::Release (void)
+{
+  m_objects.clear ();
+}
+
+void
+MemoryAccountingTestCase::DoRun (void)
+{
+  MemoryAccounting::Enable ();
+
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      m_objects.push_back (CreateObject<AccountedObject> ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("ns3::AccountedObject"), 10, "Wrong object count");
+  int64_t bytes = 10 * sizeof (AccountedObject);
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetBytes ("ns3::AccountedObject"), bytes, "Wrong byte count");
+
+  // Types without a size are counted with the size of their parent.
+  Ptr<UnsizedObject> unsized = CreateObject<UnsizedObject> ();
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("ns3::UnsizedObject"), 1, "Wrong object count");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetBytes ("ns3::UnsizedObject"), (int64_t)sizeof (AccountedObject),
+                         "Wrong byte count");
+  unsized = 0;
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("ns3::UnsizedObject"), 0, "Object not released");
+
+  g_testCounter.Add (3, 300);
+  g_testCounter.Add (-1, -100);
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("test-counter"), 2, "Wrong counter objects");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetBytes ("test-counter"), 200, "Wrong counter bytes");
+
+  std::ostringstream line;
+  line << " 10 " << bytes << " ns3::AccountedObject\n";
+  std::ostringstream report;
+  MemoryAccounting::Report (report);
+  NS_TEST_EXPECT_MSG_NE (report.str ().find ("\n" + line.str ().substr (1)), std::string::npos,
+                         "No line for the objects in\n" << report.str ());
+  NS_TEST_EXPECT_MSG_NE (report.str ().find ("\n2 200 test-counter\n"), std::string::npos,
+                         "No line for the counter in\n" << report.str ());
+
+  // Sample at 0, 1 and 2 s; the objects are released at 1.5 s, and
+  // the sampling stops at 2 s, when no other event is left.
+  std::string filename = CreateTempDirFilename ("memory-accounting.txt");
+  MemoryAccounting::EnablePeriodicReport (filename, Seconds (1));
+  Simulator::Schedule (Seconds (1.5), &MemoryAccountingTestCase::Release, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::ifstream file (filename.c_str ());
+  std::ostringstream contents;
+  contents << file.rdbuf ();
+  std::string samples = contents.str ();
+  NS_TEST_EXPECT_MSG_NE (samples.find ("\n0" + line.str ()), std::string::npos, "No sample at 0 s in\n" << samples);
+  NS_TEST_EXPECT_MSG_NE (samples.find ("\n1" + line.str ()), std::string::npos, "No sample at 1 s in\n" << samples);
+  NS_TEST_EXPECT_MSG_EQ (samples.find ("\n2" + line.str ()), std::string::npos, "Released objects sampled in\n" << samples);
+  NS_TEST_EXPECT_MSG_NE (samples.find ("\n2 2 200 test-counter\n"), std::string::npos, "No sample at 2 s in\n" << samples);
+  NS_TEST_EXPECT_MSG_EQ (samples.find ("\n3 "), std::string::npos, "Sampling kept running in\n" << samples);
+
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("ns3::AccountedObject"), 0, "Objects not released");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetBytes ("ns3::AccountedObject"), 0, "Bytes not released");
+
+  g_testCounter.Add (-2, -200);
+  MemoryAccounting::Disable ();
+}
+
+/**
+ * Check that the counters stay exact when memory is allocated and
+ * released with accounting in different states, or by different
+ * threads.
+ */
+class MemoryAccountingCounterTestCase : public TestCase
+{
+public:
+  MemoryAccountingCounterTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Allocate from another thread. */
+  static void Allocate (void);
+};
+
+MemoryAccountingCounterTestCase::MemoryAccountingCounterTestCase ()
+  : TestCase ("Check that counters do not drift")
+{
+}
+
+void
+MemoryAccountingCounterTestCase::Allocate (void)
+{
+  g_testCounter.Add (5, 500);
+}
+
+void
+MemoryAccountingCounterTestCase::DoRun (void)
+{
+  // Allocated while disabled, released while enabled, and the other
+  // way around.
+  g_testCounter.Add (1, 10);
+  MemoryAccounting::Enable ();
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("test-counter"), 1, "Update lost while disabled");
+  g_testCounter.Add (-1, -10);
+  g_testCounter.Add (2, 20);
+  MemoryAccounting::Disable ();
+  g_testCounter.Add (-2, -20);
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("test-counter"), 0, "Counter objects drifted");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetBytes ("test-counter"), 0, "Counter bytes drifted");
+
+#ifdef HAVE_PTHREAD_H
+  // Allocated by threads which exited, released by this one; the
+  // second thread reuses the counts of the first.
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&MemoryAccountingCounterTestCase::Allocate));
+      thread->Start ();
+      thread->Join ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("test-counter"), 10, "Update of another thread lost");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetBytes ("test-counter"), 1000, "Update of another thread lost");
+  g_testCounter.Add (-10, -1000);
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("test-counter"), 0, "Counter objects drifted");
+#endif /* HAVE_PTHREAD_H */
+}
+
+class MemoryAccountingTestSuite : public TestSuite
+{
+public:
+  MemoryAccountingTestSuite ()
+    : TestSuite ("memory-accounting")
+  {
+    AddTestCase (new MemoryAccountingTestCase, TestCase::QUICK);
+    AddTestCase (new MemoryAccountingCounterTestCase, TestCase::QUICK);
+  }
+} g_memoryAccountingTestSuite;
@@ -0,0 +1,275 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Run a ring of contexts, each of them running local events and
+ * sending events to the next one, first with the default simulator
+ * and then with the multithreaded one, and check that every context
+ * sees the same events at the same times.
+ */
+class MultithreadedSimulatorRingTestCase : public TestCase
+{
+public:
+  /**
+   * \param [in] partitions The number of partitions to split the ring in.
+   */
+  MultithreadedSimulatorRingTestCase (uint32_t partitions);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Run the scenario with the current simulator implementation.
+   * \return The log of each context.
+   */
+  std::vector<std::string> RunRing (void);
+  /**
+   * A local event.
+   * \param [in] context The context running the event.
+   * \param [in] k The event number.
+   */
+  void Local (uint32_t context, uint32_t k);
+  /**
+   * An event sent by the previous context.
+   * \param [in] from The sending context.
+   * \param [in] k The number of the sending event.
+   */
+  void Remote (uint32_t from, uint32_t k);
+
+  /** The number of partitions. */
+  uint32_t m_partitions;
+  /** The per-context logs; each one is only touched by its partition. */
+  std::vector<std::ostringstream *> m_logs;
+
+  /** The number of contexts in the ring. */
+  static const uint32_t CONTEXTS = 8;
+};
+
+MultithreadedSimulatorRingTestCase::MultithreadedSimulatorRingTestCase (uint32_t partitions)
+  : TestCase ("Check a ring of contexts split in partitions"),
+    m_partitions (partitions)
+{
+}
+
+void
+MultithreadedSimulatorRingTestCase::Local (uint32_t context, uint32_t k)
+{
+  *m_logs[context] << "L" << k << "@" << Simulator::Now ().GetMicroSeconds ()
+                   << "/" << Simulator::GetContext () << " ";
+  if (k < 50)
+    {
+      Simulator::Schedule (MicroSeconds (100),
+                           &MultithreadedSimulatorRingTestCase::Local, this, context, k + 1);
+    }
+  if (k % 5 == 0)
+    {
+      // offset so that remote events never tie with local ones
+      Simulator::ScheduleWithContext ((context + 1) % CONTEXTS, MicroSeconds (1050),
+                                      &MultithreadedSimulatorRingTestCase::Remote, this, context, k);
+    }
+}
+
+void
+MultithreadedSimulatorRingTestCase::Remote (uint32_t from, uint32_t k)
+{
+  uint32_t context = Simulator::GetContext ();
+  *m_logs[context] << "R" << from << "." << k << "@"
+                   << Simulator::Now ().GetMicroSeconds () << " ";
+}
+
+std::vector<std::string>
+MultithreadedSimulatorRingTestCase::RunRing (void)
+{
+  for (uint32_t c = 0; c < CONTEXTS; c++)
+    {
+      m_logs.push_back (new std::ostringstream);
+      Simulator::ScheduleWithContext (c, MicroSeconds (c),
+                                      &MultithreadedSimulatorRingTestCase::Local, this, c, 0);
+    }
+  Simulator::Run ();
+  std::vector<std::string> logs;
+  for (uint32_t c = 0; c < CONTEXTS; c++)
+    {
+      logs.push_back (m_logs[c]->str ());
+      delete m_logs[c];
+    }
+  m_logs.clear ();
+  Simulator::Destroy ();
+  return logs;
+}
+
+void
+MultithreadedSimulatorRingTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  std::vector<std::string> expected = RunRing ();
+
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Ptr<MultithreadedSimulatorImpl> impl =
+    DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Unexpected simulator implementation");
+  for (uint32_t c = 0; c < CONTEXTS; c++)
+    {
+      impl->SetPartition (c, c % m_partitions);
+    }
+  impl->SetLookAhead (MilliSeconds (1));
+  NS_TEST_ASSERT_MSG_EQ (impl->GetPartitionCount (), m_partitions, "Wrong number of partitions");
+  impl = 0;
+  std::vector<std::string> logs = RunRing ();
+
+  for (uint32_t c = 0; c < CONTEXTS; c++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (logs[c], expected[c], "Context " << c << " diverged");
+    }
+}
+
+void
+MultithreadedSimulatorRingTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+/**
+ * Check Stop, and the handling of the events scheduled before Run.
+ */
+class MultithreadedSimulatorStopTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorStopTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Count an event.
+   * \param [in] index The counter of the partition running the event.
+   */
+  void Tick (uint32_t index);
+  /**
+   * Call Stop from an event.
+   * \param [in] delay The delay passed to Stop.
+   */
+  void DoStop (Time delay);
+
+  /** One counter per context. */
+  uint32_t m_ticks[2];
+};
+
+MultithreadedSimulatorStopTestCase::MultithreadedSimulatorStopTestCase ()
+  : TestCase ("Check Stop and events scheduled before Run")
+{
+}
+
+void
+MultithreadedSimulatorStopTestCase::Tick (uint32_t index)
+{
+  m_ticks[index]++;
+  Simulator::Schedule (MilliSeconds (1), &MultithreadedSimulatorStopTestCase::Tick, this, index);
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoStop (Time delay)
+{
+  Simulator::Stop (delay);
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Ptr<MultithreadedSimulatorImpl> impl =
+    DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Unexpected simulator implementation");
+  impl->SetPartition (0, 0);
+  impl->SetPartition (1, 1);
+  impl->SetLookAhead (MilliSeconds (10));
+  impl = 0;
+
+  m_ticks[0] = 0;
+  m_ticks[1] = 0;
+  Simulator::ScheduleWithContext (0, Seconds (0), &MultithreadedSimulatorStopTestCase::Tick, this, 0);
+  Simulator::ScheduleWithContext (1, Seconds (0), &MultithreadedSimulatorStopTestCase::Tick, this, 1);
+  EventId cancelled = Simulator::Schedule (Seconds (1), &MultithreadedSimulatorStopTestCase::Tick, this, 0);
+  EventId removed = Simulator::Schedule (Seconds (1), &MultithreadedSimulatorStopTestCase::Tick, this, 0);
+  NS_TEST_EXPECT_MSG_EQ (cancelled.IsExpired (), false, "Pending event reported as expired");
+  Simulator::Cancel (cancelled);
+  Simulator::Remove (removed);
+  NS_TEST_EXPECT_MSG_EQ (cancelled.IsExpired (), true, "Cancelled event not reported as expired");
+  NS_TEST_EXPECT_MSG_EQ (removed.IsExpired (), true, "Removed event not reported as expired");
+
+  // Both partitions run the events before the stop time, and no other.
+  Simulator::Stop (MilliSeconds (100) + MicroSeconds (500));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_ticks[0], 101, "Partition 0 did not stop at the right time");
+  NS_TEST_EXPECT_MSG_EQ (m_ticks[1], 101, "Partition 1 did not stop at the right time");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsFinished (), true, "Simulation not stopped");
+
+  // Running again resumes where the partitions stopped; the stop time
+  // is relative to the last event run.
+  Simulator::Stop (MilliSeconds (50));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_ticks[0], 150, "Partition 0 did not resume");
+  NS_TEST_EXPECT_MSG_EQ (m_ticks[1], 150, "Partition 1 did not resume");
+
+  // A stop time beyond the window of the calling event applies to all
+  // the partitions: the event runs at 149 ms and stops both at 179 ms.
+  Simulator::ScheduleWithContext (1, Seconds (0), &MultithreadedSimulatorStopTestCase::DoStop,
+                                  this, MilliSeconds (30));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_ticks[0], 179, "Partition 0 did not stop at the time set by partition 1");
+  NS_TEST_EXPECT_MSG_EQ (m_ticks[1], 179, "Partition 1 did not stop at the time it set");
+
+  // A stop time within the window stops the calling partition at that
+  // time, 178.5 ms, and the other partitions at the end of the window
+  // starting at 178 ms.
+  Simulator::ScheduleWithContext (1, Seconds (0), &MultithreadedSimulatorStopTestCase::DoStop,
+                                  this, MicroSeconds (500));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_ticks[0], 188, "Partition 0 did not complete the window");
+  NS_TEST_EXPECT_MSG_EQ (m_ticks[1], 179, "Partition 1 did not stop at the time it set");
+  Simulator::Destroy ();
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    AddTestCase (new MultithreadedSimulatorRingTestCase (1), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorRingTestCase (2), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorRingTestCase (4), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorStopTestCase, TestCase::QUICK);
+  }
+} g_multithreadedSimulatorTestSuite;
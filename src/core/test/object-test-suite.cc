@@ -359,6 +359,69 @@ AggregateObjectTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
 }
 
+// ===========================================================================
+// Test case to make sure that cached aggregate lookups stay consistent
+// when the aggregation changes.
+// ===========================================================================
+class AggregateLookupCacheTestCase : public TestCase
+{
+public:
+  AggregateLookupCacheTestCase ();
+  virtual ~AggregateLookupCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AggregateLookupCacheTestCase::AggregateLookupCacheTestCase ()
+  : TestCase ("Check cached GetObject results across aggregation")
+{
+}
+
+AggregateLookupCacheTestCase::~AggregateLookupCacheTestCase ()
+{
+}
+
+void
+AggregateLookupCacheTestCase::DoRun (void)
+{
+  Ptr<BaseA> baseA = CreateObject<BaseA> ();
+
+  //
+  // A failed lookup must not be remembered once the missing type is
+  // aggregated.
+  //
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), 0, "Unexpectedly found a BaseB through baseA");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), 0, "Unexpectedly found a BaseB through baseA");
+
+  Ptr<DerivedB> derivedB = CreateObject<DerivedB> ();
+  baseA->AggregateObject (derivedB);
+
+  //
+  // Repeated lookups, by exact and by parent type, must keep returning
+  // the aggregated object.
+  //
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), derivedB, "Wrong BaseB through baseA");
+      NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<DerivedB> (), derivedB, "Wrong DerivedB through baseA");
+      NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), baseA, "Wrong BaseA through derivedB");
+      NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<DerivedA> (), 0, "Unexpectedly found a DerivedA through derivedB");
+    }
+
+  //
+  // Aggregating an object must make it visible from an object whose
+  // failed lookup of its type was cached.
+  //
+  Ptr<DerivedA> derivedA = CreateObject<DerivedA> ();
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseA> (), derivedA, "Wrong BaseA through derivedA");
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseB> (), 0, "Unexpectedly found a BaseB through derivedA");
+  Ptr<BaseB> b = CreateObject<BaseB> ();
+  derivedA->AggregateObject (b);
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseB> (), b, "Wrong BaseB through derivedA after aggregation");
+  NS_TEST_ASSERT_MSG_EQ (b->GetObject<BaseA> (), derivedA, "Wrong BaseA through b after aggregation");
+}
+
 // ===========================================================================
 // Test case to make sure that an Object factory can create Objects
 // ===========================================================================
@@ -445,6 +508,7 @@ ObjectTestSuite::ObjectTestSuite ()
 {
   AddTestCase (new CreateObjectTestCase, TestCase::QUICK);
   AddTestCase (new AggregateObjectTestCase, TestCase::QUICK);
+  AddTestCase (new AggregateLookupCacheTestCase, TestCase::QUICK);
   AddTestCase (new ObjectFactoryTestCase, TestCase::QUICK);
 }
 
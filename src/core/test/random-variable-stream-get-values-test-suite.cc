@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/random-variable-stream.h"
+#include <string>
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case for the bulk generation of values
+// ===========================================================================
+class RandomVariableStreamBatchTestCase : public TestCase
+{
+public:
+  RandomVariableStreamBatchTestCase ();
+  virtual ~RandomVariableStreamBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check that GetValues returns the same sequence as GetValue on
+   * two streams with the same stream number.
+   *
+   * \param [in] scalar The stream read one value at a time.
+   * \param [in] batch The stream read in batches.
+   * \param [in] name The distribution name.
+   */
+  void Compare (Ptr<RandomVariableStream> scalar, Ptr<RandomVariableStream> batch, std::string name);
+};
+
+RandomVariableStreamBatchTestCase::RandomVariableStreamBatchTestCase ()
+  : TestCase ("Bulk generation matches the scalar sequence")
+{
+}
+
+RandomVariableStreamBatchTestCase::~RandomVariableStreamBatchTestCase ()
+{
+}
+
+void
+RandomVariableStreamBatchTestCase::Compare (Ptr<RandomVariableStream> scalar, Ptr<RandomVariableStream> batch, std::string name)
+{
+  scalar->SetStream (7);
+  batch->SetStream (7);
+
+  // Batches of varied sizes, with single draws in between.
+  uint32_t sizes[] = { 1, 2, 3, 7, 64, 65, 129, 1000 };
+  double values[1000];
+  for (uint32_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); ++i)
+    {
+      batch->GetValues (values, sizes[i]);
+      for (uint32_t j = 0; j < sizes[i]; ++j)
+        {
+          NS_TEST_ASSERT_MSG_EQ (values[j], scalar->GetValue (), name << ": batch of " << sizes[i] << " differs at " << j);
+        }
+      NS_TEST_ASSERT_MSG_EQ (batch->GetValue (), scalar->GetValue (), name << ": stream out of step after a batch of " << sizes[i]);
+    }
+}
+
+void
+RandomVariableStreamBatchTestCase::DoRun (void)
+{
+  for (uint32_t antithetic = 0; antithetic < 2; ++antithetic)
+    {
+      Ptr<UniformRandomVariable> u1 = CreateObject<UniformRandomVariable> ();
+      Ptr<UniformRandomVariable> u2 = CreateObject<UniformRandomVariable> ();
+      u1->SetAttribute ("Min", DoubleValue (-3.0));
+      u2->SetAttribute ("Min", DoubleValue (-3.0));
+      u1->SetAttribute ("Antithetic", BooleanValue (antithetic));
+      u2->SetAttribute ("Antithetic", BooleanValue (antithetic));
+      Compare (u1, u2, "uniform");
+
+      Ptr<ExponentialRandomVariable> e1 = CreateObject<ExponentialRandomVariable> ();
+      Ptr<ExponentialRandomVariable> e2 = CreateObject<ExponentialRandomVariable> ();
+      e1->SetAttribute ("Antithetic", BooleanValue (antithetic));
+      e2->SetAttribute ("Antithetic", BooleanValue (antithetic));
+      Compare (e1, e2, "exponential");
+      // A tight bound rejects about half of the values.
+      e1->SetAttribute ("Bound", DoubleValue (0.7));
+      e2->SetAttribute ("Bound", DoubleValue (0.7));
+      Compare (e1, e2, "bounded exponential");
+
+      Ptr<NormalRandomVariable> n1 = CreateObject<NormalRandomVariable> ();
+      Ptr<NormalRandomVariable> n2 = CreateObject<NormalRandomVariable> ();
+      n1->SetAttribute ("Antithetic", BooleanValue (antithetic));
+      n2->SetAttribute ("Antithetic", BooleanValue (antithetic));
+      n1->SetAttribute ("Variance", DoubleValue (4.0));
+      n2->SetAttribute ("Variance", DoubleValue (4.0));
+      Compare (n1, n2, "normal");
+      n1->SetAttribute ("Bound", DoubleValue (1.0));
+      n2->SetAttribute ("Bound", DoubleValue (1.0));
+      Compare (n1, n2, "bounded normal");
+
+      // Falls back to GetValue.
+      Ptr<ParetoRandomVariable> p1 = CreateObject<ParetoRandomVariable> ();
+      Ptr<ParetoRandomVariable> p2 = CreateObject<ParetoRandomVariable> ();
+      p1->SetAttribute ("Antithetic", BooleanValue (antithetic));
+      p2->SetAttribute ("Antithetic", BooleanValue (antithetic));
+      Compare (p1, p2, "pareto");
+    }
+}
+
+class RandomVariableStreamGetValuesTestSuite : public TestSuite
+{
+public:
+  RandomVariableStreamGetValuesTestSuite ();
+};
+
+RandomVariableStreamGetValuesTestSuite::RandomVariableStreamGetValuesTestSuite ()
+  : TestSuite ("random-variable-stream-get-values", UNIT)
+{
+  AddTestCase (new RandomVariableStreamBatchTestCase, TestCase::QUICK);
+}
+
+static RandomVariableStreamGetValuesTestSuite randomVariableStreamGetValuesTestSuite;
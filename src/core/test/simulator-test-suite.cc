@@ -21,8 +21,14 @@
 #include "ns3/simulator.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+
+#include <fstream>
+#include <sstream>
 
 using namespace ns3;
 
@@ -459,6 +465,75 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SimulatorProfilerTestCase : public TestCase
+{
+public:
+  SimulatorProfilerTestCase ();
+  void Event (void);
+  static void Function (void);
+private:
+  virtual void DoRun (void);
+  /**
+   * Read a whole file.
+   * \param [in] filename The file name.
+   * \returns The file contents.
+   */
+  std::string Read (std::string filename);
+};
+
+SimulatorProfilerTestCase::SimulatorProfilerTestCase ()
+  : TestCase ("Check the event profile of DefaultSimulatorImpl")
+{
+}
+
+void
+SimulatorProfilerTestCase::Event (void)
+{
+}
+
+void
+SimulatorProfilerTestCase::Function (void)
+{
+}
+
+std::string
+SimulatorProfilerTestCase::Read (std::string filename)
+{
+  std::ifstream file (filename.c_str ());
+  std::ostringstream contents;
+  contents << file.rdbuf ();
+  return contents.str ();
+}
+
+void
+SimulatorProfilerTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("simulator-profile.txt");
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileFile", StringValue (filename));
+
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Simulator::Schedule (Seconds (i), &SimulatorProfilerTestCase::Event, this);
+    }
+  Simulator::Schedule (Seconds (1), &SimulatorProfilerTestCase::Function);
+  EventId cancelled = Simulator::Schedule (Seconds (2), &SimulatorProfilerTestCase::Function);
+  Simulator::Cancel (cancelled);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileFile", StringValue (""));
+
+  std::string report = Read (filename);
+  NS_TEST_EXPECT_MSG_NE (report.find ("# events: 5,"), std::string::npos, "Wrong event count in\n" << report);
+  NS_TEST_EXPECT_MSG_NE (report.find ("\n3 "), std::string::npos, "No line for the three member events in\n" << report);
+  NS_TEST_EXPECT_MSG_NE (report.find (" SimulatorProfilerTestCase "), std::string::npos, "Member events not attributed to their class in\n" << report);
+  NS_TEST_EXPECT_MSG_NE (report.find (" (cancelled)"), std::string::npos, "No line for the cancelled event in\n" << report);
+
+  std::string folded = Read (filename + ".folded");
+  NS_TEST_EXPECT_MSG_NE (folded.find ("SimulatorProfilerTestCase;"), std::string::npos, "Bad flamegraph input\n" << folded);
+  NS_TEST_EXPECT_MSG_NE (folded.find ("functions;"), std::string::npos, "Bad flamegraph input\n" << folded);
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +550,8 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorProfilerTestCase, TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -26,6 +26,9 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#ifdef HAVE_RT
+#include "ns3/realtime-simulator-impl.h"
+#endif
 
 #include <ctime>
 #include <list>
@@ -225,6 +228,119 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+#ifdef HAVE_RT
+/**
+ * Several threads schedule events on a running RealtimeSimulatorImpl:
+ * they must all run, in their context, and be accounted for in the
+ * jitter statistics.
+ */
+class RealtimeInjectionTestCase : public TestCase
+{
+public:
+  RealtimeInjectionTestCase ();
+  void Receive (uint32_t threadno);
+  void Poll (void);
+  static void InjectingThread (std::pair<RealtimeInjectionTestCase *, uint32_t> context);
+  uint32_t m_received;
+  uint32_t m_badContext;
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+/** Number of injecting threads. */
+static const uint32_t INJECTION_THREADS = 4;
+/** Number of events injected by each thread. */
+static const uint32_t INJECTION_EVENTS = 1000;
+
+RealtimeInjectionTestCase::RealtimeInjectionTestCase ()
+  : TestCase ("Check that events scheduled by other threads are run by RealtimeSimulatorImpl")
+{
+}
+
+void
+RealtimeInjectionTestCase::InjectingThread (std::pair<RealtimeInjectionTestCase *, uint32_t> context)
+{
+  for (uint32_t i = 0; i < INJECTION_EVENTS; ++i)
+    {
+      Simulator::ScheduleWithContext (context.second, MicroSeconds (i % 3),
+                                      &RealtimeInjectionTestCase::Receive, context.first, context.second);
+      if (i % 10 == 0)
+        {
+          struct timespec ts;
+          ts.tv_sec = 0;
+          ts.tv_nsec = 1000;
+          nanosleep (&ts, NULL);
+        }
+    }
+}
+
+void
+RealtimeInjectionTestCase::Receive (uint32_t threadno)
+{
+  if (Simulator::GetContext () != threadno)
+    {
+      m_badContext++;
+    }
+  m_received++;
+}
+
+void
+RealtimeInjectionTestCase::Poll (void)
+{
+  if (m_received == INJECTION_THREADS * INJECTION_EVENTS || Simulator::Now () > Seconds (10))
+    {
+      Simulator::Stop ();
+      return;
+    }
+  Simulator::Schedule (MilliSeconds (1), &RealtimeInjectionTestCase::Poll, this);
+}
+
+void
+RealtimeInjectionTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+  m_received = 0;
+  m_badContext = 0;
+
+  std::list<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < INJECTION_THREADS; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (
+        &RealtimeInjectionTestCase::InjectingThread,
+        std::pair<RealtimeInjectionTestCase *, uint32_t> (this, i))));
+    }
+
+  Simulator::Schedule (MilliSeconds (1), &RealtimeInjectionTestCase::Poll, this);
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Start ();
+    }
+  Simulator::Run ();
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+
+  Ptr<RealtimeSimulatorImpl> impl = DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Not running a RealtimeSimulatorImpl");
+  NS_TEST_EXPECT_MSG_EQ (m_received, INJECTION_THREADS * INJECTION_EVENTS, "Lost injected events");
+  NS_TEST_EXPECT_MSG_EQ (m_badContext, 0, "Injected events run in the wrong context");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (impl->GetJitterSamples (), m_received, "Events missing from the jitter statistics");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (impl->GetMaxJitter (), impl->GetMeanJitter (), "Maximum jitter below the mean");
+  impl->ResetJitterStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (impl->GetJitterSamples (), 0, "Jitter statistics not reset");
+  Simulator::Destroy ();
+}
+
+void
+RealtimeInjectionTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+#endif /* HAVE_RT */
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -262,5 +378,8 @@ public:
               }
           }
       }
+#ifdef HAVE_RT
+    AddTestCase (new RealtimeInjectionTestCase, TestCase::QUICK);
+#endif
   }
 } g_threadedSimulatorTestSuite;
@@ -19,6 +19,8 @@
 #include "ns3/test.h"
 #include "ns3/traced-callback.h"
 
+#include <string>
+
 using namespace ns3;
 
 class BasicTracedCallbackTestCase : public TestCase
@@ -108,6 +110,83 @@ BasicTracedCallbackTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_two, true, "Callback CbTwo not called");
 }
 
+class ChainTracedCallbackTestCase : public TestCase
+{
+public:
+  ChainTracedCallbackTestCase ();
+  virtual ~ChainTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  static void Record (std::string *record, char c, uint32_t v);
+  void ConnectMore (uint32_t v);
+
+  std::string m_record;
+  TracedCallback<uint32_t> m_trace;
+};
+
+ChainTracedCallbackTestCase::ChainTracedCallbackTestCase ()
+  : TestCase ("Check the order and emptiness of a TracedCallback chain")
+{
+}
+
+void
+ChainTracedCallbackTestCase::Record (std::string *record, char c, uint32_t v)
+{
+  *record += c;
+}
+
+void
+ChainTracedCallbackTestCase::ConnectMore (uint32_t v)
+{
+  m_record += 'm';
+  m_trace.ConnectWithoutContext (MakeBoundCallback (&ChainTracedCallbackTestCase::Record, &m_record, 'x'));
+}
+
+void
+ChainTracedCallbackTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), true, "New TracedCallback not empty");
+  m_trace (0);
+
+  Callback<void, uint32_t> a = MakeBoundCallback (&ChainTracedCallbackTestCase::Record, &m_record, 'a');
+  Callback<void, uint32_t> b = MakeBoundCallback (&ChainTracedCallbackTestCase::Record, &m_record, 'b');
+  Callback<void, uint32_t> c = MakeBoundCallback (&ChainTracedCallbackTestCase::Record, &m_record, 'c');
+  m_trace.ConnectWithoutContext (a);
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), false, "Connected TracedCallback empty");
+  m_trace.ConnectWithoutContext (b);
+  m_trace.ConnectWithoutContext (c);
+  m_trace.ConnectWithoutContext (a);
+  m_record = "";
+  m_trace (0);
+  NS_TEST_ASSERT_MSG_EQ (m_record, "abca", "Callbacks not called in connection order");
+
+  //
+  // Removing the first callback removes all its copies and keeps the
+  // order of the others.
+  //
+  m_trace.DisconnectWithoutContext (a);
+  m_record = "";
+  m_trace (0);
+  NS_TEST_ASSERT_MSG_EQ (m_record, "bc", "Unexpected chain after removing the first callback");
+
+  m_trace.DisconnectWithoutContext (c);
+  m_trace.DisconnectWithoutContext (b);
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), true, "Emptied TracedCallback not empty");
+  m_record = "";
+  m_trace (0);
+  NS_TEST_ASSERT_MSG_EQ (m_record, "", "Callback of an empty chain called");
+
+  //
+  // A callback may connect more callbacks while the chain runs.
+  //
+  m_trace.ConnectWithoutContext (MakeCallback (&ChainTracedCallbackTestCase::ConnectMore, this));
+  m_trace.ConnectWithoutContext (b);
+  m_trace (0);
+  NS_TEST_ASSERT_MSG_EQ (m_record, "mbx", "Callback connected while running not called");
+}
+
 class TracedCallbackTestSuite : public TestSuite
 {
 public:
@@ -118,6 +197,7 @@ TracedCallbackTestSuite::TracedCallbackTestSuite ()
   : TestSuite ("traced-callback", UNIT)
 {
   AddTestCase (new BasicTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new ChainTracedCallbackTestCase, TestCase::QUICK);
 }
 
 static TracedCallbackTestSuite tracedCallbackTestSuite;
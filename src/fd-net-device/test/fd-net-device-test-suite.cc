@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/system-thread.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/mac48-address.h"
+#include "ns3/fd-net-device.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+using namespace ns3;
+
+/**
+ * \ingroup fd-net-device
+ * \defgroup fd-net-device-test FdNetDevice module tests
+ */
+
+/**
+ * \ingroup fd-net-device-test
+ * \ingroup tests
+ *
+ * A thread writes Ethernet frames to the far end of a socket pair while
+ * a FdNetDevice reads the near end under RealtimeSimulatorImpl: the
+ * reader thread of the device hands every frame to the simulation
+ * thread through ScheduleWithContext, and each must be received once,
+ * in order and in the context of the node.
+ */
+class FdNetDeviceReaderTestCase : public TestCase
+{
+public:
+  FdNetDeviceReaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Receive callback of the device.
+   * \param device The receiving device.
+   * \param packet The received packet.
+   * \param protocol The protocol number of the packet.
+   * \param from The source address.
+   * \returns true.
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                uint16_t protocol, const Address &from);
+  /** Stop the simulation once all frames were received, or on timeout. */
+  void Poll (void);
+  /**
+   * Write the frames to the socket.
+   * \param fd The socket to write to.
+   */
+  static void WritingThread (int fd);
+
+  uint32_t m_nodeId;     //!< Id of the receiving node.
+  uint32_t m_received;   //!< Number of frames received.
+  uint32_t m_outOfOrder; //!< Number of frames received out of order.
+  uint32_t m_badContext; //!< Number of frames received in another context.
+};
+
+/** Number of frames written to the device. */
+static const uint32_t READER_FRAMES = 500;
+/** Size of the Ethernet header of the frames. */
+static const uint32_t READER_HEADER_SIZE = 14;
+
+FdNetDeviceReaderTestCase::FdNetDeviceReaderTestCase ()
+  : TestCase ("Check that the frames read by FdNetDevice all reach the simulation, in order")
+{
+}
+
+void
+FdNetDeviceReaderTestCase::WritingThread (int fd)
+{
+  uint8_t frame[READER_HEADER_SIZE + 4];
+  memset (frame, 0xff, 6);
+  memset (frame + 6, 0, 6);
+  frame[11] = 1;
+  frame[12] = 0x08;
+  frame[13] = 0x00;
+  for (uint32_t i = 0; i < READER_FRAMES; ++i)
+    {
+      frame[READER_HEADER_SIZE] = (i >> 24) & 0xff;
+      frame[READER_HEADER_SIZE + 1] = (i >> 16) & 0xff;
+      frame[READER_HEADER_SIZE + 2] = (i >> 8) & 0xff;
+      frame[READER_HEADER_SIZE + 3] = i & 0xff;
+      if (write (fd, frame, sizeof (frame)) != sizeof (frame))
+        {
+          NS_FATAL_ERROR ("Error writing frame " << i << ": " << strerror (errno));
+        }
+      if (i % 10 == 0)
+        {
+          struct timespec ts;
+          ts.tv_sec = 0;
+          ts.tv_nsec = 100000;
+          nanosleep (&ts, NULL);
+        }
+    }
+}
+
+bool
+FdNetDeviceReaderTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                    uint16_t protocol, const Address &from)
+{
+  if (Simulator::GetContext () != m_nodeId)
+    {
+      m_badContext++;
+    }
+  uint8_t payload[4];
+  if (packet->CopyData (payload, 4) != 4
+      || ((uint32_t)payload[0] << 24 | (uint32_t)payload[1] << 16
+          | (uint32_t)payload[2] << 8 | payload[3]) != m_received)
+    {
+      m_outOfOrder++;
+    }
+  m_received++;
+  return true;
+}
+
+void
+FdNetDeviceReaderTestCase::Poll (void)
+{
+  if (m_received == READER_FRAMES || Simulator::Now () > Seconds (10))
+    {
+      Simulator::Stop ();
+      return;
+    }
+  Simulator::Schedule (MilliSeconds (1), &FdNetDeviceReaderTestCase::Poll, this);
+}
+
+void
+FdNetDeviceReaderTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+  m_received = 0;
+  m_outOfOrder = 0;
+  m_badContext = 0;
+
+  int sv[2];
+  NS_TEST_ASSERT_MSG_EQ (socketpair (AF_UNIX, SOCK_DGRAM, 0, sv), 0, "Could not create the socket pair");
+
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<FdNetDevice> device = CreateObject<FdNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  device->SetReceiveCallback (MakeCallback (&FdNetDeviceReaderTestCase::Receive, this));
+  device->SetFileDescriptor (sv[0]);
+  m_nodeId = node->GetId ();
+
+  Ptr<SystemThread> writer = Create<SystemThread> (MakeBoundCallback (&FdNetDeviceReaderTestCase::WritingThread, sv[1]));
+  Simulator::Schedule (MilliSeconds (1), &FdNetDeviceReaderTestCase::Poll, this);
+  writer->Start ();
+  Simulator::Run ();
+  writer->Join ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, READER_FRAMES, "Lost frames");
+  NS_TEST_EXPECT_MSG_EQ (m_outOfOrder, 0, "Frames received out of order");
+  NS_TEST_EXPECT_MSG_EQ (m_badContext, 0, "Frames received in the wrong context");
+
+  Simulator::Destroy ();
+  close (sv[1]);
+}
+
+void
+FdNetDeviceReaderTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+/**
+ * \ingroup fd-net-device-test
+ * \ingroup tests
+ *
+ * FdNetDevice test suite.
+ */
+class FdNetDeviceTestSuite : public TestSuite
+{
+public:
+  FdNetDeviceTestSuite ();
+};
+
+FdNetDeviceTestSuite::FdNetDeviceTestSuite ()
+  : TestSuite ("fd-net-device", SYSTEM)
+{
+  AddTestCase (new FdNetDeviceReaderTestCase, TestCase::QUICK);
+}
+
+static FdNetDeviceTestSuite g_fdNetDeviceTestSuite; //!< Static variable for test initialization
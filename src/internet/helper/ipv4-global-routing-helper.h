@@ -80,6 +80,10 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * With the "GlobalRoutingIncremental" global value set, when links only
+   * went away or became more expensive, SPF runs again only for the routers
+   * whose shortest-path tree used one of them; the other routers only
+   * replace the routes to the destinations of the changed links.
    */
   static void RecomputeRoutingTables (void);
 private:
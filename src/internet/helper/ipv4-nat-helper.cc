@@ -20,6 +20,7 @@
 #include "ns3/assert.h"
 #include "ns3/ptr.h"
 #include "ns3/node.h"
+#include "ns3/simulator.h"
 #include "ns3/ipv4-nat.h"
 #include "ns3/ipv4-nat-helper.h"
 
@@ -45,5 +46,44 @@ Ipv4NatHelper::Install (Ptr<Node> node) const
   return nat;
 }
 
+void
+Ipv4NatHelper::ScheduleSaveState (Ptr<Ipv4Nat> nat, Time when, std::string filename) const
+{
+  Simulator::Schedule (when, &Ipv4Nat::SaveState, nat, filename);
+}
+
+void
+Ipv4NatHelper::RestoreState (Ptr<Ipv4Nat> nat, std::string filename) const
+{
+  Simulator::ScheduleNow (&Ipv4Nat::LoadState, nat, filename);
+}
+
+void
+Ipv4NatHelper::ExportTableAt (Time printTime, Ptr<Ipv4Nat> nat, Ptr<OutputStreamWrapper> stream)
+{
+  Simulator::Schedule (printTime, &Ipv4NatHelper::Export, nat, stream);
+}
+
+void
+Ipv4NatHelper::ExportTableEvery (Time printInterval, Ptr<Ipv4Nat> nat, Ptr<OutputStreamWrapper> stream)
+{
+  nat->ExportTableHeader (stream);
+  Simulator::Schedule (printInterval, &Ipv4NatHelper::ExportEvery, printInterval, nat, stream);
+}
+
+void
+Ipv4NatHelper::Export (Ptr<Ipv4Nat> nat, Ptr<OutputStreamWrapper> stream)
+{
+  nat->ExportTableHeader (stream);
+  nat->ExportTable (stream);
+}
+
+void
+Ipv4NatHelper::ExportEvery (Time printInterval, Ptr<Ipv4Nat> nat, Ptr<OutputStreamWrapper> stream)
+{
+  nat->ExportTable (stream);
+  Simulator::Schedule (printInterval, &Ipv4NatHelper::ExportEvery, printInterval, nat, stream);
+}
+
 
 } // namespace ns3
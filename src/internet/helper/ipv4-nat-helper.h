@@ -19,7 +19,10 @@
 #ifndef IPV4_NAT_HELPER_H
 #define IPV4_NAT_HELPER_H
 
+#include <string>
 #include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/output-stream-wrapper.h"
 #include "ns3/ipv4-nat.h"
 
 namespace ns3 {
@@ -52,7 +55,72 @@ public:
    */
   virtual Ptr<Ipv4Nat> Install (Ptr<Node> node) const;
 
+  /**
+   * \param nat the NAT whose state is saved
+   * \param when the simulation time at which the state is saved
+   * \param filename the binary file the state is written to
+   *
+   * Schedules Ipv4Nat::SaveState, which writes the dynamic translations,
+   * the pool state and the node's conntrack entries.
+   */
+  void ScheduleSaveState (Ptr<Ipv4Nat> nat, Time when, std::string filename) const;
+
+  /**
+   * \param nat the NAT whose state is restored
+   * \param filename a file written by Ipv4Nat::SaveState
+   *
+   * Restores the state when the simulation starts, i.e. after the
+   * scenario has configured the NAT rules and pools, so that a run can
+   * skip the warm-up phase that built the saved state.
+   */
+  void RestoreState (Ptr<Ipv4Nat> nat, std::string filename) const;
+
+  /**
+   * \brief export the NAT table at a particular time.
+   *
+   * \param printTime the time at which the table is exported.
+   * \param nat the NAT whose table is exported
+   * \param stream The output stream object to use
+   *
+   * Writes the column names followed by one Ipv4Nat::ExportTable snapshot.
+   */
+  static void ExportTableAt (Time printTime, Ptr<Ipv4Nat> nat, Ptr<OutputStreamWrapper> stream);
+
+  /**
+   * \brief export the NAT table at a particular time and then periodically.
+   *
+   * \param printInterval the time between two snapshots of the table.
+   * \param nat the NAT whose table is exported
+   * \param stream The output stream object to use
+   *
+   * Writes the column names once, then appends an Ipv4Nat::ExportTable
+   * snapshot every printInterval, so that the growth and ageing of the
+   * translations can be plotted from a single file.
+   */
+  static void ExportTableEvery (Time printInterval, Ptr<Ipv4Nat> nat, Ptr<OutputStreamWrapper> stream);
+
 private:
+  /**
+   * \internal
+   *
+   * \brief export the NAT table at a particular time.
+   *
+   * \param nat the NAT whose table is exported
+   * \param stream The output stream object to use
+   */
+  static void Export (Ptr<Ipv4Nat> nat, Ptr<OutputStreamWrapper> stream);
+
+  /**
+   * \internal
+   *
+   * \brief export the NAT table at a particular time and schedule the next snapshot.
+   *
+   * \param printInterval the time between two snapshots of the table.
+   * \param nat the NAT whose table is exported
+   * \param stream The output stream object to use
+   */
+  static void ExportEvery (Time printInterval, Ptr<Ipv4Nat> nat, Ptr<OutputStreamWrapper> stream);
+
   /**
    * \internal
    * \brief Assignment operator declared private and not implemented to disallow
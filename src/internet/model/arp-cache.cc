@@ -17,6 +17,7 @@
  *
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
+#include <algorithm>
 #include "ns3/assert.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
@@ -25,6 +26,7 @@
 #include "ns3/node.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/names.h"
+#include "ns3/memory-accounting.h"
 
 #include "arp-cache.h"
 #include "arp-header.h"
@@ -34,6 +36,12 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("ArpCache");
 
+/** MemoryAccounting of the ARP cache entries. */
+static MemoryAccounting::Counter g_arpEntryMemory ("ns3::ArpCache::Entry");
+
+/** Smallest number of entries above which the expired entries are removed. */
+static const uint32_t ARP_CACHE_MIN_EXPIRY_CHECK_SIZE = 64;
+
 NS_OBJECT_ENSURE_REGISTERED (ArpCache);
 
 TypeId 
@@ -79,13 +87,31 @@ ArpCache::GetTypeId (void)
                      "in WaitReply expiring.",
                      MakeTraceSourceAccessor (&ArpCache::m_dropTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("Entries",
+                     "The number of entries in the cache.",
+                     MakeTraceSourceAccessor (&ArpCache::m_nEntries),
+                     "ns3::TracedValue::Uint32Callback")
+    .AddTraceSource ("Requests",
+                     "The number of ArpRequests sent to resolve "
+                     "the cache entries, retransmissions included.",
+                     MakeTraceSourceAccessor (&ArpCache::m_nRequests),
+                     "ns3::TracedValue::Uint32Callback")
+    .AddTraceSource ("Replies",
+                     "The number of ArpReplies which resolved "
+                     "a cache entry.",
+                     MakeTraceSourceAccessor (&ArpCache::m_nReplies),
+                     "ns3::TracedValue::Uint32Callback")
   ;
   return tid;
 }
 
 ArpCache::ArpCache ()
   : m_device (0), 
-    m_interface (0)
+    m_interface (0),
+    m_expiryCheckSize (ARP_CACHE_MIN_EXPIRY_CHECK_SIZE),
+    m_nEntries (0),
+    m_nRequests (0),
+    m_nReplies (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -196,38 +222,37 @@ ArpCache::HandleWaitReplyTimeout (void)
   NS_LOG_FUNCTION (this);
   ArpCache::Entry* entry;
   bool restartWaitReplyTimer = false;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  std::list<ArpCache::Entry *>::iterator i = m_waitReply.begin ();
+  while (i != m_waitReply.end ())
     {
-      entry = (*i).second;
-      if (entry != 0 && entry->IsWaitReply ())
+      // MarkDead () removes the entry from the list.
+      entry = *i++;
+      if (entry->GetRetries () < m_maxRetries)
         {
-          if (entry->GetRetries () < m_maxRetries)
-            {
-              NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
-                            ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
-                            " expired -- retransmitting arp request since retries = " <<
-                            entry->GetRetries ());
-              m_arpRequestCallback (this, entry->GetIpv4Address ());
-              restartWaitReplyTimer = true;
-              entry->IncrementRetries ();
-            }
-          else
+          NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
+                        ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
+                        " expired -- retransmitting arp request since retries = " <<
+                        entry->GetRetries ());
+          m_arpRequestCallback (this, entry->GetIpv4Address ());
+          m_nRequests++;
+          restartWaitReplyTimer = true;
+          entry->IncrementRetries ();
+        }
+      else
+        {
+          NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
+                        ", wait reply for " << entry->GetIpv4Address () <<
+                        " expired -- drop since max retries exceeded: " <<
+                        entry->GetRetries ());
+          entry->MarkDead ();
+          entry->ClearRetries ();
+          Ptr<Packet> pending = entry->DequeuePending ();
+          while (pending != 0)
             {
-              NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
-                            ", wait reply for " << entry->GetIpv4Address () <<
-                            " expired -- drop since max retries exceeded: " <<
-                            entry->GetRetries ());
-              entry->MarkDead ();
-              entry->ClearRetries ();
-              Ptr<Packet> pending = entry->DequeuePending ();
-              while (pending != 0)
-                {
-                  m_dropTrace (pending);
-                  pending = entry->DequeuePending ();
-                }
+              m_dropTrace (pending);
+              pending = entry->DequeuePending ();
             }
         }
-
     }
   if (restartWaitReplyTimer)
     {
@@ -246,6 +271,9 @@ ArpCache::Flush (void)
       delete (*i).second;
     }
   m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  m_waitReply.clear ();
+  m_expiryCheckSize = ARP_CACHE_MIN_EXPIRY_CHECK_SIZE;
+  m_nEntries = 0;
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -297,10 +325,10 @@ ArpCache::Entry *
 ArpCache::Lookup (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  if (m_arpCache.find (to) != m_arpCache.end ()) 
+  CacheI i = m_arpCache.find (to);
+  if (i != m_arpCache.end ()) 
     {
-      ArpCache::Entry *entry = m_arpCache[to];
-      return entry;
+      return i->second;
     }
   return 0;
 }
@@ -311,9 +339,18 @@ ArpCache::Add (Ipv4Address to)
   NS_LOG_FUNCTION (this << to);
   NS_ASSERT (m_arpCache.find (to) == m_arpCache.end ());
 
+  // removing the expired entries each time the table doubles keeps their
+  // number proportional to the live entries, at a constant amortized cost.
+  if (m_arpCache.size () >= m_expiryCheckSize)
+    {
+      RemoveExpired ();
+      m_expiryCheckSize = std::max<uint32_t> (2 * m_arpCache.size (),
+                                              ARP_CACHE_MIN_EXPIRY_CHECK_SIZE);
+    }
   ArpCache::Entry *entry = new ArpCache::Entry (this);
   m_arpCache[to] = entry;
   entry->SetIpv4Address (to);
+  m_nEntries = m_arpCache.size ();
   return entry;
 }
 
@@ -322,25 +359,56 @@ ArpCache::Remove (ArpCache::Entry *entry)
 {
   NS_LOG_FUNCTION (this << entry);
   
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  CacheI i = m_arpCache.find (entry->GetIpv4Address ());
+  if (i != m_arpCache.end () && (*i).second == entry)
     {
-      if ((*i).second == entry)
+      m_arpCache.erase (i);
+      m_nEntries = m_arpCache.size ();
+      entry->SetState (Entry::DEAD);
+      entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
+      delete entry;
+      return;
+    }
+  NS_LOG_WARN ("Entry not found in this ARP Cache");
+}
+
+void
+ArpCache::RemoveExpired (void)
+{
+  NS_LOG_FUNCTION (this);
+  CacheI i = m_arpCache.begin ();
+  while (i != m_arpCache.end ())
+    {
+      ArpCache::Entry *entry = (*i).second;
+      if ((entry->IsAlive () || entry->IsDead ()) && entry->IsExpired ())
         {
-          m_arpCache.erase (i);
-          entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
+          NS_LOG_LOGIC ("Removing the expired entry for " << entry->GetIpv4Address ());
+          m_arpCache.erase (i++);
           delete entry;
-          return;
+        }
+      else
+        {
+          i++;
         }
     }
-  NS_LOG_WARN ("Entry not found in this ARP Cache");
+  m_nEntries = m_arpCache.size ();
 }
 
 ArpCache::Entry::Entry (ArpCache *arp)
   : m_arp (arp),
     m_state (ALIVE),
+    m_pendingHead (0),
+    m_pendingCount (0),
     m_retries (0)
 {
   NS_LOG_FUNCTION (this << arp);
+  g_arpEntryMemory.Add (1, sizeof (Entry));
+}
+
+ArpCache::Entry::~Entry ()
+{
+  NS_LOG_FUNCTION (this);
+  g_arpEntryMemory.Add (-1, -(int64_t)sizeof (Entry));
 }
 
 
@@ -375,7 +443,7 @@ ArpCache::Entry::MarkDead (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_state == ALIVE || m_state == WAIT_REPLY || m_state == DEAD);
-  m_state = DEAD;
+  SetState (DEAD);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -385,7 +453,8 @@ ArpCache::Entry::MarkAlive (Address macAddress)
   NS_LOG_FUNCTION (this << macAddress);
   NS_ASSERT (m_state == WAIT_REPLY);
   m_macAddress = macAddress;
-  m_state = ALIVE;
+  SetState (ALIVE);
+  m_arp->m_nReplies++;
   ClearRetries ();
   UpdateSeen ();
 }
@@ -394,7 +463,7 @@ ArpCache::Entry::MarkPermanent (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (!m_macAddress.IsInvalid ());
-  m_state = PERMANENT;
+  SetState (PERMANENT);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -407,11 +476,11 @@ ArpCache::Entry::UpdateWaitReply (Ptr<Packet> waiting)
    * we dump the previously waiting packet and
    * replace it with this one.
    */
-  if (m_pending.size () >= m_arp->m_pendingQueueSize)
+  if (m_pendingCount >= m_arp->m_pendingQueueSize)
     {
       return false;
     }
-  m_pending.push_back (waiting);
+  EnqueuePending (waiting);
   return true;
 }
 void 
@@ -419,13 +488,50 @@ ArpCache::Entry::MarkWaitReply (Ptr<Packet> waiting)
 {
   NS_LOG_FUNCTION (this << waiting);
   NS_ASSERT (m_state == ALIVE || m_state == DEAD);
-  NS_ASSERT (m_pending.empty ());
-  m_state = WAIT_REPLY;
-  m_pending.push_back (waiting);
+  NS_ASSERT (m_pendingCount == 0);
+  SetState (WAIT_REPLY);
+  EnqueuePending (waiting);
   UpdateSeen ();
+  m_arp->m_nRequests++;
   m_arp->StartWaitReplyTimer ();
 }
 
+void
+ArpCache::Entry::EnqueuePending (Ptr<Packet> waiting)
+{
+  NS_LOG_FUNCTION (this << waiting);
+  if (m_pendingCount == m_pending.size ())
+    {
+      // the ring is allocated once for the queue size, and only grows if
+      // the queue size was raised.
+      std::vector<Ptr<Packet> > pending (std::max<uint32_t> (m_arp->m_pendingQueueSize,
+                                                             m_pendingCount + 1));
+      for (uint32_t i = 0; i < m_pendingCount; i++)
+        {
+          pending[i] = m_pending[(m_pendingHead + i) % m_pending.size ()];
+        }
+      m_pending.swap (pending);
+      m_pendingHead = 0;
+    }
+  m_pending[(m_pendingHead + m_pendingCount) % m_pending.size ()] = waiting;
+  m_pendingCount++;
+}
+
+void
+ArpCache::Entry::SetState (ArpCacheEntryState_e state)
+{
+  NS_LOG_FUNCTION (this << state);
+  if (m_state == WAIT_REPLY && state != WAIT_REPLY)
+    {
+      m_arp->m_waitReply.erase (m_waitReply);
+    }
+  else if (m_state != WAIT_REPLY && state == WAIT_REPLY)
+    {
+      m_waitReply = m_arp->m_waitReply.insert (m_arp->m_waitReply.end (), this);
+    }
+  m_state = state;
+}
+
 Address
 ArpCache::Entry::GetMacAddress (void) const
 {
@@ -486,14 +592,16 @@ Ptr<Packet>
 ArpCache::Entry::DequeuePending (void)
 {
   NS_LOG_FUNCTION (this);
-  if (m_pending.empty ())
+  if (m_pendingCount == 0)
     {
       return 0;
     }
   else
     {
-      Ptr<Packet> p = m_pending.front ();
-      m_pending.pop_front ();
+      Ptr<Packet> p = m_pending[m_pendingHead];
+      m_pending[m_pendingHead] = 0;
+      m_pendingHead = (m_pendingHead + 1) % m_pending.size ();
+      m_pendingCount--;
       return p;
     }
 }
@@ -501,7 +609,13 @@ void
 ArpCache::Entry::ClearPendingPacket (void)
 {
   NS_LOG_FUNCTION (this);
-  m_pending.clear ();
+  while (m_pendingCount > 0)
+    {
+      m_pending[m_pendingHead] = 0;
+      m_pendingHead = (m_pendingHead + 1) % m_pending.size ();
+      m_pendingCount--;
+    }
+  m_pendingHead = 0;
 }
 void 
 ArpCache::Entry::UpdateSeen (void)
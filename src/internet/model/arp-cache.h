@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "ns3/simulator.h"
 #include "ns3/callback.h"
 #include "ns3/packet.h"
@@ -32,6 +33,7 @@
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
 #include "ns3/sgi-hashmap.h"
 #include "ns3/output-stream-wrapper.h"
 
@@ -46,6 +48,11 @@ class Ipv4Interface;
  *
  * A cached lookup table for translating layer 3 addresses to layer 2.
  * This implementation does lookups from IPv4 to a MAC address
+ *
+ * The entries are kept in a hash table.  The single timer of the cache
+ * only visits the entries waiting for a reply, and the expired entries
+ * are removed when the table has doubled in size since they were last
+ * looked for, so that the cost of a large table does not grow with time.
  */
 class ArpCache : public Object
 {
@@ -177,6 +184,10 @@ public:
      * \param arp The ArpCache this entry belongs to
      */
     Entry (ArpCache *arp);
+    /**
+     * \brief Destructor
+     */
+    ~Entry ();
 
     /**
      * \brief Changes the state of this entry to dead
@@ -285,13 +296,31 @@ private:
      */
     Time GetTimeout (void) const;
 
+    /**
+     * \brief Append a packet to the pending packets
+     * \param waiting the packet
+     */
+    void EnqueuePending (Ptr<Packet> waiting);
+
+    /**
+     * \brief Change the state of this entry, and tell the ARP cache
+     * whether it waits for a reply.
+     * \param state the new state
+     */
+    void SetState (ArpCacheEntryState_e state);
+
     ArpCache *m_arp; //!< pointer to the ARP cache owning the entry
     ArpCacheEntryState_e m_state; //!< state of the entry
     Time m_lastSeen; //!< last moment a packet from that address has been seen
     Address m_macAddress; //!< entry's MAC address
     Ipv4Address m_ipv4Address; //!< entry's IP address
-    std::list<Ptr<Packet> > m_pending; //!< list of pending packets for the entry's IP
+    std::vector<Ptr<Packet> > m_pending; //!< ring buffer of pending packets for the entry's IP
+    uint32_t m_pendingHead; //!< position of the first pending packet
+    uint32_t m_pendingCount; //!< number of pending packets
     uint32_t m_retries; //!< rerty counter
+    std::list<Entry *>::iterator m_waitReply; //!< position in the entries waiting for a reply
+
+    friend class ArpCache;
   };
 
 private:
@@ -321,9 +350,22 @@ private:
    * If there are no Arp requests pending, this event is not scheduled.
    */
   void HandleWaitReplyTimeout (void);
+  /**
+   * \brief Remove the expired entries which do not wait for a reply
+   * and are not permanent.
+   *
+   * A lookup of these entries would start a new resolution, as if they
+   * did not exist.
+   */
+  void RemoveExpired (void);
   uint32_t m_pendingQueueSize; //!< number of packets waiting for a resolution
   Cache m_arpCache; //!< the ARP cache
+  std::list<Entry *> m_waitReply; //!< the entries waiting for a reply, in the order they started
+  uint32_t m_expiryCheckSize; //!< number of entries above which the expired entries are removed
   TracedCallback<Ptr<const Packet> > m_dropTrace; //!< trace for packets dropped by the ARP cache queue
+  TracedValue<uint32_t> m_nEntries; //!< number of entries in the cache
+  TracedValue<uint32_t> m_nRequests; //!< number of ARP requests sent for the cache entries
+  TracedValue<uint32_t> m_nReplies; //!< number of ARP replies which resolved an entry
 };
 
 
@@ -16,7 +16,6 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <algorithm>
 #include <iostream>
 #include "ns3/log.h"
 #include "ns3/assert.h"
@@ -66,7 +65,7 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (&CandidateQueue::CompareSPFVertex)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -94,11 +93,9 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  // a multiset inserts after the equal elements, like upper_bound () did.
+  CandidateList_t::iterator i = m_candidates.insert (vNew);
+  m_index[vNew->GetVertexId ()] = i;
 }
 
 SPFVertex *
@@ -110,8 +107,13 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = *m_candidates.begin ();
+  m_candidates.erase (m_candidates.begin ());
+  std::map<Ipv4Address, CandidateList_t::iterator>::iterator i = m_index.find (v->GetVertexId ());
+  if (i != m_index.end () && *i->second == v)
+    {
+      m_index.erase (i);
+    }
   return v;
 }
 
@@ -124,7 +126,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return *m_candidates.begin ();
 }
 
 bool
@@ -145,18 +147,12 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  std::map<Ipv4Address, CandidateList_t::iterator>::const_iterator i = m_index.find (addr);
+  if (i == m_index.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
-
-  return 0;
+  return *i->second;
 }
 
 void
@@ -164,7 +160,28 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  // insert the vertices in their previous order, so that the sort is stable.
+  CandidateList_t candidates (&CandidateQueue::CompareSPFVertex);
+  for (CandidateList_t::const_iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+    {
+      m_index[(*i)->GetVertexId ()] = candidates.insert (*i);
+    }
+  m_candidates.swap (candidates);
+  NS_LOG_LOGIC ("After reordering the CandidateQueue");
+  NS_LOG_LOGIC (*this);
+}
+
+void
+CandidateQueue::Reorder (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  std::map<Ipv4Address, CandidateList_t::iterator>::iterator i = m_index.find (v->GetVertexId ());
+  NS_ASSERT_MSG (i != m_index.end () && *i->second == v, "CandidateQueue::Reorder (): vertex not in the queue");
+  // the position of the vertex is not valid anymore, but erasing it by
+  // iterator does not compare it with the other vertices.
+  m_candidates.erase (i->second);
+  i->second = m_candidates.insert (v);
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <map>
+#include <set>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -44,7 +45,9 @@ class SPFVertex;
  * Although a STL priority_queue almost does what we want, the requirement
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
- * enhanced priority queue.
+ * enhanced priority queue.  The vertices are kept in a balanced tree and
+ * indexed by their vertex ID, so that Push (), Pop (), Find () and the
+ * reordering of a single vertex take a logarithmic time.
  */
 class CandidateQueue
 {
@@ -152,6 +155,19 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Moves a vertex in the Candidate Queue after its distance from the
+ * root decreased.
+ *
+ * The result is the same as the one of Reorder (), which sorts the whole
+ * queue: the vertex is placed after the vertices which have the same
+ * priority.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex whose distance decreased.
+ */
+  void Reorder (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -182,8 +198,10 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
+  /// container of SPFVertex pointers, ordered by CompareSPFVertex ()
+  typedef std::multiset<SPFVertex*, bool (*)(const SPFVertex*, const SPFVertex*)> CandidateList_t;
   CandidateList_t m_candidates;  //!< SPFVertex candidates
+  std::map<Ipv4Address, CandidateList_t::iterator> m_index; //!< SPFVertex candidates by vertex ID
 
   /**
    * \brief Stream insertion operator.
@@ -30,6 +30,10 @@
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
@@ -39,11 +43,34 @@
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
 #include "ipv4-global-routing.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \ingroup globalrouting
+ * The number of threads which run the SPF calculations of the routers.
+ */
+static GlobalValue g_spfThreads = GlobalValue ("GlobalRoutingThreads",
+                                               "The number of threads which run the SPF calculations of the global routers",
+                                               UintegerValue (1),
+                                               MakeUintegerChecker<uint32_t> (1));
+
+/**
+ * \ingroup globalrouting
+ * Whether GlobalRouteManagerImpl::RecomputeRoutes only runs SPF for the
+ * routers affected by the changes of the link state database.
+ */
+static GlobalValue g_spfIncremental = GlobalValue ("GlobalRoutingIncremental",
+                                                   "Whether the recomputation of the global routes only runs SPF for the routers whose shortest-path tree changed",
+                                                   BooleanValue (false),
+                                                   MakeBooleanChecker ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -423,7 +450,10 @@ SPFVertex::ClearVertexProcessed (void)
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
-    m_extdatabase ()
+    m_extdatabase (),
+    m_linkData (),
+    m_lsas (),
+    m_lsaIndex ()
 {
   NS_LOG_FUNCTION (this);
 }
@@ -452,11 +482,15 @@ void
 GlobalRouteManagerLSDB::Initialize ()
 {
   NS_LOG_FUNCTION (this);
+  m_lsas.clear ();
+  m_lsaIndex.clear ();
   LSDBMap_t::iterator i;
   for (i= m_database.begin (); i!= m_database.end (); i++)
     {
       GlobalRoutingLSA* temp = i->second;
       temp->SetStatus (GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
+      m_lsaIndex[temp] = m_lsas.size ();
+      m_lsas.push_back (temp);
     }
 }
 
@@ -468,9 +502,29 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     {
       m_extdatabase.push_back (lsa);
     } 
-  else
+  else if (m_database.insert (LSDBPair_t (addr, lsa)).second)
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+//
+// Index the transit records for GetLSAByLinkData (), which returns the LSA
+// with the smallest ID if several have the same link data.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          std::map<Ipv4Address, Ipv4Address>::iterator k = m_linkData.find (lr->GetLinkData ());
+          if (k == m_linkData.end ())
+            {
+              m_linkData[lr->GetLinkData ()] = addr;
+            }
+          else if (addr < k->second)
+            {
+              k->second = addr;
+            }
+        }
     }
 }
 
@@ -495,13 +549,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,35 +562,90 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of one of its transit records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  std::map<Ipv4Address, Ipv4Address>::const_iterator i = m_linkData.find (addr);
+  if (i != m_linkData.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return GetLSA (i->second);
     }
   return 0;
 }
 
+uint32_t
+GlobalRouteManagerLSDB::GetNumLSAs () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_database.size ();
+}
+
+GlobalRoutingLSA*
+GlobalRouteManagerLSDB::GetLSAByIndex (uint32_t index) const
+{
+  NS_LOG_FUNCTION (this << index);
+  NS_ASSERT_MSG (m_lsas.size () == m_database.size (), "GlobalRouteManagerLSDB::GetLSAByIndex (): Initialize () was not called");
+  return m_lsas.at (index);
+}
+
+uint32_t
+GlobalRouteManagerLSDB::GetLSAIndex (GlobalRoutingLSA* lsa) const
+{
+  NS_LOG_FUNCTION (this << lsa);
+  std::map<GlobalRoutingLSA*, uint32_t>::const_iterator i = m_lsaIndex.find (lsa);
+  NS_ASSERT_MSG (i != m_lsaIndex.end (), "GlobalRouteManagerLSDB::GetLSAIndex (): LSA not indexed");
+  return i->second;
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
 //
 // ---------------------------------------------------------------------------
 
+/**
+ * \brief The SPF calculations shared by the threads of
+ * GlobalRouteManagerImpl::RunSPF ().
+ */
+struct GlobalRouteManagerImpl::SPFWork
+{
+  std::vector<SPFContext> *contexts; //!< the calculations to run
+  uint32_t next; //!< the index of the next calculation to run
+#ifdef HAVE_PTHREAD_H
+  SystemMutex mutex; //!< protects next
+#endif /* HAVE_PTHREAD_H */
+};
+
+GlobalRouteManagerImpl::PendingRoute::PendingRoute (Type type, Ipv4Address dest, Ipv4Mask mask,
+                                                    Ipv4Address nextHop, uint32_t outIf)
+  : type (type),
+    dest (dest),
+    mask (mask),
+    nextHop (nextHop),
+    outIf (outIf)
+{
+}
+
+bool
+GlobalRouteManagerImpl::EdgeKey::operator< (const EdgeKey &o) const
+{
+  if (from != o.from)
+    {
+      return from < o.from;
+    }
+  if (linkId != o.linkId)
+    {
+      return linkId < o.linkId;
+    }
+  if (linkData != o.linkData)
+    {
+      return linkData < o.linkData;
+    }
+  return type < o.type;
+}
+
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_work (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -598,6 +704,8 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_rootStates.clear ();
+  m_edgeIndex.clear ();
 }
 
 //
@@ -700,6 +808,7 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // Walk the list of nodes in the system.
 //
   NS_LOG_INFO ("About to start SPF calculation");
+  std::vector<Ipv4Address> roots;
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -724,12 +833,468 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       if (rtr && rtr->GetNumLSAs () )
         {
-          SPFCalculate (rtr->GetRouterId ());
+          roots.push_back (rtr->GetRouterId ());
         }
     }
+  m_rootStates.clear ();
+  RunSPF (roots);
   NS_LOG_INFO ("Finished SPF calculation");
 }
 
+//
+// Restore the root exits saved in a RootState on a vertex made for the
+// incremental computation.  The saved list is sorted, as the one of
+// MergeRootExitDirections (), or has a single exit.
+//
+static void
+RestoreRootExits (SPFVertex* v, const std::vector<SPFVertex::NodeExit_t> &exits)
+{
+  v->SetRootExitDirection (exits.at (0));
+  for (uint32_t i = 1; i < exits.size (); i++)
+    {
+      SPFVertex exit;
+      exit.SetRootExitDirection (exits[i]);
+      v->MergeRootExitDirections (&exit);
+    }
+}
+
+//
+// Compare two LSAs, except for their SPF status and node.
+//
+static bool
+IsSameLSA (GlobalRoutingLSA* a, GlobalRoutingLSA* b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+//
+// The incremental computation relies on the shortest-path tree of a root
+// staying a shortest-path tree when the only changes of the link state
+// database are edges which went away or became more expensive, and none of
+// them is in the tree.  Such a root reaches every vertex through the same
+// exits as before, so only the routes to the destinations advertised in the
+// changed LSAs need to be replaced.  Any other change falls back to the full
+// computation.
+//
+void
+GlobalRouteManagerImpl::RecomputeRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  BooleanValue incremental;
+  g_spfIncremental.GetValue (incremental);
+  if (!incremental.Get () || m_rootStates.empty ())
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+
+  GlobalRouteManagerLSDB* oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  m_lsdb->Initialize ();
+//
+// The vertices and the external routes must not change.
+//
+  bool full = oldLsdb->GetNumLSAs () != m_lsdb->GetNumLSAs ()
+    || oldLsdb->GetNumExtLSAs () != m_lsdb->GetNumExtLSAs ();
+  for (uint32_t i = 0; !full && i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      full = !IsSameLSA (oldLsdb->GetExtLSA (i), m_lsdb->GetExtLSA (i));
+    }
+  std::vector<uint32_t> changed;
+  for (uint32_t i = 0; !full && i < m_lsdb->GetNumLSAs (); i++)
+    {
+      GlobalRoutingLSA *oldLsa = oldLsdb->GetLSAByIndex (i);
+      GlobalRoutingLSA *newLsa = m_lsdb->GetLSAByIndex (i);
+      if (oldLsa->GetLinkStateId () != newLsa->GetLinkStateId ()
+          || oldLsa->GetLSType () != newLsa->GetLSType ())
+        {
+          full = true;
+        }
+      else if (!IsSameLSA (oldLsa, newLsa))
+        {
+          changed.push_back (i);
+        }
+    }
+//
+// The edges must only go away or become more expensive.
+//
+  std::vector<uint32_t> broken;
+  if (!full)
+    {
+      EdgeMap_t oldEdges = CollectEdges (oldLsdb);
+      EdgeMap_t newEdges = CollectEdges (m_lsdb);
+      for (EdgeMap_t::const_iterator i = oldEdges.begin (); i != oldEdges.end (); i++)
+        {
+          EdgeMap_t::const_iterator j = newEdges.find (i->first);
+          if (j == newEdges.end () || j->second > i->second)
+            {
+              broken.push_back (GetEdgeIndex (i->first));
+            }
+        }
+      for (EdgeMap_t::const_iterator i = newEdges.begin (); !full && i != newEdges.end (); i++)
+        {
+          EdgeMap_t::const_iterator j = oldEdges.find (i->first);
+          full = j == oldEdges.end () || i->second < j->second;
+        }
+    }
+  if (full)
+    {
+      NS_LOG_LOGIC ("The routers, networks or external routes changed, or a link appeared; recomputing all the routes");
+      delete oldLsdb;
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+
+  IndexRouterNodes ();
+  std::vector<Ipv4Address> affected;
+  for (std::map<Ipv4Address, RootState>::const_iterator i = m_rootStates.begin ();
+       i != m_rootStates.end (); i++)
+    {
+      const RootState &state = i->second;
+      bool inTree = false;
+      for (uint32_t j = 0; j < broken.size () && !inTree; j++)
+        {
+          inTree = broken[j] < state.treeEdges.size () && state.treeEdges[broken[j]];
+        }
+      NodeList_t nodes = GetRouterNodes (i->first);
+      if (inTree)
+        {
+//
+// This root runs SPF again, from an empty routing table.
+//
+          NS_LOG_LOGIC ("The shortest-path tree of " << i->first << " changed");
+          affected.push_back (i->first);
+          for (NodeList_t::const_iterator n = nodes.begin (); n != nodes.end (); n++)
+            {
+              Ptr<GlobalRouter> router = (*n)->GetObject<GlobalRouter> ();
+              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+              while (gr->GetNRoutes () > 0)
+                {
+                  gr->RemoveRoute (0);
+                }
+            }
+          continue;
+        }
+//
+// This root replaces the routes taken from the old LSAs which changed by
+// the ones taken from the new LSAs, with the same exits.
+//
+      SPFVertex root (m_lsdb->GetLSA (i->first));
+      uint32_t rootIndex = m_lsdb->GetLSAIndex (root.GetLSA ());
+      SPFContext oldRoutes;
+      oldRoutes.rootId = i->first;
+      oldRoutes.root = &root;
+      oldRoutes.rootNodes = nodes;
+      oldRoutes.state = 0;
+      SPFContext newRoutes = oldRoutes;
+      for (std::vector<uint32_t>::const_iterator c = changed.begin (); c != changed.end (); c++)
+        {
+          if (*c == rootIndex || state.exits[*c].empty ())
+            {
+              continue;
+            }
+          SPFVertex oldVertex (oldLsdb->GetLSAByIndex (*c));
+          RestoreRootExits (&oldVertex, state.exits[*c]);
+          SPFAddVertexRoutes (oldRoutes, &oldVertex);
+          SPFVertex newVertex (m_lsdb->GetLSAByIndex (*c));
+          RestoreRootExits (&newVertex, state.exits[*c]);
+          SPFAddVertexRoutes (newRoutes, &newVertex);
+        }
+      InstallRoutes (oldRoutes, false);
+      InstallRoutes (newRoutes, true);
+    }
+  delete oldLsdb;
+  RunSPF (affected);
+}
+
+void
+GlobalRouteManagerImpl::IndexRouterNodes (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_routerNodes.clear ();
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr != 0)
+        {
+          m_routerNodes[rtr->GetRouterId ()].push_back (*i);
+        }
+    }
+}
+
+GlobalRouteManagerImpl::EdgeKey
+GlobalRouteManagerImpl::GetRecordEdgeKey (GlobalRoutingLSA* lsa, GlobalRoutingLinkRecord* l)
+{
+  EdgeKey key;
+  key.from = lsa->GetLinkStateId ();
+  key.linkId = l->GetLinkId ();
+  key.linkData = l->GetLinkData ();
+  key.type = l->GetLinkType ();
+  return key;
+}
+
+GlobalRouteManagerImpl::EdgeKey
+GlobalRouteManagerImpl::GetNetworkEdgeKey (GlobalRoutingLSA* lsa, Ipv4Address router,
+                                           GlobalRoutingLSA* w_lsa)
+{
+  EdgeKey key;
+  key.from = lsa->GetLinkStateId ();
+  key.linkId = router;
+  key.linkData = w_lsa->GetLinkStateId ();
+  key.type = 0;
+  return key;
+}
+
+GlobalRouteManagerImpl::EdgeMap_t
+GlobalRouteManagerImpl::CollectEdges (const GlobalRouteManagerLSDB* lsdb)
+{
+  EdgeMap_t edges;
+  for (uint32_t i = 0; i < lsdb->GetNumLSAs (); i++)
+    {
+      GlobalRoutingLSA *lsa = lsdb->GetLSAByIndex (i);
+      if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+              if (l->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork)
+                {
+                  edges.insert (std::make_pair (GetRecordEdgeKey (lsa, l), l->GetMetric ()));
+                }
+            }
+        }
+      else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          for (uint32_t j = 0; j < lsa->GetNAttachedRouters (); j++)
+            {
+              Ipv4Address router = lsa->GetAttachedRouter (j);
+              GlobalRoutingLSA *w_lsa = lsdb->GetLSAByLinkData (router);
+              if (w_lsa)
+                {
+                  edges.insert (std::make_pair (GetNetworkEdgeKey (lsa, router, w_lsa), 0));
+                }
+            }
+        }
+    }
+  return edges;
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetEdgeIndex (const EdgeKey &key) const
+{
+  EdgeMap_t::const_iterator i = m_edgeIndex.find (key);
+  NS_ASSERT_MSG (i != m_edgeIndex.end (), "GlobalRouteManagerImpl::GetEdgeIndex (): edge not indexed");
+  return i->second;
+}
+
+//
+// The SPF calculations only read the LSDB and the nodes of their own root,
+// and write to their own context, so they run on a pool of threads.  The
+// routes they find are installed afterwards in the order of the roots, so
+// the routing tables do not depend on the number of threads.
+//
+void
+GlobalRouteManagerImpl::RunSPF (const std::vector<Ipv4Address> &roots)
+{
+  NS_LOG_FUNCTION (this << roots.size ());
+  m_lsdb->Initialize ();
+  IndexRouterNodes ();
+  BooleanValue incremental;
+  g_spfIncremental.GetValue (incremental);
+  if (incremental.Get ())
+    {
+      EdgeMap_t edges = CollectEdges (m_lsdb);
+      for (EdgeMap_t::const_iterator i = edges.begin (); i != edges.end (); i++)
+        {
+          uint32_t index = m_edgeIndex.size ();
+          m_edgeIndex.insert (std::make_pair (i->first, index));
+        }
+    }
+
+  std::vector<SPFContext> contexts (roots.size ());
+  for (uint32_t i = 0; i < roots.size (); i++)
+    {
+      contexts[i].rootId = roots[i];
+      contexts[i].root = 0;
+      contexts[i].rootNodes = GetRouterNodes (roots[i]);
+      contexts[i].state = 0;
+      if (incremental.Get ())
+        {
+          RootState &state = m_rootStates[roots[i]];
+          state = RootState ();
+          contexts[i].state = &state;
+        }
+    }
+
+  SPFWork work;
+  work.contexts = &contexts;
+  work.next = 0;
+  m_work = &work;
+#ifdef HAVE_PTHREAD_H
+  UintegerValue threads;
+  g_spfThreads.GetValue (threads);
+  uint32_t nThreads = std::min<uint32_t> (threads.Get (), contexts.size ());
+  if (!g_log.IsNoneEnabled ())
+    {
+      // keep the log of each calculation in one piece
+      nThreads = 1;
+    }
+  std::vector<Ptr<SystemThread> > workers;
+  for (uint32_t i = 1; i < nThreads; i++)
+    {
+      Ptr<SystemThread> worker = Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::SPFWorker, this));
+      worker->Start ();
+      workers.push_back (worker);
+    }
+#endif /* HAVE_PTHREAD_H */
+  SPFWorker ();
+#ifdef HAVE_PTHREAD_H
+  for (std::vector<Ptr<SystemThread> >::const_iterator i = workers.begin (); i != workers.end (); i++)
+    {
+      (*i)->Join ();
+    }
+#endif /* HAVE_PTHREAD_H */
+  m_work = 0;
+
+  for (uint32_t i = 0; i < contexts.size (); i++)
+    {
+      InstallRoutes (contexts[i], true);
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFWorker (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (;;)
+    {
+      uint32_t i;
+      {
+#ifdef HAVE_PTHREAD_H
+        CriticalSection cs (m_work->mutex);
+#endif /* HAVE_PTHREAD_H */
+        if (m_work->next == m_work->contexts->size ())
+          {
+            return;
+          }
+        i = m_work->next++;
+      }
+      SPFCalculate ((*m_work->contexts)[i]);
+    }
+}
+
+void
+GlobalRouteManagerImpl::InstallRoutes (const SPFContext &ctx, bool add)
+{
+  NS_LOG_FUNCTION (this << ctx.rootId << add);
+  Ptr<Ipv4GlobalRouting> gr;
+  for (NodeList_t::const_iterator i = ctx.rootNodes.begin (); i != ctx.rootNodes.end (); i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr != 0 && rtr->GetRouterId () == ctx.rootId)
+        {
+          gr = rtr->GetRoutingProtocol ();
+          break;
+        }
+    }
+  if (gr == 0)
+    {
+      NS_LOG_LOGIC ("No global routing protocol for router " << ctx.rootId);
+      return;
+    }
+  for (PendingRoutes_t::const_iterator r = ctx.routes.begin (); r != ctx.routes.end (); r++)
+    {
+      bool done = true;
+      switch (r->type)
+        {
+        case PendingRoute::HOST:
+          if (add)
+            {
+              gr->AddHostRouteTo (r->dest, r->nextHop, r->outIf);
+            }
+          else
+            {
+              done = gr->RemoveHostRouteTo (r->dest, r->nextHop, r->outIf);
+            }
+          break;
+        case PendingRoute::NETWORK:
+          if (add)
+            {
+              gr->AddNetworkRouteTo (r->dest, r->mask, r->nextHop, r->outIf);
+            }
+          else
+            {
+              done = gr->RemoveNetworkRouteTo (r->dest, r->mask, r->nextHop, r->outIf);
+            }
+          break;
+        case PendingRoute::EXTERNAL:
+          NS_ASSERT_MSG (add, "GlobalRouteManagerImpl::InstallRoutes (): external routes are not removed");
+          gr->AddASExternalRouteTo (r->dest, r->mask, r->nextHop, r->outIf);
+          break;
+        }
+      if (!done)
+        {
+          NS_LOG_WARN ("Router " << ctx.rootId << " has no route to " << r->dest <<
+                       " through " << r->nextHop << " to remove");
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFAddVertexRoutes (SPFContext &ctx, SPFVertex* v)
+{
+  NS_LOG_FUNCTION (this << v);
+  if (v->GetVertexType () == SPFVertex::VertexNetwork)
+    {
+      SPFIntraAddTransit (ctx, v);
+      return;
+    }
+  SPFIntraAddRouter (ctx, v);
+  GlobalRoutingLSA *rlsa = v->GetLSA ();
+  for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (i);
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+        {
+          SPFIntraAddStub (ctx, l, v);
+        }
+    }
+}
+
 //
 // This method is derived from quagga ospf_spf_next ().  See RFC2328 Section 
 // 16.1 (2) for further details.
@@ -744,7 +1309,7 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // vertex already on the candidate list, store the new (lower) cost.
 //
 void
-GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
+GlobalRouteManagerImpl::SPFNext (SPFContext &ctx, SPFVertex* v, CandidateQueue& candidate)
 {
   NS_LOG_FUNCTION (this << v << &candidate);
 
@@ -836,13 +1401,30 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If the link is to a router that is already in the shortest path first tree
 // then we have it covered -- ignore it.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      uint32_t wIndex = m_lsdb->GetLSAIndex (w_lsa);
+      if (ctx.status[wIndex] == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
         {
           NS_LOG_LOGIC ("Skipping ->  LSA "<< 
                         w_lsa->GetLinkStateId () << " already in SPF tree");
           continue;
         }
 //
+// Keep the edges of the paths to w, with the edges back to the root which
+// give the next hops, for the incremental computation.
+//
+      std::vector<uint32_t> edges;
+      if (ctx.state)
+        {
+          if (v->GetVertexType () == SPFVertex::VertexRouter)
+            {
+              edges.push_back (GetEdgeIndex (GetRecordEdgeKey (v->GetLSA (), l)));
+            }
+          else
+            {
+              edges.push_back (GetEdgeIndex (GetNetworkEdgeKey (v->GetLSA (), v->GetLSA ()->GetAttachedRouter (i), w_lsa)));
+            }
+        }
+//
 // (d) Calculate the link state cost D of the resulting path from the root to 
 // vertex W.  D is equal to the sum of the link state cost of the (already 
 // calculated) shortest path to vertex V and the advertised cost of the link
@@ -861,7 +1443,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
       NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (ctx.status[wIndex] == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -871,9 +1453,14 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 
 // prepare vertex w
           w = new SPFVertex (w_lsa);
-          if (SPFNexthopCalculation (v, w, l, distance))
+          if (SPFNexthopCalculation (ctx, v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              ctx.status[wIndex] = GlobalRoutingLSA::LSA_SPF_CANDIDATE;
+              if (ctx.state)
+                {
+                  edges.insert (edges.end (), ctx.exitEdges.begin (), ctx.exitEdges.end ());
+                  ctx.parentEdges[wIndex] = edges;
+                }
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -888,7 +1475,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (ctx.status[wIndex] == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -935,7 +1522,12 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 
 // prepare vertex w
               w = new SPFVertex (w_lsa);
-              SPFNexthopCalculation (v, w, l, distance);
+              SPFNexthopCalculation (ctx, v, w, l, distance);
+              if (ctx.state)
+                {
+                  ctx.parentEdges[wIndex].insert (ctx.parentEdges[wIndex].end (), edges.begin (), edges.end ());
+                  ctx.parentEdges[wIndex].insert (ctx.parentEdges[wIndex].end (), ctx.exitEdges.begin (), ctx.exitEdges.end ());
+                }
               cw->MergeRootExitDirections (w);
               cw->MergeParent (w);
 // SPFVertexAddParent (w) is necessary as the destructor of 
@@ -954,13 +1546,18 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // N.B. the nexthop_calculation is conditional, if it finds a valid nexthop
 // it will call spf_add_parents, which will flush the old parents
 //
-              if (SPFNexthopCalculation (v, cw, l, distance))
+              if (SPFNexthopCalculation (ctx, v, cw, l, distance))
                 {
+                  if (ctx.state)
+                    {
+                      edges.insert (edges.end (), ctx.exitEdges.begin (), ctx.exitEdges.end ());
+                      ctx.parentEdges[wIndex] = edges;
+                    }
 //
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Reorder (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -979,12 +1576,14 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 //
 int
 GlobalRouteManagerImpl::SPFNexthopCalculation (
+  SPFContext &ctx,
   SPFVertex* v, 
   SPFVertex* w,
   GlobalRoutingLinkRecord* l,
   uint32_t distance)
 {
   NS_LOG_FUNCTION (this << v << w << l << distance);
+  ctx.exitEdges.clear ();
 //
 // If w is a NetworkVertex, l should be null
 /*
@@ -995,7 +1594,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
 */
 
 //
-// The vertex m_spfroot is a distinguished vertex representing the node at
+// The vertex ctx.root is a distinguished vertex representing the node at
 // the root of the calculations.  That is, it is the node for which we are
 // calculating the routes.
 //
@@ -1017,7 +1616,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
 // The point-to-point link information is only useful in this calculation when
 // we are examining the root node. 
 //
-  if (v == m_spfroot)
+  if (v == ctx.root)
     {
 //
 // In this case <v> is the root node, which means it is the starting point
@@ -1057,12 +1656,16 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
 // the packet to the next hop address specified in w->m_nextHop.
 //
           Ipv4Address nextHop = linkRemote->GetLinkData ();
+          if (ctx.state)
+            {
+              ctx.exitEdges.push_back (GetEdgeIndex (GetRecordEdgeKey (w->GetLSA (), linkRemote)));
+            }
 // 
 // Now find the outgoing interface corresponding to the point to point link
 // from the perspective of <v> -- remember that <l> is the link "from"
 // <v> "to" <w>.
 //
-          uint32_t outIf = FindOutgoingInterfaceId (l->GetLinkData ());
+          uint32_t outIf = FindOutgoingInterfaceId (ctx, l->GetLinkData ());
 
           w->SetRootExitDirection (nextHop, outIf);
           w->SetDistanceFromRoot (distance);
@@ -1080,7 +1683,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
           GlobalRoutingLSA* w_lsa = w->GetLSA ();
           NS_ASSERT (w_lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA);
 // Find outgoing interface ID for this network
-          uint32_t outIf = FindOutgoingInterfaceId (w_lsa->GetLinkStateId (), 
+          uint32_t outIf = FindOutgoingInterfaceId (ctx, w_lsa->GetLinkStateId (), 
                                                     w_lsa->GetNetworkLSANetworkMask () );
 // Set the next hop to 0.0.0.0 meaning "not exist"
           Ipv4Address nextHop = Ipv4Address::GetZero ();
@@ -1097,7 +1700,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
   else if (v->GetVertexType () == SPFVertex::VertexNetwork) 
     {
 // See if any of v's parents are the root
-      if (v->GetParent () == m_spfroot)
+      if (v->GetParent () == ctx.root)
         {
 // 16.1.1 para 5. ...the parent vertex is a network that
 // directly connects the calculating router to the destination
@@ -1115,6 +1718,10 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
  */
               Ipv4Address nextHop = linkRemote->GetLinkData ();
               uint32_t outIf = v->GetRootExitDirection ().second;
+              if (ctx.state)
+                {
+                  ctx.exitEdges.push_back (GetEdgeIndex (GetRecordEdgeKey (w->GetLSA (), linkRemote)));
+                }
               w->SetRootExitDirection (nextHop, outIf);
               NS_LOG_LOGIC ("Next hop from " <<
                             v->GetVertexId () << " to " << w->GetVertexId () <<
@@ -1124,7 +1731,9 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
         }
       else 
         {
-          w->SetRootExitDirection (v->GetRootExitDirection ());
+// The network may have been reached through several equal-cost paths, all
+// of which lead to w.
+          w->InheritAllRootExitDirections (v);
         }
     }
   else 
@@ -1247,7 +1856,7 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
-  SPFCalculate (root);
+  RunSPF (std::vector<Ipv4Address> (1, root));
 }
 
 //
@@ -1257,8 +1866,9 @@ GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 // to be run
 //
 bool
-GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
+GlobalRouteManagerImpl::CheckForStubNode (SPFContext &ctx)
 {
+  Ipv4Address root = ctx.rootId;
   NS_LOG_FUNCTION (this << root);
   GlobalRoutingLSA *rlsa = m_lsdb->GetLSA (root);
   Ipv4Address myRouterId = rlsa->GetLinkStateId ();
@@ -1320,15 +1930,16 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-                  NS_ASSERT (gr);
-                  gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
-                                         FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                  int32_t outIf = FindOutgoingInterfaceId (ctx, transitLink->GetLinkData ());
+                  ctx.routes.push_back (PendingRoute (PendingRoute::NETWORK, Ipv4Address ("0.0.0.0"),
+                                                      Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), outIf));
                   NS_LOG_LOGIC ("Inserting default route for node " << myRouterId << " to next hop " << 
-                                lr->GetLinkData () << " via interface " << 
-                                FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                                lr->GetLinkData () << " via interface " << outIf);
+                  if (ctx.state)
+                    {
+                      ctx.state->treeEdges[GetEdgeIndex (GetRecordEdgeKey (rlsa, transitLink))] = true;
+                      ctx.state->treeEdges[GetEdgeIndex (GetRecordEdgeKey (w_lsa, lr))] = true;
+                    }
                   return true;
                 }
             }
@@ -1339,15 +1950,24 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
 
 // quagga ospf_spf_calculate
 void
-GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
+GlobalRouteManagerImpl::SPFCalculate (SPFContext &ctx)
 {
+  Ipv4Address root = ctx.rootId;
   NS_LOG_FUNCTION (this << root);
 
   SPFVertex *v;
 //
-// Initialize the Link State Database.
+// Initialize the state of the vertices.  The Link State Database was
+// initialized by RunSPF () and is only read from here on.
 //
-  m_lsdb->Initialize ();
+  uint32_t nLSAs = m_lsdb->GetNumLSAs ();
+  ctx.status.assign (nLSAs, GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
+  if (ctx.state)
+    {
+      ctx.parentEdges.assign (nLSAs, std::vector<uint32_t> ());
+      ctx.state->treeEdges.assign (m_edgeIndex.size (), false);
+      ctx.state->exits.assign (nLSAs, ExitList_t ());
+    }
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1365,9 +1985,9 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // This vertex is the root of the SPF tree and it is distance 0 from the root.
 // We also mark this vertex as being in the SPF tree.
 //
-  m_spfroot= v;
+  ctx.root = v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  ctx.status[m_lsdb->GetLSAIndex (v->GetLSA ())] = GlobalRoutingLSA::LSA_SPF_IN_SPFTREE;
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
 
 //
@@ -1377,10 +1997,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (!ctx.rootNodes.empty () && CheckForStubNode (ctx))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
-      delete m_spfroot;
+      delete ctx.root;
+      ctx.root = 0;
       return;
     }
 
@@ -1400,7 +2021,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // shortest path).  If the new vertices represent shorter paths, we use them
 // and update the path cost.
 //
-      SPFNext (v, candidate);
+      SPFNext (ctx, v, candidate);
 //
 // RFC2328 16.1. (3). 
 //
@@ -1425,10 +2046,24 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
       v = candidate.Pop ();
       NS_LOG_LOGIC ("Popped vertex " << v->GetVertexId ());
 //
-// Update the status field of the vertex to indicate that it is in the SPF
-// tree.
+// Update the status of the vertex to indicate that it is in the SPF tree,
+// and keep the edges to its parents and its exits for the incremental
+// computation.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      uint32_t index = m_lsdb->GetLSAIndex (v->GetLSA ());
+      ctx.status[index] = GlobalRoutingLSA::LSA_SPF_IN_SPFTREE;
+      if (ctx.state)
+        {
+          const std::vector<uint32_t> &edges = ctx.parentEdges[index];
+          for (uint32_t i = 0; i < edges.size (); i++)
+            {
+              ctx.state->treeEdges[edges[i]] = true;
+            }
+          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+            {
+              ctx.state->exits[index].push_back (v->GetRootExitDirection (i));
+            }
+        }
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1467,11 +2102,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
       if (v->GetVertexType () == SPFVertex::VertexRouter)
         {
-          SPFIntraAddRouter (v);
+          SPFIntraAddRouter (ctx, v);
         }
       else if (v->GetVertexType () == SPFVertex::VertexNetwork)
         {
-          SPFIntraAddTransit (v);
+          SPFIntraAddTransit (ctx, v);
         }
       else
         {
@@ -1486,26 +2121,40 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
     }  // end for loop
 
 // Second stage of SPF calculation procedure
-  SPFProcessStubs (m_spfroot);
+  SPFProcessStubs (ctx, ctx.root);
   for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
     {
-      m_spfroot->ClearVertexProcessed ();
+      ctx.root->ClearVertexProcessed ();
       GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (i);
       NS_LOG_LOGIC ("Processing External LSA with id " << extlsa->GetLinkStateId ());
-      ProcessASExternals (m_spfroot, extlsa);
+      ProcessASExternals (ctx, ctx.root, extlsa);
     }
 
 //
-// We're all done setting the routing information for the node at the root of
+// We're all done finding the routing information for the node at the root of
 // the SPF tree.  Delete all of the vertices and corresponding resources.  Go
 // possibly do it again for the next router.
 //
-  delete m_spfroot;
-  m_spfroot = 0;
+  delete ctx.root;
+  ctx.root = 0;
+  ctx.status.clear ();
+  ctx.parentEdges.clear ();
+}
+
+GlobalRouteManagerImpl::NodeList_t
+GlobalRouteManagerImpl::GetRouterNodes (Ipv4Address routerId) const
+{
+  NS_LOG_FUNCTION (this << routerId);
+  std::map<Ipv4Address, NodeList_t>::const_iterator it = m_routerNodes.find (routerId);
+  if (it != m_routerNodes.end ())
+    {
+      return it->second;
+    }
+  return NodeList_t ();
 }
 
 void
-GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa)
+GlobalRouteManagerImpl::ProcessASExternals (SPFContext &ctx, SPFVertex* v, GlobalRoutingLSA* extlsa)
 {
   NS_LOG_FUNCTION (this << v << extlsa);
   NS_LOG_LOGIC ("Processing external for destination " << 
@@ -1519,7 +2168,7 @@ GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extl
       if ((rlsa->GetLinkStateId ()) == (extlsa->GetAdvertisingRouter ()))
         {
           NS_LOG_LOGIC ("Found advertising router to destination");
-          SPFAddASExternal (extlsa,v);
+          SPFAddASExternal (ctx, extlsa, v);
         }
     }
   for (uint32_t i = 0; i < v->GetNChildren (); i++)
@@ -1527,7 +2176,7 @@ GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extl
       if (!v->GetChild (i)->IsVertexProcessed ())
         {
           NS_LOG_LOGIC ("Vertex's child " << i << " not yet processed, processing...");
-          ProcessASExternals (v->GetChild (i), extlsa);
+          ProcessASExternals (ctx, v->GetChild (i), extlsa);
           v->GetChild (i)->SetVertexProcessed (true);
         }
     }
@@ -1539,15 +2188,15 @@ GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extl
 //
 
 void
-GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v)
+GlobalRouteManagerImpl::SPFAddASExternal (SPFContext &ctx, GlobalRoutingLSA *extlsa, SPFVertex *v)
 {
   NS_LOG_FUNCTION (this << extlsa << v);
 
-  NS_ASSERT_MSG (m_spfroot, "GlobalRouteManagerImpl::SPFAddASExternal (): Root pointer not set");
+  NS_ASSERT_MSG (ctx.root, "GlobalRouteManagerImpl::SPFAddASExternal (): Root pointer not set");
 // Two cases to consider: We are advertising the external ourselves
 // => No need to add anything
 // OR find best path to the advertising router
-  if (v->GetVertexId () == m_spfroot->GetVertexId ())
+  if (v->GetVertexId () == ctx.rootId)
     {
       NS_LOG_LOGIC ("External is on local host: " 
                     << v->GetVertexId () << "; returning");
@@ -1556,16 +2205,15 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
 
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
+  Ipv4Address routerId = ctx.rootId;
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// We need the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
+  NodeList_t::const_iterator i = ctx.rootNodes.begin ();
+  NodeList_t::const_iterator listEnd = ctx.rootNodes.end ();
   for (; i != listEnd; i++)
     {
       Ptr<Node> node = *i;
@@ -1626,13 +2274,6 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
           // walk through all next-hop-IPs and out-going-interfaces for reaching
           // the stub network gateway 'v' from the root node
           for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
@@ -1642,7 +2283,7 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
               int32_t outIf = exit.second;
               if (outIf >= 0)
                 {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+                  ctx.routes.push_back (PendingRoute (PendingRoute::EXTERNAL, tempip, tempmask, nextHop, outIf));
                   NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
                                 " add external network route to " << tempip <<
                                 " using next hop " << nextHop <<
@@ -1666,7 +2307,7 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // stub link records will exist for point-to-point interfaces and for
 // broadcast interfaces for which no neighboring router can be found
 void
-GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
+GlobalRouteManagerImpl::SPFProcessStubs (SPFContext &ctx, SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << v);
   NS_LOG_LOGIC ("Processing stubs for " << v->GetVertexId ());
@@ -1683,7 +2324,7 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
           if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
             {
               NS_LOG_LOGIC ("Found a Stub record to " << l->GetLinkId ());
-              SPFIntraAddStub (l, v);
+              SPFIntraAddStub (ctx, l, v);
               continue;
             }
         }
@@ -1692,7 +2333,7 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
     {
       if (!v->GetChild (i)->IsVertexProcessed ())
         {
-          SPFProcessStubs (v->GetChild (i));
+          SPFProcessStubs (ctx, v->GetChild (i));
           v->GetChild (i)->SetVertexProcessed (true);
         }
     }
@@ -1700,11 +2341,11 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
 
 // RFC2328 16.1. second stage. 
 void
-GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex* v)
+GlobalRouteManagerImpl::SPFIntraAddStub (SPFContext &ctx, GlobalRoutingLinkRecord *l, SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << l << v);
 
-  NS_ASSERT_MSG (m_spfroot, 
+  NS_ASSERT_MSG (ctx.root, 
                  "GlobalRouteManagerImpl::SPFIntraAddStub (): Root pointer not set");
 
   // XXX simplifed logic for the moment.  There are two cases to consider:
@@ -1712,7 +2353,7 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
   //    (already handled above)
   // 2) the stub network is on a remote router, so I should use the
   // same next hop that I use to get to vertex v
-  if (v->GetVertexId () == m_spfroot->GetVertexId ())
+  if (v->GetVertexId () == ctx.rootId)
     {
       NS_LOG_LOGIC ("Stub is on local host: " << v->GetVertexId () << "; returning");
       return;
@@ -1725,16 +2366,15 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // going to use this ID to discover which node it is that we're actually going
 // to update.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
+  Ipv4Address routerId = ctx.rootId;
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// We need the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
+  NodeList_t::const_iterator i = ctx.rootNodes.begin ();
+  NodeList_t::const_iterator listEnd = ctx.rootNodes.end ();
   for (; i != listEnd; i++)
     {
       Ptr<Node> node = *i;
@@ -1797,13 +2437,6 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // which the packets should be send for forwarding.
 //
 
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
           // walk through all next-hop-IPs and out-going-interfaces for reaching
           // the stub network gateway 'v' from the root node
           for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
@@ -1813,7 +2446,7 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
               int32_t outIf = exit.second;
               if (outIf >= 0)
                 {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+                  ctx.routes.push_back (PendingRoute (PendingRoute::NETWORK, tempip, tempmask, nextHop, outIf));
                   NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
                                 " add network route to " << tempip <<
                                 " using next hop " << nextHop <<
@@ -1840,7 +2473,7 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // for routing assumes -1 to be a legal return value)
 //
 int32_t
-GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
+GlobalRouteManagerImpl::FindOutgoingInterfaceId (const SPFContext &ctx, Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (this << a << amask);
 //
@@ -1851,14 +2484,13 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 // node in order to iterate the interfaces and find the one corresponding to
 // the address in question.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
+  Ipv4Address routerId = ctx.rootId;
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// Walk the nodes corresponding to the node at the root of the SPF tree.  This
+// is the node for which we are building the routing table.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
+  NodeList_t::const_iterator i = ctx.rootNodes.begin ();
+  NodeList_t::const_iterator listEnd = ctx.rootNodes.end ();
   for (; i != listEnd; i++)
     {
       Ptr<Node> node = *i;
@@ -1927,11 +2559,11 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 // route.
 //
 void
-GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
+GlobalRouteManagerImpl::SPFIntraAddRouter (SPFContext &ctx, SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << v);
 
-  NS_ASSERT_MSG (m_spfroot, 
+  NS_ASSERT_MSG (ctx.root, 
                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
@@ -1940,16 +2572,15 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // going to use this ID to discover which node it is that we're actually going
 // to update.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
+  Ipv4Address routerId = ctx.rootId;
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// We need the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
+  NodeList_t::const_iterator i = ctx.rootNodes.begin ();
+  NodeList_t::const_iterator listEnd = ctx.rootNodes.end ();
   for (; i != listEnd; i++)
     {
       Ptr<Node> node = *i;
@@ -2031,13 +2662,6 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
               // walk through all available exit directions due to ECMP,
               // and add host route for each of the exit direction toward
               // the vertex 'v'
@@ -2048,8 +2672,8 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
                   int32_t outIf = exit.second;
                   if (outIf >= 0)
                     {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
+                      ctx.routes.push_back (PendingRoute (PendingRoute::HOST, lr->GetLinkData (),
+                                                          Ipv4Mask::GetOnes (), nextHop, outIf));
                       NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
                                     " adding host route to " << lr->GetLinkData () <<
                                     " using next hop " << nextHop <<
@@ -2072,11 +2696,11 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
     }
 }
 void
-GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
+GlobalRouteManagerImpl::SPFIntraAddTransit (SPFContext &ctx, SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << v);
 
-  NS_ASSERT_MSG (m_spfroot, 
+  NS_ASSERT_MSG (ctx.root, 
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
@@ -2085,16 +2709,15 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 // going to use this ID to discover which node it is that we're actually going
 // to update.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
+  Ipv4Address routerId = ctx.rootId;
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// We need the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
+  NodeList_t::const_iterator i = ctx.rootNodes.begin ();
+  NodeList_t::const_iterator listEnd = ctx.rootNodes.end ();
   for (; i != listEnd; i++)
     {
       Ptr<Node> node = *i;
@@ -2144,13 +2767,6 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
           Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
           Ipv4Address tempip = lsa->GetLinkStateId ();
           tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
           // walk through all available exit directions due to ECMP,
           // and add host route for each of the exit direction toward
           // the vertex 'v'
@@ -2162,7 +2778,7 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
               if (outIf >= 0)
                 {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+                  ctx.routes.push_back (PendingRoute (PendingRoute::NETWORK, tempip, tempmask, nextHop, outIf));
                   NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
                                 " add network route to " << tempip <<
                                 " using next hop " << nextHop <<
@@ -30,6 +30,7 @@
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/node.h"
 #include "global-router-interface.h"
 
 namespace ns3 {
@@ -639,13 +640,41 @@ public:
  */
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
+/**
+ * @brief Get the number of router and network Link State Advertisements.
+ *
+ * @returns the number of router and network Link State Advertisements.
+ */
+  uint32_t GetNumLSAs () const;
+
+/**
+ * @brief Look up a router or network Link State Advertisement by index.
+ *
+ * The LSAs are indexed in the order of their link state IDs by Initialize ().
+ *
+ * @param index the index of the LSA, smaller than GetNumLSAs ().
+ * @returns A pointer to the Link State Advertisement.
+ */
+  GlobalRoutingLSA* GetLSAByIndex (uint32_t index) const;
+
+/**
+ * @brief Get the index of a router or network Link State Advertisement.
+ *
+ * The SPF calculations keep the state of their vertices in vectors indexed
+ * this way, so that several of them can share the database.
+ *
+ * @param lsa A pointer to a Link State Advertisement of the database.
+ * @returns the index of the LSA, as set by Initialize ().
+ */
+  uint32_t GetLSAIndex (GlobalRoutingLSA* lsa) const;
+
 /**
  * @brief Set all LSA flags to an initialized state, for SPF computation
  *
  * This function walks the database and resets the status flags of all of the
- * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED.  This is done
- * prior to each SPF calculation to reset the state of the SPFVertex structures
- * that will reference the LSAs during the calculation.
+ * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED, and indexes
+ * them for GetLSAByIndex () and GetLSAIndex ().  This is done before the SPF
+ * calculations, which then only read the database.
  *
  * @see GlobalRoutingLSA
  * @see SPFVertex
@@ -679,6 +708,9 @@ private:
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
+  std::map<Ipv4Address, Ipv4Address> m_linkData; //!< the smallest link state ID with a transit record of each link data
+  std::vector<GlobalRoutingLSA*> m_lsas; //!< the LSAs of m_database, by index
+  std::map<GlobalRoutingLSA*, uint32_t> m_lsaIndex; //!< the index of each LSA of m_database
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -733,6 +765,20 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Recompute the routes after a change of the topology.
+ *
+ * By default, this deletes all the routes and computes them again, as
+ * DeleteGlobalRoutes (), BuildGlobalRoutingDatabase () and
+ * InitializeRoutes () do.  With the "GlobalRoutingIncremental" global
+ * value set, the SPF state of the previous computation is kept, and when
+ * links only went away or became more expensive, SPF runs again only for
+ * the routers whose shortest-path tree used one of these links.  The other
+ * routers reach every vertex through the same exits as before, so they
+ * only replace the routes taken from the changed LSAs.
+ */
+  virtual void RecomputeRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -764,9 +810,183 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
-  SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
 
+  typedef std::vector<Ptr<Node> > NodeList_t; //!< container of Node pointers
+  std::map<Ipv4Address, NodeList_t> m_routerNodes; //!< the nodes of each router ID
+
+  typedef std::vector<SPFVertex::NodeExit_t> ExitList_t; //!< container of root exits
+
+  /**
+   * \brief A route found by an SPF calculation, installed once all the
+   * calculations are done.
+   */
+  struct PendingRoute
+  {
+    /** The table of the route. */
+    enum Type
+    {
+      HOST,     //!< a host route
+      NETWORK,  //!< a network route
+      EXTERNAL  //!< an AS external route
+    };
+    /**
+     * \param type the table of the route
+     * \param dest the destination host or network
+     * \param mask the mask of the destination network
+     * \param nextHop the next hop
+     * \param outIf the outgoing interface
+     */
+    PendingRoute (Type type, Ipv4Address dest, Ipv4Mask mask,
+                  Ipv4Address nextHop, uint32_t outIf);
+    Type type;           //!< the table of the route
+    Ipv4Address dest;    //!< the destination host or network
+    Ipv4Mask mask;       //!< the mask of the destination network
+    Ipv4Address nextHop; //!< the next hop
+    uint32_t outIf;      //!< the outgoing interface
+  };
+  typedef std::vector<PendingRoute> PendingRoutes_t; //!< container of pending routes
+
+  /**
+   * \brief The SPF state of a root kept for the incremental computation.
+   */
+  struct RootState
+  {
+    std::vector<bool> treeEdges; //!< the edges of the shortest-path tree, by edge index
+    std::vector<ExitList_t> exits; //!< the root exits to each vertex, by LSA index
+  };
+
+  /**
+   * \brief The state of one SPF calculation.
+   *
+   * Each calculation only writes to its own context and reads the LSDB, so
+   * the calculations of several roots can run at the same time.
+   */
+  struct SPFContext
+  {
+    Ipv4Address rootId; //!< the router ID of the root
+    SPFVertex* root; //!< the root vertex, while the tree exists
+    NodeList_t rootNodes; //!< the nodes with the router ID of the root
+    std::vector<GlobalRoutingLSA::SPFStatus> status; //!< the status of each vertex, by LSA index
+    std::vector<std::vector<uint32_t> > parentEdges; //!< the edges to the parents of each candidate, by LSA index
+    std::vector<uint32_t> exitEdges; //!< the edges back to the root read by the last next hop calculation
+    PendingRoutes_t routes; //!< the routes found, in the order they were found
+    RootState *state; //!< where to keep the state for the incremental computation, or 0
+  };
+
+  /**
+   * \brief An edge of the link state graph: a point-to-point or transit
+   * record of a router LSA, or an attached router of a network LSA.
+   */
+  struct EdgeKey
+  {
+    Ipv4Address from; //!< the link state ID of the LSA of the edge
+    Ipv4Address linkId; //!< the link ID of the record, or the attached router
+    Ipv4Address linkData; //!< the link data of the record, or the router ID of the attached router
+    uint8_t type; //!< the type of the record, or 0 for a network LSA
+    /**
+     * \param o the edge to compare to
+     * \returns true if this edge sorts before o
+     */
+    bool operator< (const EdgeKey &o) const;
+  };
+  typedef std::map<EdgeKey, uint32_t> EdgeMap_t; //!< container of edges
+
+  std::map<Ipv4Address, RootState> m_rootStates; //!< the SPF state of each root, in incremental mode
+  EdgeMap_t m_edgeIndex; //!< the index of each edge seen since the routes were last deleted
+
+  /**
+   * \brief The SPF calculations of a RunSPF () call, and the index of the
+   * next one to run.
+   */
+  struct SPFWork;
+  SPFWork *m_work; //!< the calculations shared by the SPF threads
+
+  /**
+   * \brief Index the nodes by router ID.
+   *
+   * This is done before the SPF calculations, which then look up the
+   * nodes of their root with GetRouterNodes ().
+   */
+  void IndexRouterNodes (void);
+
+  /**
+   * \brief Find the nodes which have a router ID.
+   *
+   * \param routerId the router ID
+   * \returns the nodes, in the order of the list of nodes
+   */
+  NodeList_t GetRouterNodes (Ipv4Address routerId) const;
+
+  /**
+   * \brief Collect the edges of a link state database with their metric.
+   *
+   * \param lsdb the database
+   * \returns the edges, with their metric
+   */
+  static EdgeMap_t CollectEdges (const GlobalRouteManagerLSDB* lsdb);
+
+  /**
+   * \brief Get the key of the edge of a point-to-point or transit record.
+   *
+   * \param lsa the router LSA of the record
+   * \param l the link record
+   * \returns the key of the edge
+   */
+  static EdgeKey GetRecordEdgeKey (GlobalRoutingLSA* lsa, GlobalRoutingLinkRecord* l);
+
+  /**
+   * \brief Get the key of the edge from a network to an attached router.
+   *
+   * \param lsa the network LSA
+   * \param router the address of the attached router
+   * \param w_lsa the router LSA of the attached router
+   * \returns the key of the edge
+   */
+  static EdgeKey GetNetworkEdgeKey (GlobalRoutingLSA* lsa, Ipv4Address router,
+                                    GlobalRoutingLSA* w_lsa);
+
+  /**
+   * \brief Get the index of an edge of the current database.
+   *
+   * \param key the key of the edge
+   * \returns the index of the edge in the tree edges of a RootState
+   */
+  uint32_t GetEdgeIndex (const EdgeKey &key) const;
+
+  /**
+   * \brief Run the SPF calculations of several roots and install their routes.
+   *
+   * The calculations run on the number of threads given by the
+   * "GlobalRoutingThreads" global value.  The routes are then installed by
+   * the calling thread, in the order of the roots.
+   *
+   * \param roots the router IDs of the roots
+   */
+  void RunSPF (const std::vector<Ipv4Address> &roots);
+
+  /**
+   * \brief Run SPF calculations until none is left in m_work.
+   */
+  void SPFWorker (void);
+
+  /**
+   * \brief Install or remove the routes found for a root.
+   *
+   * \param ctx the context of the root
+   * \param add true to install the routes, false to remove them
+   */
+  void InstallRoutes (const SPFContext &ctx, bool add);
+
+  /**
+   * \brief Find the routes taken from the LSA of a vertex, with its root
+   * exits, as SPFCalculate () does.
+   *
+   * \param ctx the context of the root
+   * \param v the vertex
+   */
+  void SPFAddVertexRoutes (SPFContext &ctx, SPFVertex* v);
+
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
    *
@@ -774,18 +994,18 @@ private:
    * can safely be added to the next-hop router and SPF does not need
    * to be run
    *
-   * \param root the root node
+   * \param ctx the context of the calculation
    * \returns true if the node is a stub
    */
-  bool CheckForStubNode (Ipv4Address root);
+  bool CheckForStubNode (SPFContext &ctx);
 
   /**
    * \brief Calculate the shortest path first (SPF) tree
    *
    * Equivalent to quagga ospf_spf_calculate
-   * \param root the root node
+   * \param ctx the context of the calculation, with its root set
    */
-  void SPFCalculate (Ipv4Address root);
+  void SPFCalculate (SPFContext &ctx);
 
   /**
    * \brief Process Stub nodes
@@ -794,17 +1014,19 @@ private:
    * stub link records will exist for point-to-point interfaces and for
    * broadcast interfaces for which no neighboring router can be found
    *
+   * \param ctx the context of the calculation
    * \param v vertex to be processed
    */
-  void SPFProcessStubs (SPFVertex* v);
+  void SPFProcessStubs (SPFContext &ctx, SPFVertex* v);
 
   /**
    * \brief Process Autonomous Systems (AS) External LSA
    *
+   * \param ctx the context of the calculation
    * \param v vertex to be processed
    * \param extlsa external LSA
    */
-  void ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa);
+  void ProcessASExternals (SPFContext &ctx, SPFVertex* v, GlobalRoutingLSA* extlsa);
 
   /**
    * \brief Examine the links in v's LSA and update the list of candidates with any
@@ -824,10 +1046,11 @@ private:
    * vertices not already on the list.  If a lower-cost path is found to a
    * vertex already on the candidate list, store the new (lower) cost.
    *
+   * \param ctx the context of the calculation
    * \param v the vertex
    * \param candidate the SPF candidate queue
    */
-  void SPFNext (SPFVertex* v, CandidateQueue& candidate);
+  void SPFNext (SPFContext &ctx, SPFVertex* v, CandidateQueue& candidate);
 
   /**
    * \brief Calculate nexthop from root through V (parent) to vertex W (destination)
@@ -836,13 +1059,14 @@ private:
    * This method is derived from quagga ospf_nexthop_calculation() 16.1.1.
    * For now, this is greatly simplified from the quagga code
    *
+   * \param ctx the context of the calculation
    * \param v the parent
    * \param w the destination
    * \param l the link record
    * \param distance the target distance
    * \returns 1 on success
    */
-  int SPFNexthopCalculation (SPFVertex* v, SPFVertex* w, 
+  int SPFNexthopCalculation (SPFContext &ctx, SPFVertex* v, SPFVertex* w, 
                              GlobalRoutingLinkRecord* l, uint32_t distance);
 
   /**
@@ -902,33 +1126,37 @@ private:
    * a destination IP address, reachable from the root, to which we add a host
    * route.
    *
+   * \param ctx the context of the calculation
    * \param v the vertex
    *
    */
-  void SPFIntraAddRouter (SPFVertex* v);
+  void SPFIntraAddRouter (SPFContext &ctx, SPFVertex* v);
 
   /**
    * \brief Add a transit to the routing tables
    *
+   * \param ctx the context of the calculation
    * \param v the vertex
    */
-  void SPFIntraAddTransit (SPFVertex* v);
+  void SPFIntraAddTransit (SPFContext &ctx, SPFVertex* v);
 
   /**
    * \brief Add a stub to the routing tables
    *
+   * \param ctx the context of the calculation
    * \param l the global routing link record
    * \param v the vertex
    */
-  void SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex* v);
+  void SPFIntraAddStub (SPFContext &ctx, GlobalRoutingLinkRecord *l, SPFVertex* v);
 
   /**
    * \brief Add an external route to the routing tables
    *
+   * \param ctx the context of the calculation
    * \param extlsa the external LSA
    * \param v the vertex
    */
-  void SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v);
+  void SPFAddASExternal (SPFContext &ctx, GlobalRoutingLSA *extlsa, SPFVertex *v);
 
   /**
    * \brief Return the interface number corresponding to a given IP address and mask
@@ -938,11 +1166,12 @@ private:
    * If no such interface is found, return -1 (note:  unit test framework
    * for routing assumes -1 to be a legal return value)
    *
+   * \param ctx the context of the calculation
    * \param a the target IP address
    * \param amask the target subnet mask
    * \return the outgoing interface number
    */
-  int32_t FindOutgoingInterfaceId (Ipv4Address a, 
+  int32_t FindOutgoingInterfaceId (const SPFContext &ctx, Ipv4Address a, 
                                    Ipv4Mask amask = Ipv4Mask ("255.255.255.255"));
 };
 
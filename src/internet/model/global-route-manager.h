@@ -62,6 +62,17 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Recompute the routes after a change of the topology.
+ *
+ * This deletes the routes and computes them again, or, with the
+ * "GlobalRoutingIncremental" global value set, only runs SPF again for the
+ * routers whose shortest-path tree changed.
+ *
+ * @see GlobalRouteManagerImpl::RecomputeRoutes
+ */
+  static void RecomputeRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
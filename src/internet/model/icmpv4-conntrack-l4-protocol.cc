@@ -39,14 +39,29 @@ Icmpv4ConntrackL4Protocol::PacketToTuple (Ptr<Packet> p, NetfilterConntrackTuple
   if (!found)
     NS_LOG_DEBUG (":: Errrr, No ICMP Header :: ");
 
-  //TODO: Add ICMP specific fields to the NetfilterConntrackTuple class, such as request ID
+  // Echo requests and replies are told apart by their identifier, which
+  // plays the role of both ports; other messages have no ports
+  uint16_t id = 0;
+  if ((icmpHeader.GetType () == Icmpv4Header::ECHO
+       || icmpHeader.GetType () == Icmpv4Header::ECHO_REPLY)
+      && p->GetSize () >= 8)
+    {
+      uint8_t buf[8];
+      p->CopyData (buf, 8);
+      id = (buf[4] << 8) | buf[5];
+    }
+  tuple.SetSourcePort (id);
+  tuple.SetDestinationPort (id);
 
+  NS_LOG_DEBUG ("ICMP Packet To Tuple: " << "( " << tuple.GetSource () << "," << tuple.GetDestination () << ", id " << id << ")" );
   return true;
 }
 
 bool 
 Icmpv4ConntrackL4Protocol::InvertTuple (NetfilterConntrackTuple& inverse, NetfilterConntrackTuple& orig)
 {
+  inverse.SetSourcePort (orig.GetDestinationPort () );
+  inverse.SetDestinationPort (orig.GetSourcePort () );
   return true;
 }
 
@@ -24,11 +24,17 @@ namespace ns3 {
 IpConntrackInfo::IpConntrackInfo ()
 {
   m_status = 0;
+  m_info = 0;
+  m_packets = 0;
+  m_bytes = 0;
 }
 
 IpConntrackInfo::IpConntrackInfo (uint32_t status)
 {
   m_status = status;
+  m_info = 0;
+  m_packets = 0;
+  m_bytes = 0;
 }
 
 void
@@ -38,7 +44,7 @@ IpConntrackInfo::SetStatus (uint32_t status)
 }
 
 uint32_t
-IpConntrackInfo::GetStatus ()
+IpConntrackInfo::GetStatus () const
 {
   return m_status;
 }
@@ -50,11 +56,53 @@ IpConntrackInfo::SetInfo (uint8_t info)
 }
 
 uint8_t
-IpConntrackInfo::GetInfo ()
+IpConntrackInfo::GetInfo () const
 {
   return m_info;
 }
 
+void
+IpConntrackInfo::CopyState (const IpConntrackInfo& other)
+{
+  m_status = other.m_status;
+  m_info = other.m_info;
+}
+
+void
+IpConntrackInfo::RecordPacket (uint32_t bytes)
+{
+  m_packets++;
+  m_bytes += bytes;
+}
+
+void
+IpConntrackInfo::TransferCounters (IpConntrackInfo& other)
+{
+  m_packets += other.m_packets;
+  m_bytes += other.m_bytes;
+  other.m_packets = 0;
+  other.m_bytes = 0;
+}
+
+void
+IpConntrackInfo::SetCounters (uint64_t packets, uint64_t bytes)
+{
+  m_packets = packets;
+  m_bytes = bytes;
+}
+
+uint64_t
+IpConntrackInfo::GetPackets () const
+{
+  return m_packets;
+}
+
+uint64_t
+IpConntrackInfo::GetBytes () const
+{
+  return m_bytes;
+}
+
 bool
 IpConntrackInfo::IsConfirmed ()
 {
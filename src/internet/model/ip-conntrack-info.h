@@ -98,7 +98,7 @@ public:
   /*Method to set the status*/
   void SetStatus (uint32_t status);
   /*Returns Conntrack status*/
-  uint32_t GetStatus ();
+  uint32_t GetStatus () const;
   /*Confirming if the packet has left the device*/
   bool IsConfirmed ();
   /*Setting the Confirmed bit*/
@@ -110,7 +110,19 @@ public:
   /*Setting the info field of Conntrack*/
   void SetInfo (uint8_t info);
   /*Get the info field of Conntrack*/
-  uint8_t GetInfo ();
+  uint8_t GetInfo () const;
+  /*Copying the status and info fields of another entry, leaving the counters untouched*/
+  void CopyState (const IpConntrackInfo& other);
+  /*Counting a packet of the given size that matched the tuple of this entry*/
+  void RecordPacket (uint32_t bytes);
+  /*Adding the counters of another entry to this one and clearing them there*/
+  void TransferCounters (IpConntrackInfo& other);
+  /*Setting the counters, used when restoring a saved conntrack table*/
+  void SetCounters (uint64_t packets, uint64_t bytes);
+  /*Get the number of packets that matched the tuple of this entry*/
+  uint64_t GetPackets () const;
+  /*Get the number of bytes that matched the tuple of this entry*/
+  uint64_t GetBytes () const;
 
   ConntrackDirection_t ConntrackInfoToDirection (ConntrackInfo_t ctinfo);
 
@@ -119,6 +131,9 @@ private:
   uint32_t m_status;
   /*Information on connection */
   uint8_t m_info;
+  /*Packets and bytes seen in the direction of this entry's tuple*/
+  uint64_t m_packets;
+  uint64_t m_bytes;
 };
 
 }
@@ -44,32 +44,140 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::Tuple::operator == (const Tuple &other) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  return addresses == other.addresses && ports == other.ports;
+}
+
+size_t
+Ipv4EndPointDemux::TupleHash::operator () (const Tuple &tuple) const
+{
+  uint64_t hash = (tuple.addresses ^ (tuple.ports * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL;
+  return hash ^ (hash >> 32);
+}
+
+Ipv4EndPointDemux::Tuple
+Ipv4EndPointDemux::MakeTuple (Ipv4Address localAddress, uint16_t localPort,
+                              Ipv4Address peerAddress, uint16_t peerPort)
+{
+  Tuple tuple;
+  tuple.addresses = ((uint64_t)localAddress.Get () << 32) | peerAddress.Get ();
+  tuple.ports = ((uint32_t)localPort << 16) | peerPort;
+  return tuple;
+}
+
+bool
+Ipv4EndPointDemux::IsConnected (Ipv4EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () != Ipv4Address::GetAny () &&
+         endPoint->GetPeerAddress () != Ipv4Address::GetAny () &&
+         endPoint->GetPeerPort () != 0;
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  Index (endPoint);
+  endPoint->m_demux = this;
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  uint16_t localPort = endPoint->GetLocalPort ();
+  std::map<uint16_t, Port>::iterator port = m_ports.find (localPort);
+  if (port == m_ports.end ())
+    {
+      port = m_ports.insert (std::make_pair (localPort, Port ())).first;
+      SetEphemeralPortUsed (localPort, true);
+    }
+  port->second.addresses[endPoint->GetLocalAddress ()]++;
+  if (IsConnected (endPoint))
+    {
+      Tuple tuple = MakeTuple (endPoint->GetLocalAddress (), localPort,
+                               endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      m_connected[tuple].push_back (endPoint);
+    }
+  else
     {
-      if ((*i)->GetLocalPort  () == port) 
+      port->second.wildcards.push_back (endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  uint16_t localPort = endPoint->GetLocalPort ();
+  std::map<uint16_t, Port>::iterator port = m_ports.find (localPort);
+  NS_ASSERT (port != m_ports.end ());
+  if (IsConnected (endPoint))
+    {
+      Tuple tuple = MakeTuple (endPoint->GetLocalAddress (), localPort,
+                               endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      sgi::hash_map<Tuple, EndPoints, TupleHash>::iterator connected = m_connected.find (tuple);
+      NS_ASSERT (connected != m_connected.end ());
+      connected->second.remove (endPoint);
+      if (connected->second.empty ())
         {
-          return true;
+          m_connected.erase (connected);
         }
     }
-  return false;
+  else
+    {
+      port->second.wildcards.remove (endPoint);
+    }
+  std::map<Ipv4Address, uint32_t>::iterator address =
+    port->second.addresses.find (endPoint->GetLocalAddress ());
+  NS_ASSERT (address != port->second.addresses.end ());
+  if (--address->second == 0)
+    {
+      port->second.addresses.erase (address);
+    }
+  if (port->second.addresses.empty ())
+    {
+      m_ports.erase (port);
+      SetEphemeralPortUsed (localPort, false);
+    }
+}
+
+void
+Ipv4EndPointDemux::SetEphemeralPortUsed (uint16_t port, bool used)
+{
+  if (m_ephemeralPorts.empty () || port < m_portFirst || port > m_portLast)
+    {
+      return;
+    }
+  uint32_t bit = port - m_portFirst;
+  if (used)
+    {
+      m_ephemeralPorts[bit / 32] |= 1U << (bit % 32);
+    }
+  else
+    {
+      m_ephemeralPorts[bit / 32] &= ~(1U << (bit % 32));
+    }
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
-        {
-          return true;
-        }
-    }
-  return false;
+  std::map<uint16_t, Port>::const_iterator i = m_ports.find (port);
+  return i != m_ports.end () &&
+         i->second.addresses.find (addr) != i->second.addresses.end ();
 }
 
 Ipv4EndPoint *
@@ -82,10 +190,7 @@ Ipv4EndPointDemux::Allocate (void)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (Ipv4Address::GetAny (), port));
 }
 
 Ipv4EndPoint *
@@ -98,10 +203,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -121,10 +223,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -132,7 +231,29 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
+  endPoint->SetPeer (peerAddress, peerPort);
+  // only the end points indexed like the new one can have the same four-tuple.
+  EndPoints none;
+  EndPoints *candidates = &none;
+  if (IsConnected (endPoint))
+    {
+      sgi::hash_map<Tuple, EndPoints, TupleHash>::iterator connected =
+        m_connected.find (MakeTuple (localAddress, localPort, peerAddress, peerPort));
+      if (connected != m_connected.end ())
+        {
+          candidates = &connected->second;
+        }
+    }
+  else
+    {
+      std::map<uint16_t, Port>::iterator port = m_ports.find (localPort);
+      if (port != m_ports.end ())
+        {
+          candidates = &port->second.wildcards;
+        }
+    }
+  for (EndPointsI i = candidates->begin (); i != candidates->end (); i++)
     {
       if ((*i)->GetLocalPort () == localPort &&
           (*i)->GetLocalAddress () == localAddress &&
@@ -141,16 +262,11 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
         {
           NS_LOG_WARN ("No way we can allocate this end-point.");
           /* no way we can allocate this end-point. */
+          delete endPoint;
           return 0;
         }
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
-  endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void 
@@ -161,6 +277,7 @@ Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -186,6 +303,94 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
 }
 
 
+void
+Ipv4EndPointDemux::LookupMatch (Ipv4EndPoint *endP,
+                                Ipv4Address daddr, uint16_t dport,
+                                Ipv4Address saddr, uint16_t sport,
+                                Ptr<Ipv4Interface> incomingInterface,
+                                bool isBroadcast, Ipv4Address incomingInterfaceAddr,
+                                EndPoints retval[4])
+{
+  NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                             << " daddr=" << endP->GetLocalAddress ()
+                                             << " sport=" << endP->GetPeerPort ()
+                                             << " saddr=" << endP->GetPeerAddress ());
+
+  if (!endP->IsRxEnabled ())
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                    << " because endpoint can not receive packets");
+      return;
+    }
+
+  NS_ASSERT (endP->GetLocalPort () == dport);
+  if (endP->GetBoundNetDevice ())
+    {
+      if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+        {
+          NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                             << " because endpoint is bound to specific device and"
+                                             << endP->GetBoundNetDevice ()
+                                             << " does not match packet device " << incomingInterface->GetDevice ());
+          return;
+        }
+    }
+  bool localAddressMatchesWildCard = 
+    endP->GetLocalAddress () == Ipv4Address::GetAny ();
+  bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+
+  if (isBroadcast)
+    {
+      NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
+    }
+
+  if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+    {
+      localAddressMatchesExact = (endP->GetLocalAddress () ==
+                                  incomingInterfaceAddr);
+    }
+  // if no match here, keep looking
+  if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+    return; 
+  bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+  bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+  bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+  bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
+    Ipv4Address::GetAny ();
+  // If remote does not match either with exact or wildcard,
+  // skip this one
+  if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+    return;
+  if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+    return;
+
+  // Now figure out which return list to add this one to
+  if (localAddressMatchesWildCard &&
+      remotePeerMatchesWildCard &&
+      remoteAddressMatchesWildCard)
+    { // Only local port matches exactly
+      retval[0].push_back (endP);
+    }
+  if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
+      remotePeerMatchesWildCard &&
+      remoteAddressMatchesWildCard)
+    { // Only local port and local address matches exactly
+      retval[1].push_back (endP);
+    }
+  if (localAddressMatchesWildCard &&
+      remotePeerMatchesExact &&
+      remoteAddressMatchesExact)
+    { // All but local address
+      retval[2].push_back (endP);
+    }
+  if (localAddressMatchesExact &&
+      remotePeerMatchesExact &&
+      remoteAddressMatchesExact)
+    { // All 4 match
+      retval[3].push_back (endP);
+    }
+}
+
 /*
  * If we have an exact match, we return it.
  * Otherwise, if we find a generic match, we return it.
@@ -198,122 +403,68 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
   
-  EndPoints retval1; // Matches exact on local port, wildcards on others
-  EndPoints retval2; // Matches exact on local port/adder, wildcards on others
-  EndPoints retval3; // Matches all but local address
-  EndPoints retval4; // Exact match on all 4
+  // retval[0]: Matches exact on local port, wildcards on others
+  // retval[1]: Matches exact on local port/adder, wildcards on others
+  // retval[2]: Matches all but local address
+  // retval[3]: Exact match on all 4
+  EndPoints retval[4];
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
     {
-      Ipv4EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-
-      if (!endP->IsRxEnabled ())
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
-          continue;
-        }
-
-      if (endP->GetLocalPort () != dport) 
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
         }
-      if (endP->GetBoundNetDevice ())
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // A connected end point only matches a packet of its own four-tuple,
+  // whose destination is the local address or, for a broadcast, the
+  // address of the incoming interface.
+  sgi::hash_map<Tuple, EndPoints, TupleHash>::iterator connected =
+    m_connected.find (MakeTuple (daddr, dport, saddr, sport));
+  if (connected != m_connected.end ())
+    {
+      for (EndPointsI i = connected->second.begin (); i != connected->second.end (); i++)
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
-            {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
-              continue;
-            }
+          LookupMatch (*i, daddr, dport, saddr, sport, incomingInterface,
+                       isBroadcast, incomingInterfaceAddr, retval);
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    }
+  if (isBroadcast && incomingInterfaceAddr != daddr)
+    {
+      connected = m_connected.find (MakeTuple (incomingInterfaceAddr, dport, saddr, sport));
+      if (connected != m_connected.end ())
         {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+          for (EndPointsI i = connected->second.begin (); i != connected->second.end (); i++)
             {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
+              LookupMatch (*i, daddr, dport, saddr, sport, incomingInterface,
+                           isBroadcast, incomingInterfaceAddr, retval);
             }
         }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
-      bool localAddressMatchesWildCard = 
-        endP->GetLocalAddress () == Ipv4Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
-
-      if (isBroadcast)
-        {
-          NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
-        }
-
-      if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+    }
+  std::map<uint16_t, Port>::iterator port = m_ports.find (dport);
+  if (port != m_ports.end ())
+    {
+      for (EndPointsI i = port->second.wildcards.begin (); i != port->second.wildcards.end (); i++)
         {
-          localAddressMatchesExact = (endP->GetLocalAddress () ==
-                                      incomingInterfaceAddr);
-        }
-      // if no match here, keep looking
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        continue; 
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
-        Ipv4Address::GetAny ();
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
-
-      // Now figure out which return list to add this one to
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port matches exactly
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port and local address matches exactly
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All but local address
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All 4 match
-          retval4.push_back (endP);
+          LookupMatch (*i, daddr, dport, saddr, sport, incomingInterface,
+                       isBroadcast, incomingInterfaceAddr, retval);
         }
     }
 
   // Here we find the most exact match
-  if (!retval4.empty ()) return retval4;
-  if (!retval3.empty ()) return retval3;
-  if (!retval2.empty ()) return retval2;
-  return retval1;  // might be empty if no matches
+  if (!retval[3].empty ()) return retval[3];
+  if (!retval[2].empty ()) return retval[2];
+  if (!retval[1].empty ()) return retval[1];
+  return retval[0];  // might be empty if no matches
 }
 
 Ipv4EndPoint *
@@ -324,6 +475,14 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  sgi::hash_map<Tuple, EndPoints, TupleHash>::iterator connected =
+    m_connected.find (MakeTuple (daddr, dport, saddr, sport));
+  if (connected != m_connected.end ())
+    {
+      /* this is an exact match. */
+      return connected->second.front ();
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
   uint32_t genericity = 3;
@@ -361,24 +520,43 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 uint16_t
 Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
-  // Similar to counting up logic in netinet/in_pcb.c
+  // Similar to counting up logic in netinet/in_pcb.c, with a bitmap
+  // of the ports in use.
   NS_LOG_FUNCTION (this);
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do 
+  uint32_t nPorts = m_portLast - m_portFirst + 1;
+  if (m_ephemeralPorts.empty ())
     {
-      if (count-- < 0)
+      m_ephemeralPorts.resize ((nPorts + 31) / 32, 0);
+      for (std::map<uint16_t, Port>::iterator i = m_ports.lower_bound (m_portFirst);
+           i != m_ports.end () && i->first <= m_portLast; i++)
         {
-          return 0;
+          SetEphemeralPortUsed (i->first, true);
         }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
+    }
+  uint32_t bit = 0;
+  if (m_ephemeral >= m_portFirst && m_ephemeral < m_portLast)
+    {
+      bit = m_ephemeral + 1 - m_portFirst;
+    }
+  for (uint32_t count = 0; count < nPorts; )
+    {
+      uint32_t word = m_ephemeralPorts[bit / 32];
+      if (bit % 32 == 0 && word == 0xffffffff && bit + 32 <= nPorts)
         {
-          port = m_portFirst;
+          // 32 ports in use.
+          count += 32;
+          bit = (bit + 32) % nPorts;
+          continue;
+        }
+      if ((word & (1U << (bit % 32))) == 0)
+        {
+          m_ephemeral = m_portFirst + bit;
+          return m_ephemeral;
         }
-    } while (LookupPortLocal (port));
-  m_ephemeral = port;
-  return port;
+      count++;
+      bit = (bit + 1) % nPorts;
+    }
+  return 0;
 }
 
 } // namespace ns3
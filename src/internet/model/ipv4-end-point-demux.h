@@ -23,7 +23,10 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv4-interface.h"
 
 namespace ns3 {
@@ -38,6 +41,13 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed so that a lookup does not visit all of
+ * them: the connected endpoints, whose four-tuple has no wildcard, are
+ * found by hashing the four-tuple of the packet, and the other ones
+ * are kept in a table of the local ports.  The endpoints notify the
+ * demux when their local address or their peer change.  The ephemeral
+ * ports in use are tracked in a bitmap.
  */
 
 class Ipv4EndPointDemux {
@@ -85,7 +95,9 @@ public:
    *   -# Only local port and local address match
    *   -# Only local port match
    *
-   * EndPoint with disabled Rx are skipped.
+   * EndPoint with disabled Rx are skipped.  Within each list, the
+   * connected endpoints come before the other ones, which are in
+   * allocation order.
    *
    * \param daddr destination address to test
    * \param dport destination port to test
@@ -161,6 +173,117 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The four-tuple of a connected end point.
+   */
+  struct Tuple
+  {
+    uint64_t addresses; //!< The local and the peer addresses.
+    uint32_t ports;     //!< The local and the peer ports.
+
+    /**
+     * \brief Compare two four-tuples.
+     * \param other the other four-tuple
+     * \returns true if the four-tuples are equal
+     */
+    bool operator == (const Tuple &other) const;
+  };
+
+  /**
+   * \brief Hash of a four-tuple.
+   */
+  class TupleHash : public std::unary_function<Tuple, size_t>
+  {
+  public:
+    /**
+     * \brief Hash a four-tuple.
+     * \param tuple the four-tuple
+     * \returns the hash
+     */
+    size_t operator () (const Tuple &tuple) const;
+  };
+
+  /**
+   * \brief The end points of a local port.
+   */
+  struct Port
+  {
+    /**
+     * \brief The end points which are not connected, in allocation order.
+     */
+    EndPoints wildcards;
+    /**
+     * \brief The number of end points, connected or not, by local address.
+     */
+    std::map<Ipv4Address, uint32_t> addresses;
+  };
+
+  /**
+   * \brief Build a four-tuple.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \returns the four-tuple
+   */
+  static Tuple MakeTuple (Ipv4Address localAddress, uint16_t localPort,
+                          Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Check if an end point is connected.
+   * \param endPoint the end point
+   * \returns true if no field of the four-tuple of the end point is a wildcard
+   */
+  static bool IsConnected (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add a new end point to the demux.
+   * \param endPoint the end point
+   * \returns the end point
+   */
+  Ipv4EndPoint *Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the indexes.
+   * \param endPoint the end point
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the indexes.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Mark an ephemeral port as used or free in the bitmap.
+   * \param port the port, ignored if it is not an ephemeral port
+   * \param used true if the port is used
+   */
+  void SetEphemeralPortUsed (uint16_t port, bool used);
+
+  /**
+   * \brief Add an end point to the lookup results it matches.
+   * \param endP the end point
+   * \param daddr destination address to test
+   * \param dport destination port to test
+   * \param saddr source address to test
+   * \param sport source port to test
+   * \param incomingInterface the incoming interface
+   * \param isBroadcast true if daddr is a broadcast address
+   * \param incomingInterfaceAddr the address of the incoming interface
+   *        which daddr is a subnet-directed broadcast of, or daddr
+   * \param retval the four lists of Lookup, from the least to the most
+   *        exact match
+   */
+  void LookupMatch (Ipv4EndPoint *endP,
+                    Ipv4Address daddr, uint16_t dport,
+                    Ipv4Address saddr, uint16_t sport,
+                    Ptr<Ipv4Interface> incomingInterface,
+                    bool isBroadcast, Ipv4Address incomingInterfaceAddr,
+                    EndPoints retval[4]);
 
   /**
    * \brief Allocate an ephemeral port.
@@ -187,6 +310,23 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The connected end points, by four-tuple.
+   */
+  sgi::hash_map<Tuple, EndPoints, TupleHash> m_connected;
+
+  /**
+   * \brief The local ports in use.
+   */
+  std::map<uint16_t, Port> m_ports;
+
+  /**
+   * \brief One bit per ephemeral port, set if the port is in use.
+   *
+   * Allocated by the first ephemeral port allocation.
+   */
+  std::vector<uint32_t> m_ephemeralPorts;
 };
 
 } // namespace ns3
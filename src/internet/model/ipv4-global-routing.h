@@ -21,6 +21,7 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +29,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-prefix-trie.h"
 
 namespace ns3 {
 
@@ -167,6 +169,32 @@ public:
                              Ipv4Address nextHop,
                              uint32_t interface);
 
+  /**
+   * \brief Remove a host route from the global routing table.
+   *
+   * \param dest The Ipv4Address destination of the route.
+   * \param nextHop The Ipv4Address of the next hop of the route.
+   * \param interface The network interface index of the route.
+   * \returns true if a route was removed
+   */
+  bool RemoveHostRouteTo (Ipv4Address dest,
+                          Ipv4Address nextHop,
+                          uint32_t interface);
+
+  /**
+   * \brief Remove a network route from the global routing table.
+   *
+   * \param network The Ipv4Address network of the route.
+   * \param networkMask The Ipv4Mask of the network.
+   * \param nextHop The next hop of the route.
+   * \param interface The network interface index of the route.
+   * \returns true if a route was removed
+   */
+  bool RemoveNetworkRouteTo (Ipv4Address network,
+                             Ipv4Mask networkMask,
+                             Ipv4Address nextHop,
+                             uint32_t interface);
+
   /**
    * \brief Get the number of individual unicast routes that have been added
    * to the routing table.
@@ -260,10 +288,24 @@ private:
 
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Index the routes in m_trie if they changed.
+   */
+  void UpdateTrie (void);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  /// The host, network and external routes, in the order of GetRoute
+  std::vector<Ipv4RoutingTableEntry *> m_routes;
+  /// The positions of the routes in m_routes, by prefix
+  Ipv4PrefixTrie m_trie;
+  /// True if m_routes and m_trie are up to date
+  bool m_trieValid;
+  /// The positions of the routes which may match a destination
+  std::vector<uint32_t> m_candidates;
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -379,17 +379,45 @@ Ipv4Header::GetSerializedSize (void) const
 	return m_headerSize;
 }
 
+/**
+ * Compute the checksum of a header image, the way
+ * Buffer::Iterator::CalculateIpChecksum would in the buffer.
+ *
+ * \param [in] image The header bytes.
+ * \param [in] size The number of bytes, even.
+ * \returns The checksum, to be written with WriteU16.
+ */
+static uint16_t
+ImageChecksum (uint8_t const *image, uint32_t size)
+{
+  /* see RFC 1071 to understand this code. */
+  uint32_t sum = 0;
+  for (uint32_t j = 0; j < size; j += 2)
+    {
+      sum += image[j] | (image[j + 1] << 8);
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return ~sum;
+}
+
 void
 Ipv4Header::Serialize (Buffer::Iterator start) const
 {
   NS_LOG_FUNCTION (this << &start);
-  Buffer::Iterator i = start;
+  // Build the header in place and copy it in the buffer at once.
+  uint8_t image[20];
 
   uint8_t verIhl = (4 << 4) | (5);
-  i.WriteU8 (verIhl);
-  i.WriteU8 (m_tos);
-  i.WriteHtonU16 (m_payloadSize + 5*4);
-  i.WriteHtonU16 (m_identification);
+  image[0] = verIhl;
+  image[1] = m_tos;
+  uint16_t totalLength = m_payloadSize + 5*4;
+  image[2] = totalLength >> 8;
+  image[3] = totalLength & 0xff;
+  image[4] = m_identification >> 8;
+  image[5] = m_identification & 0xff;
   uint32_t fragmentOffset = m_fragmentOffset / 8;
   uint8_t flagsFrag = (fragmentOffset >> 8) & 0x1f;
   if (m_flags & DONT_FRAGMENT) 
@@ -400,39 +428,42 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
     {
       flagsFrag |= (1<<5);
     }
-  i.WriteU8 (flagsFrag);
-  uint8_t frag = fragmentOffset & 0xff;
-  i.WriteU8 (frag);
-  i.WriteU8 (m_ttl);
-  i.WriteU8 (m_protocol);
-  i.WriteHtonU16 (0);
-  i.WriteHtonU32 (m_source.Get ());
-  i.WriteHtonU32 (m_destination.Get ());
+  image[6] = flagsFrag;
+  image[7] = fragmentOffset & 0xff;
+  image[8] = m_ttl;
+  image[9] = m_protocol;
+  image[10] = 0;
+  image[11] = 0;
+  m_source.Serialize (&image[12]);
+  m_destination.Serialize (&image[16]);
 
   if (m_calcChecksum) 
     {
-      i = start;
-      uint16_t checksum = i.CalculateIpChecksum (20);
+      uint16_t checksum = ImageChecksum (image, 20);
       NS_LOG_LOGIC ("checksum=" <<checksum);
-      i = start;
-      i.Next (10);
-      i.WriteU16 (checksum);
+      image[10] = checksum & 0xff;
+      image[11] = checksum >> 8;
     }
+  start.Write (image, 20);
 }
 uint32_t
 Ipv4Header::Deserialize (Buffer::Iterator start)
 {
   NS_LOG_FUNCTION (this << &start);
+  // Copy the header out of the buffer at once and decode it there.
+  uint8_t image[20];
   Buffer::Iterator i = start;
-  uint8_t verIhl = i.ReadU8 ();
+  i.Read (image, 20);
+
+  uint8_t verIhl = image[0];
   uint8_t ihl = verIhl & 0x0f; 
   uint16_t headerSize = ihl * 4;
   NS_ASSERT ((verIhl >> 4) == 4);
-  m_tos = i.ReadU8 ();
-  uint16_t size = i.ReadNtohU16 ();
+  m_tos = image[1];
+  uint16_t size = (image[2] << 8) | image[3];
   m_payloadSize = size - headerSize;
-  m_identification = i.ReadNtohU16 ();
-  uint8_t flags = i.ReadU8 ();
+  m_identification = (image[4] << 8) | image[5];
+  uint8_t flags = image[6];
   m_flags = 0;
   if (flags & (1<<6)) 
     {
@@ -442,23 +473,30 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
     {
       m_flags |= MORE_FRAGMENTS;
     }
-  i.Prev ();
-  m_fragmentOffset = i.ReadU8 () & 0x1f;
+  m_fragmentOffset = flags & 0x1f;
   m_fragmentOffset <<= 8;
-  m_fragmentOffset |= i.ReadU8 ();
+  m_fragmentOffset |= image[7];
   m_fragmentOffset <<= 3;
-  m_ttl = i.ReadU8 ();
-  m_protocol = i.ReadU8 ();
-  m_checksum = i.ReadU16 ();
-  /* i.Next (2); // checksum */
-  m_source.Set (i.ReadNtohU32 ());
-  m_destination.Set (i.ReadNtohU32 ());
+  m_ttl = image[8];
+  m_protocol = image[9];
+  m_checksum = image[10] | (image[11] << 8);
+  m_source = Ipv4Address::Deserialize (&image[12]);
+  m_destination = Ipv4Address::Deserialize (&image[16]);
   m_headerSize = headerSize;
 
   if (m_calcChecksum) 
     {
-      i = start;
-      uint16_t checksum = i.CalculateIpChecksum (headerSize);
+      uint16_t checksum;
+      if (headerSize == 20)
+        {
+          checksum = ImageChecksum (image, 20);
+        }
+      else
+        {
+          // The options are not decoded, but they are checksummed.
+          i = start;
+          checksum = i.CalculateIpChecksum (headerSize);
+        }
       NS_LOG_LOGIC ("checksum=" <<checksum);
 
       m_goodChecksum = (checksum == 0);
@@ -29,7 +29,6 @@
 #include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object-vector.h"
-#include "ns3/tcp-header.h"
 
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
@@ -223,6 +222,11 @@ Ipv4L3Protocol::SetNetfilter (Ptr<Ipv4Netfilter> netfilter)
 {
   NS_LOG_FUNCTION (this << netfilter);
   m_netfilter = netfilter;
+  m_conntrackConfirm.Nullify ();
+  if (netfilter != 0)
+    {
+      m_conntrackConfirm = MakeCallback (&Ipv4Netfilter::NetfilterConntrackConfirm, netfilter);
+    }
 }
 
 Ptr<Ipv4Netfilter>
@@ -249,6 +253,7 @@ Ipv4L3Protocol::DoDispose (void)
   m_sockets.clear ();
   m_node = 0;
   m_routingProtocol = 0;
+  m_conntrackConfirm.Nullify ();
 
   for (MapFragments_t::iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
     {
@@ -508,14 +513,17 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
         {
 
           NS_LOG_DEBUG ("NF_INET_PRE_ROUTING packet not accepted");
-          Ipv4Header ipHeader;
-          if (Node::ChecksumEnabled ())
+          if (!m_dropTrace.IsEmpty ())
             {
-              ipHeader.EnableChecksum ();
+              Ipv4Header ipHeader;
+              if (Node::ChecksumEnabled ())
+                {
+                  ipHeader.EnableChecksum ();
+                }
+              packet->RemoveHeader (ipHeader);
+              int32_t interfacePkt = GetInterfaceForDevice (device);
+              m_dropTrace (ipHeader, packet, DROP_NF_DROP, this, interfacePkt);
             }
-          packet->RemoveHeader (ipHeader);
-          int32_t interfacePkt = GetInterfaceForDevice (device);
-          m_dropTrace (ipHeader, packet, DROP_NF_DROP, m_node->GetObject<Ipv4> (), interfacePkt);
           return;
         }
     }
@@ -530,20 +538,23 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
         {
           if (ipv4Interface->IsUp ())
             {
-              m_rxTrace (packet, m_node->GetObject<Ipv4> (), interface);
+              m_rxTrace (packet, this, interface);
               break;
             }
           else
             {
               std::cout<<"\nin``````````````````````````````";
               NS_LOG_LOGIC ("Dropping received packet -- interface is down");
-              Ipv4Header ipHeader;
-              if (Node::ChecksumEnabled ())
+              if (!m_dropTrace.IsEmpty ())
                 {
-                  ipHeader.EnableChecksum ();
+                  Ipv4Header ipHeader;
+                  if (Node::ChecksumEnabled ())
+                    {
+                      ipHeader.EnableChecksum ();
+                    }
+                  packet->RemoveHeader (ipHeader);
+                  m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, this, interface);
                 }
-              packet->RemoveHeader (ipHeader);
-              m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
               return;
             }
         }
@@ -570,7 +581,7 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
 
       std::cout<<"\nDrop in receive method--------------------------";
 
-      m_dropTrace (ipHeader, packet, DROP_BAD_CHECKSUM, m_node->GetObject<Ipv4> (), interface);
+      m_dropTrace (ipHeader, packet, DROP_BAD_CHECKSUM, this, interface);
       return;
     }
 
@@ -591,7 +602,7 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
                                       ))
     {
       NS_LOG_WARN ("No route found for forwarding packet.  Drop.");
-      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), interface);
+      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, this, interface);
     }
 
 
@@ -740,8 +751,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
           if (m_netfilter != 0)
             {
               NS_LOG_DEBUG ("NF_INET_POST_ROUTING Hook");
-              Callback<uint32_t, Ptr<Packet> > ccb = MakeCallback (&Ipv4Netfilter::NetfilterConntrackConfirm, m_netfilter);
-              Verdicts_t verdict = (Verdicts_t) m_netfilter->ProcessHook (PF_INET, NF_INET_POST_ROUTING, packetCopy, 0, device, ccb);
+              Verdicts_t verdict = (Verdicts_t) m_netfilter->ProcessHook (PF_INET, NF_INET_POST_ROUTING, packetCopy, 0, device, m_conntrackConfirm);
               if (verdict == NF_DROP)
                 {
                   NS_LOG_DEBUG ("NF_INET_POST_ROUTING packet not accepted");
@@ -752,7 +762,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
 
 
 
-          m_txTrace (packetCopy, m_node->GetObject<Ipv4> (), ifaceIndex);
+          m_txTrace (packetCopy, this, ifaceIndex);
           outInterface->Send (packetCopy, destination);
         }
       return;
@@ -797,8 +807,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
               if (m_netfilter != 0)
                 {
                   NS_LOG_DEBUG ("NF_INET_POST_ROUTING Hook");
-                  Callback<uint32_t, Ptr<Packet> > ccb = MakeCallback (&Ipv4Netfilter::NetfilterConntrackConfirm, m_netfilter);
-                  Verdicts_t verdict = (Verdicts_t) m_netfilter->ProcessHook (PF_INET, NF_INET_POST_ROUTING, packetCopy, 0, device, ccb);
+                  Verdicts_t verdict = (Verdicts_t) m_netfilter->ProcessHook (PF_INET, NF_INET_POST_ROUTING, packetCopy, 0, device, m_conntrackConfirm);
                   if (verdict == NF_DROP)
                     {
                       NS_LOG_DEBUG ("NF_INET_POST_ROUTING packet not accepted");
@@ -808,7 +817,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
                 }
 
 
-              m_txTrace (packetCopy, m_node->GetObject<Ipv4> (), ifaceIndex);
+              m_txTrace (packetCopy, this, ifaceIndex);
               outInterface->Send (packetCopy, destination);
               return;
             }
@@ -912,7 +921,7 @@ if (m_netfilter != 0)
   else
     {
       NS_LOG_WARN ("No route to host.  Drop.");
-      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), 0);
+      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, this, 0);
     }
 }
 
@@ -980,20 +989,22 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
 if (m_netfilter != 0)
     {
       NS_LOG_DEBUG ("NF_INET_POST_ROUTING Hook");
-      ContinueCallback ccb = MakeCallback (&Ipv4Netfilter::NetfilterConntrackConfirm, m_netfilter);
-      Verdicts_t verdict=(Verdicts_t) m_netfilter->ProcessHook (PF_INET, NF_INET_POST_ROUTING, packet, 0, outDev, ccb);
+      Verdicts_t verdict=(Verdicts_t) m_netfilter->ProcessHook (PF_INET, NF_INET_POST_ROUTING, packet, 0, outDev, m_conntrackConfirm);
 
       if (verdict == NF_DROP)
         {
           NS_LOG_DEBUG ("NF_INET_POST_ROUTING packet not accepted");
-          Ipv4Header ipH = ipHeader;
-          if (Node::ChecksumEnabled ())
+          if (!m_dropTrace.IsEmpty ())
             {
-              ipH.EnableChecksum ();
+              Ipv4Header ipH = ipHeader;
+              if (Node::ChecksumEnabled ())
+                {
+                  ipH.EnableChecksum ();
+                }
+              packet->RemoveHeader (ipH);
+              int32_t interfacePkt = GetInterfaceForDevice (outDev);
+              m_dropTrace (ipH, packet, DROP_NF_DROP, this, interfacePkt);
             }
-          packet->RemoveHeader (ipH);
-          int32_t interfacePkt = GetInterfaceForDevice (outDev);
-          m_dropTrace (ipH, packet, DROP_NF_DROP, m_node->GetObject<Ipv4> (), interfacePkt);
           return;
         }
       
@@ -1002,7 +1013,7 @@ if (m_netfilter != 0)
  if (route == 0)
     {
       NS_LOG_WARN ("No route to host.  Drop.");
-      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), 0);
+      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, this, 0);
       return;
     }
 
@@ -1026,26 +1037,29 @@ if (m_netfilter != 0)
               DoFragmentation (packet, outInterface->GetDevice ()->GetMtu (), listFragments);
               for ( std::list<Ptr<Packet> >::iterator it = listFragments.begin (); it != listFragments.end (); it++ )
                 {
-                  m_txTrace (*it, m_node->GetObject<Ipv4> (), interface);
+                  m_txTrace (*it, this, interface);
                   outInterface->Send (*it, route->GetGateway ());
                 }
             }
           else
             {
-              m_txTrace (packet, m_node->GetObject<Ipv4> (), interface);
+              m_txTrace (packet, this, interface);
               outInterface->Send (packet, route->GetGateway ());
             }
         }
       else
         {
           NS_LOG_LOGIC ("Dropping -- outgoing interface is down: " << route->GetGateway ());
-          Ipv4Header ipHeader;
-          if (Node::ChecksumEnabled ())
+          if (!m_dropTrace.IsEmpty ())
             {
-              ipHeader.EnableChecksum ();
+              Ipv4Header ipHeader;
+              if (Node::ChecksumEnabled ())
+                {
+                  ipHeader.EnableChecksum ();
+                }
+              packet->RemoveHeader (ipHeader);
+              m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, this, interface);
             }
-          packet->RemoveHeader (ipHeader);
-          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
         }
     } 
   else 
@@ -1060,26 +1074,29 @@ if (m_netfilter != 0)
               for ( std::list<Ptr<Packet> >::iterator it = listFragments.begin (); it != listFragments.end (); it++ )
                 {
                   NS_LOG_LOGIC ("Sending fragment " << **it );
-                  m_txTrace (*it, m_node->GetObject<Ipv4> (), interface);
+                  m_txTrace (*it, this, interface);
                   outInterface->Send (*it, ipHeader.GetDestination ());
                 }
             }
           else
             {
-              m_txTrace (packet, m_node->GetObject<Ipv4> (), interface);
+              m_txTrace (packet, this, interface);
               outInterface->Send (packet, ipHeader.GetDestination ());
             }
         }
       else
         {
           NS_LOG_LOGIC ("Dropping -- outgoing interface is down: " << ipHeader.GetDestination ());
-          Ipv4Header ipHeader;
-          if (Node::ChecksumEnabled ())
+          if (!m_dropTrace.IsEmpty ())
             {
-              ipHeader.EnableChecksum ();
+              Ipv4Header ipHeader;
+              if (Node::ChecksumEnabled ())
+                {
+                  ipHeader.EnableChecksum ();
+                }
+              packet->RemoveHeader (ipHeader);
+              m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, this, interface);
             }
-          packet->RemoveHeader (ipHeader);
-          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
         }
     }
 }
@@ -1105,7 +1122,7 @@ Ipv4L3Protocol::IpMulticastForward (Ptr<Ipv4MulticastRoute> mrtentry, Ptr<const
       if (h.GetTtl () == 0)
         {
           NS_LOG_WARN ("TTL exceeded.  Drop.");
-          m_dropTrace (header, packet, DROP_TTL_EXPIRED, m_node->GetObject<Ipv4> (), interfaceId);
+          m_dropTrace (header, packet, DROP_TTL_EXPIRED, this, interfaceId);
           return;
         }
       NS_LOG_LOGIC ("Forward multicast via interface " << interfaceId);
@@ -1145,7 +1162,7 @@ Ipv4L3Protocol::IpForward (Ptr<Ipv4Route> rtentry, Ptr<const Packet> p, const Ip
           icmp->SendTimeExceededTtl (ipHeader, packet);
         }
       NS_LOG_WARN ("TTL exceeded.  Drop.");
-      m_dropTrace (header, packet, DROP_TTL_EXPIRED, m_node->GetObject<Ipv4> (), interface);
+      m_dropTrace (header, packet, DROP_TTL_EXPIRED, this, interface);
       return;
     }
   m_unicastForwardTrace (ipHeader, packet, interface);
@@ -1164,22 +1181,6 @@ Ipv4L3Protocol::LocalDeliver (Ptr<const Packet> packet, Ipv4Header const&ip, uin
   Ptr<Packet> p = packet->Copy (); // need to pass a non-const packet up
   Ipv4Header ipHeader = ip;
   Ptr<Packet> pkt = packet->Copy ();
-  Ptr<Packet> p1 = packet->Copy (); // need to pass a non-const packet up
-
-
-  TcpHeader tcpheader; 
-  if (Node::ChecksumEnabled ())
-    {
-      tcpheader.EnableChecksums ();
-    }
-  p1->RemoveHeader(tcpheader);
-//std::cout<<"\n";
-//std::cout<<"At time " << Simulator::Now ().GetSeconds ()<<" s ";
-//std::cout<<ipHeader.GetDestination()<<" is receiving packet with Sequence number ";
-//std::cout<<tcpheader.GetSequenceNumber()<<" and Ack number "<<tcpheader.GetAckNumber()<<" from "<<ipHeader.GetSource();
-//std::cout<<"\n";
-
-
 
   Ptr<NetDevice> device = GetNetDevice(iif);
  
@@ -1187,8 +1188,7 @@ Ipv4L3Protocol::LocalDeliver (Ptr<const Packet> packet, Ipv4Header const&ip, uin
   if (m_netfilter != 0)
     {
       NS_LOG_DEBUG ("NF_INET_LOCAL_IN Hook");
-      Callback<uint32_t, Ptr<Packet> > ccb = MakeCallback (&Ipv4Netfilter::NetfilterConntrackConfirm, m_netfilter);
-      Verdicts_t verdict = (Verdicts_t) m_netfilter->ProcessHook (PF_INET, NF_INET_LOCAL_IN, pkt, 0, device, ccb);
+      Verdicts_t verdict = (Verdicts_t) m_netfilter->ProcessHook (PF_INET, NF_INET_LOCAL_IN, pkt, 0, device, m_conntrackConfirm);
       if (verdict == NF_DROP)
         {
           NS_LOG_DEBUG ("NF_INET_LOCAL_IN packet not accepted");
@@ -1198,7 +1198,7 @@ Ipv4L3Protocol::LocalDeliver (Ptr<const Packet> packet, Ipv4Header const&ip, uin
             }
           pkt->RemoveHeader (ipHeader);
           int32_t interfacePkt = GetInterfaceForDevice (device);
-          m_dropTrace (ipHeader, pkt, DROP_NF_DROP, m_node->GetObject<Ipv4> (), interfacePkt);
+          m_dropTrace (ipHeader, pkt, DROP_NF_DROP, this, interfacePkt);
           return;
         }
     }
@@ -1513,7 +1513,7 @@ Ipv4L3Protocol::RouteInputError (Ptr<const Packet> p, const Ipv4Header & ipHeade
 {
   NS_LOG_FUNCTION (this << p << ipHeader << sockErrno);
   NS_LOG_LOGIC ("Route input failure-- dropping packet to " << ipHeader << " with errno " << sockErrno); 
-  m_dropTrace (ipHeader, p, DROP_ROUTE_ERROR, m_node->GetObject<Ipv4> (), 0);
+  m_dropTrace (ipHeader, p, DROP_ROUTE_ERROR, this, 0);
 }
 
 void
@@ -1600,9 +1600,6 @@ Ipv4L3Protocol::DoFragmentation (Ptr<Packet> packet, uint32_t outIfaceMtu, std::
       NS_LOG_LOGIC ("New fragment Header " << fragmentHeader);
       fragment->AddHeader (fragmentHeader);
 
-      std::ostringstream oss;
-      fragment->Print (oss);
-
       NS_LOG_LOGIC ("New fragment " << *fragment);
 
       listFragments.push_back (fragment);
@@ -1698,6 +1695,28 @@ Ipv4L3Protocol::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentO
     }
 
   m_fragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
+
+  // merge the range of the fragment with the ranges it overlaps or touches.
+  uint32_t start = fragmentOffset;
+  uint32_t end = start + fragment->GetSize ();
+  std::map<uint32_t, uint32_t>::iterator range = m_received.upper_bound (start);
+  if (range != m_received.begin ())
+    {
+      std::map<uint32_t, uint32_t>::iterator previous = range;
+      previous--;
+      if (previous->second >= start)
+        {
+          range = previous;
+          start = previous->first;
+        }
+    }
+  while (range != m_received.end () && range->first <= end)
+    {
+      end = std::max (end, range->second);
+      m_received.erase (range++);
+    }
+  m_received[start] = end;
+  NS_LOG_LOGIC ("Received " << m_received.size () << " disjoint ranges");
 }
 
 bool
@@ -1705,29 +1724,9 @@ Ipv4L3Protocol::Fragments::IsEntire () const
 {
   NS_LOG_FUNCTION (this);
 
-  bool ret = !m_moreFragment && m_fragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-        {
-          // overlapping fragments do exist
-          NS_LOG_LOGIC ("Checking overlaps " << lastEndOffset << " - " << it->second );
-
-          if (lastEndOffset < it->second)
-            {
-              ret = false;
-              break;
-            }
-          // fragments might overlap in strange ways
-          uint16_t fragmentEnd = it->first->GetSize () + it->second;
-          lastEndOffset = std::max ( lastEndOffset, fragmentEnd );
-        }
-    }
-
-  return ret;
+  // the fragments cover a single range, from the start of the packet to the
+  // end of the last fragment.
+  return !m_moreFragment && m_received.size () == 1 && m_received.begin ()->first == 0;
 }
 
 Ptr<Packet>
@@ -1817,7 +1816,7 @@ Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4H
       Ptr<Icmpv4L4Protocol> icmp = GetIcmp ();
       icmp->SendTimeExceededTtl (ipHeader, packet);
     }
-  m_dropTrace (ipHeader, packet, DROP_FRAGMENT_TIMEOUT, m_node->GetObject<Ipv4> (), iif);
+  m_dropTrace (ipHeader, packet, DROP_FRAGMENT_TIMEOUT, this, iif);
 
   // clear the buffers
   it->second = 0;
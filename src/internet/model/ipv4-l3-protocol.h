@@ -478,6 +478,8 @@ Ptr<Icmpv4L4Protocol> GetIcmp (void) const;
 
   Ptr<Ipv4RoutingProtocol> m_routingProtocol; //!< Routing protocol associated with the stack
 Ptr<Ipv4Netfilter> m_netfilter;
+  /// Conntrack confirmation passed to the netfilter hooks, built once per netfilter
+  Callback<uint32_t, Ptr<Packet> > m_conntrackConfirm;
   SocketList m_sockets; //!< List of IPv4 raw sockets.
 
   /**
@@ -534,6 +536,13 @@ private:
      */
     std::list<std::pair<Ptr<Packet>, uint16_t> > m_fragments;
 
+    /**
+     * \brief The byte ranges received, as disjoint [start, end) intervals
+     * indexed by their start, so that overlapping and adjacent fragments
+     * are merged as they arrive.
+     */
+    std::map<uint32_t, uint32_t> m_received;
+
   };
 
   /// Container of fragments, stored as pairs(src+dst addr, src+dst port) / fragment
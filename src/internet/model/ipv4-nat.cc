@@ -31,13 +31,17 @@
 
 #include "tcp-header.h"
 #include "udp-header.h"
+#include "icmpv4.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/simulator.h"
 #include "ipv4-nat.h"
 #include "ipv4.h"
 
 #include <iomanip>
+#include <fstream>
+#include <vector>
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4Nat");
 
@@ -51,6 +55,14 @@ Ipv4AddressGenerator address;
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4Nat);
 
+// Header of the files written by Ipv4Nat::SaveState
+static const uint32_t NAT_STATE_MAGIC = 0x6e617473;
+static const uint32_t NAT_STATE_VERSION = 3;
+// Serialized pool state which precedes the translation tuples
+static const uint32_t NAT_STATE_HEADER_SIZE = 4 + 4 + 4 + 2 + 2 + 2 + 2 + 4;
+// Serialized size of one translation tuple
+static const uint32_t NAT_STATE_TUPLE_SIZE = 4 + 4 + 2 + 2 + 8 + 4 * 8;
+
 TypeId
 Ipv4Nat::GetTypeId (void)
 {
@@ -64,8 +76,7 @@ Ipv4Nat::GetTypeId (void)
 
 
 Ipv4Nat::Ipv4Nat () //Constructor : Called whenever the nat is installed on any node.
-  : m_insideInterface (-1),
-    m_outsideInterface (-1),m_startport(-1),m_endport(-1)
+  : m_startport(-1),m_endport(-1),m_currentPort (0),m_flag (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -248,10 +259,11 @@ Ipv4Nat::PrintTable (Ptr<OutputStreamWrapper> stream) const
     {
       *os << "       Static Nat Rules" << std::endl;
       *os << "Local IP     Local Port     Global IP    Global Port " << std::endl;
-      for (uint32_t i = 0; i < GetNStaticRules (); i++)
+      for (StaticNatRules::const_iterator i = m_statictable.begin ();
+           i != m_statictable.end (); i++)
         {
           std::ostringstream locip,gloip,locprt,gloprt;
-          Ipv4StaticNatRule rule = GetStaticRule (i);
+          const Ipv4StaticNatRule &rule = *i;
 
           if (rule.GetLocalPort ())
             {
@@ -288,10 +300,11 @@ Ipv4Nat::PrintTable (Ptr<OutputStreamWrapper> stream) const
       *os << std::endl;
       *os << "       Dynamic Nat Rules" << std::endl;
       *os << "Local Network          Local Netmask" << std::endl;
-      for (uint32_t i = 0; i < GetNDynamicRules (); i++)
+      for (DynamicNatRules::const_iterator i = m_dynamictable.begin ();
+           i != m_dynamictable.end (); i++)
         {
           std::ostringstream locnet,locmask,gloip,glomask,strtprt,endprt;
-          Ipv4DynamicNatRule rule = GetDynamicRule (i);//Contains the tuple having localnet and subnet mask
+          const Ipv4DynamicNatRule &rule = *i;//Contains the tuple having localnet and subnet mask
                                                        //Rules keep track of the localnet and the subnet mask
           locnet << rule.GetLocalNet ();
           *os << std::setiosflags (std::ios::left) << std::setw (32) << locnet.str ();
@@ -309,10 +322,11 @@ Ipv4Nat::PrintTable (Ptr<OutputStreamWrapper> stream) const
       *os << std::endl;
       *os << "       Current Dynamic Translations" << std::endl;
       *os << "Local IP             Global IP    LocalPort       Translated Port" << std::endl;
-      for (uint32_t i = 0; i < GetNDynamicTuples (); i++)
+      for (DynamicNatTuple::const_iterator i = m_dynatuple.begin ();
+           i != m_dynatuple.end (); i++)
         {
           std::ostringstream locip,gloip,locprt,prt;
-          Ipv4DynamicNatTuple tup = GetDynamicTuple (i);//Returns the localip, globalip and the port assigned to each node
+          const Ipv4DynamicNatTuple &tup = *i;//Returns the localip, globalip and the port assigned to each node
                                                         //Tuples keep track of the entry for each node, having all the above information
 
           locip << tup.GetLocalAddress ();
@@ -335,6 +349,76 @@ Ipv4Nat::PrintTable (Ptr<OutputStreamWrapper> stream) const
     }
 }
 
+void
+Ipv4Nat::ExportTableHeader (Ptr<OutputStreamWrapper> stream) const
+{
+  *stream->GetStream () << "time_ns,type,local_ip,local_port,global_ip,global_port,age_ns,"
+                           "out_packets,out_bytes,in_packets,in_bytes\n";
+}
+
+void
+Ipv4Nat::ExportTable (Ptr<OutputStreamWrapper> stream) const
+{
+  NS_LOG_FUNCTION (this);
+  std::ostream* os = stream->GetStream ();
+  // Integer nanoseconds keep the full resolution of long simulations
+  Time now = Simulator::Now ();
+  int64_t nowNs = now.GetNanoSeconds ();
+  for (StaticNatRules::const_iterator i = m_statictable.begin ();
+       i != m_statictable.end (); i++)
+    {
+      *os << nowNs << ",S," << i->GetLocalIp () << ',' << i->GetLocalPort ()
+          << ',' << i->GetGlobalIp () << ',' << i->GetGlobalPort ()
+          << ",," << i->GetOutboundPackets () << ',' << i->GetOutboundBytes ()
+          << ',' << i->GetInboundPackets () << ',' << i->GetInboundBytes () << '\n';
+    }
+  for (DynamicNatTuple::const_iterator i = m_dynatuple.begin ();
+       i != m_dynatuple.end (); i++)
+    {
+      *os << nowNs << ",D," << i->GetLocalAddress () << ',' << i->GetLocalPort ()
+          << ',' << i->GetGlobalAddress () << ',' << i->GetTranslatedPort ()
+          << ',' << (now - i->GetCreationTime ()).GetNanoSeconds ()
+          << ',' << i->GetOutboundPackets () << ',' << i->GetOutboundBytes ()
+          << ',' << i->GetInboundPackets () << ',' << i->GetInboundBytes () << '\n';
+    }
+}
+
+Ipv4Nat::CountersByAddress
+Ipv4Nat::GetLocalAddressCounters (void) const
+{
+  NS_LOG_FUNCTION (this);
+  CountersByAddress counters;
+  for (StaticNatRules::const_iterator i = m_statictable.begin ();
+       i != m_statictable.end (); i++)
+    {
+      counters[i->GetLocalIp ()].Add (*i);
+    }
+  for (DynamicNatTuple::const_iterator i = m_dynatuple.begin ();
+       i != m_dynatuple.end (); i++)
+    {
+      counters[i->GetLocalAddress ()].Add (*i);
+    }
+  return counters;
+}
+
+Ipv4Nat::CountersByAddress
+Ipv4Nat::GetGlobalAddressCounters (void) const
+{
+  NS_LOG_FUNCTION (this);
+  CountersByAddress counters;
+  for (StaticNatRules::const_iterator i = m_statictable.begin ();
+       i != m_statictable.end (); i++)
+    {
+      counters[i->GetGlobalIp ()].Add (*i);
+    }
+  for (DynamicNatTuple::const_iterator i = m_dynatuple.begin ();
+       i != m_dynatuple.end (); i++)
+    {
+      counters[i->GetGlobalAddress ()].Add (*i);
+    }
+  return counters;
+}
+
 uint32_t
 Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
                           Ptr<NetDevice> in, Ptr<NetDevice> out, ContinueCallback& ccb)
@@ -350,22 +434,30 @@ Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
 
   Ipv4Header ipHeader;
 
-  NS_LOG_DEBUG ("Input device " << m_ipv4->GetInterfaceForDevice (in) << " inside interface " << m_insideInterface);
-  NS_LOG_DEBUG ("Output device " << m_ipv4->GetInterfaceForDevice (out) << " outside interface " << m_outsideInterface);
+  NS_LOG_DEBUG ("Input device role " << (uint16_t) GetDeviceRole (in) << " output device role " << (uint16_t) GetDeviceRole (out));
   if (Node::ChecksumEnabled ())
     {
       ipHeader.EnableChecksum ();
     }
   p->RemoveHeader (ipHeader);
-  if (m_ipv4->GetInterfaceForDevice (in) == m_outsideInterface) //The interface number of an Ipv4 interface or -1 if not found. 
-    {                                                           //Member variable of the class IPv4Nat (Nat node) - OutsideInterface.
+  if (GetDeviceRole (in) & ROLE_OUTSIDE)
+    {
       // outside interface is the input interface, NAT the destination addr
       // so that the NAT does not try to locally deliver the packet
       NS_LOG_DEBUG ("evaluating packet with src " << ipHeader.GetSource () << " dst " << ipHeader.GetDestination ());
       Ipv4Address destAddress = ipHeader.GetDestination ();
+      if (ipHeader.GetProtocol () == IPPROTO_ICMP)
+        {
+          if (DoNatIcmpPreRouting (p, ipHeader))
+            {
+              value=true;
+            }
+          p->AddHeader (ipHeader);
+          return NF_ACCEPT;
+        }
       //std::cout<< "Destination Address:\n"<<destAddress;//Confirms the packets coming from the server.
       //Checking for Static NAT Rules
-      for (StaticNatRules::const_iterator i = m_statictable.begin ();
+      for (StaticNatRules::iterator i = m_statictable.begin ();
            i != m_statictable.end (); i++)
         {
           if (destAddress != (*i).GetGlobalIp ())
@@ -379,6 +471,7 @@ Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
               ipHeader.SetDestination ((*i).GetLocalIp ());
               p->AddHeader (ipHeader);
               value=true;
+              (*i).RecordInbound (p->GetSize ());
               return NF_ACCEPT;
             }
           else
@@ -407,7 +500,7 @@ Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
                       ipHeader.SetDestination ((*i).GetLocalIp ());
                       p->AddHeader (ipHeader);
                       value=true;
-
+                      (*i).RecordInbound (p->GetSize ());
                       return NF_ACCEPT;
 
                     }
@@ -439,7 +532,7 @@ Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
                       ipHeader.SetDestination ((*i).GetLocalIp ());
                       p->AddHeader (ipHeader);
                       value=true;
-
+                      (*i).RecordInbound (p->GetSize ());
                       return NF_ACCEPT;
                     }
                   p->AddHeader (udpHeader);
@@ -458,7 +551,7 @@ Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
 
       //std::cout<<"Destination address : " << destAddress << "AddressPoolIP : " << GetAddressPoolIp()<<"\n\n"; Confirms that both are always the same
 
-      for (DynamicNatTuple::const_iterator i = m_dynatuple.begin ();
+      for (DynamicNatTuple::iterator i = m_dynatuple.begin ();
            i != m_dynatuple.end (); i++)
         {
           if (destAddress != (*i).GetGlobalAddress ())
@@ -472,6 +565,7 @@ Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
               ipHeader.SetDestination ((*i).GetLocalAddress ());
               p->AddHeader (ipHeader);
               value=true;
+              (*i).RecordInbound (p->GetSize ());
               return NF_ACCEPT;
             }
 
@@ -498,6 +592,7 @@ Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
                       p->AddHeader (tcpHeader);
                       p->AddHeader (ipHeader);
                       value=true;
+                      (*i).RecordInbound (p->GetSize ());
                       return NF_ACCEPT;
                     }
                   p->AddHeader (tcpHeader);
@@ -526,6 +621,7 @@ Ipv4Nat::DoNatPreRouting (Hooks_t hookNumber, Ptr<Packet> p,
                       p->AddHeader (udpHeader);
                       p->AddHeader (ipHeader);
                       value=true;
+                      (*i).RecordInbound (p->GetSize ());
                       return NF_ACCEPT;
                      
                     }
@@ -561,8 +657,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
   uint16_t port;
   Ipv4Address global_ip; 
 
-  NS_LOG_DEBUG ("Input device " << m_ipv4->GetInterfaceForDevice (in) << " inside interface " << m_insideInterface);
-  NS_LOG_DEBUG ("Output device " << m_ipv4->GetInterfaceForDevice (out) << " outside interface " << m_outsideInterface);
+  NS_LOG_DEBUG ("Input device role " << (uint16_t) GetDeviceRole (in) << " output device role " << (uint16_t) GetDeviceRole (out));
   if (Node::ChecksumEnabled ())
     {
       ipHeader.EnableChecksum ();
@@ -572,16 +667,22 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
 /*std::cout<<ipHeader;
   std::cout<<"\n\n";*/
 
-  if (m_ipv4->GetInterfaceForDevice (out) == m_outsideInterface) 
+  if (GetDeviceRole (out) & ROLE_OUTSIDE)
     {
       // matching output interface, consider whether to NAT the source
       // address and port
       NS_LOG_DEBUG ("evaluating packet with src " << ipHeader.GetSource () << " dst " << ipHeader.GetDestination ());
       Ipv4Address srcAddress = ipHeader.GetSource ();
+      if (ipHeader.GetProtocol () == IPPROTO_ICMP)
+        {
+          bool translated = DoNatIcmpPostRouting (p, ipHeader);
+          p->AddHeader (ipHeader);
+          return (translated || value) ? NF_ACCEPT : NF_DROP;
+        }
 
 
       //Checking for Static NAT Rules
-      for (StaticNatRules::const_iterator i = m_statictable.begin ();
+      for (StaticNatRules::iterator i = m_statictable.begin ();
            i != m_statictable.end (); i++)
         {
           if (srcAddress != (*i).GetLocalIp ())
@@ -594,7 +695,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
               NS_LOG_DEBUG ("Rule match with a non-port-specific rule");
               ipHeader.SetSource ((*i).GetGlobalIp ());
               p->AddHeader (ipHeader);
-
+              (*i).RecordOutbound (p->GetSize ());
               return NF_ACCEPT;
             }
           else
@@ -620,6 +721,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
                       p->AddHeader (tcpHeader);
                       ipHeader.SetSource ((*i).GetGlobalIp ());
                       p->AddHeader (ipHeader);
+                      (*i).RecordOutbound (p->GetSize ());
                       return NF_ACCEPT;
                     }
                   p->AddHeader (tcpHeader);
@@ -649,6 +751,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
                       
                       ipHeader.SetSource ((*i).GetGlobalIp ());
                       p->AddHeader (ipHeader);
+                      (*i).RecordOutbound (p->GetSize ());
                       return NF_ACCEPT;
                     }
                   p->AddHeader (udpHeader);
@@ -659,7 +762,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
       //Checking for Dynamic NAT Rules
 
       //Checking for existing connection
-      for (DynamicNatTuple::const_iterator i = m_dynatuple.begin (); //Ipv4DynamicNatTuple::Ipv4DynamicNatTuple (Ipv4Address local, Ipv4Address global, uint16_t port)
+      for (DynamicNatTuple::iterator i = m_dynatuple.begin (); //Ipv4DynamicNatTuple::Ipv4DynamicNatTuple (Ipv4Address local, Ipv4Address global, uint16_t port)
            i != m_dynatuple.end (); i++)
         {
                        
@@ -676,6 +779,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
               ipHeader.SetSource ((*i).GetGlobalAddress ());
               p->AddHeader (ipHeader);
 
+              (*i).RecordOutbound (p->GetSize ());
               return NF_ACCEPT;
             }
 
@@ -699,6 +803,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
                       p->AddHeader (tcpHeader);
                       ipHeader.SetSource ((*i).GetGlobalAddress()); //changes made
                       p->AddHeader (ipHeader);
+                      (*i).RecordOutbound (p->GetSize ());
                       return NF_ACCEPT;
                     }
                   p->AddHeader (tcpHeader);
@@ -723,6 +828,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
                       p->AddHeader (udpHeader);
                       ipHeader.SetSource ((*i).GetGlobalAddress());   //changes made          
                       p->AddHeader (ipHeader);
+                      (*i).RecordOutbound (p->GetSize ());
                       return NF_ACCEPT;
                     }
                   p->AddHeader (udpHeader);
@@ -776,6 +882,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
                   p->AddHeader (ipHeader);
                         
      
+                  m_dynatuple.front ().RecordOutbound (p->GetSize ());
                   return NF_ACCEPT;
                 }
               else
@@ -803,6 +910,7 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
 
                   p->AddHeader (ipHeader);
 
+                  m_dynatuple.front ().RecordOutbound (p->GetSize ());
                   return NF_ACCEPT;
                 }
 
@@ -829,6 +937,547 @@ Ipv4Nat::DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
 
 
 
+/**
+ * \param checksum an Internet checksum
+ * \param oldWord a 16-bit word covered by the checksum
+ * \param newWord the value replacing oldWord
+ * \returns the checksum updated for the new value of the word
+ *
+ * Incremental update of RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m').
+ */
+static uint16_t
+AdjustChecksum (uint16_t checksum, uint16_t oldWord, uint16_t newWord)
+{
+  uint32_t sum = (uint16_t) ~checksum + (uint16_t) ~oldWord + newWord;
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  return ~sum;
+}
+
+/**
+ * \param checksum an Internet checksum
+ * \param oldAddress an address covered by the checksum
+ * \param newAddress the address replacing oldAddress
+ * \returns the checksum updated for the new address
+ */
+static uint16_t
+AdjustChecksum (uint16_t checksum, Ipv4Address oldAddress, Ipv4Address newAddress)
+{
+  checksum = AdjustChecksum (checksum, oldAddress.Get () >> 16, newAddress.Get () >> 16);
+  return AdjustChecksum (checksum, oldAddress.Get () & 0xffff, newAddress.Get () & 0xffff);
+}
+
+/**
+ * \param protocol IP protocol number of a packet quoted by an ICMP error
+ * \param source true for the source port, false for the destination port
+ * \returns the offset of the port, or of the echo identifier, in the first
+ * eight bytes of the quoted L4 header; -1 if the protocol has no ports
+ */
+static int32_t
+GetQuotedPortOffset (uint8_t protocol, bool source)
+{
+  if (protocol == IPPROTO_TCP || protocol == IPPROTO_UDP)
+    {
+      return source ? 0 : 2;
+    }
+  if (protocol == IPPROTO_ICMP)
+    {
+      return 4;
+    }
+  return -1;
+}
+
+bool
+Ipv4Nat::FindOutsideMapping (Ipv4Address local, uint16_t localPort, uint8_t protocol,
+                             Ipv4Address &global, uint16_t &globalPort,
+                             StaticNatRules::iterator &rule,
+                             DynamicNatTuple::iterator &tuple)
+{
+  rule = m_statictable.end ();
+  tuple = m_dynatuple.end ();
+  for (StaticNatRules::iterator i = m_statictable.begin ();
+       i != m_statictable.end (); i++)
+    {
+      if (local != i->GetLocalIp ())
+        {
+          continue;
+        }
+      if (i->GetLocalPort () == 0)
+        {
+          global = i->GetGlobalIp ();
+          globalPort = localPort;
+          rule = i;
+          return true;
+        }
+      // port-specific rules do not apply to echo identifiers
+      if (protocol != IPPROTO_ICMP
+          && (i->GetProtocol () == protocol || i->GetProtocol () == 0)
+          && i->GetLocalPort () == localPort)
+        {
+          global = i->GetGlobalIp ();
+          globalPort = i->GetGlobalPort ();
+          rule = i;
+          return true;
+        }
+    }
+  for (DynamicNatTuple::iterator i = m_dynatuple.begin ();
+       i != m_dynatuple.end (); i++)
+    {
+      if (local != i->GetLocalAddress ())
+        {
+          continue;
+        }
+      if (i->GetLocalPort () == 0 || i->GetLocalPort () == localPort)
+        {
+          global = i->GetGlobalAddress ();
+          globalPort = i->GetLocalPort () == 0 ? localPort : i->GetTranslatedPort ();
+          tuple = i;
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+Ipv4Nat::FindInsideMapping (Ipv4Address global, uint16_t globalPort, uint8_t protocol,
+                            Ipv4Address &local, uint16_t &localPort,
+                            StaticNatRules::iterator &rule,
+                            DynamicNatTuple::iterator &tuple)
+{
+  rule = m_statictable.end ();
+  tuple = m_dynatuple.end ();
+  for (StaticNatRules::iterator i = m_statictable.begin ();
+       i != m_statictable.end (); i++)
+    {
+      if (global != i->GetGlobalIp ())
+        {
+          continue;
+        }
+      if (i->GetGlobalPort () == 0)
+        {
+          local = i->GetLocalIp ();
+          localPort = globalPort;
+          rule = i;
+          return true;
+        }
+      if (protocol != IPPROTO_ICMP
+          && (i->GetProtocol () == protocol || i->GetProtocol () == 0)
+          && i->GetGlobalPort () == globalPort)
+        {
+          local = i->GetLocalIp ();
+          localPort = i->GetLocalPort ();
+          rule = i;
+          return true;
+        }
+    }
+  for (DynamicNatTuple::iterator i = m_dynatuple.begin ();
+       i != m_dynatuple.end (); i++)
+    {
+      if (global != i->GetGlobalAddress ())
+        {
+          continue;
+        }
+      if (i->GetTranslatedPort () == 0 || i->GetTranslatedPort () == globalPort)
+        {
+          local = i->GetLocalAddress ();
+          localPort = i->GetTranslatedPort () == 0 ? globalPort : i->GetLocalPort ();
+          tuple = i;
+          return true;
+        }
+    }
+  return false;
+}
+
+template <typename T>
+bool
+Ipv4Nat::DoNatIcmpError (Ptr<Packet> p, Ipv4Header &ipHeader, bool inbound,
+                         StaticNatRules::iterator &rule, DynamicNatTuple::iterator &tuple)
+{
+  NS_LOG_FUNCTION (this << p << inbound);
+  T error;
+  p->RemoveHeader (error);
+  Ipv4Header quoted = error.GetHeader ();
+  uint8_t data[8];
+  error.GetData (data);
+
+  // An error coming from the outside quotes a packet that the NAT sent
+  // out, so the quoted source is the translated endpoint; an error sent
+  // by an inside host quotes a packet that the NAT let in, so the quoted
+  // destination is the inside endpoint.
+  //
+  // The quoted endpoint is looked up in the NAT tables rather than in
+  // conntrack: Ipv4Netfilter tracks connections by the addresses seen
+  // before the NAT hooks run (its NAT bindings are not built), so no
+  // conntrack tuple holds the translated endpoint an outside error
+  // quotes, nor maps it back.  The NAT tables are the only record of
+  // the binding, and the only one for static rules.
+  int32_t offset = GetQuotedPortOffset (quoted.GetProtocol (), inbound);
+  uint16_t port = offset < 0 ? 0 : (data[offset] << 8) | data[offset + 1];
+  Ipv4Address oldAddress = inbound ? quoted.GetSource () : quoted.GetDestination ();
+  Ipv4Address address;
+  uint16_t newPort;
+  bool translated;
+  if (inbound)
+    {
+      translated = FindInsideMapping (quoted.GetSource (), port, quoted.GetProtocol (),
+                                      address, newPort, rule, tuple);
+      if (translated)
+        {
+          quoted.SetSource (address);
+          ipHeader.SetDestination (address);
+        }
+    }
+  else
+    {
+      translated = FindOutsideMapping (quoted.GetDestination (), port, quoted.GetProtocol (),
+                                       address, newPort, rule, tuple);
+      if (translated)
+        {
+          quoted.SetDestination (address);
+          ipHeader.SetSource (address);
+        }
+    }
+  if (translated)
+    {
+      NS_LOG_DEBUG ("Translating quoted packet to " << address << " port " << newPort);
+      if (offset >= 0)
+        {
+          data[offset] = newPort >> 8;
+          data[offset + 1] = newPort & 0xff;
+        }
+      // The UDP checksum is within the quoted eight bytes and covers the
+      // pseudo-header, so it follows the address and port; a zero checksum
+      // was not computed by the sender.  The TCP checksum is not quoted.
+      uint16_t checksum = (data[6] << 8) | data[7];
+      if (quoted.GetProtocol () == IPPROTO_UDP && checksum != 0)
+        {
+          checksum = AdjustChecksum (checksum, oldAddress, address);
+          checksum = AdjustChecksum (checksum, port, newPort);
+          if (checksum == 0)
+            {
+              checksum = 0xffff;
+            }
+          data[6] = checksum >> 8;
+          data[7] = checksum & 0xff;
+        }
+      if (Node::ChecksumEnabled ())
+        {
+          quoted.EnableChecksum ();
+        }
+      error.SetHeader (quoted);
+      error.SetData (Create<Packet> (data, 8));
+    }
+  p->AddHeader (error);
+  return translated;
+}
+
+bool
+Ipv4Nat::DoNatIcmpPreRouting (Ptr<Packet> p, Ipv4Header &ipHeader)
+{
+  NS_LOG_FUNCTION (this << p);
+  Icmpv4Header icmpHeader;
+  p->RemoveHeader (icmpHeader);
+  StaticNatRules::iterator rule = m_statictable.end ();
+  DynamicNatTuple::iterator tuple = m_dynatuple.end ();
+  bool translated = false;
+  switch (icmpHeader.GetType ())
+    {
+    case Icmpv4Header::ECHO:
+    case Icmpv4Header::ECHO_REPLY:
+      {
+        Icmpv4Echo echo;
+        p->RemoveHeader (echo);
+        Ipv4Address local;
+        uint16_t localId;
+        translated = FindInsideMapping (ipHeader.GetDestination (), echo.GetIdentifier (),
+                                        IPPROTO_ICMP, local, localId, rule, tuple);
+        if (translated)
+          {
+            NS_LOG_DEBUG ("Translating echo to " << local << " identifier " << localId);
+            ipHeader.SetDestination (local);
+            echo.SetIdentifier (localId);
+          }
+        p->AddHeader (echo);
+        break;
+      }
+    case Icmpv4Header::DEST_UNREACH:
+      translated = DoNatIcmpError<Icmpv4DestinationUnreachable> (p, ipHeader, true, rule, tuple);
+      break;
+    case Icmpv4Header::TIME_EXCEEDED:
+      translated = DoNatIcmpError<Icmpv4TimeExceeded> (p, ipHeader, true, rule, tuple);
+      break;
+    default:
+      NS_LOG_DEBUG ("Not translating ICMP type " << (uint16_t) icmpHeader.GetType ());
+      break;
+    }
+  if (Node::ChecksumEnabled ())
+    {
+      icmpHeader.EnableChecksum ();
+    }
+  p->AddHeader (icmpHeader);
+  if (rule != m_statictable.end ())
+    {
+      rule->RecordInbound (p->GetSize () + ipHeader.GetSerializedSize ());
+    }
+  if (tuple != m_dynatuple.end ())
+    {
+      tuple->RecordInbound (p->GetSize () + ipHeader.GetSerializedSize ());
+    }
+  return translated;
+}
+
+bool
+Ipv4Nat::DoNatIcmpPostRouting (Ptr<Packet> p, Ipv4Header &ipHeader)
+{
+  NS_LOG_FUNCTION (this << p);
+  Icmpv4Header icmpHeader;
+  p->RemoveHeader (icmpHeader);
+  StaticNatRules::iterator rule = m_statictable.end ();
+  DynamicNatTuple::iterator tuple = m_dynatuple.end ();
+  bool translated = false;
+  switch (icmpHeader.GetType ())
+    {
+    case Icmpv4Header::ECHO:
+    case Icmpv4Header::ECHO_REPLY:
+      {
+        Icmpv4Echo echo;
+        p->RemoveHeader (echo);
+        Ipv4Address global;
+        uint16_t globalId;
+        translated = FindOutsideMapping (ipHeader.GetSource (), echo.GetIdentifier (),
+                                         IPPROTO_ICMP, global, globalId, rule, tuple);
+        if (!translated && icmpHeader.GetType () == Icmpv4Header::ECHO)
+          {
+            // new query: its identifier is allocated from the port pool
+            for (DynamicNatRules::const_iterator i = m_dynamictable.begin ();
+                 i != m_dynamictable.end (); i++)
+              {
+                if ((*i).GetLocalNet ().CombineMask ((*i).GetLocalMask ()) != ipHeader.GetSource ().CombineMask ((*i).GetLocalMask ()))
+                  {
+                    continue;
+                  }
+                global = GetAddressPoolIp ();
+                globalId = GetNewOutsidePort ();
+                if (globalId != 0)
+                  {
+                    m_dynatuple.push_front (Ipv4DynamicNatTuple (ipHeader.GetSource (), global,
+                                                                 globalId, echo.GetIdentifier ()));
+                    tuple = m_dynatuple.begin ();
+                    translated = true;
+                  }
+                break;
+              }
+          }
+        if (translated)
+          {
+            NS_LOG_DEBUG ("Translating echo to " << global << " identifier " << globalId);
+            ipHeader.SetSource (global);
+            echo.SetIdentifier (globalId);
+          }
+        p->AddHeader (echo);
+        break;
+      }
+    case Icmpv4Header::DEST_UNREACH:
+      translated = DoNatIcmpError<Icmpv4DestinationUnreachable> (p, ipHeader, false, rule, tuple);
+      break;
+    case Icmpv4Header::TIME_EXCEEDED:
+      translated = DoNatIcmpError<Icmpv4TimeExceeded> (p, ipHeader, false, rule, tuple);
+      break;
+    default:
+      NS_LOG_DEBUG ("Not translating ICMP type " << (uint16_t) icmpHeader.GetType ());
+      break;
+    }
+  if (Node::ChecksumEnabled ())
+    {
+      icmpHeader.EnableChecksum ();
+    }
+  p->AddHeader (icmpHeader);
+  if (rule != m_statictable.end ())
+    {
+      rule->RecordOutbound (p->GetSize () + ipHeader.GetSerializedSize ());
+    }
+  if (tuple != m_dynatuple.end ())
+    {
+      tuple->RecordOutbound (p->GetSize () + ipHeader.GetSerializedSize ());
+    }
+  return translated;
+}
+
+uint32_t
+Ipv4Nat::GetSerializedStateSize (void) const
+{
+  // pool addresses and mask, port pool, then the translation tuples
+  return NAT_STATE_HEADER_SIZE + m_dynatuple.size () * NAT_STATE_TUPLE_SIZE;
+}
+
+void
+Ipv4Nat::SerializeState (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  i.WriteHtonU32 (m_globalip.Get ());
+  i.WriteHtonU32 (m_endglobalip.Get ());
+  i.WriteHtonU32 (m_globalmask.Get ());
+  i.WriteHtonU16 (m_startport);
+  i.WriteHtonU16 (m_endport);
+  i.WriteHtonU16 (m_currentPort);
+  i.WriteHtonU16 (m_flag);
+  i.WriteHtonU32 (m_dynatuple.size ());
+  for (DynamicNatTuple::const_iterator it = m_dynatuple.begin ();
+       it != m_dynatuple.end (); it++)
+    {
+      i.WriteHtonU32 (it->GetLocalAddress ().Get ());
+      i.WriteHtonU32 (it->GetGlobalAddress ().Get ());
+      i.WriteHtonU16 (it->GetTranslatedPort ());
+      i.WriteHtonU16 (it->GetLocalPort ());
+      i.WriteHtonU64 (it->GetCreationTime ().GetTimeStep ());
+      i.WriteHtonU64 (it->GetOutboundPackets ());
+      i.WriteHtonU64 (it->GetOutboundBytes ());
+      i.WriteHtonU64 (it->GetInboundPackets ());
+      i.WriteHtonU64 (it->GetInboundBytes ());
+    }
+}
+
+uint32_t
+Ipv4Nat::DeserializeState (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  if (i.GetRemainingSize () < NAT_STATE_HEADER_SIZE)
+    {
+      NS_LOG_WARN ("NAT state truncated before the tuple count");
+      return 0;
+    }
+  Ipv4Address globalip = Ipv4Address (i.ReadNtohU32 ());
+  Ipv4Address endglobalip = Ipv4Address (i.ReadNtohU32 ());
+  Ipv4Mask globalmask = Ipv4Mask (i.ReadNtohU32 ());
+  uint16_t startport = i.ReadNtohU16 ();
+  uint16_t endport = i.ReadNtohU16 ();
+  uint16_t currentPort = i.ReadNtohU16 ();
+  uint16_t flag = i.ReadNtohU16 ();
+  uint32_t n = i.ReadNtohU32 ();
+  // Divide rather than multiply so that a corrupt count cannot overflow
+  if (n > i.GetRemainingSize () / NAT_STATE_TUPLE_SIZE)
+    {
+      NS_LOG_WARN ("NAT state holds " << i.GetRemainingSize () << " bytes for "
+                   << n << " tuples");
+      return 0;
+    }
+
+  m_globalip = globalip;
+  m_endglobalip = endglobalip;
+  m_globalmask = globalmask;
+  m_startport = startport;
+  m_endport = endport;
+  m_currentPort = currentPort;
+  m_flag = flag;
+  m_dynatuple.clear ();
+  for (uint32_t k = 0; k < n; k++)
+    {
+      Ipv4Address local = Ipv4Address (i.ReadNtohU32 ());
+      Ipv4Address global = Ipv4Address (i.ReadNtohU32 ());
+      uint16_t port = i.ReadNtohU16 ();
+      uint16_t locport = i.ReadNtohU16 ();
+      Ipv4DynamicNatTuple tuple (local, global, port, locport);
+      tuple.SetCreationTime (TimeStep (i.ReadNtohU64 ()));
+      uint64_t outPackets = i.ReadNtohU64 ();
+      uint64_t outBytes = i.ReadNtohU64 ();
+      uint64_t inPackets = i.ReadNtohU64 ();
+      tuple.SetCounters (outPackets, outBytes, inPackets, i.ReadNtohU64 ());
+      m_dynatuple.push_back (tuple);
+    }
+  if (m_globalip != Ipv4Address ())
+    {
+      // Resume the address generator where the saved pool left off
+      address.Init (m_globalip.CombineMask (m_globalmask), m_globalmask);
+      address.InitAddress (Ipv4Address (m_globalip.Get () & ~m_globalmask.Get ()), m_globalmask);
+    }
+  NS_LOG_DEBUG ("Restored " << m_dynatuple.size () << " dynamic translations");
+  return i.GetDistanceFrom (start);
+}
+
+void
+Ipv4Nat::SaveState (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  Ptr<Ipv4Netfilter> netfilter = m_ipv4 != 0 ? m_ipv4->GetNetfilter () : 0;
+  uint32_t natSize = GetSerializedStateSize ();
+  uint32_t conntrackSize = netfilter != 0 ? netfilter->GetSerializedConntrackSize () : 0;
+
+  Buffer buffer;
+  buffer.AddAtStart (4 + 4 + 4 + natSize + 4 + conntrackSize);
+  Buffer::Iterator i = buffer.Begin ();
+  i.WriteHtonU32 (NAT_STATE_MAGIC);
+  i.WriteHtonU32 (NAT_STATE_VERSION);
+  i.WriteHtonU32 (natSize);
+  SerializeState (i);
+  i.Next (natSize);
+  i.WriteHtonU32 (conntrackSize);
+  if (netfilter != 0)
+    {
+      netfilter->SerializeConntrack (i);
+    }
+
+  std::ofstream os (filename.c_str (), std::ios::out | std::ios::binary);
+  if (!os.is_open ())
+    {
+      NS_FATAL_ERROR ("Ipv4Nat::SaveState(): cannot open " << filename);
+    }
+  buffer.CopyData (&os, buffer.GetSize ());
+}
+
+void
+Ipv4Nat::LoadState (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  if (!is.is_open ())
+    {
+      NS_FATAL_ERROR ("Ipv4Nat::LoadState(): cannot open " << filename);
+    }
+  std::vector<uint8_t> data ((std::istreambuf_iterator<char> (is)), std::istreambuf_iterator<char> ());
+  if (data.size () < 3 * 4)
+    {
+      NS_FATAL_ERROR ("Ipv4Nat::LoadState(): " << filename << " is truncated");
+    }
+
+  Buffer buffer;
+  buffer.AddAtStart (data.size ());
+  buffer.Begin ().Write (&data[0], data.size ());
+  Buffer::Iterator i = buffer.Begin ();
+  if (i.ReadNtohU32 () != NAT_STATE_MAGIC || i.ReadNtohU32 () != NAT_STATE_VERSION)
+    {
+      NS_FATAL_ERROR ("Ipv4Nat::LoadState(): " << filename << " is not a NAT state file of version " << NAT_STATE_VERSION);
+    }
+  uint32_t natSize = i.ReadNtohU32 ();
+  if (buffer.GetSize () - i.GetDistanceFrom (buffer.Begin ()) < natSize + 4)
+    {
+      NS_FATAL_ERROR ("Ipv4Nat::LoadState(): " << filename << " is truncated");
+    }
+  // Restore from a fragment so that the tuple count is checked against
+  // the NAT section alone and not the connection tracking state after it
+  uint32_t natStart = i.GetDistanceFrom (buffer.Begin ());
+  Buffer natState = buffer.CreateFragment (natStart, natSize);
+  if (DeserializeState (natState.Begin ()) == 0)
+    {
+      NS_FATAL_ERROR ("Ipv4Nat::LoadState(): " << filename << " holds a corrupt NAT state");
+    }
+  i.Next (natSize);
+  uint32_t conntrackSize = i.ReadNtohU32 ();
+  if (buffer.GetSize () - i.GetDistanceFrom (buffer.Begin ()) < conntrackSize)
+    {
+      NS_FATAL_ERROR ("Ipv4Nat::LoadState(): " << filename << " is truncated");
+    }
+  Ptr<Ipv4Netfilter> netfilter = m_ipv4 != 0 ? m_ipv4->GetNetfilter () : 0;
+  if (conntrackSize > 0 && netfilter != 0)
+    {
+      if (netfilter->DeserializeConntrack (i, conntrackSize) != conntrackSize)
+        {
+          NS_FATAL_ERROR ("Ipv4Nat::LoadState(): " << filename << " holds a corrupt conntrack state");
+        }
+    }
+}
+
 void
 Ipv4Nat::AddAddressPool (Ipv4Address netid,Ipv4Address globalip, Ipv4Address endglobalip, Ipv4Mask globalmask)
 {
@@ -930,16 +1579,72 @@ void
 Ipv4Nat::SetInside (int32_t interfaceIndex)
 {
   NS_LOG_FUNCTION (this << interfaceIndex);
-  m_insideInterface = interfaceIndex;
-
+  SetInterfaceRole (interfaceIndex, ROLE_INSIDE);
+  m_insideInterfaces.push_back (interfaceIndex);
 }
 
 void
 Ipv4Nat::SetOutside (int32_t interfaceIndex)
 {
-
   NS_LOG_FUNCTION (this << interfaceIndex);
-  m_outsideInterface = interfaceIndex;
+  SetInterfaceRole (interfaceIndex, ROLE_OUTSIDE);
+  m_outsideInterfaces.push_back (interfaceIndex);
+}
+
+uint32_t
+Ipv4Nat::GetNInsideInterfaces (void) const
+{
+  return m_insideInterfaces.size ();
+}
+
+uint32_t
+Ipv4Nat::GetNOutsideInterfaces (void) const
+{
+  return m_outsideInterfaces.size ();
+}
+
+bool
+Ipv4Nat::IsInside (Ptr<const NetDevice> device) const
+{
+  return (GetDeviceRole (device) & ROLE_INSIDE) != 0;
+}
+
+bool
+Ipv4Nat::IsOutside (Ptr<const NetDevice> device) const
+{
+  return (GetDeviceRole (device) & ROLE_OUTSIDE) != 0;
+}
+
+void
+Ipv4Nat::SetInterfaceRole (int32_t interfaceIndex, InterfaceRole role)
+{
+  NS_LOG_FUNCTION (this << interfaceIndex << role);
+  NS_ASSERT_MSG (m_ipv4, "Forgot to aggregate Ipv4Nat to Node");
+  NS_ASSERT_MSG (interfaceIndex >= 0 && (uint32_t) interfaceIndex < m_ipv4->GetNInterfaces (),
+                 "Invalid interface index " << interfaceIndex);
+  // The device index is unique per node, so it can directly address the
+  // role table; the hooks then resolve a device with a single array access.
+  uint32_t ifIndex = m_ipv4->GetNetDevice (interfaceIndex)->GetIfIndex ();
+  if (ifIndex >= m_deviceRoles.size ())
+    {
+      m_deviceRoles.resize (ifIndex + 1, ROLE_NONE);
+    }
+  m_deviceRoles[ifIndex] |= role;
+}
+
+uint8_t
+Ipv4Nat::GetDeviceRole (Ptr<const NetDevice> device) const
+{
+  if (device == 0)
+    {
+      return ROLE_NONE;
+    }
+  uint32_t ifIndex = device->GetIfIndex ();
+  if (ifIndex >= m_deviceRoles.size ())
+    {
+      return ROLE_NONE;
+    }
+  return m_deviceRoles[ifIndex];
 }
 
 
@@ -963,14 +1668,30 @@ Ipv4Nat::AddStaticRule (const Ipv4StaticNatRule& rule)
       NS_LOG_WARN ("Adding node's own IP address as the global NAT address");
       return;
     }
-  NS_ASSERT_MSG (m_outsideInterface > -1, "Forgot to assign outside interface");
-  // Add address to outside interface so that node will proxy ARP for it
-  Ipv4Mask outsideMask = m_ipv4->GetAddress (m_outsideInterface, 0).GetMask ();
+  NS_ASSERT_MSG (!m_outsideInterfaces.empty (), "Forgot to assign outside interface");
+  // Add address to the outside interface whose subnet holds the global
+  // address so that node will proxy ARP for it; default to the first one
+  int32_t outside = m_outsideInterfaces.front ();
+  for (std::vector<int32_t>::const_iterator i = m_outsideInterfaces.begin ();
+       i != m_outsideInterfaces.end (); i++)
+    {
+      Ipv4InterfaceAddress ifAddr = m_ipv4->GetAddress (*i, 0);
+      if (ifAddr.GetLocal ().CombineMask (ifAddr.GetMask ()) == rule.GetGlobalIp ().CombineMask (ifAddr.GetMask ()))
+        {
+          outside = *i;
+          break;
+        }
+    }
+  Ipv4Mask outsideMask = m_ipv4->GetAddress (outside, 0).GetMask ();
   Ipv4InterfaceAddress natAddress (rule.GetGlobalIp (), outsideMask);
-  m_ipv4->AddAddress (m_outsideInterface, natAddress);
+  m_ipv4->AddAddress (outside, natAddress);
 }
 
 Ipv4StaticNatRule::Ipv4StaticNatRule (Ipv4Address localip, uint16_t locprt, Ipv4Address globalip,uint16_t gloprt, uint16_t protocol)
+  : m_outPackets (0),
+    m_outBytes (0),
+    m_inPackets (0),
+    m_inBytes (0)
 {
   NS_LOG_FUNCTION (this << localip << locprt << globalip << gloprt << protocol);
   m_localaddr = localip;
@@ -984,6 +1705,10 @@ Ipv4StaticNatRule::Ipv4StaticNatRule (Ipv4Address localip, uint16_t locprt, Ipv4
 
 // This version is used for no port restrictions
 Ipv4StaticNatRule::Ipv4StaticNatRule (Ipv4Address localip, Ipv4Address globalip)
+  : m_outPackets (0),
+    m_outBytes (0),
+    m_inPackets (0),
+    m_inBytes (0)
 {
   NS_LOG_FUNCTION (this << localip << globalip);
   m_localaddr = localip;
@@ -1023,6 +1748,44 @@ Ipv4StaticNatRule::GetProtocol () const
   return m_protocol;
 }
 
+void
+Ipv4StaticNatRule::RecordOutbound (uint32_t bytes)
+{
+  m_outPackets++;
+  m_outBytes += bytes;
+}
+
+void
+Ipv4StaticNatRule::RecordInbound (uint32_t bytes)
+{
+  m_inPackets++;
+  m_inBytes += bytes;
+}
+
+uint64_t
+Ipv4StaticNatRule::GetOutboundPackets () const
+{
+  return m_outPackets;
+}
+
+uint64_t
+Ipv4StaticNatRule::GetOutboundBytes () const
+{
+  return m_outBytes;
+}
+
+uint64_t
+Ipv4StaticNatRule::GetInboundPackets () const
+{
+  return m_inPackets;
+}
+
+uint64_t
+Ipv4StaticNatRule::GetInboundBytes () const
+{
+  return m_inBytes;
+}
+
 Ipv4DynamicNatRule::Ipv4DynamicNatRule (Ipv4Address localnet, Ipv4Mask localmask)
 {
   NS_LOG_FUNCTION (this << localnet << localmask);
@@ -1050,6 +1813,11 @@ Ipv4DynamicNatTuple::Ipv4DynamicNatTuple (Ipv4Address local, Ipv4Address global,
   m_globalip = global;
   m_port = port;
   m_localport = locport;
+  m_created = Simulator::Now ();
+  m_outPackets = 0;
+  m_outBytes = 0;
+  m_inPackets = 0;
+  m_inBytes = 0;
 }
 
 Ipv4Address
@@ -1076,4 +1844,90 @@ Ipv4DynamicNatTuple::GetLocalPort () const
   return m_localport;
 }
 
+Time
+Ipv4DynamicNatTuple::GetCreationTime () const
+{
+  return m_created;
+}
+
+void
+Ipv4DynamicNatTuple::SetCreationTime (Time created)
+{
+  m_created = created;
+}
+
+void
+Ipv4DynamicNatTuple::RecordOutbound (uint32_t bytes)
+{
+  m_outPackets++;
+  m_outBytes += bytes;
+}
+
+void
+Ipv4DynamicNatTuple::RecordInbound (uint32_t bytes)
+{
+  m_inPackets++;
+  m_inBytes += bytes;
+}
+
+uint64_t
+Ipv4DynamicNatTuple::GetOutboundPackets () const
+{
+  return m_outPackets;
+}
+
+uint64_t
+Ipv4DynamicNatTuple::GetOutboundBytes () const
+{
+  return m_outBytes;
+}
+
+uint64_t
+Ipv4DynamicNatTuple::GetInboundPackets () const
+{
+  return m_inPackets;
+}
+
+uint64_t
+Ipv4DynamicNatTuple::GetInboundBytes () const
+{
+  return m_inBytes;
+}
+
+void
+Ipv4DynamicNatTuple::SetCounters (uint64_t outPackets, uint64_t outBytes,
+                                  uint64_t inPackets, uint64_t inBytes)
+{
+  m_outPackets = outPackets;
+  m_outBytes = outBytes;
+  m_inPackets = inPackets;
+  m_inBytes = inBytes;
+}
+
+Ipv4NatCounters::Ipv4NatCounters ()
+  : outboundPackets (0),
+    outboundBytes (0),
+    inboundPackets (0),
+    inboundBytes (0)
+{
+}
+
+void
+Ipv4NatCounters::Add (const Ipv4DynamicNatTuple& tuple)
+{
+  outboundPackets += tuple.GetOutboundPackets ();
+  outboundBytes += tuple.GetOutboundBytes ();
+  inboundPackets += tuple.GetInboundPackets ();
+  inboundBytes += tuple.GetInboundBytes ();
+}
+
+void
+Ipv4NatCounters::Add (const Ipv4StaticNatRule& rule)
+{
+  outboundPackets += rule.GetOutboundPackets ();
+  outboundBytes += rule.GetOutboundBytes ();
+  inboundPackets += rule.GetInboundPackets ();
+  inboundBytes += rule.GetInboundBytes ();
+}
+
 }
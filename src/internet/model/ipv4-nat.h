@@ -22,10 +22,14 @@
 
 #include <stdint.h>
 #include <limits.h>
+#include <vector>
+#include <map>
 #include <sys/socket.h>
 #include "ns3/ptr.h"
 #include "ns3/net-device.h"
 #include "ns3/packet.h"
+#include "ns3/buffer.h"
+#include "ns3/nstime.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/object.h"
 #include "ipv4-netfilter.h"
@@ -98,7 +102,37 @@ public:
   */
   uint16_t GetProtocol () const;
 
+/**
+  *\brief Count a packet translated from the inside to the outside
+  *\param bytes The size of the translated packet, including its IP header
+  */
+  void RecordOutbound (uint32_t bytes);
 
+/**
+  *\brief Count a packet translated from the outside to the inside
+  *\param bytes The size of the translated packet, including its IP header
+  */
+  void RecordInbound (uint32_t bytes);
+
+/**
+  *\return The number of packets translated from the inside to the outside
+  */
+  uint64_t GetOutboundPackets () const;
+
+/**
+  *\return The number of bytes translated from the inside to the outside
+  */
+  uint64_t GetOutboundBytes () const;
+
+/**
+  *\return The number of packets translated from the outside to the inside
+  */
+  uint64_t GetInboundPackets () const;
+
+/**
+  *\return The number of bytes translated from the outside to the inside
+  */
+  uint64_t GetInboundBytes () const;
 
 private:
   Ipv4Address m_localaddr;
@@ -106,6 +140,10 @@ private:
   uint16_t m_localport;
   uint16_t m_globalport;
   uint16_t m_protocol;
+  uint64_t m_outPackets;
+  uint64_t m_outBytes;
+  uint64_t m_inPackets;
+  uint64_t m_inBytes;
 
   // private data member
 };
@@ -179,15 +217,93 @@ public:
 
   uint16_t GetLocalPort() const;
 
+/**
+  *\return The simulation time at which the translation was created
+  */
+  Time GetCreationTime () const;
+
+/**
+  *\param created The simulation time at which the translation was created
+  */
+  void SetCreationTime (Time created);
+
+/**
+  *\brief Count a packet translated from the inside to the outside
+  *\param bytes The size of the translated packet, including its IP header
+  */
+  void RecordOutbound (uint32_t bytes);
+
+/**
+  *\brief Count a packet translated from the outside to the inside
+  *\param bytes The size of the translated packet, including its IP header
+  */
+  void RecordInbound (uint32_t bytes);
+
+/**
+  *\return The number of packets translated from the inside to the outside
+  */
+  uint64_t GetOutboundPackets () const;
+
+/**
+  *\return The number of bytes translated from the inside to the outside
+  */
+  uint64_t GetOutboundBytes () const;
+
+/**
+  *\return The number of packets translated from the outside to the inside
+  */
+  uint64_t GetInboundPackets () const;
+
+/**
+  *\return The number of bytes translated from the outside to the inside
+  */
+  uint64_t GetInboundBytes () const;
+
+/**
+  *\brief Set the traffic counters, used when restoring a saved translation
+  */
+  void SetCounters (uint64_t outPackets, uint64_t outBytes,
+                    uint64_t inPackets, uint64_t inBytes);
+
 
 private:
   Ipv4Address m_localip;
   Ipv4Address m_globalip;
   uint16_t m_port;
  uint16_t m_localport;
+  Time m_created;
+  uint64_t m_outPackets;
+  uint64_t m_outBytes;
+  uint64_t m_inPackets;
+  uint64_t m_inBytes;
  
 };
 
+/**
+ * \brief Traffic counters of a set of static NAT rules and dynamic NAT translations.
+ */
+struct Ipv4NatCounters
+{
+  Ipv4NatCounters ();
+
+  /**
+   * \brief Add the counters of a translation
+   * \param tuple the translation
+   */
+  void Add (const Ipv4DynamicNatTuple& tuple);
+
+  /**
+   * \brief Add the counters of a static rule
+   * \param rule the rule
+   */
+  void Add (const Ipv4StaticNatRule& rule);
+
+  uint64_t outboundPackets; //!< packets translated from inside to outside
+  uint64_t outboundBytes;   //!< bytes translated from inside to outside
+  uint64_t inboundPackets;  //!< packets translated from outside to inside
+  uint64_t inboundBytes;    //!< bytes translated from outside to inside
+};
+
 /**
   * \brief Implementation of Nat
   *
@@ -293,6 +409,44 @@ public:
    */
   void PrintTable (Ptr<OutputStreamWrapper> stream) const;
 
+  /**
+   * \brief Write the column names of ExportTable
+   *
+   * \param stream the stream the table snapshots are written to
+   */
+  void ExportTableHeader (Ptr<OutputStreamWrapper> stream) const;
+
+  /**
+   * \brief Write a snapshot of the NAT translation table as CSV rows
+   *
+   * \param stream the stream the snapshot is appended to
+   *
+   * Writes one row per static rule and dynamic translation with the
+   * current time, the inside and outside address and port, and the age
+   * of dynamic translations, and the traffic counters of both.  Times
+   * are integer nanoseconds.  The table is walked once
+   * and the stream is not flushed, so that frequent snapshots stay cheap.
+   */
+  void ExportTable (Ptr<OutputStreamWrapper> stream) const;
+
+  /// Traffic counters indexed by address
+  typedef std::map<Ipv4Address, Ipv4NatCounters> CountersByAddress;
+
+  /**
+   * \brief Sum the traffic counters of the static rules and dynamic translations per inside host
+   * \return the counters indexed by local address
+   *
+   * The rules and translations only count their own packets as they are
+   * translated; the sums are computed here, when asked for.
+   */
+  CountersByAddress GetLocalAddressCounters (void) const;
+
+  /**
+   * \brief Sum the traffic counters of the static rules and dynamic translations per global address
+   * \return the counters indexed by global address
+   */
+  CountersByAddress GetGlobalAddressCounters (void) const;
+
   
 /**
    *\rekha paul
@@ -313,19 +467,88 @@ public:
   void AddPortPool (uint16_t, uint16_t); //port range
 
   /**
-   * \brief Set the inside interface for the node
+   * \brief Add an inside interface for the node
    *
    * \param interfaceIndex interface index number of the interface on the node
+   *
+   * May be called several times to declare more than one inside interface.
    */
   void SetInside (int32_t interfaceIndex);
 
   /**
-   * \brief Set the outside interfaces for the node
+   * \brief Add an outside interface for the node
    *
    * \param interfaceIndex interface index number of the interface on the node
+   *
+   * May be called several times to declare more than one outside interface.
    */
   void SetOutside (int32_t interfaceIndex);
 
+  /**
+   * \return number of inside interfaces
+   */
+  uint32_t GetNInsideInterfaces (void) const;
+
+  /**
+   * \return number of outside interfaces
+   */
+  uint32_t GetNOutsideInterfaces (void) const;
+
+  /**
+   * \param device a NetDevice of the node the NAT is aggregated to
+   * \return true if the device belongs to an inside interface
+   */
+  bool IsInside (Ptr<const NetDevice> device) const;
+
+  /**
+   * \param device a NetDevice of the node the NAT is aggregated to
+   * \return true if the device belongs to an outside interface
+   */
+  bool IsOutside (Ptr<const NetDevice> device) const;
+
+  /**
+   * \return the number of bytes needed to serialize the NAT state
+   */
+  uint32_t GetSerializedStateSize (void) const;
+
+  /**
+   * \param start an iterator which points to where the state should be written
+   *
+   * Serializes the dynamic translations and the address and port pool
+   * state.  Static and dynamic rules are configuration and are not saved,
+   * so the counters of static rules start from zero after a restore.
+   */
+  void SerializeState (Buffer::Iterator start) const;
+
+  /**
+   * \param start an iterator which points to where the state should be read
+   * \return the number of bytes read, or 0 if the state is truncated
+   *
+   * Replaces the dynamic translations and the address and port pool
+   * state with the serialized ones.  The tuple count is checked against
+   * the bytes left in the buffer before anything is read; a state which
+   * does not hold that many tuples is rejected and the current state is
+   * kept.
+   */
+  uint32_t DeserializeState (Buffer::Iterator start);
+
+  /**
+   * \brief Save the NAT and connection tracking state to a binary file
+   *
+   * \param filename the file to write
+   */
+  void SaveState (std::string filename) const;
+
+  /**
+   * \brief Restore the NAT and connection tracking state from a binary file
+   *
+   * \param filename a file previously written by SaveState
+   *
+   * The rules, pools and interfaces must already be configured; only the
+   * state accumulated while the simulation was running is restored.
+   */
+  void LoadState (std::string filename);
+
   typedef std::list<Ipv4StaticNatRule> StaticNatRules;
   typedef std::list<Ipv4DynamicNatRule> DynamicNatRules;
   typedef std::list<Ipv4DynamicNatTuple> DynamicNatTuple;
@@ -338,6 +561,31 @@ protected:
 private:
   //bool m_isConnected;
 
+  /**
+   * \brief Role bits of a NetDevice, stored per device index
+   */
+  enum InterfaceRole
+  {
+    ROLE_NONE = 0,
+    ROLE_INSIDE = 1,
+    ROLE_OUTSIDE = 2
+  };
+
+  /**
+   * \param interfaceIndex interface index number of the interface on the node
+   * \param role role bit to set for the device of that interface
+   *
+   * Records the role in the device-index table so that hooks do not
+   * have to scan the interface list for every packet.
+   */
+  void SetInterfaceRole (int32_t interfaceIndex, InterfaceRole role);
+
+  /**
+   * \param device a NetDevice of the node, possibly null
+   * \return the role bits of the device
+   */
+  uint8_t GetDeviceRole (Ptr<const NetDevice> device) const;
+
   Ptr<Ipv4> m_ipv4;
 
   /**
@@ -371,6 +619,74 @@ private:
 
   uint32_t DoNatPostRouting (Hooks_t hookNumber, Ptr<Packet> p,
                              Ptr<NetDevice> in, Ptr<NetDevice> out, ContinueCallback& ccb);
+
+  /**
+   * \param p ICMP message received on an outside interface, without its IP header
+   * \param ipHeader the IP header of the message, updated in place
+   * \returns true if the message was translated
+   *
+   * Echo messages are translated by their identifier, which dynamic NAT
+   * allocates from the port pool.  Errors are translated by looking up the
+   * IP header and ports they quote, i.e. the packet that the NAT sent out.
+   */
+  bool DoNatIcmpPreRouting (Ptr<Packet> p, Ipv4Header &ipHeader);
+
+  /**
+   * \param p ICMP message sent on an outside interface, without its IP header
+   * \param ipHeader the IP header of the message, updated in place
+   * \returns true if the message was translated
+   *
+   * Outgoing echo requests matching a dynamic rule create a translation
+   * for their identifier.
+   */
+  bool DoNatIcmpPostRouting (Ptr<Packet> p, Ipv4Header &ipHeader);
+
+  /**
+   * \param p ICMP error message starting with the error-specific header
+   * \param ipHeader the IP header of the message, updated in place
+   * \param inbound true if the message comes from the outside
+   * \param rule set to the static rule which translated the message, if any
+   * \param tuple set to the dynamic translation which translated the
+   *        message, if any
+   * \returns true if the quoted packet and the message were translated
+   *
+   * T is Icmpv4DestinationUnreachable or Icmpv4TimeExceeded.  The
+   * caller counts the message on the rule or translation, like the
+   * traffic of the flow it reports on.
+   */
+  template <typename T>
+  bool DoNatIcmpError (Ptr<Packet> p, Ipv4Header &ipHeader, bool inbound,
+                       StaticNatRules::iterator &rule, DynamicNatTuple::iterator &tuple);
+
+  /**
+   * \param local inside address
+   * \param localPort inside port, or echo identifier
+   * \param protocol IP protocol number
+   * \param global the outside address, if found
+   * \param globalPort the outside port, if found
+   * \param rule the matching static rule, or the end of the list
+   * \param tuple the matching dynamic translation, or the end of the list
+   * \returns true if a rule or translation maps the inside endpoint
+   */
+  bool FindOutsideMapping (Ipv4Address local, uint16_t localPort, uint8_t protocol,
+                           Ipv4Address &global, uint16_t &globalPort,
+                           StaticNatRules::iterator &rule,
+                           DynamicNatTuple::iterator &tuple);
+
+  /**
+   * \param global outside address
+   * \param globalPort outside port, or echo identifier
+   * \param protocol IP protocol number
+   * \param local the inside address, if found
+   * \param localPort the inside port, if found
+   * \param rule the matching static rule, or the end of the list
+   * \param tuple the matching dynamic translation, or the end of the list
+   * \returns true if a rule or translation maps the outside endpoint
+   */
+  bool FindInsideMapping (Ipv4Address global, uint16_t globalPort, uint8_t protocol,
+                          Ipv4Address &local, uint16_t &localPort,
+                          StaticNatRules::iterator &rule,
+                          DynamicNatTuple::iterator &tuple);
   /**
   *\return The Global Pool Ip address
   */
@@ -412,8 +728,9 @@ private:
   StaticNatRules m_statictable;
   DynamicNatRules m_dynamictable;
   DynamicNatTuple m_dynatuple;
-  int32_t m_insideInterface;
-  int32_t m_outsideInterface;
+  std::vector<int32_t> m_insideInterfaces;
+  std::vector<int32_t> m_outsideInterfaces;
+  std::vector<uint8_t> m_deviceRoles; //!< role bits indexed by NetDevice::GetIfIndex ()
   Ipv4Address m_globalip;
   Ipv4Address m_endglobalip;  
   Ipv4Mask m_globalmask;
@@ -19,6 +19,7 @@
  */
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/memory-accounting.h"
 #include "ipv4-netfilter.h"
 
 #include "ip-conntrack-info.h"
@@ -38,6 +39,15 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4Netfilter);
 
+/** MemoryAccounting of the confirmed connection tracking entries. */
+static MemoryAccounting::Counter g_conntrackMemory ("ns3::Ipv4Netfilter::m_hash");
+
+/**
+ * Size of a serialized conntrack entry: addresses, ports, L3 protocol,
+ * direction, status, info and the packet and byte counters.
+ */
+static const uint32_t CONNTRACK_ENTRY_SIZE = 4 + 2 + 4 + 2 + 2 + 1 + 4 + 1 + 8 + 8;
+
 TypeId
 Ipv4Netfilter::GetTypeId (void)
 {
@@ -55,7 +65,8 @@ Ipv4Netfilter::GetTypeId (void)
 }
 
 Ipv4Netfilter::Ipv4Netfilter ()
- // : m_enableNat (0)
+  : m_accountedEntries (0)
+ // , m_enableNat (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -106,6 +117,25 @@ Ipv4Netfilter::Ipv4Netfilter ()
 */
   }
 
+Ipv4Netfilter::~Ipv4Netfilter ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_hash.clear ();
+  AccountHash ();
+}
+
+void
+Ipv4Netfilter::AccountHash (void)
+{
+  // The hash table node holds the entry and a next pointer.
+  int64_t delta = (int64_t)m_hash.size () - m_accountedEntries;
+  if (delta != 0)
+    {
+      g_conntrackMemory.Add (delta, delta * (int64_t)(sizeof (TupleHash::value_type) + sizeof (void *)));
+      m_accountedEntries += delta;
+    }
+}
+
 void
 Ipv4Netfilter::RegisterHook (const Ipv4NetfilterHook& hook)
 {
@@ -121,7 +151,9 @@ Ipv4Netfilter::DeregisterHook (const Ipv4NetfilterHook& hook)
 uint32_t
 Ipv4Netfilter::ProcessHook (uint8_t protocolFamily, Hooks_t hookNumber, Ptr<Packet> p,Ptr<NetDevice> in, Ptr<NetDevice> out,ContinueCallback ccb)
 {
-  return m_netfilterHooks[(uint32_t)hookNumber].IterateAndCallHook (hookNumber, p, in, out, ccb);
+  uint32_t verdict = m_netfilterHooks[(uint32_t)hookNumber].IterateAndCallHook (hookNumber, p, in, out, ccb);
+  AccountHash ();
+  return verdict;
   //return 1;
 }
 
@@ -278,6 +310,10 @@ Ipv4Netfilter::ResolveNormalConntrack (Ptr<Packet> packet, uint32_t protocolFami
   currentOriginalTuple = tuple;
   currentReplyTuple = replyTuple;
 
+  // Count the packet on the entry it matched, either the confirmed one
+  // or, for the first packet of a connection, the unconfirmed one
+  it->second.RecordPacket (packet->GetSize ());
+
   /* TODO: Add a pointer to the hashed tuple in IpConntrackInfo()
    * and store these tuples somehwere, when you destruct then you
    * you have to take care of the tuples stored in the vector as
@@ -446,8 +482,13 @@ Ipv4Netfilter::NetfilterConntrackConfirm (Ptr<Packet> packet)
   }*/
 
   NS_LOG_DEBUG ("Creating confirmed hash entries");
-  m_hash[currentOriginalTuple] = m_unconfirmed[currentOriginalTuple];
-  m_hash[currentReplyTuple] = m_unconfirmed[currentOriginalTuple];
+  // The confirmed entries take over the state of the unconfirmed one,
+  // but keep counting their own direction
+  IpConntrackInfo &unconfirmed = m_unconfirmed[currentOriginalTuple];
+  IpConntrackInfo &original = m_hash[currentOriginalTuple];
+  original.CopyState (unconfirmed);
+  original.TransferCounters (unconfirmed);
+  m_hash[currentReplyTuple].CopyState (unconfirmed);
 
   return 0;
 }
@@ -476,6 +517,74 @@ Ipv4Netfilter::GetHash ()
   return m_hash;
 }
 
+uint32_t
+Ipv4Netfilter::GetSerializedConntrackSize (void) const
+{
+  // entry count, then the entries
+  return 4 + m_hash.size () * CONNTRACK_ENTRY_SIZE;
+}
+
+void
+Ipv4Netfilter::SerializeConntrack (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  i.WriteHtonU32 (m_hash.size ());
+  for (TupleHash::const_iterator it = m_hash.begin (); it != m_hash.end (); it++)
+    {
+      const NetfilterConntrackTuple &tuple = it->first;
+      i.WriteHtonU32 (tuple.GetSource ().Get ());
+      i.WriteHtonU16 (tuple.GetSourcePort ());
+      i.WriteHtonU32 (tuple.GetDestination ().Get ());
+      i.WriteHtonU16 (tuple.GetDestinationPort ());
+      i.WriteHtonU16 (tuple.GetProtocol ());
+      i.WriteU8 (tuple.GetDirection ());
+      i.WriteHtonU32 (it->second.GetStatus ());
+      i.WriteU8 (it->second.GetInfo ());
+      i.WriteHtonU64 (it->second.GetPackets ());
+      i.WriteHtonU64 (it->second.GetBytes ());
+    }
+}
+
+uint32_t
+Ipv4Netfilter::DeserializeConntrack (Buffer::Iterator start, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  Buffer::Iterator i = start;
+  if (size < 4 || i.GetRemainingSize () < size)
+    {
+      NS_LOG_WARN ("Conntrack state truncated before the entry count");
+      return 0;
+    }
+  uint32_t n = i.ReadNtohU32 ();
+  // Divide rather than multiply so that a corrupt count cannot overflow
+  if (n > (size - 4) / CONNTRACK_ENTRY_SIZE)
+    {
+      NS_LOG_WARN ("Conntrack state holds " << size << " bytes for " << n << " entries");
+      return 0;
+    }
+  m_hash.clear ();
+  m_unconfirmed.clear ();
+  for (uint32_t k = 0; k < n; k++)
+    {
+      NetfilterConntrackTuple tuple;
+      tuple.SetSource (Ipv4Address (i.ReadNtohU32 ()));
+      tuple.SetSourcePort (i.ReadNtohU16 ());
+      tuple.SetDestination (Ipv4Address (i.ReadNtohU32 ()));
+      tuple.SetDestinationPort (i.ReadNtohU16 ());
+      tuple.SetProtocol (i.ReadNtohU16 ());
+      tuple.SetDirection ((ConntrackDirection_t) i.ReadU8 ());
+      IpConntrackInfo info (i.ReadNtohU32 ());
+      info.SetInfo (i.ReadU8 ());
+      uint64_t packets = i.ReadNtohU64 ();
+      info.SetCounters (packets, i.ReadNtohU64 ());
+      m_hash[tuple] = info;
+    }
+  NS_LOG_DEBUG ("Restored " << m_hash.size () << " conntrack entries");
+  AccountHash ();
+  return i.GetDistanceFrom (start);
+}
+
 #ifdef NOTYET
 uint32_t
 Ipv4Netfilter::NetfilterDoNat (Hooks_t hookNumber, Ptr<Packet> p,
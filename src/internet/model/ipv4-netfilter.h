@@ -27,6 +27,7 @@
 #include "ns3/ptr.h"
 #include "ns3/net-device.h"
 #include "ns3/packet.h"
+#include "ns3/buffer.h"
 //#include "ns3/conntrack-tag.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/object.h"
@@ -83,6 +84,7 @@ public:
   static TypeId GetTypeId (void);
 
   Ipv4Netfilter ();
+  virtual ~Ipv4Netfilter ();
 
   /**
     * \param hook The hook function to be registered
@@ -246,6 +248,30 @@ public:
 
   TupleHash& GetHash ();
 
+  /**
+    * \returns the number of bytes needed to serialize the confirmed
+    * connection tracking entries
+    */
+  uint32_t GetSerializedConntrackSize (void) const;
+
+  /**
+    * \param start an iterator which points to where the entries should be written
+    *
+    * Serializes the confirmed connection tracking entries, so that a later
+    * simulation can be started with the same connections.
+    */
+  void SerializeConntrack (Buffer::Iterator start) const;
+
+  /**
+    * \param start an iterator which points to where the entries should be read
+    * \param size the number of bytes of serialized entries at \p start
+    * \returns the number of bytes read, or 0 if the entries do not fit
+    *          in \p size bytes, in which case the entries are left unchanged
+    *
+    * Replaces the confirmed connection tracking entries with the serialized ones.
+    */
+  uint32_t DeserializeConntrack (Buffer::Iterator start, uint32_t size);
+
 #ifdef NOTYET
   void AddNatRule (NatRule natRule);
 
@@ -265,11 +291,19 @@ public:
 #endif 
 
 private:
+  /**
+   * Report the entries added to or removed from m_hash since the last
+   * call to MemoryAccounting.
+   */
+  void AccountHash (void);
+
   NetfilterCallbackChain m_netfilterHooks[NF_INET_NUMHOOKS];
   //std::vector<Ptr<NetfilterConntrackL3Protocol> > m_netfilterConntrackL3Protocols;
   TupleHash m_netfilterTupleHash[IP_CT_DIR_MAX];
   TupleHash m_unconfirmed;
   TupleHash m_hash;
+  /** Number of m_hash entries reported to MemoryAccounting. */
+  int64_t m_accountedEntries;
 
   /* TODO: Should be a table once we have more L3/L4 Protocols */
   Ptr<NetfilterConntrackL3Protocol> m_netfilterConntrackL3Protocols;
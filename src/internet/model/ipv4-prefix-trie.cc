@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ipv4-prefix-trie.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4PrefixTrie");
+
+namespace {
+
+/**
+ * \brief Get the mask of a prefix length.
+ * \param length the prefix length
+ * \returns the mask
+ */
+inline uint32_t
+GetMask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+/**
+ * \brief Get a bit of an address.
+ * \param address the address
+ * \param i the index of the bit, 0 for the most significant one
+ * \returns the bit
+ */
+inline uint32_t
+GetBit (uint32_t address, uint8_t i)
+{
+  return (address >> (31 - i)) & 1;
+}
+
+} // unnamed namespace
+
+Ipv4PrefixTrie::Ipv4PrefixTrie ()
+  : m_root (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4PrefixTrie::~Ipv4PrefixTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+Ipv4PrefixTrie::Node *
+Ipv4PrefixTrie::CreateNode (uint32_t prefix, uint8_t length)
+{
+  Node *node = new Node ();
+  node->prefix = prefix & GetMask (length);
+  node->length = length;
+  node->children[0] = 0;
+  node->children[1] = 0;
+  return node;
+}
+
+void
+Ipv4PrefixTrie::DeleteNode (Node *node)
+{
+  if (node != 0)
+    {
+      DeleteNode (node->children[0]);
+      DeleteNode (node->children[1]);
+      delete node;
+    }
+}
+
+void
+Ipv4PrefixTrie::Insert (Ipv4Address network, Ipv4Mask mask, uint32_t value)
+{
+  NS_LOG_FUNCTION (this << network << mask << value);
+  uint32_t inverse = ~mask.Get ();
+  if ((inverse & (inverse + 1)) != 0)
+    {
+      NS_LOG_LOGIC ("Non-contiguous mask " << mask);
+      m_nonContiguous.push_back (value);
+      return;
+    }
+  uint8_t length = mask.GetPrefixLength ();
+  uint32_t prefix = network.Get () & GetMask (length);
+  Node **link = &m_root;
+  while (true)
+    {
+      Node *node = *link;
+      if (node == 0)
+        {
+          node = CreateNode (prefix, length);
+          node->values.push_back (value);
+          *link = node;
+          return;
+        }
+      // the length of the prefix common to the node and the new prefix.
+      uint8_t common = std::min (node->length, length);
+      uint32_t difference = (node->prefix ^ prefix) & GetMask (common);
+      if (difference != 0)
+        {
+          common = 0;
+          while (GetBit (difference, common) == 0)
+            {
+              common++;
+            }
+        }
+      if (common == node->length && common == length)
+        {
+          node->values.push_back (value);
+          return;
+        }
+      if (common == node->length)
+        {
+          link = &node->children[GetBit (prefix, common)];
+          continue;
+        }
+      // the new prefix diverges from the node, or contains it.
+      Node *parent = CreateNode (prefix, common);
+      parent->children[GetBit (node->prefix, common)] = node;
+      if (common == length)
+        {
+          parent->values.push_back (value);
+        }
+      else
+        {
+          Node *leaf = CreateNode (prefix, length);
+          leaf->values.push_back (value);
+          parent->children[GetBit (prefix, common)] = leaf;
+        }
+      *link = parent;
+      return;
+    }
+}
+
+void
+Ipv4PrefixTrie::Lookup (Ipv4Address address, std::vector<uint32_t> &values) const
+{
+  NS_LOG_FUNCTION (this << address);
+  uint32_t destination = address.Get ();
+  std::vector<uint32_t>::size_type start = values.size ();
+  uint32_t nPrefixes = 0;
+  for (Node *node = m_root;
+       node != 0 && (destination & GetMask (node->length)) == node->prefix;
+       node = node->length < 32 ? node->children[GetBit (destination, node->length)] : 0)
+    {
+      if (!node->values.empty ())
+        {
+          values.insert (values.end (), node->values.begin (), node->values.end ());
+          nPrefixes++;
+        }
+    }
+  if (!m_nonContiguous.empty ())
+    {
+      values.insert (values.end (), m_nonContiguous.begin (), m_nonContiguous.end ());
+      nPrefixes++;
+    }
+  if (nPrefixes > 1)
+    {
+      std::sort (values.begin () + start, values.end ());
+    }
+}
+
+void
+Ipv4PrefixTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  DeleteNode (m_root);
+  m_root = 0;
+  m_nonContiguous.clear ();
+}
+
+} // namespace ns3
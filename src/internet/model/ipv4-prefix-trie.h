@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_PREFIX_TRIE_H
+#define IPV4_PREFIX_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief A path-compressed binary trie of IPv4 prefixes.
+ *
+ * The routing protocols which keep their routes in lists index them
+ * in this trie to find the routes which match a destination without
+ * visiting all of them.  Each prefix holds the values inserted with
+ * it, typically the positions of the routes in the list of the
+ * routing protocol.  Only the nodes where the prefixes diverge are
+ * stored, so a lookup visits at most one node per matching prefix
+ * and one per branching point.
+ *
+ * Routes with a non-contiguous mask can not be stored in a trie: their
+ * values are returned by every lookup, and the caller is expected to
+ * check the match itself.
+ */
+class Ipv4PrefixTrie
+{
+public:
+  Ipv4PrefixTrie ();
+  ~Ipv4PrefixTrie ();
+
+  /**
+   * \brief Add a value to a prefix.
+   * \param network the network address
+   * \param mask the network mask
+   * \param value the value
+   */
+  void Insert (Ipv4Address network, Ipv4Mask mask, uint32_t value);
+
+  /**
+   * \brief Get the values of all the prefixes which contain an address.
+   * \param address the address
+   * \param values the values, appended in increasing order.  The values
+   *        of the non-contiguous masks are always included.
+   */
+  void Lookup (Ipv4Address address, std::vector<uint32_t> &values) const;
+
+  /**
+   * \brief Remove all the prefixes.
+   */
+  void Clear (void);
+
+private:
+  /**
+   * \brief Copy constructor, not implemented.
+   * \param o object to copy
+   */
+  Ipv4PrefixTrie (const Ipv4PrefixTrie &o);
+  /**
+   * \brief Assignment operator, not implemented.
+   * \param o object to copy
+   * \returns the copied object
+   */
+  Ipv4PrefixTrie &operator = (const Ipv4PrefixTrie &o);
+
+  /**
+   * \brief A node of the trie.
+   */
+  struct Node
+  {
+    uint32_t prefix;              //!< The prefix, with the bits beyond its length cleared.
+    uint8_t length;               //!< The length of the prefix.
+    Node *children[2];            //!< The longer prefixes, by their first bit beyond length.
+    std::vector<uint32_t> values; //!< The values of the prefix, empty for a branching point.
+  };
+
+  /**
+   * \brief Create a node.
+   * \param prefix the prefix
+   * \param length the length of the prefix
+   * \returns the node
+   */
+  static Node *CreateNode (uint32_t prefix, uint8_t length);
+
+  /**
+   * \brief Delete a node and its children.
+   * \param node the node
+   */
+  static void DeleteNode (Node *node);
+
+  Node *m_root; //!< The shortest prefix.
+  std::vector<uint32_t> m_nonContiguous; //!< The values of the non-contiguous masks.
+};
+
+} // namespace ns3
+
+#endif /* IPV4_PREFIX_TRIE_H */
@@ -54,7 +54,8 @@ Ipv4StaticRouting::GetTypeId (void)
 }
 
 Ipv4StaticRouting::Ipv4StaticRouting () 
-  : m_ipv4 (0)
+  : m_trieValid (false),
+    m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -73,6 +74,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_trieValid = false;
 }
 
 void 
@@ -87,6 +89,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_trieValid = false;
 }
 
 void 
@@ -144,6 +147,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_trieValid = false;
 }
 
 uint32_t 
@@ -240,12 +244,16 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 
 
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
+  // the trie gives the routes which may match, in the order of the list.
+  UpdateTrie ();
+  m_candidates.clear ();
+  m_trie.Lookup (dest, m_candidates);
+  for (std::vector<uint32_t>::const_iterator i = m_candidates.begin (); 
+       i != m_candidates.end (); 
        i++) 
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
+      Ipv4RoutingTableEntry *j = m_routes[*i].first;
+      uint32_t metric = m_routes[*i].second;
       Ipv4Mask mask = (j)->GetDestNetworkMask ();
       uint16_t masklen = mask.GetPrefixLength ();
       Ipv4Address entry = (j)->GetDestNetwork ();
@@ -349,6 +357,24 @@ Ipv4StaticRouting::LookupStatic (
   return mrtentry;
 }
 
+void
+Ipv4StaticRouting::UpdateTrie (void)
+{
+  if (m_trieValid)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_routes.assign (m_networkRoutes.begin (), m_networkRoutes.end ());
+  m_trie.Clear ();
+  for (uint32_t i = 0; i < m_routes.size (); i++)
+    {
+      m_trie.Insert (m_routes[i].first->GetDestNetwork (),
+                     m_routes[i].first->GetDestNetworkMask (), i);
+    }
+  m_trieValid = true;
+}
+
 uint32_t 
 Ipv4StaticRouting::GetNRoutes (void) const
 {
@@ -445,6 +471,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
         {
           delete j->first;
           m_networkRoutes.erase (j);
+          m_trieValid = false;
           return;
         }
       tmp++;
@@ -593,6 +620,7 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_trieValid = false;
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -633,6 +661,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_trieValid = false;
         }
       else
         {
@@ -680,6 +709,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_trieValid = false;
         }
       else
         {
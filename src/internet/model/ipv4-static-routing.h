@@ -24,6 +24,7 @@
 
 #include <list>
 #include <utility>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -31,6 +32,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-prefix-trie.h"
 
 namespace ns3 {
 
@@ -425,11 +427,36 @@ private:
    */
   Ipv4Address SourceAddressSelection (uint32_t interface, Ipv4Address dest);
 
+  /**
+   * \brief Index the network routes in m_trie if they changed.
+   */
+  void UpdateTrie (void);
+
   /**
    * \brief the forwarding table for network.
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the network routes, in the order of m_networkRoutes.
+   */
+  std::vector<std::pair <Ipv4RoutingTableEntry *, uint32_t> > m_routes;
+
+  /**
+   * \brief the positions of the network routes in m_routes, by prefix.
+   */
+  Ipv4PrefixTrie m_trie;
+
+  /**
+   * \brief true if m_routes and m_trie are up to date.
+   */
+  bool m_trieValid;
+
+  /**
+   * \brief the positions of the routes which may match a destination.
+   */
+  std::vector<uint32_t> m_candidates;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -26,16 +26,22 @@ namespace ns3 {
 
 NetfilterConntrackTuple::NetfilterConntrackTuple ()
 {
+  m_l3Protocol = 0;
   m_l4Source = 0;
   m_l4Destination = 0;
+  m_protocolNumber = 0;
+  m_direction = IP_CT_DIR_ORIGINAL;
 }
 
 NetfilterConntrackTuple::NetfilterConntrackTuple (Ipv4Address src, uint16_t srcPort, Ipv4Address dst, uint16_t dstPort)
 {
   m_l3Source = src;
+  m_l3Protocol = 0;
   m_l4Source = srcPort;
   m_l3Destination = dst;
   m_l4Destination = dstPort;
+  m_protocolNumber = 0;
+  m_direction = IP_CT_DIR_ORIGINAL;
 }
 
 bool
@@ -122,7 +128,7 @@ NetfilterConntrackTuple::SetProtocol (uint16_t protocol)
   m_l3Protocol = protocol;
 }
 
-uint16_t NetfilterConntrackTuple::GetProtocol ()
+uint16_t NetfilterConntrackTuple::GetProtocol () const
 {
   return m_l3Protocol;
 }
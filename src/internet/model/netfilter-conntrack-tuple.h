@@ -50,7 +50,7 @@ public:
   char * ToString () const;
   uint16_t GetDestinationProtocol () const;
   uint8_t GetDirection () const;
-  uint16_t GetProtocol ();
+  uint16_t GetProtocol () const;
 
   void SetSource (Ipv4Address source);
   void SetSourcePort (uint16_t source);
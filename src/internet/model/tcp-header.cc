@@ -302,15 +302,33 @@ TcpHeader::GetSerializedSize (void)  const
 void
 TcpHeader::Serialize (Buffer::Iterator start)  const
 {
+  // Build the fixed part in place and copy it in the buffer at once.
+  uint8_t image[20];
+  image[0] = m_sourcePort >> 8;
+  image[1] = m_sourcePort & 0xff;
+  image[2] = m_destinationPort >> 8;
+  image[3] = m_destinationPort & 0xff;
+  uint32_t sequenceNumber = m_sequenceNumber.GetValue ();
+  image[4] = sequenceNumber >> 24;
+  image[5] = (sequenceNumber >> 16) & 0xff;
+  image[6] = (sequenceNumber >> 8) & 0xff;
+  image[7] = sequenceNumber & 0xff;
+  uint32_t ackNumber = m_ackNumber.GetValue ();
+  image[8] = ackNumber >> 24;
+  image[9] = (ackNumber >> 16) & 0xff;
+  image[10] = (ackNumber >> 8) & 0xff;
+  image[11] = ackNumber & 0xff;
+  uint16_t field = GetLength () << 12 | m_flags; //reserved bits are all zero
+  image[12] = field >> 8;
+  image[13] = field & 0xff;
+  image[14] = m_windowSize >> 8;
+  image[15] = m_windowSize & 0xff;
+  image[16] = 0;
+  image[17] = 0;
+  image[18] = m_urgentPointer >> 8;
+  image[19] = m_urgentPointer & 0xff;
   Buffer::Iterator i = start;
-  i.WriteHtonU16 (m_sourcePort);
-  i.WriteHtonU16 (m_destinationPort);
-  i.WriteHtonU32 (m_sequenceNumber.GetValue ());
-  i.WriteHtonU32 (m_ackNumber.GetValue ());
-  i.WriteHtonU16 (GetLength () << 12 | m_flags); //reserved bits are all zero
-  i.WriteHtonU16 (m_windowSize);
-  i.WriteHtonU16 (0);
-  i.WriteHtonU16 (m_urgentPointer);
+  i.Write (image, 20);
 
   // Serialize options if they exist
   // This implementation does not presently try to align options on word
@@ -347,17 +365,19 @@ TcpHeader::Serialize (Buffer::Iterator start)  const
 uint32_t
 TcpHeader::Deserialize (Buffer::Iterator start)
 {
+  // Copy the fixed part out of the buffer at once and decode it there.
+  uint8_t image[20];
   Buffer::Iterator i = start;
-  m_sourcePort = i.ReadNtohU16 ();
-  m_destinationPort = i.ReadNtohU16 ();
-  m_sequenceNumber = i.ReadNtohU32 ();
-  m_ackNumber = i.ReadNtohU32 ();
-  uint16_t field = i.ReadNtohU16 ();
+  i.Read (image, 20);
+  m_sourcePort = (image[0] << 8) | image[1];
+  m_destinationPort = (image[2] << 8) | image[3];
+  m_sequenceNumber = ((uint32_t)image[4] << 24) | (image[5] << 16) | (image[6] << 8) | image[7];
+  m_ackNumber = ((uint32_t)image[8] << 24) | (image[9] << 16) | (image[10] << 8) | image[11];
+  uint16_t field = (image[12] << 8) | image[13];
   m_flags = field & 0x3F;
   m_length = field>>12;
-  m_windowSize = i.ReadNtohU16 ();
-  i.Next (2);
-  m_urgentPointer = i.ReadNtohU16 ();
+  m_windowSize = (image[14] << 8) | image[15];
+  m_urgentPointer = (image[18] << 8) | image[19];
 
   // Deserialize options if they exist
   m_options.clear ();
@@ -114,13 +114,24 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size ())
+  else if (m_size)
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return HeadSequence () + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
 
+SequenceNumber32
+TcpRxBuffer::HeadSequence (void) const
+{
+  NS_ASSERT (m_size != 0);
+  if (m_availBytes)
+    {
+      return m_headSeq;
+    }
+  return m_outOfOrder.begin ()->first;
+}
+
 void
 TcpRxBuffer::SetFinSequence (const SequenceNumber32& s)
 {
@@ -150,15 +161,20 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  if (m_size)
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = HeadSequence () + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end () && i->first <= tailSeq)
+  // Remove overlapped bytes from packet. The blocks are disjoint, so only
+  // the last one which starts at or before headSeq may overlap its head.
+  BufIterator i = m_outOfOrder.upper_bound (headSeq);
+  if (i != m_outOfOrder.begin ())
+    {
+      --i;
+    }
+  while (i != m_outOfOrder.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
       if (lastByteSeq > headSeq)
@@ -166,7 +182,7 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
           if (i->first > headSeq && lastByteSeq < tailSeq)
             { // Rare case: Existing packet is embedded fully in the new packet
               m_size -= i->second->GetSize ();
-              m_data.erase (i++);
+              m_outOfOrder.erase (i++);
               continue;
             }
           if (i->first <= headSeq)
@@ -194,23 +210,23 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       NS_ASSERT (length == p->GetSize ());
     }
   // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
+  NS_ASSERT (m_outOfOrder.find (headSeq) == m_outOfOrder.end ()); // Shouldn't be there yet
+  m_outOfOrder [ headSeq ] = p;
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  // Move the blocks which are now in sequence to the data available to read
+  while (!m_outOfOrder.empty () && m_outOfOrder.begin ()->first == m_nextRxSeq)
     {
-      if (i->first < m_nextRxSeq)
+      Ptr<Packet> block = m_outOfOrder.begin ()->second;
+      m_outOfOrder.erase (m_outOfOrder.begin ());
+      if (m_availBytes == 0)
         {
-          continue;
+          m_headSeq = m_nextRxSeq;
         }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      m_data.push_back (block);
+      m_nextRxSeq = m_nextRxSeq + SequenceNumber32 (block->GetSize ());
+      m_availBytes += block->GetSize ();
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
@@ -229,39 +245,41 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
   NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
+  Ptr<Packet> outPkt = 0; // The packet that contains all the data to return
   while (extractSize)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+      Ptr<Packet> head = m_data.front ();
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
+      uint32_t pktSize = head->GetSize ();
       if (pktSize <= extractSize)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
+          m_data.pop_front ();
           m_size -= pktSize;
           m_availBytes -= pktSize;
+          m_headSeq += pktSize;
           extractSize -= pktSize;
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
+          m_data.front () = head->CreateFragment (extractSize, pktSize - extractSize);
+          head = head->CreateFragment (0, extractSize);
           m_size -= extractSize;
           m_availBytes -= extractSize;
+          m_headSeq += extractSize;
           extractSize = 0;
         }
-    }
-  if (outPkt->GetSize () == 0)
-    {
-      NS_LOG_LOGIC ("Nothing extracted.");
-      return 0;
+      if (outPkt == 0)
+        { // The first packet is returned without copying its data
+          outPkt = head->Copy ();
+          outPkt->RemoveAllPacketTags ();
+        }
+      else
+        {
+          outPkt->AddAtEnd (head);
+        }
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num pkts in buffer=" << m_data.size () + m_outOfOrder.size ());
   return outPkt;
 }
 
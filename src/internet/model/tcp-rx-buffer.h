@@ -22,6 +22,7 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -36,6 +37,13 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * The data received in sequence waits for the application in a queue of
+ * packets, from which it is extracted without any search.  The data
+ * received out of sequence is kept apart, as a list of disjoint blocks
+ * sorted by sequence number, like the blocks of a SACK option: a new
+ * segment is only compared with the blocks it overlaps, and the blocks
+ * move to the queue once the hole before them is filled.
  */
 class TcpRxBuffer : public Object
 {
@@ -124,16 +132,25 @@ public:
    * \returns a packet
    */
   Ptr<Packet> Extract (uint32_t maxSize);
-public:
-  /// container for data stored in the buffer
+private:
+  /// container for the data received out of sequence, by sequence number of the first byte
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+
+  /**
+   * \brief Get the sequence number of the first byte in the buffer.
+   * \returns the sequence number of the first byte in the buffer, in sequence or not
+   */
+  SequenceNumber32 HeadSequence (void) const;
+
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  SequenceNumber32 m_headSeq;                //!< Seqnum of the first byte available to read
+  std::deque<Ptr<Packet> > m_data;           //!< Data available to read, in sequence
+  std::map<SequenceNumber32, Ptr<Packet> > m_outOfOrder; //!< Disjoint blocks of data received out of sequence
 };
 
 } //namepsace ns3
@@ -57,7 +57,7 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_lastSlice (0)
 {
 }
 
@@ -111,7 +111,10 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          Slice slice;
+          slice.seq = m_firstByteSeq + SequenceNumber32 (m_size);
+          slice.packet = p;
+          m_data.push_back (slice);
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -148,63 +151,85 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     }
 
   // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
   NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  uint32_t i = FindSlice (seq);
+  uint32_t packetOffset = seq - m_data[i].seq;
+  uint32_t pktSize = m_data[i].packet->GetSize ();
+  if (pktSize - packetOffset >= s)
+    { // Data to be copied falls entirely in this packet
+      return m_data[i].packet->CreateFragment (packetOffset, s);
+    }
+  Ptr<Packet> outPacket = m_data[i].packet->CreateFragment (packetOffset, pktSize - packetOffset);
+  uint32_t remaining = s - outPacket->GetSize ();
+  while (remaining > 0)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
+      ++i;
+      pktSize = m_data[i].packet->GetSize ();
+      if (pktSize >= remaining)
         { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
+          NS_LOG_LOGIC ("Last byte found in packet #" << i << " of seq " << m_data[i].seq
                                                       << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
+          outPacket->AddAtEnd (m_data[i].packet->CreateFragment (0, remaining));
+          remaining = 0;
         }
       else
         {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          NS_LOG_LOGIC ("Appending to output the packet #" << i << " of seq " << m_data[i].seq
+                                                           << " len=" << pktSize);
+          outPacket->AddAtEnd (m_data[i].packet);
+          remaining -= pktSize;
         }
-      count += pktSize;
+      NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
     }
+  m_lastSlice = i;
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
 }
 
+uint32_t
+TcpTxBuffer::FindSlice (const SequenceNumber32& seq)
+{
+  NS_LOG_FUNCTION (this << seq);
+  NS_ASSERT (!m_data.empty ());
+  // the segments are mostly sent in sequence: try the slice where the
+  // previous one ended, and the one which follows it.
+  for (uint32_t i = m_lastSlice; i < m_data.size () && i <= m_lastSlice + 1; ++i)
+    {
+      if (m_data[i].seq <= seq && seq < m_data[i].seq + SequenceNumber32 (m_data[i].packet->GetSize ()))
+        {
+          m_lastSlice = i;
+          return i;
+        }
+    }
+  // binary search of the last slice which starts at or before seq.
+  uint32_t low = 0;
+  uint32_t high = m_data.size ();
+  while (high - low > 1)
+    {
+      uint32_t middle = low + (high - low) / 2;
+      if (m_data[middle].seq <= seq)
+        {
+          low = middle;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  NS_LOG_LOGIC ("Sequence " << seq << " found in packet #" << low << " of seq " << m_data[low].seq);
+  m_lastSlice = low;
+  return low;
+}
+
 void
 TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
+  // the data given before the connection was established moves with the head.
+  for (BufQueue::iterator i = m_data.begin (); i != m_data.end (); ++i)
+    {
+      i->seq = seq + SequenceNumber32 (i->seq - m_firstByteSeq.Get ());
+    }
   m_firstByteSeq = seq;
 }
 
@@ -217,40 +242,39 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
-  uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
-  NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  // Discard the packets from the head of the buffer
+  while (!m_data.empty ())
     {
-      if (offset > (*i)->GetSize ())
+      Slice &head = m_data.front ();
+      uint32_t pktSize = head.packet->GetSize ();
+      if (head.seq + SequenceNumber32 (pktSize) <= seq)
         { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
           m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
+          m_data.pop_front ();
+          if (m_lastSlice > 0)
+            {
+              m_lastSlice--;
+            }
+          NS_LOG_LOGIC ("Removed one packet of size " << pktSize);
         }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
+      else
+        {
+          if (head.seq < seq)
+            { // Part of the packet is behind the seqnum. Fragment
+              uint32_t offset = seq - head.seq;
+              head.packet = head.packet->CreateFragment (offset, pktSize - offset);
+              head.seq = seq;
+              m_size -= offset;
+              NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize - offset);
+            }
           break;
         }
     }
-  // Catching the case of ACKing a FIN
-  if (m_size == 0)
-    {
-      m_firstByteSeq = seq;
-    }
+  // Also catching the case of ACKing a FIN
+  m_firstByteSeq = seq;
   NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
                         <<" numPkts="<< m_data.size ());
-  NS_ASSERT (m_firstByteSeq == seq);
+  NS_ASSERT (m_data.empty () || m_data.front ().seq == seq);
 }
 
 } // namepsace ns3
@@ -21,7 +21,7 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,6 +36,13 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The packets given by the application are kept, without copying their
+ * data, in a queue of slices which records the sequence number of the
+ * first byte of each of them.  The slice which holds a sequence number
+ * is found by a binary search of the queue, and the segments are usually
+ * extracted in sequence, so the slice which follows the previous
+ * extraction is tried first.
  */
 class TcpTxBuffer : public Object
 {
@@ -128,13 +135,30 @@ public:
   void DiscardUpTo (const SequenceNumber32& seq);
 
 private:
+  /**
+   * \brief A packet of the buffer.
+   */
+  struct Slice
+  {
+    SequenceNumber32 seq; //!< Sequence number of the first byte of the packet
+    Ptr<Packet> packet;   //!< The packet
+  };
+
   /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  typedef std::deque<Slice> BufQueue;
+
+  /**
+   * \brief Find the slice which holds a sequence number.
+   * \param seq the sequence number, in [HeadSequence, TailSequence)
+   * \returns the index of the slice in m_data
+   */
+  uint32_t FindSlice (const SequenceNumber32& seq);
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  BufQueue m_data;                              //!< Corresponding data (may be null)
+  uint32_t m_lastSlice;                         //!< Index of the slice where the last extraction ended
 };
 
 } // namepsace ns3
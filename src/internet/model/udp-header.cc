@@ -183,47 +183,42 @@ UdpHeader::GetSerializedSize (void) const
 void
 UdpHeader::Serialize (Buffer::Iterator start) const
 {
+  // Build the header in place and copy it in the buffer at once.
+  uint8_t image[8];
+  image[0] = m_sourcePort >> 8;
+  image[1] = m_sourcePort & 0xff;
+  image[2] = m_destinationPort >> 8;
+  image[3] = m_destinationPort & 0xff;
+  uint16_t length = m_payloadSize == 0 ? start.GetSize () : m_payloadSize;
+  image[4] = length >> 8;
+  image[5] = length & 0xff;
+  image[6] = m_checksum & 0xff;
+  image[7] = m_checksum >> 8;
   Buffer::Iterator i = start;
+  i.Write (image, 8);
 
-  i.WriteHtonU16 (m_sourcePort);
-  i.WriteHtonU16 (m_destinationPort);
-  if (m_payloadSize == 0)
+  if (m_checksum == 0 && m_calcChecksum)
     {
-      i.WriteHtonU16 (start.GetSize ());
-    }
-  else
-    {
-      i.WriteHtonU16 (m_payloadSize);
-    }
+      uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
+      i = start;
+      uint16_t checksum = i.CalculateIpChecksum (start.GetSize (), headerChecksum);
 
-  if ( m_checksum == 0)
-    {
-      i.WriteU16 (0);
-
-      if (m_calcChecksum)
-        {
-          uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
-          i = start;
-          uint16_t checksum = i.CalculateIpChecksum (start.GetSize (), headerChecksum);
-
-          i = start;
-          i.Next (6);
-          i.WriteU16 (checksum);
-        }
-    }
-  else
-    {
-      i.WriteU16 (m_checksum);
+      i = start;
+      i.Next (6);
+      i.WriteU16 (checksum);
     }
 }
 uint32_t
 UdpHeader::Deserialize (Buffer::Iterator start)
 {
+  // Copy the header out of the buffer at once and decode it there.
+  uint8_t image[8];
   Buffer::Iterator i = start;
-  m_sourcePort = i.ReadNtohU16 ();
-  m_destinationPort = i.ReadNtohU16 ();
-  m_payloadSize = i.ReadNtohU16 () - GetSerializedSize ();
-  m_checksum = i.ReadU16 ();
+  i.Read (image, 8);
+  m_sourcePort = (image[0] << 8) | image[1];
+  m_destinationPort = (image[2] << 8) | image[3];
+  m_payloadSize = ((image[4] << 8) | image[5]) - GetSerializedSize ();
+  m_checksum = image[6] | (image[7] << 8);
 
   if (m_calcChecksum)
     {
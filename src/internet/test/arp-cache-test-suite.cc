@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/callback.h"
+#include "ns3/mac48-address.h"
+#include "ns3/arp-cache.h"
+
+using namespace ns3;
+
+/**
+ * Check the pending packets of the ARP cache entries.
+ */
+class ArpCachePendingTestCase : public TestCase
+{
+public:
+  ArpCachePendingTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+ArpCachePendingTestCase::ArpCachePendingTestCase ()
+  : TestCase ("Check the queue of the packets waiting for a reply")
+{
+}
+
+void
+ArpCachePendingTestCase::DoRun (void)
+{
+  Ptr<ArpCache> cache = CreateObject<ArpCache> ();
+  cache->SetAttribute ("PendingQueueSize", UintegerValue (3));
+  ArpCache::Entry *entry = cache->Add (Ipv4Address ("10.0.0.1"));
+
+  Ptr<Packet> packets[5];
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      packets[i] = Create<Packet> (i);
+    }
+  entry->MarkWaitReply (packets[0]);
+  NS_TEST_EXPECT_MSG_EQ (entry->UpdateWaitReply (packets[1]), true, "The queue is not full");
+  NS_TEST_EXPECT_MSG_EQ (entry->UpdateWaitReply (packets[2]), true, "The queue is not full");
+  NS_TEST_EXPECT_MSG_EQ (entry->UpdateWaitReply (packets[3]), false, "The queue is full");
+  NS_TEST_EXPECT_MSG_EQ (entry->DequeuePending (), packets[0], "Wrong packet order");
+  NS_TEST_EXPECT_MSG_EQ (entry->UpdateWaitReply (packets[3]), true, "The queue is not full");
+  NS_TEST_EXPECT_MSG_EQ (entry->DequeuePending (), packets[1], "Wrong packet order");
+
+  // the queue grows if its size is raised while packets are waiting.
+  cache->SetAttribute ("PendingQueueSize", UintegerValue (4));
+  NS_TEST_EXPECT_MSG_EQ (entry->UpdateWaitReply (packets[4]), true, "The queue is not full");
+  NS_TEST_EXPECT_MSG_EQ (entry->UpdateWaitReply (packets[0]), true, "The queue is not full");
+  NS_TEST_EXPECT_MSG_EQ (entry->UpdateWaitReply (packets[1]), false, "The queue is full");
+  NS_TEST_EXPECT_MSG_EQ (entry->DequeuePending (), packets[2], "Wrong packet order");
+  NS_TEST_EXPECT_MSG_EQ (entry->DequeuePending (), packets[3], "Wrong packet order");
+  NS_TEST_EXPECT_MSG_EQ (entry->DequeuePending (), packets[4], "Wrong packet order");
+  NS_TEST_EXPECT_MSG_EQ (entry->DequeuePending (), packets[0], "Wrong packet order");
+  NS_TEST_EXPECT_MSG_EQ (entry->DequeuePending (), 0, "The queue is not empty");
+
+  entry->UpdateWaitReply (packets[1]);
+  entry->ClearPendingPacket ();
+  NS_TEST_EXPECT_MSG_EQ (entry->DequeuePending (), 0, "The queue was not cleared");
+  entry->MarkAlive (Mac48Address ("00:00:00:00:00:01"));
+  cache->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Check the retransmissions of the ARP requests, the removal of the
+ * expired entries and the statistics of the ARP cache.
+ */
+class ArpCacheTimeoutTestCase : public TestCase
+{
+public:
+  ArpCacheTimeoutTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Count a retransmitted ARP request.
+   * \param cache the ARP cache
+   * \param to the address to resolve
+   */
+  void SendRequest (Ptr<const ArpCache> cache, Ipv4Address to);
+  /**
+   * Count a dropped packet.
+   * \param packet the packet
+   */
+  void Drop (Ptr<const Packet> packet);
+  /**
+   * Store the new value of a statistic of the cache.
+   * \param value the stored value
+   * \param oldValue the previous value
+   * \param newValue the new value
+   */
+  static void Store (uint32_t *value, uint32_t oldValue, uint32_t newValue);
+  uint32_t m_nRetransmissions; //!< Number of ARP requests retransmitted by the cache.
+  uint32_t m_nDrops; //!< Number of packets dropped by the cache.
+};
+
+ArpCacheTimeoutTestCase::ArpCacheTimeoutTestCase ()
+  : TestCase ("Check the retransmissions and the expiry of the entries"),
+    m_nRetransmissions (0),
+    m_nDrops (0)
+{
+}
+
+void
+ArpCacheTimeoutTestCase::SendRequest (Ptr<const ArpCache> cache, Ipv4Address to)
+{
+  m_nRetransmissions++;
+}
+
+void
+ArpCacheTimeoutTestCase::Drop (Ptr<const Packet> packet)
+{
+  m_nDrops++;
+}
+
+void
+ArpCacheTimeoutTestCase::Store (uint32_t *value, uint32_t oldValue, uint32_t newValue)
+{
+  *value = newValue;
+}
+
+void
+ArpCacheTimeoutTestCase::DoRun (void)
+{
+  Ptr<ArpCache> cache = CreateObject<ArpCache> ();
+  cache->SetAttribute ("MaxRetries", UintegerValue (2));
+  cache->SetArpRequestCallback (MakeCallback (&ArpCacheTimeoutTestCase::SendRequest, this));
+  cache->TraceConnectWithoutContext ("Drop", MakeCallback (&ArpCacheTimeoutTestCase::Drop, this));
+  uint32_t nEntries = 0;
+  uint32_t nRequests = 0;
+  uint32_t nReplies = 0;
+  cache->TraceConnectWithoutContext ("Entries", MakeBoundCallback (&ArpCacheTimeoutTestCase::Store, &nEntries));
+  cache->TraceConnectWithoutContext ("Requests", MakeBoundCallback (&ArpCacheTimeoutTestCase::Store, &nRequests));
+  cache->TraceConnectWithoutContext ("Replies", MakeBoundCallback (&ArpCacheTimeoutTestCase::Store, &nReplies));
+
+  // many resolved entries, and one which never gets a reply.
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      ArpCache::Entry *entry = cache->Add (Ipv4Address (0x0a000000 + i));
+      entry->MarkWaitReply (Create<Packet> ());
+      if (i != 50)
+        {
+          entry->MarkAlive (Mac48Address::Allocate ());
+        }
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_nRetransmissions, 2, "The waiting entry was not retransmitted");
+  NS_TEST_EXPECT_MSG_EQ (m_nDrops, 1, "The pending packet was not dropped");
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup (Ipv4Address (0x0a000000 + 50))->IsDead (), true,
+                         "The entry is not dead");
+
+  NS_TEST_EXPECT_MSG_EQ (nRequests, 102, "Wrong number of requests");
+  NS_TEST_EXPECT_MSG_EQ (nReplies, 99, "Wrong number of replies");
+  NS_TEST_EXPECT_MSG_EQ (nEntries, 100, "Wrong number of entries");
+
+  // once the entries expired, they are removed when the cache grows.
+  Simulator::Schedule (cache->GetAliveTimeout () + Seconds (1), &Simulator::Stop);
+  Simulator::Run ();
+  ArpCache::Entry *permanent = cache->Add (Ipv4Address ("10.1.0.1"));
+  permanent->SetMacAddresss (Mac48Address::Allocate ());
+  permanent->MarkPermanent ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      ArpCache::Entry *entry = cache->Add (Ipv4Address (0x0a020000 + i));
+      entry->MarkWaitReply (Create<Packet> ());
+      entry->MarkAlive (Mac48Address::Allocate ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup (Ipv4Address (0x0a000000)), 0, "The expired entry was not removed");
+  NS_TEST_EXPECT_MSG_NE (cache->Lookup (Ipv4Address ("10.1.0.1")), 0, "The permanent entry was removed");
+  NS_TEST_EXPECT_MSG_EQ (nEntries, 101, "Wrong number of entries");
+
+  cache->Dispose ();
+  Simulator::Destroy ();
+}
+
+class ArpCacheTestSuite : public TestSuite
+{
+public:
+  ArpCacheTestSuite ()
+    : TestSuite ("arp-cache", UNIT)
+  {
+    AddTestCase (new ArpCachePendingTestCase, TestCase::QUICK);
+    AddTestCase (new ArpCacheTimeoutTestCase, TestCase::QUICK);
+  }
+} g_arpCacheTestSuite;
@@ -213,6 +213,55 @@ GlobalRouteManagerImplTestCase::DoRun (void)
   // does not crash
 }
 
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase();
+  virtual void DoRun (void);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase()
+  : TestCase ("Check the order of the CandidateQueue after a reordering")
+{
+}
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+  SPFVertex *v[4];
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      v[i] = new SPFVertex;
+      v[i]->SetVertexId (Ipv4Address (i + 1));
+      v[i]->SetVertexType (SPFVertex::VertexRouter);
+      v[i]->SetDistanceFromRoot (10 * (i + 1));
+      candidate.Push (v[i]);
+    }
+  v[1]->SetVertexType (SPFVertex::VertexNetwork);
+
+  NS_TEST_EXPECT_MSG_EQ (candidate.Find (Ipv4Address (3)), v[2], "Vertex not found");
+  NS_TEST_EXPECT_MSG_EQ (candidate.Find (Ipv4Address (5)), 0, "Unknown vertex found");
+
+  // v[3] has the distance of v[0] and goes after it; v[1] has the same
+  // distance too, but a network goes before a router.
+  v[3]->SetDistanceFromRoot (10);
+  candidate.Reorder (v[3]);
+  v[1]->SetDistanceFromRoot (10);
+  candidate.Reorder (v[1]);
+
+  NS_TEST_EXPECT_MSG_EQ (candidate.Pop (), v[1], "Wrong vertex order");
+  NS_TEST_EXPECT_MSG_EQ (candidate.Pop (), v[0], "Wrong vertex order");
+  NS_TEST_EXPECT_MSG_EQ (candidate.Pop (), v[3], "Wrong vertex order");
+  NS_TEST_EXPECT_MSG_EQ (candidate.Find (Ipv4Address (4)), 0, "Popped vertex found");
+  NS_TEST_EXPECT_MSG_EQ (candidate.Top (), v[2], "Wrong vertex order");
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      if (i != 2)
+        {
+          delete v[i];
+        }
+    }
+}
 
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
@@ -221,5 +270,6 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+    AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
   }
 } g_globalRoutingManagerImplTestSuite;
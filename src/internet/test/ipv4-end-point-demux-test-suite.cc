@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-interface.h"
+
+using namespace ns3;
+
+/**
+ * Check that the lookups of Ipv4EndPointDemux find the listening and the
+ * connected end points, including after their four-tuple changes.
+ */
+class Ipv4EndPointDemuxLookupTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxLookupTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxLookupTestCase::Ipv4EndPointDemuxLookupTestCase ()
+  : TestCase ("Check the lookup of listening and connected end points")
+{
+}
+
+void
+Ipv4EndPointDemuxLookupTestCase::DoRun (void)
+{
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer1 ("10.0.1.1");
+  Ipv4Address peer2 ("10.0.1.2");
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  interface->AddAddress (Ipv4InterfaceAddress (local, Ipv4Mask ("255.255.255.0")));
+
+  Ipv4EndPointDemux demux;
+  Ipv4EndPoint *listener = demux.Allocate (80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Allocation failed");
+  Ipv4EndPoint *connection1 = demux.Allocate (local, 80, peer1, 1000);
+  Ipv4EndPoint *connection2 = demux.Allocate (local, 80, peer2, 1000);
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 80, peer1, 1000), 0, "Duplicate four-tuple");
+
+  Ipv4EndPointDemux::EndPoints endPoints = demux.Lookup (local, 80, peer1, 1000, interface);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of end points");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), connection1, "The connection was not found");
+  endPoints = demux.Lookup (local, 80, peer2, 1000, interface);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of end points");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), connection2, "The connection was not found");
+  endPoints = demux.Lookup (local, 80, peer1, 1001, interface);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of end points");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), listener, "The listener was not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, 81, peer1, 1000, interface).size (), 0, "Wrong port");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 80, peer2, 1000), connection2, "The connection was not found");
+
+  // a connected end point which can not receive is skipped.
+  connection1->SetRxEnabled (false);
+  endPoints = demux.Lookup (local, 80, peer1, 1000, interface);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of end points");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), listener, "The listener was not found");
+  connection1->SetRxEnabled (true);
+
+  // the end points are found again after a change of their four-tuple.
+  connection1->SetPeer (peer1, 2000);
+  endPoints = demux.Lookup (local, 80, peer1, 1000, interface);
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), listener, "The old peer still matches");
+  endPoints = demux.Lookup (local, 80, peer1, 2000, interface);
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), connection1, "The new peer does not match");
+
+  Ipv4EndPoint *client = demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (client, 0, "Allocation failed");
+  client->SetPeer (peer1, 80);
+  endPoints = demux.Lookup (local, client->GetLocalPort (), peer1, 80, interface);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of end points");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), client, "The client was not found");
+  client->SetLocalAddress (local);
+  endPoints = demux.Lookup (local, client->GetLocalPort (), peer1, 80, interface);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of end points");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), client, "The client was not found");
+
+  // the ports stay used as long as one of their end points exists.
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (local, 80), true, "The connections use the port");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (peer1, 80), false, "No end point for this address");
+  demux.DeAllocate (listener);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), true, "The connections use the port");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, 80, peer1, 1001, interface).size (), 0, "The listener was not removed");
+  demux.DeAllocate (connection1);
+  demux.DeAllocate (connection2);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), false, "The port is still used");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 1, "Wrong number of end points");
+}
+
+/**
+ * Check the allocation of the ephemeral ports of Ipv4EndPointDemux.
+ */
+class Ipv4EndPointDemuxEphemeralTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxEphemeralTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxEphemeralTestCase::Ipv4EndPointDemuxEphemeralTestCase ()
+  : TestCase ("Check the allocation of the ephemeral ports")
+{
+}
+
+void
+Ipv4EndPointDemuxEphemeralTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  // a port bound explicitly is skipped.
+  demux.Allocate (49154);
+  Ipv4EndPoint *first = demux.Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (first->GetLocalPort (), 49153, "Wrong first ephemeral port");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49155, "A used port was allocated");
+
+  // all the ephemeral ports can be used, then none is left.
+  uint32_t n = 3;
+  while (demux.Allocate () != 0)
+    {
+      n++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (n, 65535 - 49152 + 1, "Wrong number of ephemeral ports");
+
+  // a released port is allocated again.
+  demux.DeAllocate (first);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (49153), false, "The port is still used");
+  Ipv4EndPoint *again = demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (again, 0, "The released port was not allocated");
+  NS_TEST_EXPECT_MSG_EQ (again->GetLocalPort (), 49153, "Wrong ephemeral port");
+}
+
+class Ipv4EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  Ipv4EndPointDemuxTestSuite ()
+    : TestSuite ("ipv4-end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxLookupTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4EndPointDemuxEphemeralTestCase, TestCase::QUICK);
+  }
+} g_ipv4EndPointDemuxTestSuite;
@@ -14,6 +14,8 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <sstream>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
@@ -36,6 +38,10 @@
 #include "ns3/simple-channel.h"
 #include "ns3/socket-factory.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/global-value.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
 
 using namespace ns3;
 
@@ -420,6 +426,160 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
 }
 
 
+class Ipv4GlobalRoutingRecomputeTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingRecomputeTestCase ();
+
+private:
+  typedef std::vector<std::vector<std::string> > Tables;
+  Tables GetTables (bool sorted) const;
+  void ApplyChange (uint32_t change, bool undo);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  NodeContainer m_nodes;
+};
+
+Ipv4GlobalRoutingRecomputeTestCase::Ipv4GlobalRoutingRecomputeTestCase ()
+  : TestCase ("Check the global routes computed on several threads and incrementally")
+{
+}
+
+// The routing tables of all the nodes, in table order or sorted
+Ipv4GlobalRoutingRecomputeTestCase::Tables
+Ipv4GlobalRoutingRecomputeTestCase::GetTables (bool sorted) const
+{
+  Tables tables;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> gr = m_nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      std::vector<std::string> table;
+      for (uint32_t j = 0; j < gr->GetNRoutes (); j++)
+        {
+          std::ostringstream oss;
+          oss << *gr->GetRoute (j);
+          table.push_back (oss.str ());
+        }
+      if (sorted)
+        {
+          std::sort (table.begin (), table.end ());
+        }
+      tables.push_back (table);
+    }
+  return tables;
+}
+
+// The changes of the topology: links which go down and metrics which
+// increase, which the incremental computation handles, then the reverse
+// changes, which make it fall back to the full computation.
+void
+Ipv4GlobalRoutingRecomputeTestCase::ApplyChange (uint32_t change, bool undo)
+{
+  static const uint32_t nodes[] = { 5, 6, 9, 3 };
+  static const uint32_t interfaces[] = { 1, 2, 1, 2 };
+  Ptr<Ipv4> ipv4 = m_nodes.Get (nodes[change])->GetObject<Ipv4> ();
+  if (change % 2 == 0)
+    {
+      if (undo)
+        {
+          ipv4->SetUp (interfaces[change]);
+        }
+      else
+        {
+          ipv4->SetDown (interfaces[change]);
+        }
+    }
+  else
+    {
+      ipv4->SetMetric (interfaces[change], undo ? 1 : 5);
+    }
+}
+
+// Test program for a grid of 3 x 4 routers connected by point-to-point
+// links, with a shared network between routers 0, 5 and 10 and a stub
+// host 12 behind router 11.  The routing tables must not depend on the
+// number of threads, and the incremental recomputation must give the same
+// routes as the full one after each change of the topology.
+void
+Ipv4GlobalRoutingRecomputeTestCase::DoRun (void)
+{
+  m_nodes.Create (13);
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 12; i++)
+    {
+      if (i % 4 != 3)
+        {
+          ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (i), m_nodes.Get (i + 1))));
+          ipv4.NewNetwork ();
+        }
+      if (i < 8)
+        {
+          ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (i), m_nodes.Get (i + 4))));
+          ipv4.NewNetwork ();
+        }
+    }
+  ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (11), m_nodes.Get (12))));
+  ipv4.NewNetwork ();
+  devHelper.SetNetDevicePointToPointMode (false);
+  ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (0), m_nodes.Get (5), m_nodes.Get (10))));
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  Tables serial = GetTables (false);
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_ASSERT_MSG_EQ ((GetTables (false) == serial), true, "The routes depend on the number of threads");
+
+  // the routes of the full computation after each change
+  std::vector<Tables> full;
+  for (uint32_t change = 0; change < 4; change++)
+    {
+      ApplyChange (change, false);
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      full.push_back (GetTables (true));
+    }
+  for (uint32_t change = 0; change < 4; change++)
+    {
+      ApplyChange (3 - change, true);
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      full.push_back (GetTables (true));
+    }
+
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (true));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_ASSERT_MSG_EQ ((GetTables (false) == serial), true, "The first incremental computation is not a full one");
+  for (uint32_t change = 0; change < 4; change++)
+    {
+      ApplyChange (change, false);
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      NS_TEST_ASSERT_MSG_EQ ((GetTables (true) == full[change]), true,
+                             "The incremental routes differ after change " << change);
+    }
+  for (uint32_t change = 0; change < 4; change++)
+    {
+      ApplyChange (3 - change, true);
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      NS_TEST_ASSERT_MSG_EQ ((GetTables (true) == full[4 + change]), true,
+                             "The incremental routes differ after undoing change " << 3 - change);
+    }
+
+  Simulator::Destroy ();
+}
+
+void
+Ipv4GlobalRoutingRecomputeTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (false));
+  m_nodes = NodeContainer ();
+}
+
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
 public:
@@ -431,6 +591,7 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingRecomputeTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,805 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/socket.h"
+#include "ns3/socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/ipv4-raw-socket-factory.h"
+#include "ns3/icmpv4.h"
+#include "ns3/uinteger.h"
+#include "ns3/callback.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/log.h"
+#include "ns3/output-stream-wrapper.h"
+
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-nat-helper.h"
+#include "ns3/ipv4-nat.h"
+#include "ns3/ipv4-netfilter.h"
+#include "ns3/ipv4-address-generator.h"
+#include "ns3/buffer.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/udp-header.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+
+#include <string>
+#include <sstream>
+#include <limits>
+
+using namespace ns3;
+
+/**
+ * \brief Add a SimpleNetDevice on the given channel and configure an
+ * IPv4 interface with the given address (/24) on it.
+ * \returns the Ipv4 interface index
+ */
+static uint32_t
+AddInterface (Ptr<Node> node, Ptr<SimpleChannel> channel, const char *address)
+{
+  Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+  dev->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+  dev->SetChannel (channel);
+  node->AddDevice (dev);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (dev);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (address), Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (interface);
+  return interface;
+}
+
+/**
+ * \brief Static NAT with two inside and two outside interfaces.
+ *
+ * Each inside host sits behind its own inside interface, while the server
+ * is reached through the second of two outside interfaces.
+ */
+class Ipv4NatMultiInterfaceTest : public TestCase
+{
+public:
+  Ipv4NatMultiInterfaceTest ();
+  virtual void DoRun (void);
+
+private:
+  void DoSendData (Ptr<Socket> socket, std::string to);
+  void ServerReceive (Ptr<Socket> socket);
+  void ClientReceive (Ptr<Socket> socket);
+
+  std::vector<Ipv4Address> m_serverSources;
+  uint32_t m_clientReceived;
+};
+
+Ipv4NatMultiInterfaceTest::Ipv4NatMultiInterfaceTest ()
+  : TestCase ("Static NAT over multiple inside and outside interfaces"),
+    m_clientReceived (0)
+{
+}
+
+void
+Ipv4NatMultiInterfaceTest::DoSendData (Ptr<Socket> socket, std::string to)
+{
+  Address realTo = InetSocketAddress (Ipv4Address (to.c_str ()), 1234);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, realTo),
+                         123, "send failed");
+}
+
+void
+Ipv4NatMultiInterfaceTest::ServerReceive (Ptr<Socket> socket)
+{
+  Address from;
+  Ptr<Packet> packet = socket->RecvFrom (std::numeric_limits<uint32_t>::max (), 0, from);
+  m_serverSources.push_back (InetSocketAddress::ConvertFrom (from).GetIpv4 ());
+  socket->SendTo (Create<Packet> (packet->GetSize ()), 0, from);
+}
+
+void
+Ipv4NatMultiInterfaceTest::ClientReceive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet = socket->Recv (std::numeric_limits<uint32_t>::max (), 0);
+  m_clientReceived++;
+}
+
+void
+Ipv4NatMultiInterfaceTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (4);
+  Ptr<Node> hostA = nodes.Get (0);
+  Ptr<Node> hostB = nodes.Get (1);
+  Ptr<Node> natNode = nodes.Get (2);
+  Ptr<Node> server = nodes.Get (3);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ptr<SimpleChannel> insideA = CreateObject<SimpleChannel> ();
+  Ptr<SimpleChannel> insideB = CreateObject<SimpleChannel> ();
+  Ptr<SimpleChannel> outside1 = CreateObject<SimpleChannel> ();
+  Ptr<SimpleChannel> outside2 = CreateObject<SimpleChannel> ();
+
+  uint32_t hostAIf = AddInterface (hostA, insideA, "192.168.1.2");
+  uint32_t hostBIf = AddInterface (hostB, insideB, "192.168.2.2");
+  uint32_t natInA = AddInterface (natNode, insideA, "192.168.1.1");
+  uint32_t natInB = AddInterface (natNode, insideB, "192.168.2.1");
+  uint32_t natOut1 = AddInterface (natNode, outside1, "203.0.113.1");
+  uint32_t natOut2 = AddInterface (natNode, outside2, "198.51.100.1");
+  AddInterface (server, outside2, "198.51.100.2");
+
+  Ipv4StaticRoutingHelper routingHelper;
+  routingHelper.GetStaticRouting (hostA->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("192.168.1.1"), hostAIf);
+  routingHelper.GetStaticRouting (hostB->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("192.168.2.1"), hostBIf);
+
+  Ipv4NatHelper natHelper;
+  Ptr<Ipv4Nat> nat = natHelper.Install (natNode);
+  nat->SetInside (natInA);
+  nat->SetInside (natInB);
+  nat->SetOutside (natOut1);
+  nat->SetOutside (natOut2);
+  nat->AddStaticRule (Ipv4StaticNatRule (Ipv4Address ("192.168.1.2"), Ipv4Address ("198.51.100.10")));
+  nat->AddStaticRule (Ipv4StaticNatRule (Ipv4Address ("192.168.2.2"), Ipv4Address ("198.51.100.11")));
+
+  NS_TEST_EXPECT_MSG_EQ (nat->GetNInsideInterfaces (), 2, "inside interfaces");
+  NS_TEST_EXPECT_MSG_EQ (nat->GetNOutsideInterfaces (), 2, "outside interfaces");
+  Ptr<Ipv4> natIpv4 = natNode->GetObject<Ipv4> ();
+  NS_TEST_EXPECT_MSG_EQ (nat->IsInside (natIpv4->GetNetDevice (natInB)), true, "inside role");
+  NS_TEST_EXPECT_MSG_EQ (nat->IsOutside (natIpv4->GetNetDevice (natInB)), false, "inside role");
+  NS_TEST_EXPECT_MSG_EQ (nat->IsOutside (natIpv4->GetNetDevice (natOut1)), true, "outside role");
+  NS_TEST_EXPECT_MSG_EQ (nat->IsInside (natIpv4->GetNetDevice (0)), false, "loopback has no role");
+  // the global addresses are proxied only on the outside link they belong to
+  NS_TEST_EXPECT_MSG_EQ (natIpv4->GetNAddresses (natOut1), 1, "proxy address on wrong link");
+  NS_TEST_EXPECT_MSG_EQ (natIpv4->GetNAddresses (natOut2), 3, "proxy addresses missing");
+
+  Ptr<Socket> serverSocket = server->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (serverSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234)), 0, "trivial");
+  serverSocket->SetRecvCallback (MakeCallback (&Ipv4NatMultiInterfaceTest::ServerReceive, this));
+
+  Ptr<Socket> socketA = hostA->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  socketA->SetRecvCallback (MakeCallback (&Ipv4NatMultiInterfaceTest::ClientReceive, this));
+  Ptr<Socket> socketB = hostB->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  socketB->SetRecvCallback (MakeCallback (&Ipv4NatMultiInterfaceTest::ClientReceive, this));
+
+  Simulator::ScheduleWithContext (hostA->GetId (), Seconds (1),
+                                  &Ipv4NatMultiInterfaceTest::DoSendData, this, socketA, "198.51.100.2");
+  Simulator::ScheduleWithContext (hostB->GetId (), Seconds (2),
+                                  &Ipv4NatMultiInterfaceTest::DoSendData, this, socketB, "198.51.100.2");
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_serverSources.size (), 2, "server did not receive both packets");
+  NS_TEST_EXPECT_MSG_EQ (m_serverSources[0], Ipv4Address ("198.51.100.10"), "host A not translated");
+  NS_TEST_EXPECT_MSG_EQ (m_serverSources[1], Ipv4Address ("198.51.100.11"), "host B not translated");
+  NS_TEST_EXPECT_MSG_EQ (m_clientReceived, 2, "replies were not translated back");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Dynamic NAT state saved during one run and restored in the next.
+ */
+class Ipv4NatStateTest : public TestCase
+{
+public:
+  Ipv4NatStateTest ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Build inside host -- NAT -- server with a dynamic NAT rule,
+   * and send one packet from the given host port at t = 1s.
+   */
+  Ptr<Ipv4Nat> RunScenario (std::string saveFile, std::string restoreFile, uint16_t hostPort);
+  void DoSendData (Ptr<Socket> socket);
+  void ServerReceive (Ptr<Socket> socket);
+  void CheckStartState (Ptr<Ipv4Nat> nat, Ptr<Ipv4Netfilter> netfilter);
+
+  std::vector<InetSocketAddress> m_serverSources;
+  uint32_t m_tuplesAtStart;
+  uint32_t m_conntrackAtStart;
+  uint32_t m_conntrackEntries;
+  Ptr<Ipv4Netfilter> m_netfilter;
+};
+
+Ipv4NatStateTest::Ipv4NatStateTest ()
+  : TestCase ("Dynamic NAT state snapshot and restore"),
+    m_tuplesAtStart (0),
+    m_conntrackAtStart (0),
+    m_conntrackEntries (0)
+{
+}
+
+void
+Ipv4NatStateTest::CheckStartState (Ptr<Ipv4Nat> nat, Ptr<Ipv4Netfilter> netfilter)
+{
+  m_tuplesAtStart = nat->GetNDynamicTuples ();
+  m_conntrackAtStart = netfilter->GetHash ().size ();
+}
+
+void
+Ipv4NatStateTest::DoSendData (Ptr<Socket> socket)
+{
+  Address realTo = InetSocketAddress (Ipv4Address ("203.0.113.2"), 1234);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, realTo),
+                         123, "send failed");
+}
+
+void
+Ipv4NatStateTest::ServerReceive (Ptr<Socket> socket)
+{
+  Address from;
+  Ptr<Packet> packet = socket->RecvFrom (std::numeric_limits<uint32_t>::max (), 0, from);
+  m_serverSources.push_back (InetSocketAddress::ConvertFrom (from));
+}
+
+Ptr<Ipv4Nat>
+Ipv4NatStateTest::RunScenario (std::string saveFile, std::string restoreFile, uint16_t hostPort)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  Ptr<Node> host = nodes.Get (0);
+  Ptr<Node> natNode = nodes.Get (1);
+  Ptr<Node> server = nodes.Get (2);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ptr<SimpleChannel> inside = CreateObject<SimpleChannel> ();
+  Ptr<SimpleChannel> outside = CreateObject<SimpleChannel> ();
+  uint32_t hostIf = AddInterface (host, inside, "192.168.1.2");
+  uint32_t natIn = AddInterface (natNode, inside, "192.168.1.1");
+  uint32_t natOut = AddInterface (natNode, outside, "203.0.113.1");
+  uint32_t serverIf = AddInterface (server, outside, "203.0.113.2");
+
+  Ipv4StaticRoutingHelper routingHelper;
+  routingHelper.GetStaticRouting (host->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("192.168.1.1"), hostIf);
+  routingHelper.GetStaticRouting (server->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("203.0.113.1"), serverIf);
+
+  Ipv4NatHelper natHelper;
+  Ptr<Ipv4Nat> nat = natHelper.Install (natNode);
+  nat->SetInside (natIn);
+  nat->SetOutside (natOut);
+  nat->AddAddressPool ("198.51.100.0", "0.0.0.10", "0.0.0.10", "255.255.255.0");
+  nat->AddPortPool (50000, 50010);
+  nat->AddDynamicRule (Ipv4DynamicNatRule (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0")));
+  if (!saveFile.empty ())
+    {
+      natHelper.ScheduleSaveState (nat, Seconds (5), saveFile);
+    }
+  if (!restoreFile.empty ())
+    {
+      natHelper.RestoreState (nat, restoreFile);
+    }
+
+  Ptr<Socket> serverSocket = server->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (serverSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234)), 0, "trivial");
+  serverSocket->SetRecvCallback (MakeCallback (&Ipv4NatStateTest::ServerReceive, this));
+
+  Ptr<Socket> socket = host->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), hostPort)), 0, "trivial");
+  Ptr<Ipv4Netfilter> netfilter = natNode->GetObject<Ipv4> ()->GetNetfilter ();
+  Simulator::Schedule (Seconds (0.5), &Ipv4NatStateTest::CheckStartState, this, nat, netfilter);
+  Simulator::ScheduleWithContext (host->GetId (), Seconds (1),
+                                  &Ipv4NatStateTest::DoSendData, this, socket);
+  Simulator::Run ();
+  m_conntrackEntries = netfilter->GetHash ().size ();
+  m_netfilter = netfilter;
+  return nat;
+}
+
+void
+Ipv4NatStateTest::DoRun (void)
+{
+  std::string stateFile = CreateTempDirFilename ("ipv4-nat-state.bin");
+
+  // Warm-up run: one binding is created and saved
+  Ptr<Ipv4Nat> nat = RunScenario (stateFile, "", 2000);
+  NS_TEST_ASSERT_MSG_EQ (m_serverSources.size (), 1, "warm-up packet lost");
+  NS_TEST_ASSERT_MSG_EQ (nat->GetNDynamicTuples (), 1, "binding not created");
+  Ipv4DynamicNatTuple saved = nat->GetDynamicTuple (0);
+  uint32_t savedConntrack = m_conntrackEntries;
+  NS_TEST_EXPECT_MSG_GT (savedConntrack, 0, "no conntrack entries to save");
+
+  // A state which does not hold the tuples it announces is rejected and
+  // leaves the current state alone
+  Buffer state;
+  state.AddAtStart (nat->GetSerializedStateSize ());
+  nat->SerializeState (state.Begin ());
+  Buffer truncated = state.CreateFragment (0, state.GetSize () - 1);
+  NS_TEST_EXPECT_MSG_EQ (nat->DeserializeState (truncated.Begin ()), 0, "truncated state accepted");
+  Buffer::Iterator count = state.Begin ();
+  count.Next (4 + 4 + 4 + 2 + 2 + 2 + 2);
+  count.WriteHtonU32 (0xffffffff);
+  NS_TEST_EXPECT_MSG_EQ (nat->DeserializeState (state.Begin ()), 0, "oversized tuple count accepted");
+  NS_TEST_EXPECT_MSG_EQ (nat->GetNDynamicTuples (), 1, "state changed by a rejected restore");
+
+  // Same for the conntrack entries
+  Buffer conntrack;
+  uint32_t conntrackSize = m_netfilter->GetSerializedConntrackSize ();
+  conntrack.AddAtStart (conntrackSize);
+  m_netfilter->SerializeConntrack (conntrack.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (m_netfilter->DeserializeConntrack (conntrack.Begin (), conntrackSize - 1), 0,
+                         "truncated conntrack state accepted");
+  conntrack.Begin ().WriteHtonU32 (0xffffffff);
+  NS_TEST_EXPECT_MSG_EQ (m_netfilter->DeserializeConntrack (conntrack.Begin (), conntrackSize), 0,
+                         "oversized conntrack entry count accepted");
+  NS_TEST_EXPECT_MSG_EQ (m_netfilter->GetHash ().size (), savedConntrack, "conntrack changed by a rejected restore");
+  m_netfilter = 0;
+  Simulator::Destroy ();
+
+  // Warm-started run: the saved binding is present from the start, and
+  // a new flow continues from the saved port pool position
+  m_serverSources.clear ();
+  nat = RunScenario ("", stateFile, 2001);
+  NS_TEST_EXPECT_MSG_EQ (m_tuplesAtStart, 1, "binding not restored");
+  NS_TEST_EXPECT_MSG_EQ (m_conntrackAtStart, savedConntrack, "conntrack entries not restored");
+  NS_TEST_ASSERT_MSG_EQ (nat->GetNDynamicTuples (), 2, "new binding not created");
+  Ipv4DynamicNatTuple restored = nat->GetDynamicTuple (1);
+  NS_TEST_EXPECT_MSG_EQ (restored.GetLocalAddress (), saved.GetLocalAddress (), "local address");
+  NS_TEST_EXPECT_MSG_EQ (restored.GetGlobalAddress (), saved.GetGlobalAddress (), "global address");
+  NS_TEST_EXPECT_MSG_EQ (restored.GetTranslatedPort (), saved.GetTranslatedPort (), "translated port");
+  NS_TEST_EXPECT_MSG_EQ (restored.GetLocalPort (), saved.GetLocalPort (), "local port");
+  NS_TEST_EXPECT_MSG_EQ (restored.GetCreationTime (), saved.GetCreationTime (), "creation time");
+  NS_TEST_EXPECT_MSG_EQ (restored.GetOutboundPackets (), 1, "outbound packets");
+  NS_TEST_EXPECT_MSG_EQ (restored.GetOutboundBytes (), saved.GetOutboundBytes (), "outbound bytes");
+  NS_TEST_ASSERT_MSG_EQ (m_serverSources.size (), 1, "packet lost after restore");
+  NS_TEST_EXPECT_MSG_EQ (m_serverSources[0].GetIpv4 (), saved.GetGlobalAddress (), "global address of new flow");
+  NS_TEST_EXPECT_MSG_EQ (m_serverSources[0].GetPort (), saved.GetTranslatedPort () + 1, "port pool not restored");
+  Simulator::Destroy ();
+  Ipv4AddressGenerator::Reset ();
+}
+
+/**
+ * \brief Periodic export of the NAT table.
+ */
+class Ipv4NatExportTest : public TestCase
+{
+public:
+  Ipv4NatExportTest ();
+  virtual void DoRun (void);
+
+private:
+  void DoSendData (Ptr<Socket> socket);
+};
+
+Ipv4NatExportTest::Ipv4NatExportTest ()
+  : TestCase ("Periodic NAT table export")
+{
+}
+
+void
+Ipv4NatExportTest::DoSendData (Ptr<Socket> socket)
+{
+  Address realTo = InetSocketAddress (Ipv4Address ("203.0.113.2"), 1234);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, realTo),
+                         123, "send failed");
+}
+
+void
+Ipv4NatExportTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  Ptr<Node> host = nodes.Get (0);
+  Ptr<Node> natNode = nodes.Get (1);
+  Ptr<Node> server = nodes.Get (2);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ptr<SimpleChannel> inside = CreateObject<SimpleChannel> ();
+  Ptr<SimpleChannel> outside = CreateObject<SimpleChannel> ();
+  uint32_t hostIf = AddInterface (host, inside, "192.168.1.2");
+  uint32_t natIn = AddInterface (natNode, inside, "192.168.1.1");
+  uint32_t natOut = AddInterface (natNode, outside, "203.0.113.1");
+  AddInterface (server, outside, "203.0.113.2");
+
+  Ipv4StaticRoutingHelper routingHelper;
+  routingHelper.GetStaticRouting (host->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("192.168.1.1"), hostIf);
+
+  Ipv4NatHelper natHelper;
+  Ptr<Ipv4Nat> nat = natHelper.Install (natNode);
+  nat->SetInside (natIn);
+  nat->SetOutside (natOut);
+  nat->AddStaticRule (Ipv4StaticNatRule (Ipv4Address ("192.168.1.5"), Ipv4Address ("203.0.113.5")));
+  nat->AddAddressPool ("198.51.100.0", "0.0.0.10", "0.0.0.10", "255.255.255.0");
+  nat->AddPortPool (50000, 50010);
+  nat->AddDynamicRule (Ipv4DynamicNatRule (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0")));
+
+  std::ostringstream os;
+  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (&os);
+  Ipv4NatHelper::ExportTableEvery (Seconds (2), nat, stream);
+
+  Ptr<Socket> socket = host->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 2000)), 0, "trivial");
+  Simulator::ScheduleWithContext (host->GetId (), Seconds (1),
+                                  &Ipv4NatExportTest::DoSendData, this, socket);
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  Ipv4AddressGenerator::Reset ();
+
+  // The translation is created just after 1s, as the packet only waits
+  // for the inside link's transmission delay
+  Ipv4DynamicNatTuple tuple = nat->GetDynamicTuple (0);
+  std::ostringstream expected;
+  expected << "time_ns,type,local_ip,local_port,global_ip,global_port,age_ns,"
+           << "out_packets,out_bytes,in_packets,in_bytes\n";
+  int64_t created = tuple.GetCreationTime ().GetNanoSeconds ();
+  const char *times[] = { "2000000000", "4000000000" };
+  const int64_t nowNs[] = { 2000000000LL, 4000000000LL };
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      expected << times[k] << ",S,192.168.1.5,0,203.0.113.5,0,,0,0,0,0\n"
+               << times[k] << ",D,192.168.1.2,2000," << tuple.GetGlobalAddress ()
+               << ',' << tuple.GetTranslatedPort ()
+               << ',' << nowNs[k] - created
+               << ",1,151,0,0\n";
+    }
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (tuple.GetCreationTime (), Seconds (1), "creation time");
+  NS_TEST_EXPECT_MSG_EQ (os.str (), expected.str (), "unexpected table export");
+}
+
+/**
+ * \brief Per-translation and per-conntrack-entry traffic counters.
+ */
+class Ipv4NatCountersTest : public TestCase
+{
+public:
+  Ipv4NatCountersTest ();
+  virtual void DoRun (void);
+
+private:
+  void DoSendData (Ptr<Socket> socket);
+  void ServerReceive (Ptr<Socket> socket);
+};
+
+Ipv4NatCountersTest::Ipv4NatCountersTest ()
+  : TestCase ("Static and dynamic NAT and conntrack traffic counters")
+{
+}
+
+void
+Ipv4NatCountersTest::DoSendData (Ptr<Socket> socket)
+{
+  Address realTo = InetSocketAddress (Ipv4Address ("203.0.113.2"), 1234);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, realTo),
+                         123, "send failed");
+}
+
+void
+Ipv4NatCountersTest::ServerReceive (Ptr<Socket> socket)
+{
+  Address from;
+  Ptr<Packet> packet = socket->RecvFrom (std::numeric_limits<uint32_t>::max (), 0, from);
+  socket->SendTo (Create<Packet> (packet->GetSize () + 100), 0, from);
+}
+
+void
+Ipv4NatCountersTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  Ptr<Node> host = nodes.Get (0);
+  Ptr<Node> natNode = nodes.Get (1);
+  Ptr<Node> server = nodes.Get (2);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ptr<SimpleChannel> inside = CreateObject<SimpleChannel> ();
+  Ptr<SimpleChannel> outside = CreateObject<SimpleChannel> ();
+  uint32_t hostIf = AddInterface (host, inside, "192.168.1.2");
+  uint32_t natIn = AddInterface (natNode, inside, "192.168.1.1");
+  uint32_t natOut = AddInterface (natNode, outside, "203.0.113.1");
+  uint32_t serverIf = AddInterface (server, outside, "203.0.113.2");
+
+  Ipv4StaticRoutingHelper routingHelper;
+  routingHelper.GetStaticRouting (host->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("192.168.1.1"), hostIf);
+  routingHelper.GetStaticRouting (server->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("203.0.113.1"), serverIf);
+
+  Ipv4NatHelper natHelper;
+  Ptr<Ipv4Nat> nat = natHelper.Install (natNode);
+  nat->SetInside (natIn);
+  nat->SetOutside (natOut);
+  nat->AddAddressPool ("198.51.100.0", "0.0.0.10", "0.0.0.10", "255.255.255.0");
+  nat->AddPortPool (50000, 50010);
+  nat->AddDynamicRule (Ipv4DynamicNatRule (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0")));
+  nat->AddStaticRule (Ipv4StaticNatRule (Ipv4Address ("192.168.1.2"), 2002,
+                                         Ipv4Address ("198.51.100.20"), 6000, UdpL4Protocol::PROT_NUMBER));
+
+  Ptr<Socket> serverSocket = server->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (serverSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234)), 0, "trivial");
+  serverSocket->SetRecvCallback (MakeCallback (&Ipv4NatCountersTest::ServerReceive, this));
+
+  // Two flows from the same host, the first one sends twice
+  Ptr<Socket> socketA = host->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (socketA->Bind (InetSocketAddress (Ipv4Address::GetAny (), 2000)), 0, "trivial");
+  Ptr<Socket> socketB = host->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (socketB->Bind (InetSocketAddress (Ipv4Address::GetAny (), 2001)), 0, "trivial");
+  Simulator::ScheduleWithContext (host->GetId (), Seconds (1),
+                                  &Ipv4NatCountersTest::DoSendData, this, socketA);
+  Simulator::ScheduleWithContext (host->GetId (), Seconds (2),
+                                  &Ipv4NatCountersTest::DoSendData, this, socketB);
+  Simulator::ScheduleWithContext (host->GetId (), Seconds (3),
+                                  &Ipv4NatCountersTest::DoSendData, this, socketA);
+  // A third flow is mapped by the static rule
+  Ptr<Socket> socketC = host->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (socketC->Bind (InetSocketAddress (Ipv4Address::GetAny (), 2002)), 0, "trivial");
+  Simulator::ScheduleWithContext (host->GetId (), Seconds (4),
+                                  &Ipv4NatCountersTest::DoSendData, this, socketC);
+  Simulator::Run ();
+
+  // A request is 123 + 8 + 20 bytes long, a reply 100 bytes more
+  NS_TEST_ASSERT_MSG_EQ (nat->GetNDynamicTuples (), 2, "translations not created");
+  Ipv4DynamicNatTuple tupleB = nat->GetDynamicTuple (0);
+  Ipv4DynamicNatTuple tupleA = nat->GetDynamicTuple (1);
+  NS_TEST_EXPECT_MSG_EQ (tupleA.GetLocalPort (), 2000, "translation order");
+  NS_TEST_EXPECT_MSG_EQ (tupleA.GetOutboundPackets (), 2, "outbound packets");
+  NS_TEST_EXPECT_MSG_EQ (tupleA.GetOutboundBytes (), 2 * 151, "outbound bytes");
+  NS_TEST_EXPECT_MSG_EQ (tupleA.GetInboundPackets (), 2, "inbound packets");
+  NS_TEST_EXPECT_MSG_EQ (tupleA.GetInboundBytes (), 2 * 251, "inbound bytes");
+  NS_TEST_EXPECT_MSG_EQ (tupleB.GetOutboundPackets (), 1, "outbound packets");
+  NS_TEST_EXPECT_MSG_EQ (tupleB.GetInboundPackets (), 1, "inbound packets");
+  Ipv4StaticNatRule rule = nat->GetStaticRule (0);
+  NS_TEST_EXPECT_MSG_EQ (rule.GetOutboundPackets (), 1, "static rule outbound packets");
+  NS_TEST_EXPECT_MSG_EQ (rule.GetOutboundBytes (), 151, "static rule outbound bytes");
+  NS_TEST_EXPECT_MSG_EQ (rule.GetInboundPackets (), 1, "static rule inbound packets");
+  NS_TEST_EXPECT_MSG_EQ (rule.GetInboundBytes (), 251, "static rule inbound bytes");
+
+  Ipv4Nat::CountersByAddress byHost = nat->GetLocalAddressCounters ();
+  NS_TEST_ASSERT_MSG_EQ (byHost.size (), 1, "one inside host");
+  const Ipv4NatCounters &hostCounters = byHost[Ipv4Address ("192.168.1.2")];
+  NS_TEST_EXPECT_MSG_EQ (hostCounters.outboundPackets, 4, "aggregated outbound packets");
+  NS_TEST_EXPECT_MSG_EQ (hostCounters.outboundBytes, 4 * 151, "aggregated outbound bytes");
+  NS_TEST_EXPECT_MSG_EQ (hostCounters.inboundPackets, 4, "aggregated inbound packets");
+  NS_TEST_EXPECT_MSG_EQ (hostCounters.inboundBytes, 4 * 251, "aggregated inbound bytes");
+  Ipv4Nat::CountersByAddress byGlobal = nat->GetGlobalAddressCounters ();
+  NS_TEST_ASSERT_MSG_EQ (byGlobal.size (), 2, "one pool and one static global address");
+  NS_TEST_EXPECT_MSG_EQ (byGlobal[tupleA.GetGlobalAddress ()].outboundPackets, 3, "aggregated outbound packets");
+  NS_TEST_EXPECT_MSG_EQ (byGlobal[Ipv4Address ("198.51.100.20")].inboundPackets, 1, "static rule inbound packets");
+
+  // The conntrack entry of the first flow counts both of its requests
+  TupleHash &hash = natNode->GetObject<Ipv4> ()->GetNetfilter ()->GetHash ();
+  bool found = false;
+  for (TupleHash::const_iterator it = hash.begin (); it != hash.end (); it++)
+    {
+      if (it->first.GetSource () == Ipv4Address ("192.168.1.2")
+          && it->first.GetSourcePort () == 2000)
+        {
+          found = true;
+          NS_TEST_EXPECT_MSG_EQ (it->second.GetPackets (), 2, "conntrack packets");
+          NS_TEST_EXPECT_MSG_EQ (it->second.GetBytes (), 2 * 151, "conntrack bytes");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "conntrack entry of the first flow");
+
+  Simulator::Destroy ();
+  Ipv4AddressGenerator::Reset ();
+}
+
+/**
+ * \brief ICMP echo and ICMP error translation through dynamic NAT.
+ */
+class Ipv4NatIcmpTest : public TestCase
+{
+public:
+  Ipv4NatIcmpTest ();
+  virtual void DoRun (void);
+
+private:
+  void SendEcho (Ptr<Socket> socket);
+  void SendUdp (Ptr<Socket> socket);
+  void ReceiveEcho (Ptr<Socket> socket);
+  void ReceiveIcmpError (Ipv4Address icmpSource, uint8_t icmpTtl, uint8_t icmpType,
+                         uint8_t icmpCode, uint32_t icmpInfo);
+
+  uint32_t m_echoReplies;
+  uint16_t m_echoId;
+  uint32_t m_icmpErrors;
+  Ipv4Address m_icmpSource;
+  uint8_t m_icmpType;
+  uint8_t m_icmpCode;
+  uint32_t m_quotedDatagrams;
+  uint8_t m_quotedUdp[8];
+};
+
+Ipv4NatIcmpTest::Ipv4NatIcmpTest ()
+  : TestCase ("ICMP echo and error translation through dynamic NAT"),
+    m_echoReplies (0),
+    m_echoId (0),
+    m_icmpErrors (0),
+    m_icmpType (0),
+    m_icmpCode (0),
+    m_quotedDatagrams (0)
+{
+}
+
+void
+Ipv4NatIcmpTest::SendEcho (Ptr<Socket> socket)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  Icmpv4Echo echo;
+  echo.SetIdentifier (77);
+  echo.SetSequenceNumber (1);
+  p->AddHeader (echo);
+  Icmpv4Header header;
+  header.SetType (Icmpv4Header::ECHO);
+  header.SetCode (0);
+  p->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (p, 0, InetSocketAddress (Ipv4Address ("203.0.113.2"), 0)),
+                         8, "send failed");
+}
+
+void
+Ipv4NatIcmpTest::SendUdp (Ptr<Socket> socket)
+{
+  // nobody listens on this port: the server answers with port unreachable
+  Address realTo = InetSocketAddress (Ipv4Address ("203.0.113.2"), 9999);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, realTo),
+                         123, "send failed");
+}
+
+void
+Ipv4NatIcmpTest::ReceiveEcho (Ptr<Socket> socket)
+{
+  Ptr<Packet> p = socket->Recv (std::numeric_limits<uint32_t>::max (), 0);
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  Icmpv4Header icmpHeader;
+  p->RemoveHeader (icmpHeader);
+  if (icmpHeader.GetType () == Icmpv4Header::ECHO_REPLY)
+    {
+      Icmpv4Echo echo;
+      p->RemoveHeader (echo);
+      m_echoReplies++;
+      m_echoId = echo.GetIdentifier ();
+    }
+  else if (icmpHeader.GetType () == Icmpv4Header::DEST_UNREACH)
+    {
+      Icmpv4DestinationUnreachable unreach;
+      p->RemoveHeader (unreach);
+      m_quotedDatagrams++;
+      unreach.GetData (m_quotedUdp);
+    }
+}
+
+void
+Ipv4NatIcmpTest::ReceiveIcmpError (Ipv4Address icmpSource, uint8_t icmpTtl, uint8_t icmpType,
+                                   uint8_t icmpCode, uint32_t icmpInfo)
+{
+  m_icmpErrors++;
+  m_icmpSource = icmpSource;
+  m_icmpType = icmpType;
+  m_icmpCode = icmpCode;
+}
+
+void
+Ipv4NatIcmpTest::DoRun (void)
+{
+  // The quoted UDP checksum is only computed with checksums enabled
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (true));
+  NodeContainer nodes;
+  nodes.Create (3);
+  Ptr<Node> host = nodes.Get (0);
+  Ptr<Node> natNode = nodes.Get (1);
+  Ptr<Node> server = nodes.Get (2);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ptr<SimpleChannel> inside = CreateObject<SimpleChannel> ();
+  Ptr<SimpleChannel> outside = CreateObject<SimpleChannel> ();
+  uint32_t hostIf = AddInterface (host, inside, "192.168.1.2");
+  uint32_t natIn = AddInterface (natNode, inside, "192.168.1.1");
+  uint32_t natOut = AddInterface (natNode, outside, "203.0.113.1");
+  uint32_t serverIf = AddInterface (server, outside, "203.0.113.2");
+
+  Ipv4StaticRoutingHelper routingHelper;
+  routingHelper.GetStaticRouting (host->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("192.168.1.1"), hostIf);
+  routingHelper.GetStaticRouting (server->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("203.0.113.1"), serverIf);
+
+  Ipv4NatHelper natHelper;
+  Ptr<Ipv4Nat> nat = natHelper.Install (natNode);
+  nat->SetInside (natIn);
+  nat->SetOutside (natOut);
+  nat->AddAddressPool ("198.51.100.0", "0.0.0.10", "0.0.0.10", "255.255.255.0");
+  nat->AddPortPool (50000, 50010);
+  nat->AddDynamicRule (Ipv4DynamicNatRule (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0")));
+
+  Ptr<Socket> rawSocket = host->GetObject<Ipv4RawSocketFactory> ()->CreateSocket ();
+  rawSocket->SetAttribute ("Protocol", UintegerValue (1));
+  rawSocket->SetRecvCallback (MakeCallback (&Ipv4NatIcmpTest::ReceiveEcho, this));
+
+  Ptr<Socket> udpSocket = host->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (udpSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 2000)), 0, "trivial");
+  udpSocket->SetAttribute ("IcmpCallback", CallbackValue (MakeCallback (&Ipv4NatIcmpTest::ReceiveIcmpError, this)));
+
+  Simulator::ScheduleWithContext (host->GetId (), Seconds (1),
+                                  &Ipv4NatIcmpTest::SendEcho, this, rawSocket);
+  Simulator::ScheduleWithContext (host->GetId (), Seconds (2),
+                                  &Ipv4NatIcmpTest::SendUdp, this, udpSocket);
+  Simulator::Run ();
+
+  // The echo identifier is translated like a port, and back
+  NS_TEST_ASSERT_MSG_EQ (nat->GetNDynamicTuples (), 2, "translations not created");
+  Ipv4DynamicNatTuple echoTuple = nat->GetDynamicTuple (1);
+  NS_TEST_EXPECT_MSG_EQ (echoTuple.GetLocalPort (), 77, "echo identifier");
+  NS_TEST_EXPECT_MSG_EQ (echoTuple.GetTranslatedPort (), 50000, "translated echo identifier");
+  NS_TEST_EXPECT_MSG_EQ (echoTuple.GetOutboundPackets (), 1, "echo request not counted");
+  NS_TEST_EXPECT_MSG_EQ (echoTuple.GetInboundPackets (), 1, "echo reply not counted");
+  NS_TEST_EXPECT_MSG_EQ (m_echoReplies, 1, "echo reply not translated back");
+  NS_TEST_EXPECT_MSG_EQ (m_echoId, 77, "echo reply identifier");
+
+  // The port unreachable quotes the translated datagram, which is mapped
+  // back to the socket that sent it
+  NS_TEST_EXPECT_MSG_EQ (m_icmpErrors, 1, "ICMP error not delivered to the socket");
+  NS_TEST_EXPECT_MSG_EQ (m_icmpSource, Ipv4Address ("203.0.113.2"), "ICMP error source");
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) m_icmpType, (uint16_t) Icmpv4Header::DEST_UNREACH, "ICMP error type");
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) m_icmpCode, (uint16_t) Icmpv4DestinationUnreachable::PORT_UNREACHABLE, "ICMP error code");
+
+  // The error is counted on the translation of the datagram it reports:
+  // 20 bytes of IP header, 4 of ICMP header, then the 4 unused bytes and
+  // the quoted IP header and 8 bytes
+  Ipv4DynamicNatTuple udpTuple = nat->GetDynamicTuple (0);
+  NS_TEST_EXPECT_MSG_EQ (udpTuple.GetLocalPort (), 2000, "UDP translation");
+  NS_TEST_EXPECT_MSG_EQ (udpTuple.GetOutboundPackets (), 1, "datagram not counted");
+  NS_TEST_EXPECT_MSG_EQ (udpTuple.GetOutboundBytes (), 151, "datagram bytes");
+  NS_TEST_EXPECT_MSG_EQ (udpTuple.GetInboundPackets (), 1, "ICMP error not counted");
+  NS_TEST_EXPECT_MSG_EQ (udpTuple.GetInboundBytes (), 20 + 4 + 4 + 20 + 8, "ICMP error bytes");
+
+  // The quoted UDP header is the one the host sent, checksum included
+  UdpHeader udpHeader;
+  udpHeader.EnableChecksums ();
+  udpHeader.InitializeChecksum (Ipv4Address ("192.168.1.2"), Ipv4Address ("203.0.113.2"),
+                                UdpL4Protocol::PROT_NUMBER);
+  udpHeader.SetSourcePort (2000);
+  udpHeader.SetDestinationPort (9999);
+  Ptr<Packet> sent = Create<Packet> (123);
+  sent->AddHeader (udpHeader);
+  uint8_t expected[8];
+  sent->CopyData (expected, 8);
+  uint16_t expectedChecksum = (expected[6] << 8) | expected[7];
+  NS_TEST_ASSERT_MSG_EQ (m_quotedDatagrams, 1, "ICMP error not delivered to the raw socket");
+  uint16_t quotedPort = (m_quotedUdp[0] << 8) | m_quotedUdp[1];
+  uint16_t quotedChecksum = (m_quotedUdp[6] << 8) | m_quotedUdp[7];
+  NS_TEST_EXPECT_MSG_EQ (quotedPort, 2000, "quoted source port");
+  NS_TEST_EXPECT_MSG_NE (expectedChecksum, 0, "UDP checksum not computed");
+  NS_TEST_EXPECT_MSG_EQ (quotedChecksum, expectedChecksum, "quoted UDP checksum not translated");
+
+  Simulator::Destroy ();
+  Ipv4AddressGenerator::Reset ();
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (false));
+}
+
+
+class Ipv4NatTestSuite : public TestSuite
+{
+public:
+  Ipv4NatTestSuite () : TestSuite ("ipv4-nat", UNIT)
+  {
+    AddTestCase (new Ipv4NatMultiInterfaceTest, TestCase::QUICK);
+    AddTestCase (new Ipv4NatStateTest, TestCase::QUICK);
+    AddTestCase (new Ipv4NatExportTest, TestCase::QUICK);
+    AddTestCase (new Ipv4NatCountersTest, TestCase::QUICK);
+    AddTestCase (new Ipv4NatIcmpTest, TestCase::QUICK);
+  }
+} g_ipv4NatTestSuite;
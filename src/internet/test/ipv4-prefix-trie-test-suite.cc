@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/ipv4-prefix-trie.h"
+
+using namespace ns3;
+
+/**
+ * Check a few lookups whose result is known.
+ */
+class Ipv4PrefixTrieSimpleTestCase : public TestCase
+{
+public:
+  Ipv4PrefixTrieSimpleTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4PrefixTrieSimpleTestCase::Ipv4PrefixTrieSimpleTestCase ()
+  : TestCase ("Check the lookup of nested and disjoint prefixes")
+{
+}
+
+void
+Ipv4PrefixTrieSimpleTestCase::DoRun (void)
+{
+  Ipv4PrefixTrie trie;
+  trie.Insert (Ipv4Address ("10.1.0.0"), Ipv4Mask ("255.255.0.0"), 0);
+  trie.Insert (Ipv4Address ("10.1.2.0"), Ipv4Mask ("255.255.255.0"), 1);
+  trie.Insert (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), 2);
+  trie.Insert (Ipv4Address ("10.1.2.3"), Ipv4Mask ("255.255.255.255"), 3);
+  trie.Insert (Ipv4Address ("10.0.0.0"), Ipv4Mask ("255.0.0.0"), 4);
+  trie.Insert (Ipv4Address ("10.1.2.0"), Ipv4Mask ("255.255.255.0"), 5);
+  trie.Insert (Ipv4Address ("192.168.0.0"), Ipv4Mask ("255.255.0.0"), 6);
+
+  std::vector<uint32_t> values;
+  trie.Lookup (Ipv4Address ("10.1.2.3"), values);
+  NS_TEST_ASSERT_MSG_EQ (values.size (), 6, "Wrong number of prefixes");
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (values[i], i, "Values not in increasing order");
+    }
+
+  values.clear ();
+  trie.Lookup (Ipv4Address ("10.1.3.1"), values);
+  NS_TEST_ASSERT_MSG_EQ (values.size (), 3, "Wrong number of prefixes");
+  NS_TEST_EXPECT_MSG_EQ (values[0], 0, "Wrong prefix");
+  NS_TEST_EXPECT_MSG_EQ (values[1], 2, "Wrong prefix");
+  NS_TEST_EXPECT_MSG_EQ (values[2], 4, "Wrong prefix");
+
+  values.clear ();
+  trie.Lookup (Ipv4Address ("11.0.0.1"), values);
+  NS_TEST_ASSERT_MSG_EQ (values.size (), 1, "Wrong number of prefixes");
+  NS_TEST_EXPECT_MSG_EQ (values[0], 2, "Only the default route matches");
+
+  trie.Clear ();
+  values.clear ();
+  trie.Lookup (Ipv4Address ("10.1.2.3"), values);
+  NS_TEST_EXPECT_MSG_EQ (values.size (), 0, "The trie was not cleared");
+}
+
+/**
+ * Check the lookups of many random prefixes against a scan of all of
+ * them, including non-contiguous masks.
+ */
+class Ipv4PrefixTrieRandomTestCase : public TestCase
+{
+public:
+  Ipv4PrefixTrieRandomTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \returns the next pseudo-random number.
+   */
+  uint32_t Next (void);
+  uint32_t m_state; //!< State of the pseudo-random numbers.
+};
+
+Ipv4PrefixTrieRandomTestCase::Ipv4PrefixTrieRandomTestCase ()
+  : TestCase ("Check the lookups against a scan of all the prefixes"),
+    m_state (1)
+{
+}
+
+uint32_t
+Ipv4PrefixTrieRandomTestCase::Next (void)
+{
+  m_state = m_state * 1103515245 + 12345;
+  return m_state;
+}
+
+void
+Ipv4PrefixTrieRandomTestCase::DoRun (void)
+{
+  std::vector<Ipv4Address> networks;
+  std::vector<Ipv4Mask> masks;
+  Ipv4PrefixTrie trie;
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      // few distinct high bits, so that many prefixes are nested.
+      uint32_t length = Next () % 33;
+      uint32_t mask = length == 0 ? 0 : 0xffffffff << (32 - length);
+      if (i % 500 == 0)
+        {
+          mask = 0xff00ff00;
+        }
+      uint32_t address = (Next () & 0x0f0f00ff) | 0x0a000000;
+      networks.push_back (Ipv4Address (address & mask));
+      masks.push_back (Ipv4Mask (mask));
+      trie.Insert (networks.back (), masks.back (), i);
+    }
+
+  for (uint32_t j = 0; j < 2000; j++)
+    {
+      Ipv4Address destination ((Next () & 0x0f0f00ff) | 0x0a000000);
+      std::vector<uint32_t> expected;
+      for (uint32_t i = 0; i < networks.size (); i++)
+        {
+          if (masks[i].IsMatch (destination, networks[i]))
+            {
+              expected.push_back (i);
+            }
+        }
+      std::vector<uint32_t> values;
+      trie.Lookup (destination, values);
+      std::vector<uint32_t> found;
+      for (uint32_t i = 0; i < values.size (); i++)
+        {
+          if (masks[values[i]].IsMatch (destination, networks[values[i]]))
+            {
+              found.push_back (values[i]);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Wrong prefixes for " << destination);
+    }
+}
+
+class Ipv4PrefixTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4PrefixTrieTestSuite ()
+    : TestSuite ("ipv4-prefix-trie", UNIT)
+  {
+    AddTestCase (new Ipv4PrefixTrieSimpleTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4PrefixTrieRandomTestCase, TestCase::QUICK);
+  }
+} g_ipv4PrefixTrieTestSuite;
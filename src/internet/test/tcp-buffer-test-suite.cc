@@ -0,0 +1,231 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-rx-buffer.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * \returns the byte of a stream at a sequence number.
+ * \param seq the sequence number
+ */
+uint8_t
+GetByte (uint32_t seq)
+{
+  return (seq * 7) ^ (seq >> 8);
+}
+
+/**
+ * \returns a packet holding the bytes of a stream.
+ * \param seq the sequence number of the first byte
+ * \param size the number of bytes
+ */
+Ptr<Packet>
+CreateData (uint32_t seq, uint32_t size)
+{
+  std::vector<uint8_t> data (size + 1);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      data[i] = GetByte (seq + i);
+    }
+  return Create<Packet> (&data[0], size);
+}
+
+/**
+ * \returns true if a packet holds the bytes of the stream.
+ * \param p the packet
+ * \param seq the sequence number of its first byte
+ */
+bool
+CheckData (Ptr<const Packet> p, uint32_t seq)
+{
+  std::vector<uint8_t> data (p->GetSize () + 1);
+  p->CopyData (&data[0], p->GetSize ());
+  for (uint32_t i = 0; i < p->GetSize (); i++)
+    {
+      if (data[i] != GetByte (seq + i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // unnamed namespace
+
+/**
+ * Check the segments copied from the send buffer.
+ */
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("Check the segments copied from the send buffer")
+{
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  // the sequence numbers wrap around in the buffer.
+  uint32_t isn = 0xfffff000;
+  Ptr<TcpTxBuffer> buffer = CreateObject<TcpTxBuffer> (1);
+  buffer->SetMaxBufferSize (100000);
+  uint32_t size = 0;
+  for (uint32_t i = 1; i < 200; i++)
+    {
+      uint32_t pktSize = (i * 37) % 500;
+      NS_TEST_ASSERT_MSG_EQ (buffer->Add (CreateData (isn + size, pktSize)), true, "The buffer is not full");
+      size += pktSize;
+    }
+  // the data given before the connection is established follows the head.
+  buffer->SetHeadSequence (SequenceNumber32 (isn));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), size, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (buffer->TailSequence (), SequenceNumber32 (isn + size), "Wrong tail");
+
+  // segments in sequence, and retransmissions.
+  for (uint32_t offset = 0; offset < size; offset += 536)
+    {
+      Ptr<Packet> p = buffer->CopyFromSequence (536, SequenceNumber32 (isn + offset));
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (536u, size - offset), "Wrong segment size");
+      NS_TEST_ASSERT_MSG_EQ (CheckData (p, isn + offset), true, "Wrong data at offset " << offset);
+    }
+  for (uint32_t offset = size - 1; offset > 0; offset -= std::min (offset, 997u))
+    {
+      Ptr<Packet> p = buffer->CopyFromSequence (1460, SequenceNumber32 (isn + offset));
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (1460u, size - offset), "Wrong segment size");
+      NS_TEST_ASSERT_MSG_EQ (CheckData (p, isn + offset), true, "Wrong data at offset " << offset);
+    }
+
+  // acknowledgements inside a packet and at its end.
+  buffer->DiscardUpTo (SequenceNumber32 (isn + 1000));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), size - 1000, "Wrong size");
+  Ptr<Packet> p = buffer->CopyFromSequence (100, SequenceNumber32 (isn + 1000));
+  NS_TEST_ASSERT_MSG_EQ (CheckData (p, isn + 1000), true, "Wrong data after an acknowledgement");
+  buffer->DiscardUpTo (SequenceNumber32 (isn + 37 + 74 + 111 + 148 + 185 + 222 + 259));
+  p = buffer->CopyFromSequence (3000, SequenceNumber32 (isn + 5000));
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 3000, "Wrong segment size");
+  NS_TEST_ASSERT_MSG_EQ (CheckData (p, isn + 5000), true, "Wrong data after an acknowledgement");
+
+  // the acknowledgement of a FIN.
+  buffer->DiscardUpTo (SequenceNumber32 (isn + size + 1));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 0, "The buffer is not empty");
+  NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), SequenceNumber32 (isn + size + 1), "Wrong head");
+}
+
+/**
+ * Check the reordering of the segments in the receive buffer.
+ */
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  TcpRxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Add a segment of the stream to the buffer.
+   * \param buffer the buffer
+   * \param seq the sequence number of the segment
+   * \param size the size of the segment
+   * \returns the result of TcpRxBuffer::Add
+   */
+  static bool Add (Ptr<TcpRxBuffer> buffer, uint32_t seq, uint32_t size);
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase ()
+  : TestCase ("Check the reordering of the segments in the receive buffer")
+{
+}
+
+bool
+TcpRxBufferTestCase::Add (Ptr<TcpRxBuffer> buffer, uint32_t seq, uint32_t size)
+{
+  TcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (seq));
+  return buffer->Add (CreateData (seq, size), header);
+}
+
+void
+TcpRxBufferTestCase::DoRun (void)
+{
+  uint32_t isn = 0xfffff000;
+  Ptr<TcpRxBuffer> buffer = CreateObject<TcpRxBuffer> (isn);
+  buffer->SetMaxBufferSize (10000);
+
+  // blocks out of sequence, overlapping each other.
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 1000, 500), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 3000, 500), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 1200, 100), false, "Duplicate block stored");
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 1400, 1000), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 2800, 1000), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 2600, 100), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 2500, 1500), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (buffer->Size (), 2900, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ (buffer->Available (), 0, "Data available before the first byte");
+  NS_TEST_EXPECT_MSG_EQ (buffer->MaxRxSequence (), SequenceNumber32 (isn + 11000), "Wrong window");
+
+  // the first hole is filled.
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn, 1100), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (buffer->NextRxSequence (), SequenceNumber32 (isn + 2400), "Wrong next sequence");
+  NS_TEST_EXPECT_MSG_EQ (buffer->Available (), 2400, "Wrong available data");
+  Ptr<Packet> p = buffer->Extract (700);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 700, "Wrong extracted size");
+  NS_TEST_EXPECT_MSG_EQ (CheckData (p, isn), true, "Wrong extracted data");
+  NS_TEST_EXPECT_MSG_EQ (buffer->MaxRxSequence (), SequenceNumber32 (isn + 10700), "Wrong window");
+
+  // the second hole is filled, along with data already received.
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 2000, 600), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (buffer->NextRxSequence (), SequenceNumber32 (isn + 4000), "Wrong next sequence");
+  NS_TEST_EXPECT_MSG_EQ (buffer->Size (), 3300, "Wrong size");
+  p = buffer->Extract (5000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 3300, "Wrong extracted size");
+  NS_TEST_EXPECT_MSG_EQ (CheckData (p, isn + 700), true, "Wrong extracted data");
+  NS_TEST_EXPECT_MSG_EQ (buffer->Extract (1000), 0, "Data extracted from an empty buffer");
+
+  // the FIN is accounted for once the data before it is received.
+  buffer->SetFinSequence (SequenceNumber32 (isn + 5000));
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 4500, 500), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (buffer->Finished (), false, "Finished before the last byte");
+  NS_TEST_EXPECT_MSG_EQ (Add (buffer, isn + 4000, 500), true, "Block not stored");
+  NS_TEST_EXPECT_MSG_EQ (buffer->Finished (), true, "Not finished after the last byte");
+  p = buffer->Extract (5000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1000, "Wrong extracted size");
+  NS_TEST_EXPECT_MSG_EQ (CheckData (p, isn + 4000), true, "Wrong extracted data");
+}
+
+class TcpBufferTestSuite : public TestSuite
+{
+public:
+  TcpBufferTestSuite ()
+    : TestSuite ("tcp-buffer", UNIT)
+  {
+    AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+    AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+  }
+} g_tcpBufferTestSuite;
@@ -0,0 +1,345 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "simulator-partition-helper.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SimulatorPartitionHelper");
+
+namespace {
+
+/** A channel, as seen by the partitioning. */
+struct PartitionEdge
+{
+  std::vector<uint32_t> nodes; //!< Indexes of the attached nodes
+  uint64_t delay;              //!< Delay, in time steps
+  bool cuttable;               //!< Whether the channel may connect two partitions
+};
+
+/**
+ * The channels which hand the packets sent to another partition a deep
+ * copy (see Packet::DeepCopy), and refer to the receiving device and
+ * node without touching their reference counts.  Other channels, such
+ * as the CsmaChannel whose carrier-sense state is read and written by
+ * all its devices, are never cut.
+ */
+const char * const g_cuttableChannels[] = {
+  "ns3::SimpleChannel",
+  "ns3::PointToPointChannel"
+};
+
+/**
+ * \param [in] channel A channel.
+ * \return \c true if \p channel may connect two partitions.
+ */
+bool
+IsCuttable (Ptr<Channel> channel)
+{
+  TypeId tid = channel->GetInstanceTypeId ();
+  for (uint32_t i = 0; i < sizeof (g_cuttableChannels) / sizeof (g_cuttableChannels[0]); i++)
+    {
+      TypeId cuttable;
+      if (TypeId::LookupByNameFailSafe (g_cuttableChannels[i], &cuttable)
+          && (tid == cuttable || tid.IsChildOf (cuttable)))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/**
+ * \param [in,out] parent The union-find forest.
+ * \param [in] i An element.
+ * \return The representative of the set of \p i.
+ */
+uint32_t
+FindRoot (std::vector<uint32_t> &parent, uint32_t i)
+{
+  while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+  return i;
+}
+
+/** Order the groups of nodes, largest first, then by first node. */
+struct GroupLess
+{
+  /**
+   * \param [in] a A (weight, first node) pair.
+   * \param [in] b A (weight, first node) pair.
+   * \return \c true if \p a must be assigned first.
+   */
+  bool operator () (const std::pair<uint32_t, uint32_t> &a,
+                    const std::pair<uint32_t, uint32_t> &b) const
+  {
+    if (a.first != b.first)
+      {
+        return a.first > b.first;
+      }
+    return a.second < b.second;
+  }
+};
+
+/**
+ * Group the nodes connected by the channels faster than \p threshold
+ * and assign the groups to the partitions.
+ *
+ * \param [in] nodes The number of nodes.
+ * \param [in] edges The channels.
+ * \param [in] threshold The delay below which channels are not cut.
+ * \param [in] partitions The number of partitions.
+ * \param [out] partitionOf The partition of each node.
+ * \return The weight of the heaviest partition.
+ */
+uint32_t
+Assign (uint32_t nodes, const std::vector<PartitionEdge> &edges, uint64_t threshold,
+        uint32_t partitions, std::vector<uint32_t> &partitionOf)
+{
+  std::vector<uint32_t> parent (nodes);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      parent[i] = i;
+    }
+  for (std::vector<PartitionEdge>::const_iterator e = edges.begin (); e != edges.end (); ++e)
+    {
+      if (e->cuttable && e->delay >= threshold)
+        {
+          continue;
+        }
+      for (uint32_t j = 1; j < e->nodes.size (); j++)
+        {
+          uint32_t a = FindRoot (parent, e->nodes[0]);
+          uint32_t b = FindRoot (parent, e->nodes[j]);
+          parent[std::max (a, b)] = std::min (a, b);
+        }
+    }
+
+  // Roots are the smallest index of their group.
+  std::vector<uint32_t> weight (nodes, 0);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      weight[FindRoot (parent, i)]++;
+    }
+  std::vector<std::pair<uint32_t, uint32_t> > groups;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      if (weight[i] != 0)
+        {
+          groups.push_back (std::make_pair (weight[i], i));
+        }
+    }
+  std::sort (groups.begin (), groups.end (), GroupLess ());
+
+  std::vector<uint32_t> load (partitions, 0);
+  std::vector<uint32_t> groupPartition (nodes, 0);
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator g = groups.begin ();
+       g != groups.end (); ++g)
+    {
+      uint32_t lightest = std::min_element (load.begin (), load.end ()) - load.begin ();
+      load[lightest] += g->first;
+      groupPartition[g->second] = lightest;
+    }
+  partitionOf.resize (nodes);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      partitionOf[i] = groupPartition[FindRoot (parent, i)];
+    }
+  return *std::max_element (load.begin (), load.end ());
+}
+
+} // unnamed namespace
+
+SimulatorPartitionHelper::SimulatorPartitionHelper ()
+  : m_partitions (1),
+    m_imbalance (0.1)
+{
+}
+
+void
+SimulatorPartitionHelper::SetPartitionCount (uint32_t partitions)
+{
+  NS_ASSERT_MSG (partitions > 0, "At least one partition is needed");
+  m_partitions = partitions;
+}
+
+void
+SimulatorPartitionHelper::SetImbalance (double imbalance)
+{
+  NS_ASSERT (imbalance >= 0);
+  m_imbalance = imbalance;
+}
+
+void
+SimulatorPartitionHelper::Compute (NodeContainer c)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nodes = c.GetN ();
+  std::map<uint32_t, uint32_t> index;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      index[c.Get (i)->GetId ()] = i;
+    }
+
+  std::vector<PartitionEdge> edges;
+  std::set<Ptr<Channel> > seen;
+  std::set<uint64_t> delays;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      Ptr<Node> node = c.Get (i);
+      for (uint32_t d = 0; d < node->GetNDevices (); d++)
+        {
+          Ptr<Channel> channel = node->GetDevice (d)->GetChannel ();
+          if (channel == 0 || !seen.insert (channel).second)
+            {
+              continue;
+            }
+          PartitionEdge edge;
+          for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+            {
+              Ptr<NetDevice> device = channel->GetDevice (j);
+              std::map<uint32_t, uint32_t>::const_iterator k = index.find (device->GetNode ()->GetId ());
+              if (k != index.end ())
+                {
+                  edge.nodes.push_back (k->second);
+                }
+            }
+          TimeValue delay;
+          edge.cuttable = IsCuttable (channel)
+            && channel->GetAttributeFailSafe ("Delay", delay)
+            && delay.Get ().IsStrictlyPositive ();
+          edge.delay = edge.cuttable ? delay.Get ().GetTimeStep () : 0;
+          if (edge.cuttable)
+            {
+              delays.insert (edge.delay);
+            }
+          edges.push_back (edge);
+        }
+    }
+
+  // Try the largest thresholds first: they give the largest windows.
+  std::vector<uint32_t> partitionOf;
+  uint32_t limit = (uint32_t) std::ceil (std::ceil ((double) nodes / m_partitions) * (1 + m_imbalance));
+  bool found = false;
+  for (std::set<uint64_t>::const_reverse_iterator t = delays.rbegin (); t != delays.rend (); ++t)
+    {
+      if (Assign (nodes, edges, *t, m_partitions, partitionOf) <= limit)
+        {
+          NS_LOG_LOGIC ("cutting channels slower than " << TimeStep (*t));
+          found = true;
+          break;
+        }
+    }
+  if (!found)
+    {
+      // Cut as much as possible, even if unbalanced.
+      uint64_t threshold = delays.empty () ? 0xffffffffffffffffULL : *delays.begin ();
+      Assign (nodes, edges, threshold, m_partitions, partitionOf);
+    }
+
+  m_partition.clear ();
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      m_partition[c.Get (i)->GetId ()] = partitionOf[i];
+    }
+  m_lookAhead = Seconds (0);
+  for (std::vector<PartitionEdge>::const_iterator e = edges.begin (); e != edges.end (); ++e)
+    {
+      for (uint32_t j = 1; j < e->nodes.size (); j++)
+        {
+          if (partitionOf[e->nodes[j]] != partitionOf[e->nodes[0]])
+            {
+              NS_ASSERT (e->cuttable);
+              Time delay = TimeStep (e->delay);
+              if (m_lookAhead.IsZero () || delay < m_lookAhead)
+                {
+                  m_lookAhead = delay;
+                }
+              break;
+            }
+        }
+    }
+  NS_LOG_LOGIC ("look-ahead " << m_lookAhead);
+}
+
+void
+SimulatorPartitionHelper::Install (NodeContainer c)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<MultithreadedSimulatorImpl> impl =
+    DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl == 0)
+    {
+      NS_FATAL_ERROR ("SimulatorPartitionHelper::Install(): "
+                      "SimulatorImplementationType must be ns3::MultithreadedSimulatorImpl");
+    }
+  Compute (c);
+  for (std::map<uint32_t, uint32_t>::const_iterator i = m_partition.begin ();
+       i != m_partition.end (); ++i)
+    {
+      impl->SetPartition (i->first, i->second);
+    }
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      (*i)->SetAttribute ("SystemId", UintegerValue (m_partition[(*i)->GetId ()]));
+    }
+  if (m_lookAhead.IsZero ())
+    {
+      // No channel connects two partitions: they never exchange events.
+      impl->SetLookAhead (Simulator::GetMaximumSimulationTime ());
+    }
+  else
+    {
+      impl->SetLookAhead (m_lookAhead);
+    }
+}
+
+void
+SimulatorPartitionHelper::Install (void)
+{
+  Install (NodeContainer::GetGlobal ());
+}
+
+uint32_t
+SimulatorPartitionHelper::GetPartition (Ptr<Node> node) const
+{
+  std::map<uint32_t, uint32_t>::const_iterator i = m_partition.find (node->GetId ());
+  NS_ASSERT_MSG (i != m_partition.end (), "Node " << node->GetId () << " was not partitioned");
+  return i->second;
+}
+
+Time
+SimulatorPartitionHelper::GetLookAhead (void) const
+{
+  return m_lookAhead;
+}
+
+} // namespace ns3
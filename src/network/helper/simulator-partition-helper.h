@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SIMULATOR_PARTITION_HELPER_H
+#define SIMULATOR_PARTITION_HELPER_H
+
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+
+#include <map>
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Split the nodes of a topology between the partitions of
+ * ns3::MultithreadedSimulatorImpl.
+ *
+ * The nodes are grouped by the channels which connect them, using the
+ * "Delay" attribute of the channels: the helper looks for the largest
+ * delay threshold such that gluing together the nodes connected by the
+ * channels faster than the threshold still leaves groups small enough
+ * to balance the partitions.  The groups are then assigned to the
+ * partitions, largest first, and the look-ahead is the smallest delay
+ * of the channels which end up connecting two partitions.  Only the
+ * ns3::SimpleChannel and ns3::PointToPointChannel channels with a
+ * positive "Delay" are cut: they give the packets they pass to another
+ * partition a deep copy (Packet::DeepCopy), since the data shared by
+ * the copies of a packet is counted without synchronization.
+ *
+ * Install() also stores the partition of each node in its "SystemId"
+ * attribute, which those channels compare to the one of the sender.
+ * The attribute is otherwise used by the MPI distributed simulator, so
+ * the two must not be combined.
+ */
+class SimulatorPartitionHelper
+{
+public:
+  SimulatorPartitionHelper ();
+
+  /**
+   * \param [in] partitions The number of partitions, hence of threads,
+   *             to use.
+   */
+  void SetPartitionCount (uint32_t partitions);
+  /**
+   * \param [in] imbalance How much larger than the average, as a
+   *             fraction, a partition may grow.
+   */
+  void SetImbalance (double imbalance);
+
+  /**
+   * Compute the partition of each node.
+   *
+   * \param [in] c The nodes to split.
+   */
+  void Compute (NodeContainer c);
+  /**
+   * Compute the partition of each node and configure the simulator
+   * with it.  The simulator must be ns3::MultithreadedSimulatorImpl
+   * and must not have run yet.  The "SystemId" attribute of the
+   * nodes is set to their partition.
+   *
+   * \param [in] c The nodes to split.
+   */
+  void Install (NodeContainer c);
+  /**
+   * Compute the partition of all the nodes and configure the simulator
+   * with it.
+   */
+  void Install (void);
+
+  /**
+   * \param [in] node A node passed to Compute() or Install().
+   * \return The partition of the node.
+   */
+  uint32_t GetPartition (Ptr<Node> node) const;
+  /**
+   * \return The smallest delay of the channels between two partitions,
+   *         zero if no channel could be cut.
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  uint32_t m_partitions;                    //!< Number of partitions to fill
+  double m_imbalance;                       //!< Tolerated partition overweight
+  std::map<uint32_t, uint32_t> m_partition; //!< Partition of each node id
+  Time m_lookAhead;                         //!< Result of the last Compute
+};
+
+} // namespace ns3
+
+#endif /* SIMULATOR_PARTITION_HELPER_H */
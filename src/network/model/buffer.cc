@@ -18,8 +18,19 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "buffer.h"
+#include "packet-allocator.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/memory-accounting.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined (__AVX2__)
+#include <immintrin.h>
+#endif
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -49,100 +60,11 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
+/** MemoryAccounting of the live buffer data. */
+static MemoryAccounting::Counter g_bufferMemory ("ns3::Buffer::Data");
 
-uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
+__thread uint32_t Buffer::g_recommendedStart = 0;
 
-void
-Buffer::Recycle (struct Buffer::Data *data)
-{
-  NS_LOG_FUNCTION (data);
-  NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
-}
-
-Buffer::Data *
-Buffer::Create (uint32_t dataSize)
-{
-  NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
-}
-#else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
@@ -157,7 +79,6 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
-#endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
@@ -169,9 +90,16 @@ Buffer::Allocate (uint32_t reqSize)
     }
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
+#ifdef BUFFER_FREE_LIST
+  // the whole block of the size class is usable.
+  size = PacketAllocator::GetBlockSize (size);
+  uint8_t *b = static_cast<uint8_t *> (PacketAllocator::Allocate (size));
+#else
   uint8_t *b = new uint8_t [size];
+#endif
+  g_bufferMemory.Add (1, size);
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
-  data->m_size = reqSize;
+  data->m_size = size + 1 - sizeof (struct Buffer::Data);
   data->m_count = 1;
   return data;
 }
@@ -181,8 +109,14 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
+  uint32_t size = data->m_size - 1 + sizeof (struct Buffer::Data);
+  g_bufferMemory.Add (-1, -(int64_t)size);
+#ifdef BUFFER_FREE_LIST
+  PacketAllocator::Deallocate (data, size);
+#else
   uint8_t *buf = reinterpret_cast<uint8_t *> (data);
   delete [] buf;
+#endif
 }
 
 Buffer::Buffer ()
@@ -244,7 +178,10 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
+  /* reserve the headroom the headers of earlier buffers needed: the
+   * rounding to the size class leaves the slack for the trailers.
+   */
+  m_data = Buffer::Create (g_recommendedStart);
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -427,12 +364,30 @@ Buffer::AddAtEnd (const Buffer &o)
     }
 
   Buffer dst = CreateFullCopy ();
-  Buffer src = o.CreateFullCopy ();
+  if (o.m_data == dst.m_data)
+    {
+      // the iterators of o would see the bytes written below.
+      Buffer src = o.CreateFullCopy ();
+      dst.AddAtEnd (src.GetSize ());
+      Buffer::Iterator destStart = dst.End ();
+      destStart.Prev (src.GetSize ());
+      destStart.Write (src.Begin (), src.End ());
+      *this = dst;
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
 
-  dst.AddAtEnd (src.GetSize ());
+  /* Write o, zero area included, directly rather than through a full
+   * copy of o, so that each of its bytes is copied once.  Only the first buffer of a
+   * chain of concatenations (e.g. a reassembled packet) is fully copied,
+   * and the following ones are appended in place while the data block
+   * has room.
+   */
+  uint32_t size = o.GetSize ();
+  dst.AddAtEnd (size);
   Buffer::Iterator destStart = dst.End ();
-  destStart.Prev (src.GetSize ());
-  destStart.Write (src.Begin (), src.End ());
+  destStart.Prev (size);
+  destStart.Write (o.Begin (), o.End ());
   *this = dst;
   NS_ASSERT (CheckInternalState ());
 }
@@ -555,6 +510,24 @@ Buffer::CreateFullCopy (void) const
   return *this;
 }
 
+Buffer
+Buffer::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (CheckInternalState ());
+  Buffer tmp (m_zeroAreaEnd - m_zeroAreaStart);
+  uint32_t dataStart = m_zeroAreaStart - m_start;
+  tmp.AddAtStart (dataStart);
+  tmp.Begin ().Write (m_data->m_data + m_start, dataStart);
+  uint32_t dataEnd = m_end - m_zeroAreaEnd;
+  tmp.AddAtEnd (dataEnd);
+  Buffer::Iterator i = tmp.End ();
+  i.Prev (dataEnd);
+  i.Write (m_data->m_data + m_zeroAreaStart, dataEnd);
+  NS_ASSERT (tmp.CheckInternalState ());
+  return tmp;
+}
+
 uint32_t 
 Buffer::GetSerializedSize (void) const
 {
@@ -1123,9 +1096,28 @@ void
 Buffer::Iterator::Read (uint8_t *buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
-  for (uint32_t i = 0; i < size; i++)
+  NS_ASSERT_MSG (m_current >= m_dataStart &&
+                 m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
+  uint32_t end = m_current + size;
+  if (m_current < m_zeroStart)
+    {
+      uint32_t n = std::min (end, m_zeroStart) - m_current;
+      memcpy (buffer, &m_data[m_current], n);
+      buffer += n;
+      m_current += n;
+    }
+  if (m_current < end && m_current < m_zeroEnd)
+    {
+      uint32_t n = std::min (end, m_zeroEnd) - m_current;
+      memset (buffer, 0, n);
+      buffer += n;
+      m_current += n;
+    }
+  if (m_current < end)
     {
-      buffer[i] = ReadU8 ();
+      memcpy (buffer, &m_data[m_current - (m_zeroEnd - m_zeroStart)], end - m_current);
+      m_current = end;
     }
 }
 
@@ -1136,22 +1128,145 @@ Buffer::Iterator::CalculateIpChecksum (uint16_t size)
   return CalculateIpChecksum (size, 0);
 }
 
+/**
+ * Fold a one's complement sum to 16 bits.
+ * \param [in] sum The sum.
+ * \returns The folded sum.
+ */
+static uint16_t
+ChecksumFold (uint64_t sum)
+{
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return sum;
+}
+
+/**
+ * Compute the one's complement sum of contiguous bytes.
+ *
+ * The words are taken in little endian order, as ReadU16 reads them,
+ * and the sum is computed with 32-bit words in a 64-bit accumulator:
+ * since 2^16 = 1 in one's complement arithmetic, folding it gives the
+ * same result as summing 16-bit words.
+ *
+ * \param [in] data The bytes.
+ * \param [in] size The number of bytes.
+ * \returns The folded sum.
+ */
+static uint16_t
+ChecksumSpan (uint8_t const *data, uint32_t size)
+{
+  uint64_t sum = 0;
+#if defined (__AVX2__)
+  if (size >= 32)
+    {
+      __m256i zero = _mm256_setzero_si256 ();
+      __m256i acc = zero;
+      while (size >= 32)
+        {
+          __m256i v = _mm256_loadu_si256 (reinterpret_cast<__m256i const *> (data));
+          acc = _mm256_add_epi64 (acc, _mm256_unpacklo_epi32 (v, zero));
+          acc = _mm256_add_epi64 (acc, _mm256_unpackhi_epi32 (v, zero));
+          data += 32;
+          size -= 32;
+        }
+      uint64_t lanes[4];
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (lanes), acc);
+      sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+#if defined (__SSE2__)
+  if (size >= 16)
+    {
+      __m128i zero = _mm_setzero_si128 ();
+      __m128i acc = zero;
+      while (size >= 16)
+        {
+          __m128i v = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (data));
+          acc = _mm_add_epi64 (acc, _mm_unpacklo_epi32 (v, zero));
+          acc = _mm_add_epi64 (acc, _mm_unpackhi_epi32 (v, zero));
+          data += 16;
+          size -= 16;
+        }
+      uint64_t lanes[2];
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (lanes), acc);
+      sum += lanes[0] + lanes[1];
+    }
+#endif
+  while (size >= 8)
+    {
+      uint64_t word;
+      std::memcpy (&word, data, 8);
+      sum += (word & 0xffffffff) + (word >> 32);
+      data += 8;
+      size -= 8;
+    }
+  if (size >= 4)
+    {
+      uint32_t word;
+      std::memcpy (&word, data, 4);
+      sum += word;
+      data += 4;
+      size -= 4;
+    }
+  if (size >= 2)
+    {
+      uint16_t word;
+      std::memcpy (&word, data, 2);
+      sum += word;
+      data += 2;
+      size -= 2;
+    }
+#if defined (__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  if (size)
+    {
+      sum += *data << 8;
+    }
+  // The host words were summed in the wrong byte order.
+  uint16_t folded = ChecksumFold (sum);
+  return (folded >> 8) | (folded << 8);
+#else
+  if (size)
+    {
+      sum += *data;
+    }
+  return ChecksumFold (sum);
+#endif
+}
+
 uint16_t
 Buffer::Iterator::CalculateIpChecksum (uint16_t size, uint32_t initialChecksum)
 {
   NS_LOG_FUNCTION (this << size << initialChecksum);
+  NS_ASSERT_MSG (m_current >= m_dataStart &&
+                 m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
   /* see RFC 1071 to understand this code. */
-  uint32_t sum = initialChecksum;
+  uint64_t sum = initialChecksum;
+  uint32_t start = m_current;
+  uint32_t end = m_current + size;
 
-  for (int j = 0; j < size/2; j++)
-    sum += ReadU16 ();
-
-  if (size & 1)
-    sum += ReadU8 ();
+  if (start < m_zeroStart)
+    {
+      sum += ChecksumSpan (&m_data[start], std::min (end, m_zeroStart) - start);
+    }
+  // The zero area adds nothing, but if its length is odd the bytes
+  // after it change halves in their words.
+  uint32_t after = std::max (start, m_zeroEnd);
+  if (after < end)
+    {
+      uint16_t partial = ChecksumSpan (&m_data[after - (m_zeroEnd - m_zeroStart)], end - after);
+      if ((after - start) & 1)
+        {
+          partial = (partial >> 8) | (partial << 8);
+        }
+      sum += partial;
+    }
+  m_current = end;
 
-  while (sum >> 16)
-    sum = (sum & 0xffff) + (sum >> 16);
-  return ~sum;
+  return ~ChecksumFold (sum);
 }
 
 uint32_t 
@@ -1161,6 +1276,13 @@ Buffer::Iterator::GetSize (void) const
   return m_dataEnd - m_dataStart;
 }
 
+uint32_t
+Buffer::Iterator::GetRemainingSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_dataEnd - m_current;
+}
+
 
 std::string 
 Buffer::Iterator::GetReadErrorMessage (void) const
@@ -342,7 +342,8 @@ public:
      *
      * Copy size bytes of data from the internal buffer to the
      * input buffer and advance the Iterator by the number of
-     * bytes read.
+     * bytes read.  The bounds are checked once, so that this is
+     * the fast way to read a fixed-size header.
      */
     void Read (uint8_t *buffer, uint32_t size);
 
@@ -376,6 +377,12 @@ public:
      */
     uint32_t GetSize (void) const;
 
+    /**
+     * \returns the number of bytes left between this iterator and the
+     *     end of the underlying buffer
+     */
+    uint32_t GetRemainingSize (void) const;
+
 private:
     friend class Buffer;
     /**
@@ -549,6 +556,17 @@ private:
    */
   Buffer CreateFragment (uint32_t start, uint32_t length) const;
 
+  /**
+   * \brief Create a copy of the buffer which shares no data with it.
+   *
+   * Unlike the copy constructor, which shares the data and its
+   * reference count, the copy may be handed to another thread.  The
+   * zero area is kept.
+   *
+   * \returns a copy of the buffer
+   */
+  Buffer DeepCopy (void) const;
+
   /**
    * \return an Iterator which points to the
    * start of this Buffer.
@@ -759,9 +777,9 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value. Each thread learns its own value.
    */
-  static uint32_t g_recommendedStart;
+  static __thread uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -783,19 +801,6 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
 };
 
 } // namespace ns3
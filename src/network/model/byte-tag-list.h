@@ -188,6 +188,12 @@ private:
    */ 
   void RemoveAll (void);
 
+  /**
+   * \returns a copy of the list which shares no data with it, and
+   * may therefore be handed to another thread.
+   */
+  ByteTagList DeepCopy (void) const;
+
   /**
    * \param offsetStart the offset which uniquely identifies the first data byte 
    *        present in the byte buffer associated to this ByteTagList.
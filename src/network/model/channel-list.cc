@@ -167,6 +167,7 @@ ChannelListPriv::DoDispose (void)
       *i = 0;
     }
   m_channels.erase (m_channels.begin (), m_channels.end ());
+  Config::InvalidateCache ();
   Object::DoDispose ();
 }
 
@@ -176,6 +177,7 @@ ChannelListPriv::Add (Ptr<Channel> channel)
   NS_LOG_FUNCTION (this << channel);
   uint32_t index = m_channels.size ();
   m_channels.push_back (channel);
+  Config::InvalidateCache ();
   return index;
 
 }
@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-allocator.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/memory-accounting.h"
+#include "ns3/core-config.h"
+
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketAllocator");
+
+namespace {
+
+/** MemoryAccounting of the free blocks kept by the size classes. */
+MemoryAccounting::Counter g_freeBlockMemory ("ns3::PacketAllocator::FreeBlock");
+
+/** A free block, linked in the free list of its class. */
+struct FreeBlock
+{
+  FreeBlock *next; //!< The next free block.
+};
+
+/** A size class. */
+struct SizeClass
+{
+  FreeBlock *head;                         //!< The free list.
+  PacketAllocator::Statistics statistics;  //!< The statistics.
+};
+
+/**
+ * The size classes of the calling thread, and one more entry for the
+ * statistics of the larger blocks.
+ *
+ * This is plain thread-local data, initialized to zero before any
+ * constructor runs, so that packets can be allocated and released by
+ * any static constructor or destructor, and by any thread without
+ * locking.
+ */
+__thread SizeClass g_classes[PacketAllocator::N_CLASSES + 1];
+
+/**
+ * Set once the static destructors of this file have run: the blocks
+ * released after that are not cached anymore.
+ */
+bool g_destroyed = false;
+
+/** Release the free blocks when the program exits. */
+struct LocalStaticDestructor
+{
+  ~LocalStaticDestructor ()
+  {
+    PacketAllocator::Purge ();
+    g_destroyed = true;
+  }
+} g_localStaticDestructor; //!< Local static destructor
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Set once the free lists of the calling thread are released at its
+ * exit by ReleaseThread.
+ */
+__thread bool g_threadRegistered = false;
+/** The key whose destructor releases the free lists of a thread. */
+pthread_key_t g_threadKey;
+/** Creates g_threadKey once. */
+pthread_once_t g_threadKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Release the free blocks of a thread when it exits.
+ * \param [in] value The value of g_threadKey, unused.
+ */
+void
+ReleaseThread (void *value)
+{
+  g_threadRegistered = false;
+  PacketAllocator::Purge ();
+}
+
+/** Create g_threadKey. */
+void
+CreateThreadKey (void)
+{
+  pthread_key_create (&g_threadKey, &ReleaseThread);
+}
+
+/**
+ * Make sure the free lists of the calling thread are released when it
+ * exits: the main thread releases its own from the static destructors.
+ */
+void
+RegisterThread (void)
+{
+  pthread_once (&g_threadKeyOnce, &CreateThreadKey);
+  pthread_setspecific (g_threadKey, &g_threadRegistered);
+  g_threadRegistered = true;
+}
+#endif /* HAVE_PTHREAD_H */
+
+} // unnamed namespace
+
+uint32_t
+PacketAllocator::GetClass (uint32_t size)
+{
+  uint32_t i = 0;
+  uint32_t blockSize = MIN_BLOCK_SIZE;
+  while (blockSize < size)
+    {
+      if (blockSize == MAX_BLOCK_SIZE)
+        {
+          return N_CLASSES;
+        }
+      blockSize <<= 1;
+      i++;
+    }
+  return i;
+}
+
+uint32_t
+PacketAllocator::GetBlockSize (uint32_t size)
+{
+  uint32_t i = GetClass (size);
+  if (i == N_CLASSES)
+    {
+      return size;
+    }
+  return MIN_BLOCK_SIZE << i;
+}
+
+void *
+PacketAllocator::Allocate (uint32_t size)
+{
+  NS_LOG_FUNCTION (size);
+  uint32_t i = GetClass (size);
+  SizeClass *sizeClass = &g_classes[i];
+  sizeClass->statistics.allocations++;
+  if (sizeClass->head != 0)
+    {
+      FreeBlock *block = sizeClass->head;
+      sizeClass->head = block->next;
+      sizeClass->statistics.reuses++;
+      sizeClass->statistics.cached--;
+      g_freeBlockMemory.Add (-1, -(int64_t)(MIN_BLOCK_SIZE << i));
+      return block;
+    }
+  if (i != N_CLASSES)
+    {
+      size = MIN_BLOCK_SIZE << i;
+    }
+  return ::operator new (size);
+}
+
+void
+PacketAllocator::Deallocate (void *block, uint32_t size)
+{
+  NS_LOG_FUNCTION (block << size);
+  uint32_t i = GetClass (size);
+  SizeClass *sizeClass = &g_classes[i];
+  sizeClass->statistics.deallocations++;
+  if (i == N_CLASSES ||
+      sizeClass->statistics.cached >= MAX_CACHED ||
+      g_destroyed)
+    {
+      ::operator delete (block);
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (!g_threadRegistered)
+    {
+      RegisterThread ();
+    }
+#endif
+  FreeBlock *freeBlock = static_cast<FreeBlock *> (block);
+  freeBlock->next = sizeClass->head;
+  sizeClass->head = freeBlock;
+  sizeClass->statistics.cached++;
+  g_freeBlockMemory.Add (1, MIN_BLOCK_SIZE << i);
+}
+
+PacketAllocator::Statistics
+PacketAllocator::GetStatistics (uint32_t i)
+{
+  NS_LOG_FUNCTION (i);
+  NS_ASSERT_MSG (i <= N_CLASSES, "PacketAllocator::GetStatistics(): no size class " << i);
+  Statistics statistics = g_classes[i].statistics;
+  statistics.blockSize = i == N_CLASSES ? 0 : MIN_BLOCK_SIZE << i;
+  return statistics;
+}
+
+void
+PacketAllocator::PrintStatistics (std::ostream &os)
+{
+  NS_LOG_FUNCTION (&os);
+  os << "# block-size allocations reuses deallocations cached" << std::endl;
+  for (uint32_t i = 0; i <= N_CLASSES; i++)
+    {
+      Statistics statistics = GetStatistics (i);
+      if (statistics.allocations == 0)
+        {
+          continue;
+        }
+      if (i == N_CLASSES)
+        {
+          os << ">" << MAX_BLOCK_SIZE;
+        }
+      else
+        {
+          os << statistics.blockSize;
+        }
+      os << " " << statistics.allocations
+         << " " << statistics.reuses
+         << " " << statistics.deallocations
+         << " " << statistics.cached << std::endl;
+    }
+}
+
+void
+PacketAllocator::Purge (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (uint32_t i = 0; i < N_CLASSES; i++)
+    {
+      SizeClass *sizeClass = &g_classes[i];
+      while (sizeClass->head != 0)
+        {
+          FreeBlock *block = sizeClass->head;
+          sizeClass->head = block->next;
+          ::operator delete (block);
+        }
+      g_freeBlockMemory.Add (-(int64_t)sizeClass->statistics.cached,
+                             -(int64_t)sizeClass->statistics.cached * (MIN_BLOCK_SIZE << i));
+      sizeClass->statistics.cached = 0;
+    }
+}
+
+} // namespace ns3
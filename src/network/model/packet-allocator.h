@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PACKET_ALLOCATOR_H
+#define PACKET_ALLOCATOR_H
+
+#include <ostream>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief Size-class free lists for the memory of packets.
+ *
+ * Packet objects, the data of their Buffer, ByteTagList and
+ * PacketMetadata, and the nodes of their PacketTagList are allocated
+ * and released at a very high rate: every copy of a packet, such as
+ * the ones made for each interface of a broadcast, allocates several
+ * of them. This class
+ * keeps the released blocks in free lists, one per power-of-two size
+ * class from MIN_BLOCK_SIZE to MAX_BLOCK_SIZE bytes, so that most
+ * allocations reuse a block instead of calling the system allocator.
+ * Larger blocks are not cached.
+ *
+ * Each free list keeps at most MAX_CACHED blocks; the blocks released
+ * beyond that go back to the system allocator.
+ *
+ * The free lists and their statistics are per thread, so that the
+ * threads of a parallel simulation allocate packets without locking:
+ * a block released by another thread than the one which allocated it
+ * joins the free lists of the releasing thread. The free blocks of a
+ * thread go back to the system allocator when it exits.
+ */
+class PacketAllocator
+{
+public:
+  /** The size classes. */
+  enum
+  {
+    MIN_BLOCK_SIZE = 16,   //!< Size of the blocks of the smallest class.
+    MAX_BLOCK_SIZE = 4096, //!< Size of the blocks of the largest class.
+    N_CLASSES = 9,         //!< Number of size classes.
+    MAX_CACHED = 1024      //!< Maximum number of free blocks per class.
+  };
+
+  /** The statistics of a size class. */
+  struct Statistics
+  {
+    uint32_t blockSize;     //!< Size of the blocks, 0 for larger blocks.
+    uint64_t allocations;   //!< Number of blocks allocated.
+    uint64_t reuses;        //!< Number of allocations served from the free list.
+    uint64_t deallocations; //!< Number of blocks released.
+    uint32_t cached;        //!< Number of blocks in the free list.
+  };
+
+  /**
+   * Allocate a block.
+   * \param [in] size The size of the block.
+   * \returns A block of at least \p size bytes.
+   */
+  static void *Allocate (uint32_t size);
+  /**
+   * Release a block returned by Allocate.
+   * \param [in] block The block.
+   * \param [in] size The size the block was allocated with, or any
+   *        size up to the GetBlockSize of that size.
+   */
+  static void Deallocate (void *block, uint32_t size);
+  /**
+   * Get the usable size of the blocks of a given size.
+   * \param [in] size The size of a block.
+   * \returns The size of the blocks of the class of \p size, which
+   *          callers may use entirely.
+   */
+  static uint32_t GetBlockSize (uint32_t size);
+
+  /**
+   * Get the statistics of a size class in the calling thread.
+   * \param [in] i The index of the class, from 0 to N_CLASSES; index
+   *        N_CLASSES describes the blocks too large for any class.
+   * \returns The statistics of the class.
+   */
+  static Statistics GetStatistics (uint32_t i);
+  /**
+   * Print the statistics of all the size classes in the calling
+   * thread, one line per class.
+   * \param [in] os The output stream.
+   */
+  static void PrintStatistics (std::ostream &os);
+  /** Return all the free blocks of the calling thread to the system allocator. */
+  static void Purge (void);
+
+private:
+  /**
+   * Get the size class of a size.
+   * \param [in] size The size of a block.
+   * \returns The index of the class, or N_CLASSES if \p size is too
+   *          large for all of them.
+   */
+  static uint32_t GetClass (uint32_t size);
+};
+
+} // namespace ns3
+
+#endif /* PACKET_ALLOCATOR_H */
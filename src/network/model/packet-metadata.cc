@@ -22,7 +22,9 @@
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/memory-accounting.h"
 #include "packet-metadata.h"
+#include "packet-allocator.h"
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -31,22 +33,15 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
+/** MemoryAccounting of the allocated metadata, recycled or not. */
+static MemoryAccounting::Counter g_metadataMemory ("ns3::PacketMetadata::Data");
+
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
+bool PacketMetadata::m_enableCompact = false;
 bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
+__thread uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
 
 void 
 PacketMetadata::Enable (void)
@@ -70,6 +65,21 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+void 
+PacketMetadata::EnableCompact (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Enable ();
+  m_enableCompact = true;
+}
+
+void 
+PacketMetadata::DisableCompact (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_enableCompact = false;
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
@@ -133,6 +143,11 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return m_head == 0xffff && m_tail == 0xffff && m_used == 0 &&
+             m_compactSize <= PACKET_METADATA_COMPACT_SIZE;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -506,6 +521,7 @@ PacketMetadata::ReplaceTail (PacketMetadata::SmallItem *item,
 
   // create a copy of the packet without its tail.
   PacketMetadata h (m_packetUid, 0);
+  h.Expand ();
   uint16_t current = m_head;
   while (current != 0xffff && current != m_tail)
     {
@@ -567,6 +583,48 @@ PacketMetadata::ReadItems (uint16_t current,
   return buffer - &m_data->m_data[current];
 }
 
+void
+PacketMetadata::ReadCompactItem (uint16_t current,
+                                 struct PacketMetadata::SmallItem *item,
+                                 struct PacketMetadata::ExtraItem *extraItem) const
+{
+  NS_LOG_FUNCTION (this << current << item << extraItem);
+  NS_ASSERT (current < m_compactSize);
+  const struct PacketMetadata::CompactItem *compact = &m_compact[current];
+  item->next = current == 0 ? 0xffff : current - 1;
+  item->prev = current + 1 == m_compactSize ? 0xffff : current + 1;
+  item->typeUid = compact->typeUid << 1;
+  item->size = compact->size;
+  item->chunkUid = compact->chunkUid;
+  extraItem->fragmentStart = 0;
+  extraItem->fragmentEnd = compact->size;
+  extraItem->packetUid = m_packetUid;
+}
+
+void
+PacketMetadata::Expand (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data != 0)
+    {
+      return;
+    }
+  m_data = PacketMetadata::Create (10);
+  memset (m_data->m_data, 0xff, 4);
+  for (uint16_t current = m_compactSize; current > 0; current--)
+    {
+      struct PacketMetadata::SmallItem item;
+      struct PacketMetadata::ExtraItem extraItem;
+      ReadCompactItem (current - 1, &item, &extraItem);
+      item.next = 0xffff;
+      item.prev = m_tail;
+      uint16_t written = AddSmall (&item);
+      UpdateTail (written);
+    }
+  m_compactSize = 0;
+  NS_ASSERT (IsStateOk ());
+}
+
 struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
@@ -576,19 +634,6 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
   NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
 }
@@ -597,22 +642,9 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
+  NS_LOG_LOGIC ("recycle size="<<data->m_size);
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
+  PacketMetadata::Deallocate (data);
 }
 
 struct PacketMetadata::Data *
@@ -625,9 +657,11 @@ PacketMetadata::Allocate (uint32_t n)
       n = PACKET_METADATA_DATA_M_DATA_SIZE;
     }
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
-  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
+  // the whole block of the size class is usable.
+  size = PacketAllocator::GetBlockSize (size);
+  g_metadataMemory.Add (1, size);
+  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)PacketAllocator::Allocate (size);
+  data->m_size = size - sizeof (struct Data) + PACKET_METADATA_DATA_M_DATA_SIZE;
   data->m_count = 1;
   data->m_dirtyEnd = 0;
   return data;
@@ -636,8 +670,9 @@ void
 PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  uint32_t size = sizeof (struct Data) + data->m_size - PACKET_METADATA_DATA_M_DATA_SIZE;
+  g_metadataMemory.Add (-1, -(int64_t)size);
+  PacketAllocator::Deallocate (data, size);
 }
 
 
@@ -656,6 +691,11 @@ PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
+  if (!m_enable)
+    {
+      m_metadataSkipped = true;
+      return;
+    }
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   DoAddHeader (uid, size);
   NS_ASSERT (IsStateOk ());
@@ -669,6 +709,18 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (m_data == 0 && m_enableCompact &&
+      m_compactSize < PACKET_METADATA_COMPACT_SIZE)
+    {
+      struct PacketMetadata::CompactItem *compact = &m_compact[m_compactSize];
+      compact->typeUid = uid >> 1;
+      compact->chunkUid = m_chunkUid;
+      compact->size = size;
+      m_chunkUid++;
+      m_compactSize++;
+      return;
+    }
+  Expand ();
 
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
@@ -683,7 +735,6 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
@@ -691,6 +742,22 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
+  if (m_data == 0)
+    {
+      if (m_compactSize == 0 ||
+          m_compact[m_compactSize - 1].typeUid != uid >> 1 ||
+          m_compact[m_compactSize - 1].size != size)
+        {
+          if (m_enableChecking)
+            {
+              NS_FATAL_ERROR ("Removing unexpected header.");
+            }
+          return;
+        }
+      m_compactSize--;
+      return;
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -731,7 +798,6 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 void 
 PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable)
@@ -739,6 +805,19 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  if (m_data == 0 && m_enableCompact &&
+      m_compactSize < PACKET_METADATA_COMPACT_SIZE)
+    {
+      memmove (&m_compact[1], &m_compact[0], m_compactSize * sizeof (struct CompactItem));
+      m_compact[0].typeUid = uid >> 1;
+      m_compact[0].chunkUid = m_chunkUid;
+      m_compact[0].size = size;
+      m_chunkUid++;
+      m_compactSize++;
+      return;
+    }
+  Expand ();
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
@@ -753,7 +832,6 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 void 
 PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
@@ -761,6 +839,23 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  if (m_data == 0)
+    {
+      if (m_compactSize == 0 ||
+          m_compact[0].typeUid != uid >> 1 ||
+          m_compact[0].size != size)
+        {
+          if (m_enableChecking)
+            {
+              NS_FATAL_ERROR ("Removing unexpected trailer.");
+            }
+          return;
+        }
+      m_compactSize--;
+      memmove (&m_compact[0], &m_compact[1], m_compactSize * sizeof (struct CompactItem));
+      return;
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -808,7 +903,7 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
-  if (m_tail == 0xffff)
+  if (m_tail == 0xffff && m_compactSize == 0)
     {
       // We have no items so 'AddAtEnd' is 
       // equivalent to self-assignment.
@@ -816,12 +911,22 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       NS_ASSERT (IsStateOk ());
       return;
     }
-  if (o.m_head == 0xffff)
+  if (o.m_head == 0xffff && o.m_compactSize == 0)
     {
       NS_ASSERT (o.m_tail == 0xffff);
       // we have nothing to append.
       return;
     }
+  if (o.m_data == 0)
+    {
+      // The items of o are described with the packet uid of o,
+      // which only the linked list can record.
+      PacketMetadata expanded = o;
+      expanded.Expand ();
+      AddAtEnd (expanded);
+      return;
+    }
+  Expand ();
   NS_ASSERT (m_head != 0xffff && m_tail != 0xffff);
 
   // We read the current tail because we are going to append
@@ -896,7 +1001,23 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      // Remove whole items from the head of the compact representation.
+      uint32_t leftToRemove = start;
+      uint8_t n = m_compactSize;
+      while (n > 0 && m_compact[n - 1].size <= leftToRemove)
+        {
+          leftToRemove -= m_compact[n - 1].size;
+          n--;
+        }
+      if (leftToRemove == 0)
+        {
+          m_compactSize = n;
+          return;
+        }
+      Expand ();
+    }
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -923,6 +1044,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.Expand ();
           extraItem.fragmentStart += leftToRemove;
           leftToRemove = 0;
           uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
@@ -959,7 +1081,24 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      // Remove whole items from the tail of the compact representation.
+      uint32_t leftToRemove = end;
+      uint8_t n = 0;
+      while (n < m_compactSize && m_compact[n].size <= leftToRemove)
+        {
+          leftToRemove -= m_compact[n].size;
+          n++;
+        }
+      if (leftToRemove == 0)
+        {
+          m_compactSize -= n;
+          memmove (&m_compact[0], &m_compact[n], m_compactSize * sizeof (struct CompactItem));
+          return;
+        }
+      Expand ();
+    }
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
@@ -987,6 +1126,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.Expand ();
           NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
           extraItem.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
@@ -1019,6 +1159,10 @@ PacketMetadata::GetTotalSize (void) const
 {
   NS_LOG_FUNCTION (this);
   uint32_t totalSize = 0;
+  for (uint8_t i = 0; i < m_compactSize; i++)
+    {
+      totalSize += m_compact[i].size;
+    }
   uint16_t current = m_head;
   uint16_t tail = m_tail;
   while (current != 0xffff)
@@ -1043,6 +1187,17 @@ PacketMetadata::GetUid (void) const
   NS_LOG_FUNCTION (this);
   return m_packetUid;
 }
+PacketMetadata
+PacketMetadata::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketMetadata copy = *this;
+  if (copy.m_data != 0)
+    {
+      copy.ReserveCopy (0);
+    }
+  return copy;
+}
 PacketMetadata::ItemIterator 
 PacketMetadata::BeginItem (Buffer buffer) const
 {
@@ -1052,7 +1207,8 @@ PacketMetadata::BeginItem (Buffer buffer) const
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
   : m_metadata (metadata),
     m_buffer (buffer),
-    m_current (metadata->m_head),
+    m_current (metadata->m_data == 0 && metadata->m_compactSize > 0 ?
+               metadata->m_compactSize - 1 : metadata->m_head),
     m_offset (0),
     m_hasReadTail (false)
 {
@@ -1079,10 +1235,15 @@ PacketMetadata::ItemIterator::Next (void)
   struct PacketMetadata::Item item;
   struct PacketMetadata::SmallItem smallItem;
   struct PacketMetadata::ExtraItem extraItem;
-  m_metadata->ReadItems (m_current, &smallItem, &extraItem);
-  if (m_current == m_metadata->m_tail)
+  if (m_metadata->m_data == 0)
     {
-      m_hasReadTail = true;
+      m_metadata->ReadCompactItem (m_current, &smallItem, &extraItem);
+      m_hasReadTail = m_current == 0;
+    }
+  else
+    {
+      m_metadata->ReadItems (m_current, &smallItem, &extraItem);
+      m_hasReadTail = m_current == m_metadata->m_tail;
     }
   m_current = smallItem.next;
   uint32_t uid = (smallItem.typeUid & 0xfffffffe) >> 1;
@@ -1150,6 +1311,12 @@ PacketMetadata::GetSerializedSize (void) const
     {
       return totalSize;
     }
+  if (m_data == 0 && m_compactSize > 0)
+    {
+      PacketMetadata expanded = *this;
+      expanded.Expand ();
+      return expanded.GetSerializedSize ();
+    }
 
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
@@ -1183,6 +1350,12 @@ uint32_t
 PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_data == 0 && m_compactSize > 0)
+    {
+      PacketMetadata expanded = *this;
+      expanded.Expand ();
+      return expanded.Serialize (buffer, maxSize);
+    }
   uint8_t* start = buffer;
 
   buffer = AddToRawU64 (m_packetUid, start, buffer, maxSize);
@@ -1334,6 +1507,7 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
                     ", size="<<item.size<<", chunkUid="<<item.chunkUid<<
                     ", fragmentStart="<<extraItem.fragmentStart<<", fragmentEnd="<<
                     extraItem.fragmentEnd<< ", packetUid="<<extraItem.packetUid);
+      Expand ();
       uint32_t tmp = AddBig (0xffff, m_tail, &item, &extraItem);
       UpdateTail (tmp);
     }
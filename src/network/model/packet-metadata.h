@@ -74,6 +74,17 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * When PacketMetadata::EnableCompact has been called, a packet does not
+ * allocate this byte buffer until it needs it: its headers, payload
+ * and trailers are kept in a small fixed-size array stored inline
+ * in the PacketMetadata object. Only whole items are kept there: when
+ * an operation fragments an item, appends another packet or overflows
+ * the array, the packet switches to the linked list described above.
+ * The items of the array are turned into Item structures on the fly
+ * when they are iterated over with an ItemIterator.
+ *
+ * When the metadata is not enabled, no byte buffer is allocated.
  */
 class PacketMetadata 
 {
@@ -159,6 +170,19 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable the packet metadata, and keep it in the compact
+   * representation whenever possible.
+   *
+   * The packets which already exist keep their current representation.
+   */
+  static void EnableCompact (void);
+  /**
+   * \brief Stop using the compact representation for new items.
+   *
+   * The packets which already exist keep their current representation.
+   */
+  static void DisableCompact (void);
 
   /**
    * \brief Constructor
@@ -244,6 +268,15 @@ private:
    */
   uint64_t GetUid (void) const;
 
+  /**
+   * \brief Create a copy which shares no data with this metadata
+   *
+   * The copy may be handed to another thread.
+   *
+   * \return the copy
+   */
+  PacketMetadata DeepCopy (void) const;
+
   /**
    * \brief Get the metadata serialized size
    * \return the seralized size
@@ -404,6 +437,13 @@ private:
    * of PacketMetadata::Data is 16 bytes
    */ 
 #define PACKET_METADATA_DATA_M_DATA_SIZE 8
+
+  /**
+   * the maximum number of items stored in the compact representation:
+   * enough for a payload, a transport header, an IP header, two link
+   * layer headers and a trailer.
+   */
+#define PACKET_METADATA_COMPACT_SIZE 6
   
   /**
    * Data structure
@@ -492,15 +532,20 @@ private:
   };
 
   /**
-   * \brief Class to hold all the metadata
+   * \brief CompactItem structure
+   *
+   * A whole header, trailer or payload, stored in the compact
+   * representation.
    */
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
+  struct CompactItem {
+    /** the TypeId uid of the header or trailer: zero for payload. */
+    uint16_t typeUid;
+    /** the chunkUid of the item, as in SmallItem::chunkUid. */
+    uint16_t chunkUid;
+    /** the size (in bytes) of the item. */
+    uint32_t size;
   };
 
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -609,6 +654,23 @@ public:
   uint32_t ReadItems (uint16_t current, 
                       struct PacketMetadata::SmallItem *item,
                       struct PacketMetadata::ExtraItem *extraItem) const;
+  /**
+   * \brief Read an item of the compact representation
+   * \param current the index of the item in m_compact
+   * \param item pointer to where we should store the data to return to the caller
+   * \param extraItem pointer to where we should store the data to return to the caller
+   */
+  void ReadCompactItem (uint16_t current,
+                        struct PacketMetadata::SmallItem *item,
+                        struct PacketMetadata::ExtraItem *extraItem) const;
+  /**
+   * \brief Switch from the compact representation to the linked list
+   *
+   * Allocate the byte buffer, and move the items of the compact
+   * representation to it. Does nothing if the byte buffer
+   * already exists.
+   */
+  void Expand (void);
   /**
    * \brief Add an header
    * \param uid header's uid to add
@@ -656,9 +718,9 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
+  static bool m_enableCompact; //!< Enable the compact representation
 
   /**
    * Set to true when adding metadata to a packet is skipped because
@@ -667,10 +729,10 @@ public:
    */
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
+  static __thread uint32_t m_maxSize; //!< maximum metadata size allocated by the calling thread
   static uint16_t m_chunkUid; //!< Chunk Uid
 
-  struct Data *m_data; //!< Metadata storage
+  struct Data *m_data; //!< Metadata storage, or 0 in the compact representation
   /*
      head -(next)-> tail
        ^             |
@@ -680,6 +742,12 @@ public:
   uint16_t m_tail; //!< list tail
   uint16_t m_used; //!< used portion
   uint64_t m_packetUid; //!< packet Uid
+  /**
+   * the items of the compact representation, from the tail of the
+   * packet at index 0 to its head at index m_compactSize - 1.
+   */
+  struct CompactItem m_compact[PACKET_METADATA_COMPACT_SIZE];
+  uint8_t m_compactSize; //!< number of items in m_compact
 };
 
 } // namespace ns3
@@ -687,13 +755,18 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
-    m_packetUid (uid)
+    m_packetUid (uid),
+    m_compactSize (0)
 {
-  memset (m_data->m_data, 0xff, 4);
+  if (m_enable && !m_enableCompact)
+    {
+      m_data = PacketMetadata::Create (10);
+      memset (m_data->m_data, 0xff, 4);
+    }
   if (size > 0)
     {
       DoAddHeader (0, size);
@@ -704,11 +777,18 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
-    m_packetUid (o.m_packetUid)
+    m_packetUid (o.m_packetUid),
+    m_compactSize (o.m_compactSize)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
+  else
+    {
+      memcpy (m_compact, o.m_compact, m_compactSize * sizeof (struct CompactItem));
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,25 +796,37 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
   m_used = o.m_used;
   m_packetUid = o.m_packetUid;
+  m_compactSize = o.m_compactSize;
+  if (m_data == 0 && this != &o)
+    {
+      memcpy (m_compact, o.m_compact, m_compactSize * sizeof (struct CompactItem));
+    }
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      return;
+    }
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
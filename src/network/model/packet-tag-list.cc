@@ -24,6 +24,7 @@
 */
 
 #include "packet-tag-list.h"
+#include "packet-allocator.h"
 #include "tag-buffer.h"
 #include "tag.h"
 #include "ns3/fatal-error.h"
@@ -34,6 +35,18 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+void *
+PacketTagList::TagData::operator new (std::size_t size)
+{
+  return PacketAllocator::Allocate (size);
+}
+
+void
+PacketTagList::TagData::operator delete (void *tagData, std::size_t size)
+{
+  PacketAllocator::Deallocate (tagData, size);
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -260,6 +273,25 @@ PacketTagList::Add (const Tag &tag) const
   const_cast<PacketTagList *> (this)->m_next = head;
 }
 
+PacketTagList
+PacketTagList::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketTagList copy;
+  struct TagData **prevNext = &copy.m_next;
+  for (const struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData *data = new struct TagData ();
+      std::memcpy (data->data, cur->data, TagData::MAX_SIZE);
+      data->tid = cur->tid;
+      data->count = 1;
+      data->next = 0;
+      *prevNext = data;
+      prevNext = &data->next;
+    }
+  return copy;
+}
+
 bool
 PacketTagList::Peek (Tag &tag) const
 {
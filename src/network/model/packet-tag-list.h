@@ -165,6 +165,19 @@ public:
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
     uint32_t count;           /**< Number of incoming links */
+
+    /**
+     * \brief Allocate a TagData from the PacketAllocator
+     * \param [in] size The size of the TagData.
+     * \returns The memory of the TagData.
+     */
+    static void *operator new (std::size_t size);
+    /**
+     * \brief Release a TagData to the PacketAllocator
+     * \param [in] tagData The memory of the TagData.
+     * \param [in] size The size of the TagData.
+     */
+    static void operator delete (void *tagData, std::size_t size);
   };  /* struct TagData */
 
   /**
@@ -233,6 +246,11 @@ public:
    * Remove all tags from this list (up to the first merge).
    */
   inline void RemoveAll (void);
+  /**
+   * \returns a copy of the list which shares no TagData with it, and
+   * may therefore be handed to another thread.
+   */
+  PacketTagList DeepCopy (void) const;
   /**
    * \returns pointer to head of tag list
    */
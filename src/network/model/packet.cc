@@ -18,9 +18,11 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "packet.h"
+#include "packet-allocator.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/memory-accounting.h"
 #include <string>
 #include <cstdarg>
 
@@ -28,7 +30,10 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
-uint32_t Packet::m_globalUid = 0;
+/** MemoryAccounting of the live packets, excluding their buffers. */
+static MemoryAccounting::Counter g_packetMemory ("ns3::Packet");
+
+__thread uint32_t Packet::m_globalUid = 0;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -127,6 +132,37 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+Ptr<Packet>
+Packet::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Packet> copy = Ptr<Packet> (new Packet (m_buffer.DeepCopy (), m_byteTagList.DeepCopy (),
+                                              m_packetTagList.DeepCopy (), m_metadata.DeepCopy ()),
+                                  false);
+  if (m_nixVector != 0)
+    {
+      copy->m_nixVector = m_nixVector->Copy ();
+    }
+  return copy;
+}
+
+Packet::~Packet ()
+{
+  g_packetMemory.Add (-1, -(int64_t)sizeof (Packet));
+}
+
+void *
+Packet::operator new (std::size_t size)
+{
+  return PacketAllocator::Allocate (size);
+}
+
+void
+Packet::operator delete (void *packet, std::size_t size)
+{
+  PacketAllocator::Deallocate (packet, size);
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
@@ -140,6 +176,7 @@ Packet::Packet ()
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
     m_nixVector (0)
 {
+  g_packetMemory.Add (1, sizeof (Packet));
   m_globalUid++;
 }
 
@@ -149,6 +186,7 @@ Packet::Packet (const Packet &o)
     m_packetTagList (o.m_packetTagList),
     m_metadata (o.m_metadata)
 {
+  g_packetMemory.Add (1, sizeof (Packet));
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy ()
     : m_nixVector = 0;
 }
@@ -182,6 +220,7 @@ Packet::Packet (uint32_t size)
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
     m_nixVector (0)
 {
+  g_packetMemory.Add (1, sizeof (Packet));
   m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
@@ -191,6 +230,7 @@ Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
     m_metadata (0,0),
     m_nixVector (0)
 {
+  g_packetMemory.Add (1, sizeof (Packet));
   NS_ASSERT (magic);
   Deserialize (buffer, size);
 }
@@ -208,6 +248,7 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
     m_nixVector (0)
 {
+  g_packetMemory.Add (1, sizeof (Packet));
   m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
@@ -222,6 +263,7 @@ Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList,
     m_metadata (metadata),
     m_nixVector (0)
 {
+  g_packetMemory.Add (1, sizeof (Packet));
 }
 
 Ptr<Packet>
@@ -543,6 +585,13 @@ Packet::EnableChecking (void)
   PacketMetadata::EnableChecking ();
 }
 
+void
+Packet::EnableCompactPrinting (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  PacketMetadata::EnableCompact ();
+}
+
 uint32_t Packet::GetSerializedSize (void) const
 {
   uint32_t size = 0;
@@ -196,6 +196,8 @@ private:
  * checking of metadata, and do not need any printing capability, you can
  * call Packet::EnableChecking: its runtime cost is lower than
  * Packet::EnablePrinting.
+ * Packet::EnableCompactPrinting saves the memory and the allocations
+ * of the metadata of the packets which are not fragmented.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -238,12 +240,28 @@ public:
    * \param o object to copy
    */
   Packet (const Packet &o);
+  /**
+   * \brief Destructor
+   */
+  ~Packet ();
   /**
    * \brief Basic assignment
    * \param o object to copy
    * \return the copied object
    */
   Packet &operator = (const Packet &o);
+  /**
+   * \brief Allocate the memory of a packet from the PacketAllocator
+   * \param size the size of the packet object
+   * \returns the memory of the packet object
+   */
+  static void *operator new (std::size_t size);
+  /**
+   * \brief Release the memory of a packet to the PacketAllocator
+   * \param packet the memory of the packet object
+   * \param size the size of the packet object
+   */
+  static void operator delete (void *packet, std::size_t size);
   /**
    * \brief Create a packet with a zero-filled payload.
    *
@@ -424,6 +442,19 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a deep copy of the packet.
+   *
+   * \returns a copy of the packet which shares no data with it.
+   *
+   * The datasets shared by COW copies are reference-counted without
+   * synchronization: only a deep copy may be handed to another
+   * thread, such as another partition of
+   * ns3::MultithreadedSimulatorImpl.  The copy keeps the uid, tags
+   * and metadata of the packet.
+   */
+  Ptr<Packet> DeepCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -501,6 +532,18 @@ public:
    * errors will be detected and will abort the program.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable printing packets metadata, with a compact
+   * representation of the metadata.
+   *
+   * This is equivalent to EnablePrinting, except that a packet
+   * only records the headers, payload and trailers it currently
+   * contains, in a small array stored in the packet itself, and needs
+   * no allocation for them. A packet switches to the full
+   * representation when it is fragmented, concatenated with another
+   * packet, or when it holds too many headers and trailers.
+   */
+  static void EnableCompactPrinting (void);
 
   /**
    * \brief Returns number of bytes required for packet
@@ -721,7 +764,12 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  /**
+   * Counter of the packet uids allocated by the calling thread; the
+   * threads of a parallel simulation tell their uids apart with
+   * Simulator::GetSystemId.
+   */
+  static __thread uint32_t m_globalUid;
 };
 
 /**
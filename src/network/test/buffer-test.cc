@@ -359,6 +359,115 @@ BufferTest::DoRun (void)
   val2 <<= 8;
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
+
+  // Read across the zero area
+  buffer = Buffer (5);
+  buffer.AddAtStart (2);
+  buffer.AddAtEnd (2);
+  i = buffer.Begin ();
+  i.WriteU8 (0x11);
+  i.WriteU8 (0x22);
+  i.Next (5);
+  i.WriteU8 (0x33);
+  i.WriteU8 (0x44);
+  uint8_t read[8];
+  uint8_t expectedRead[8] = { 0x22, 0, 0, 0, 0, 0, 0x33, 0x44 };
+  i = buffer.Begin ();
+  i.Next (1);
+  i.Read (read, 8);
+  for (uint32_t k = 0; k < 8; k++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)read[k], (uint32_t)expectedRead[k], "Bad Read() at " << k);
+    }
+  NS_TEST_ASSERT_MSG_EQ (i.IsEnd (), true, "Read() did not advance the iterator");
+}
+//-----------------------------------------------------------------------------
+/**
+ * Check Buffer::Iterator::CalculateIpChecksum against the byte at a time
+ * sum, around zero areas of even and odd sizes and from even and odd
+ * offsets.
+ */
+class BufferChecksumTest : public TestCase {
+private:
+  /**
+   * The checksum of RFC 1071, from ReadU16.
+   * \param i The iterator to read from.
+   * \param size The number of bytes.
+   * \param initialChecksum The initial value.
+   * \return The checksum.
+   */
+  uint16_t ReferenceChecksum (Buffer::Iterator i, uint16_t size, uint32_t initialChecksum);
+public:
+  virtual void DoRun (void);
+  BufferChecksumTest ();
+};
+
+BufferChecksumTest::BufferChecksumTest ()
+  : TestCase ("Buffer checksum") {
+}
+
+uint16_t
+BufferChecksumTest::ReferenceChecksum (Buffer::Iterator i, uint16_t size, uint32_t initialChecksum)
+{
+  uint32_t sum = initialChecksum;
+  for (int j = 0; j < size/2; j++)
+    sum += i.ReadU16 ();
+  if (size & 1)
+    sum += i.ReadU8 ();
+  while (sum >> 16)
+    sum = (sum & 0xffff) + (sum >> 16);
+  return ~sum;
+}
+
+void
+BufferChecksumTest::DoRun (void)
+{
+  uint32_t seed = 1;
+  uint32_t sizes[] = { 0, 1, 2, 3, 7, 16, 17, 40, 41, 100, 1500 };
+  uint32_t nSizes = sizeof (sizes) / sizeof (sizes[0]);
+  for (uint32_t z = 0; z < nSizes; z++)
+    {
+      for (uint32_t h = 0; h < nSizes; h++)
+        {
+          uint32_t t = (z + h) % nSizes;
+          // A zero area of sizes[z] bytes with sizes[h] bytes before it
+          // and sizes[t] bytes after it.
+          Buffer buffer (sizes[z]);
+          buffer.AddAtStart (sizes[h]);
+          buffer.AddAtEnd (sizes[t]);
+          Buffer::Iterator i = buffer.Begin ();
+          for (uint32_t k = 0; k < sizes[h]; k++)
+            {
+              seed = seed * 1103515245 + 12345;
+              i.WriteU8 (seed >> 16);
+            }
+          i = buffer.End ();
+          i.Prev (sizes[t]);
+          for (uint32_t k = 0; k < sizes[t]; k++)
+            {
+              seed = seed * 1103515245 + 12345;
+              i.WriteU8 (seed >> 16);
+            }
+
+          uint32_t total = buffer.GetSize ();
+          for (uint32_t start = 0; start < total && start < 5; start++)
+            {
+              for (uint32_t end = total; end > start && end + 5 > total; end--)
+                {
+                  uint32_t initial = (start * 0x10001) ^ end;
+                  Buffer::Iterator a = buffer.Begin ();
+                  a.Next (start);
+                  Buffer::Iterator b = a;
+                  uint16_t expected = ReferenceChecksum (a, end - start, initial);
+                  uint16_t got = b.CalculateIpChecksum (end - start, initial);
+                  NS_TEST_ASSERT_MSG_EQ (got, expected, "Bad checksum of [" << start << "," << end
+                                         << ") with a zero area of " << sizes[z] << " bytes after "
+                                         << sizes[h] << " bytes");
+                  NS_TEST_ASSERT_MSG_EQ (b.GetDistanceFrom (buffer.Begin ()), end, "Iterator not advanced");
+                }
+            }
+        }
+    }
 }
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
@@ -371,6 +480,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferChecksumTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "ns3/memory-accounting.h"
+#include "ns3/packet-allocator.h"
+#include "ns3/packet.h"
+#include "ns3/test.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * Check the size classes, the reuse of the free blocks and the
+ * statistics of PacketAllocator.
+ */
+class PacketAllocatorTestCase : public TestCase
+{
+public:
+  PacketAllocatorTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Allocate and release a block from another thread. */
+  static void AllocateInThread (void);
+
+  /** The statistics of the 128-byte class seen by the other thread. */
+  static PacketAllocator::Statistics s_threadStatistics;
+};
+
+PacketAllocator::Statistics PacketAllocatorTestCase::s_threadStatistics;
+
+PacketAllocatorTestCase::PacketAllocatorTestCase ()
+  : TestCase ("Check the size classes and the free lists")
+{
+}
+
+void
+PacketAllocatorTestCase::AllocateInThread (void)
+{
+  void *block = PacketAllocator::Allocate (100);
+  PacketAllocator::Deallocate (block, 100);
+  s_threadStatistics = PacketAllocator::GetStatistics (3);
+}
+
+void
+PacketAllocatorTestCase::DoRun (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (PacketAllocator::GetBlockSize (1), 16, "Wrong block size");
+  NS_TEST_EXPECT_MSG_EQ (PacketAllocator::GetBlockSize (16), 16, "Wrong block size");
+  NS_TEST_EXPECT_MSG_EQ (PacketAllocator::GetBlockSize (100), 128, "Wrong block size");
+  NS_TEST_EXPECT_MSG_EQ (PacketAllocator::GetBlockSize (4096), 4096, "Wrong block size");
+  NS_TEST_EXPECT_MSG_EQ (PacketAllocator::GetBlockSize (5000), 5000, "Larger blocks are not rounded");
+
+  // the 128-byte class: a released block is handed out again.
+  PacketAllocator::Purge ();
+  PacketAllocator::Statistics before = PacketAllocator::GetStatistics (3);
+  NS_TEST_EXPECT_MSG_EQ (before.blockSize, 128, "Wrong class");
+  void *block = PacketAllocator::Allocate (100);
+  PacketAllocator::Deallocate (block, 100);
+  PacketAllocator::Statistics released = PacketAllocator::GetStatistics (3);
+  NS_TEST_EXPECT_MSG_EQ (released.cached, 1, "The block was not cached");
+  void *again = PacketAllocator::Allocate (128);
+  NS_TEST_EXPECT_MSG_EQ (again, block, "The cached block was not reused");
+  PacketAllocator::Statistics after = PacketAllocator::GetStatistics (3);
+  NS_TEST_EXPECT_MSG_EQ (after.allocations - before.allocations, 2, "Wrong allocation count");
+  NS_TEST_EXPECT_MSG_EQ (after.reuses - before.reuses, 1, "Wrong reuse count");
+  NS_TEST_EXPECT_MSG_EQ (after.deallocations - before.deallocations, 1, "Wrong deallocation count");
+  NS_TEST_EXPECT_MSG_EQ (after.cached, 0, "The block is still cached");
+  PacketAllocator::Deallocate (again, 128);
+
+  // larger blocks are never cached.
+  before = PacketAllocator::GetStatistics (PacketAllocator::N_CLASSES);
+  block = PacketAllocator::Allocate (10000);
+  PacketAllocator::Deallocate (block, 10000);
+  after = PacketAllocator::GetStatistics (PacketAllocator::N_CLASSES);
+  NS_TEST_EXPECT_MSG_EQ (after.blockSize, 0, "Wrong class");
+  NS_TEST_EXPECT_MSG_EQ (after.allocations - before.allocations, 1, "Wrong allocation count");
+  NS_TEST_EXPECT_MSG_EQ (after.cached, 0, "A large block was cached");
+
+  // the memory of a released packet is reused by the next one.
+  Create<Packet> (1000);
+  uint64_t reuses = 0;
+  for (uint32_t i = 0; i < PacketAllocator::N_CLASSES; i++)
+    {
+      reuses += PacketAllocator::GetStatistics (i).reuses;
+    }
+  Ptr<Packet> p = Create<Packet> (1000);
+  Ptr<Packet> copy = p->Copy ();
+  uint64_t reusesAfter = 0;
+  for (uint32_t i = 0; i < PacketAllocator::N_CLASSES; i++)
+    {
+      reusesAfter += PacketAllocator::GetStatistics (i).reuses;
+    }
+  NS_TEST_EXPECT_MSG_GT (reusesAfter, reuses, "The memory of the packets was not reused");
+
+  // a small packet does not take the block of a large one released
+  // before it.
+  Create<Packet> (100)->AddPaddingAtEnd (3000);
+  before = PacketAllocator::GetStatistics (PacketAllocator::N_CLASSES - 1);
+  Ptr<Packet> small = Create<Packet> (100);
+  after = PacketAllocator::GetStatistics (PacketAllocator::N_CLASSES - 1);
+  NS_TEST_EXPECT_MSG_EQ (after.allocations, before.allocations, "A small packet took a 4096-byte block");
+
+#ifdef HAVE_PTHREAD_H
+  // the free lists of another thread are its own, and released when
+  // it exits.
+  PacketAllocator::Purge ();
+  before = PacketAllocator::GetStatistics (3);
+  int64_t freeBlocks = MemoryAccounting::GetObjects ("ns3::PacketAllocator::FreeBlock");
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&PacketAllocatorTestCase::AllocateInThread));
+  thread->Start ();
+  thread->Join ();
+  NS_TEST_EXPECT_MSG_EQ (s_threadStatistics.allocations, 1, "The thread shares the statistics");
+  NS_TEST_EXPECT_MSG_EQ (s_threadStatistics.cached, 1, "The thread did not cache its block");
+  after = PacketAllocator::GetStatistics (3);
+  NS_TEST_EXPECT_MSG_EQ (after.allocations, before.allocations, "The thread allocated from this one");
+  NS_TEST_EXPECT_MSG_EQ (after.cached, 0, "The thread cached its block in this one");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetObjects ("ns3::PacketAllocator::FreeBlock"), freeBlocks,
+                         "The free blocks of the thread were not released at its exit");
+#endif /* HAVE_PTHREAD_H */
+
+  std::ostringstream os;
+  PacketAllocator::PrintStatistics (os);
+  NS_TEST_EXPECT_MSG_NE (os.str ().find ("\n128 "), std::string::npos, "No line for the 128-byte class in\n" << os.str ());
+  PacketAllocator::Purge ();
+}
+
+class PacketAllocatorTestSuite : public TestSuite
+{
+public:
+  PacketAllocatorTestSuite ()
+    : TestSuite ("packet-allocator", UNIT)
+  {
+    AddTestCase (new PacketAllocatorTestCase, TestCase::QUICK);
+  }
+} g_packetAllocatorTestSuite;
@@ -252,16 +252,21 @@ HistoryTrailer<N>::Deserialize (Buffer::Iterator start)
 
 class PacketMetadataTest : public TestCase {
 public:
-  PacketMetadataTest ();
+  /**
+   * \param compact Whether to use the compact representation.
+   */
+  PacketMetadataTest (bool compact);
   virtual ~PacketMetadataTest ();
   void CheckHistory (Ptr<Packet> p, const char *file, int line, uint32_t n, ...);
   virtual void DoRun (void);
 private:
   Ptr<Packet> DoAddHeader (Ptr<Packet> p);
+  bool m_compact;
 };
 
-PacketMetadataTest::PacketMetadataTest ()
-  : TestCase ("Packet metadata")
+PacketMetadataTest::PacketMetadataTest (bool compact)
+  : TestCase (compact ? "Compact packet metadata" : "Packet metadata"),
+    m_compact (compact)
 {
 }
 
@@ -399,6 +404,10 @@ void
 PacketMetadataTest::DoRun (void)
 {
   PacketMetadata::Enable ();
+  if (m_compact)
+    {
+      PacketMetadata::EnableCompact ();
+    }
 
   Ptr<Packet> p = Create<Packet> (0);
   Ptr<Packet> p1 = Create<Packet> (0);
@@ -821,6 +830,29 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // more items than the compact representation can hold.
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_HEADER (p, 2);
+  ADD_TRAILER (p, 3);
+  ADD_HEADER (p, 4);
+  ADD_HEADER (p, 5);
+  p1 = p->Copy ();
+  CHECK_HISTORY (p1, 6, 5, 4, 2, 1, 10, 3);
+  ADD_HEADER (p, 6);
+  ADD_TRAILER (p, 7);
+  CHECK_HISTORY (p, 8, 6, 5, 4, 2, 1, 10, 3, 7);
+  CHECK_HISTORY (p1, 6, 5, 4, 2, 1, 10, 3);
+  REM_HEADER (p, 6);
+  REM_TRAILER (p, 7);
+  REM_HEADER (p, 5);
+  CHECK_HISTORY (p, 5, 4, 2, 1, 10, 3);
+  p->RemoveAtStart (6);
+  p->RemoveAtEnd (3);
+  CHECK_HISTORY (p, 2, 1, 10);
+
+  PacketMetadata::DisableCompact ();
 }
 //-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
@@ -832,7 +864,8 @@ public:
 PacketMetadataTestSuite::PacketMetadataTestSuite ()
   : TestSuite ("packet-metadata", UNIT)
 {
-  AddTestCase (new PacketMetadataTest, TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (false), TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (true), TestCase::QUICK);
 }
 
 PacketMetadataTestSuite g_packetMetadataTest;
@@ -582,6 +582,37 @@ PacketTest::DoRun (void)
     tmp->AddPaddingAtEnd (50);
     CHECK (tmp, 1, E (25, 0, 50));
   }
+
+  /* Test DeepCopy: same content, nothing shared with the original. */
+  {
+    Ptr<Packet> tmp = Create<Packet> (reinterpret_cast<const uint8_t*> ("hello"), 5);
+    tmp->AddHeader (ATestHeader<10> ());
+    tmp->AddTrailer (ATestTrailer<20> ());
+    tmp->AddByteTag (ATestTag<25> ());
+    tmp->AddPacketTag (ATestTag<3> ());
+    Ptr<Packet> deep = tmp->DeepCopy ();
+    NS_TEST_EXPECT_MSG_EQ (deep->GetUid (), tmp->GetUid (), "DeepCopy changed the uid");
+    NS_TEST_EXPECT_MSG_EQ (deep->GetSize (), 35, "DeepCopy changed the size");
+    CHECK (deep, 1, E (25, 0, 35));
+    ATestTag<3> tag;
+    NS_TEST_EXPECT_MSG_EQ (deep->PeekPacketTag (tag), true, "DeepCopy lost the packet tag");
+
+    tmp->AddByteTag (ATestTag<26> ());
+    tmp->RemovePacketTag (tag);
+    CHECK (deep, 1, E (25, 0, 35));
+    NS_TEST_EXPECT_MSG_EQ (deep->PeekPacketTag (tag), true, "The packet tag was shared");
+
+    ATestHeader<10> header;
+    deep->RemoveHeader (header);
+    NS_TEST_EXPECT_MSG_EQ (header.m_error, false, "DeepCopy damaged the header");
+    ATestTrailer<20> trailer;
+    deep->RemoveTrailer (trailer);
+    NS_TEST_EXPECT_MSG_EQ (trailer.m_error, false, "DeepCopy damaged the trailer");
+    uint8_t buf[5];
+    deep->CopyData (buf, 5);
+    NS_TEST_EXPECT_MSG_EQ (std::string (reinterpret_cast<const char *> (buf), 5), "hello", "DeepCopy changed the data");
+    NS_TEST_EXPECT_MSG_EQ (tmp->GetSize (), 35, "The data was shared");
+  }
 }
 //--------------------------------------
 class PacketTagListTest : public TestCase
@@ -0,0 +1,261 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator-partition-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+
+#include <set>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Two sites of four nodes, each on a fast shared channel, joined by a
+ * slow channel: the sites must end up in different partitions, with
+ * the slow channel setting the look-ahead.
+ */
+class SimulatorPartitionHelperTestCase : public TestCase
+{
+public:
+  SimulatorPartitionHelperTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+SimulatorPartitionHelperTestCase::SimulatorPartitionHelperTestCase ()
+  : TestCase ("Check the partitioning of two sites")
+{
+}
+
+void
+SimulatorPartitionHelperTestCase::DoRun (void)
+{
+  NodeContainer siteA;
+  siteA.Create (4);
+  NodeContainer siteB;
+  siteB.Create (4);
+
+  SimpleNetDeviceHelper lan;
+  lan.SetChannelAttribute ("Delay", StringValue ("1us"));
+  lan.Install (siteA);
+  lan.Install (siteB);
+
+  SimpleNetDeviceHelper backbone;
+  backbone.SetChannelAttribute ("Delay", StringValue ("10ms"));
+  backbone.Install (NodeContainer (siteA.Get (0), siteB.Get (0)));
+
+  NodeContainer all (siteA, siteB);
+  SimulatorPartitionHelper helper;
+  helper.Compute (all);
+  for (uint32_t i = 0; i < all.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (helper.GetPartition (all.Get (i)), 0, "Node " << i << " not in the only partition");
+    }
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLookAhead (), Seconds (0), "Unexpected look-ahead with one partition");
+
+  helper.SetPartitionCount (2);
+  helper.Compute (all);
+  uint32_t a = helper.GetPartition (siteA.Get (0));
+  uint32_t b = helper.GetPartition (siteB.Get (0));
+  NS_TEST_EXPECT_MSG_NE (a, b, "Both sites in the same partition");
+  for (uint32_t i = 1; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (helper.GetPartition (siteA.Get (i)), a, "Site A split");
+      NS_TEST_EXPECT_MSG_EQ (helper.GetPartition (siteB.Get (i)), b, "Site B split");
+    }
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLookAhead (), MilliSeconds (10), "Look-ahead is not the backbone delay");
+
+  // With four partitions the sites are too large: the LANs get cut too.
+  helper.SetPartitionCount (4);
+  helper.Compute (all);
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLookAhead (), MicroSeconds (1), "Look-ahead is not the LAN delay");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Two nodes, split by SimulatorPartitionHelper::Install() into two
+ * partitions, send packets to each other over a channel: every packet
+ * arrives intact, and the packet uids allocated by the two threads do
+ * not collide.
+ */
+class SimulatorPartitionTrafficTestCase : public TestCase
+{
+public:
+  SimulatorPartitionTrafficTestCase ();
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  /**
+   * \param [in] node The index of a node.
+   * \param [in] seq The sequence number of a packet.
+   * \param [in] offset The offset of a byte in the packet.
+   * \return The byte sent by the node at the offset of the packet.
+   */
+  static uint8_t GetByte (uint32_t node, uint32_t seq, uint32_t offset);
+  /**
+   * Send a packet to the other node.
+   * \param [in] node The index of the sending node.
+   * \param [in] seq The sequence number of the packet.
+   */
+  void Send (uint32_t node, uint32_t seq);
+  /**
+   * Receive a packet from the other node.
+   * \param [in] device The receiving device.
+   * \param [in] packet The packet.
+   * \param [in] protocol The protocol number.
+   * \param [in] from The sender address.
+   * \return \c true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                uint16_t protocol, const Address &from);
+
+  /** The number of packets sent by each node. */
+  static const uint32_t N_PACKETS = 200;
+
+  NodeContainer m_nodes;          //!< The two nodes.
+  NetDeviceContainer m_devices;   //!< Their devices.
+  Address m_address[2];           //!< The addresses of the devices.
+  std::vector<uint64_t> m_sent[2];     //!< The uids sent by each node.
+  std::vector<uint64_t> m_received[2]; //!< The uids received by each node.
+  uint32_t m_corrupted[2];        //!< Packets received with wrong data by each node.
+  uint32_t m_systemId[2];         //!< The system id seen by the receive events of each node.
+};
+
+SimulatorPartitionTrafficTestCase::SimulatorPartitionTrafficTestCase ()
+  : TestCase ("Check the traffic between two partitions")
+{
+}
+
+uint8_t
+SimulatorPartitionTrafficTestCase::GetByte (uint32_t node, uint32_t seq, uint32_t offset)
+{
+  return (seq * 7 + offset + node * 101) & 0xff;
+}
+
+void
+SimulatorPartitionTrafficTestCase::Send (uint32_t node, uint32_t seq)
+{
+  std::vector<uint8_t> data (100 + seq);
+  for (uint32_t i = 0; i < data.size (); i++)
+    {
+      data[i] = GetByte (node, seq, i);
+    }
+  Ptr<Packet> p = Create<Packet> (&data[0], data.size ());
+  m_sent[node].push_back (p->GetUid ());
+  // The other device belongs to the other partition: do not copy a Ptr
+  // to it.
+  Ptr<NetDevice> device = m_devices.Get (node);
+  device->Send (p, m_address[1 - node], 0x800);
+}
+
+bool
+SimulatorPartitionTrafficTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                            uint16_t protocol, const Address &from)
+{
+  uint32_t node = device->GetAddress () == m_address[0] ? 0 : 1;
+  uint32_t seq = m_received[node].size ();
+  m_received[node].push_back (packet->GetUid ());
+  m_systemId[node] = Simulator::GetSystemId ();
+  std::vector<uint8_t> data (packet->GetSize ());
+  packet->CopyData (&data[0], data.size ());
+  bool ok = data.size () == 100 + seq;
+  for (uint32_t i = 0; ok && i < data.size (); i++)
+    {
+      ok = data[i] == GetByte (1 - node, seq, i);
+    }
+  if (!ok)
+    {
+      m_corrupted[node]++;
+    }
+  return true;
+}
+
+void
+SimulatorPartitionTrafficTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  m_nodes.Create (2);
+  SimpleNetDeviceHelper link;
+  link.SetNetDevicePointToPointMode (true);
+  link.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  m_devices = link.Install (m_nodes);
+  SimulatorPartitionHelper helper;
+  helper.SetPartitionCount (2);
+  helper.Install (m_nodes);
+  NS_TEST_ASSERT_MSG_EQ (helper.GetLookAhead (), MilliSeconds (1), "The link must set the look-ahead");
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (helper.GetPartition (m_nodes.Get (i)), i, "Node " << i << " in the wrong partition");
+      NS_TEST_ASSERT_MSG_EQ (m_nodes.Get (i)->GetSystemId (), i, "Node " << i << " system id is not its partition");
+      m_address[i] = m_devices.Get (i)->GetAddress ();
+      m_devices.Get (i)->SetReceiveCallback (MakeCallback (&SimulatorPartitionTrafficTestCase::Receive, this));
+      m_corrupted[i] = 0;
+      m_systemId[i] = 0xffffffff;
+    }
+  // both nodes send at the same times, several packets per window.
+  for (uint32_t seq = 0; seq < N_PACKETS; seq++)
+    {
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          Simulator::ScheduleWithContext (m_nodes.Get (i)->GetId (), MicroSeconds (250 * seq),
+                                          &SimulatorPartitionTrafficTestCase::Send, this, i, seq);
+        }
+    }
+  Simulator::Run ();
+
+  std::set<uint64_t> uids;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i].size (), N_PACKETS, "Node " << i << " lost packets");
+      NS_TEST_EXPECT_MSG_EQ (m_corrupted[i], 0, "Node " << i << " received corrupted packets");
+      NS_TEST_EXPECT_MSG_EQ (m_systemId[i], i, "Node " << i << " does not run on its partition");
+      NS_TEST_EXPECT_MSG_EQ ((m_received[1 - i] == m_sent[i]), true, "Node " << i << " packets changed uid");
+      uids.insert (m_sent[i].begin (), m_sent[i].end ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (uids.size (), 2 * N_PACKETS, "The partitions allocated the same packet uids");
+  Simulator::Destroy ();
+}
+
+void
+SimulatorPartitionTrafficTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+class SimulatorPartitionHelperTestSuite : public TestSuite
+{
+public:
+  SimulatorPartitionHelperTestSuite ();
+};
+
+SimulatorPartitionHelperTestSuite::SimulatorPartitionHelperTestSuite ()
+  : TestSuite ("simulator-partition-helper", UNIT)
+{
+  AddTestCase (new SimulatorPartitionHelperTestCase, TestCase::QUICK);
+  AddTestCase (new SimulatorPartitionTrafficTestCase, TestCase::QUICK);
+}
+
+static SimulatorPartitionHelperTestSuite g_simulatorPartitionHelperTestSuite;
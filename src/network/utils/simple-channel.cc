@@ -57,9 +57,14 @@ SimpleChannel::Send (Ptr<Packet> p, uint16_t protocol,
                      Ptr<SimpleNetDevice> sender)
 {
   NS_LOG_FUNCTION (this << p << protocol << to << from << sender);
-  for (std::vector<Ptr<SimpleNetDevice> >::const_iterator i = m_devices.begin (); i != m_devices.end (); ++i)
+  uint32_t systemId = sender->GetNode ()->GetSystemId ();
+  for (uint32_t j = 0; j < m_devices.size (); ++j)
     {
-      Ptr<SimpleNetDevice> tmp = *i;
+      // The receivers may belong to another partition of a
+      // MultithreadedSimulatorImpl, whose thread updates the reference
+      // counts of its devices and nodes: refer to them without copying
+      // their Ptr.
+      const Ptr<SimpleNetDevice> &tmp = m_devices[j];
       if (tmp == sender)
         {
           continue;
@@ -72,8 +77,14 @@ SimpleChannel::Send (Ptr<Packet> p, uint16_t protocol,
               continue;
             }
         }
-      Simulator::ScheduleWithContext (tmp->GetNode ()->GetId (), m_delay,
-                                      &SimpleNetDevice::Receive, tmp, p->Copy (), protocol, to, from);
+      if (m_nodes[j] == 0)
+        {
+          m_nodes[j] = tmp->GetNode ();
+        }
+      const Ptr<Node> &node = m_nodes[j];
+      Ptr<Packet> copy = node->GetSystemId () == systemId ? p->Copy () : p->DeepCopy ();
+      Simulator::ScheduleWithContext (node->GetId (), m_delay,
+                                      &SimpleNetDevice::Receive, PeekPointer (tmp), copy, protocol, to, from);
     }
 }
 
@@ -82,6 +93,7 @@ SimpleChannel::Add (Ptr<SimpleNetDevice> device)
 {
   NS_LOG_FUNCTION (this << device);
   m_devices.push_back (device);
+  m_nodes.push_back (device->GetNode ());
 }
 
 uint32_t
@@ -29,6 +29,7 @@
 namespace ns3 {
 
 class SimpleNetDevice;
+class Node;
 class Packet;
 
 /**
@@ -100,6 +101,7 @@ public:
 private:
   Time m_delay; //!< The assigned speed-of-light delay of the channel
   std::vector<Ptr<SimpleNetDevice> > m_devices; //!< devices connected by the channel
+  std::vector<Ptr<Node> > m_nodes; //!< nodes of the devices, looked up at their first packet if not known when added
   std::map<Ptr<SimpleNetDevice>, std::vector<Ptr<SimpleNetDevice> > > m_blackListedDevices; //!< devices blocked on a device
 };
 
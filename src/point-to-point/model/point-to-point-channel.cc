@@ -20,6 +20,7 @@
 #include "point-to-point-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
+#include "ns3/node.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 
@@ -78,6 +79,8 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
     {
       m_link[0].m_dst = m_link[1].m_src;
       m_link[1].m_dst = m_link[0].m_src;
+      m_link[0].m_dstNode = m_link[0].m_dst->GetNode ();
+      m_link[1].m_dstNode = m_link[1].m_dst->GetNode ();
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
     }
@@ -97,12 +100,25 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  // The receiver may belong to another partition of a
+  // MultithreadedSimulatorImpl, whose thread updates the reference counts
+  // of its device and node: refer to them without copying their Ptr, and
+  // hand it a packet that shares no data with the sender.
+  if (m_link[wire].m_dstNode == 0)
+    {
+      m_link[wire].m_dstNode = m_link[wire].m_dst->GetNode ();
+    }
+  const Ptr<Node> &node = m_link[wire].m_dstNode;
+  Ptr<Packet> packet = node->GetSystemId () == src->GetNode ()->GetSystemId () ? p : p->DeepCopy ();
+  Simulator::ScheduleWithContext (node->GetId (),
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+                                  PeekPointer (m_link[wire].m_dst), packet);
 
   // Call the tx anim callback on the net device
-  m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+  if (!m_txrxPointToPoint.IsEmpty ())
+    {
+      m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+    }
   return true;
 }
 
@@ -29,6 +29,7 @@
 namespace ns3 {
 
 class PointToPointNetDevice;
+class Node;
 class Packet;
 
 /**
@@ -194,11 +195,12 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0), m_dstNode (0) {}
 
     WireState                  m_state; //!< State of the link
     Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
     Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    Ptr<Node>                  m_dstNode; //!< Node of the second NetDevice, looked up at the first packet if not known at Attach
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
@@ -18,11 +18,22 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include "ns3/core-config.h"
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/point-to-point-helper.h"
+#include "ns3/simulator-partition-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+
+#include <vector>
+#endif /* HAVE_PTHREAD_H */
 
 using namespace ns3;
 
@@ -93,6 +104,133 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+#ifdef HAVE_PTHREAD_H
+/**
+ * \brief Test the PointToPointChannel between two partitions
+ *
+ * Two nodes, split by SimulatorPartitionHelper into the two partitions
+ * of a MultithreadedSimulatorImpl, send packets to each other at the
+ * same times: each must receive all the packets of the other, intact
+ * and in order.
+ */
+class PointToPointPartitionTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointPartitionTest ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Send a packet to the other node
+   *
+   * \param node index of the sending node
+   * \param seq sequence number of the packet
+   */
+  void Send (uint32_t node, uint32_t seq);
+  /**
+   * \brief Receive a packet from the other node
+   *
+   * \param device receiving NetDevice
+   * \param packet received packet
+   * \param protocol protocol number of the packet
+   * \param from sender address
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                uint16_t protocol, const Address &from);
+
+  /** Number of packets sent by each node. */
+  static const uint32_t N_PACKETS = 100;
+
+  NetDeviceContainer m_devices; //!< The devices of the two nodes
+  Address m_address[2];         //!< The addresses of the devices
+  uint32_t m_received[2];       //!< Number of packets received by each node
+  uint32_t m_corrupted[2];      //!< Number of packets received damaged or out of order by each node
+};
+
+PointToPointPartitionTest::PointToPointPartitionTest ()
+  : TestCase ("PointToPoint between two partitions")
+{
+}
+
+void
+PointToPointPartitionTest::Send (uint32_t node, uint32_t seq)
+{
+  std::vector<uint8_t> data (100 + seq, (uint8_t)(seq + node));
+  // The other device belongs to the other partition: only its address
+  // is used.
+  Ptr<NetDevice> device = m_devices.Get (node);
+  device->Send (Create<Packet> (&data[0], data.size ()), m_address[1 - node], 0x800);
+}
+
+bool
+PointToPointPartitionTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                    uint16_t protocol, const Address &from)
+{
+  uint32_t node = device->GetAddress () == m_address[0] ? 0 : 1;
+  uint32_t seq = m_received[node]++;
+  std::vector<uint8_t> data (packet->GetSize ());
+  packet->CopyData (&data[0], data.size ());
+  if (data != std::vector<uint8_t> (100 + seq, (uint8_t)(seq + 1 - node)))
+    {
+      m_corrupted[node]++;
+    }
+  return true;
+}
+
+void
+PointToPointPartitionTest::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  m_devices = link.Install (nodes);
+
+  SimulatorPartitionHelper helper;
+  helper.SetPartitionCount (2);
+  helper.Install (nodes);
+  NS_TEST_ASSERT_MSG_EQ (helper.GetLookAhead (), MilliSeconds (1), "The link must set the look-ahead");
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NS_TEST_ASSERT_MSG_NE (helper.GetPartition (nodes.Get (i)), helper.GetPartition (nodes.Get (1 - i)),
+                             "The nodes share a partition");
+      m_address[i] = m_devices.Get (i)->GetAddress ();
+      m_devices.Get (i)->SetReceiveCallback (MakeCallback (&PointToPointPartitionTest::Receive, this));
+      m_received[i] = 0;
+      m_corrupted[i] = 0;
+      for (uint32_t seq = 0; seq < N_PACKETS; seq++)
+        {
+          Simulator::ScheduleWithContext (nodes.Get (i)->GetId (), MicroSeconds (250 * seq),
+                                          &PointToPointPartitionTest::Send, this, i, seq);
+        }
+    }
+
+  Simulator::Run ();
+
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], N_PACKETS, "Node " << i << " lost packets");
+      NS_TEST_EXPECT_MSG_EQ (m_corrupted[i], 0, "Node " << i << " received damaged packets");
+    }
+  Simulator::Destroy ();
+}
+
+void
+PointToPointPartitionTest::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+#endif /* HAVE_PTHREAD_H */
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -109,6 +247,9 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new PointToPointPartitionTest, TestCase::QUICK);
+#endif /* HAVE_PTHREAD_H */
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Measure the cost, in time and in heap allocations, of creating and
+ * invoking callbacks and of scheduling events, as done for every hop of
+ * a simulated packet.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <new>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/** Number of calls to the global operator new. */
+static uint64_t g_allocations = 0;
+
+void *
+operator new (std::size_t size)
+{
+  g_allocations++;
+  void *p = std::malloc (size ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p)
+{
+  std::free (p);
+}
+
+namespace {
+
+/** A receiver, as found in a model. */
+class BenchReceiver
+{
+public:
+  BenchReceiver () : m_sum (0) {}
+  /**
+   * Receive a "packet".
+   * \param [in] value The packet.
+   */
+  void Receive (uint32_t value) { m_sum += value; }
+  /**
+   * Receive a "packet" with a context.
+   * \param [in] context The bound context.
+   * \param [in] value The packet.
+   */
+  void ReceiveFrom (uint32_t context, uint32_t value) { m_sum += context + value; }
+  /**
+   * Forward a "packet" until its hop count runs out.
+   * \param [in] hops The remaining hop count.
+   */
+  void Hop (uint32_t hops)
+  {
+    m_sum++;
+    if (hops > 0)
+      {
+        Simulator::Schedule (MicroSeconds (1), &BenchReceiver::Hop, this, hops - 1);
+      }
+  }
+  /** The sum of the received values. */
+  uint64_t m_sum;
+};
+
+/**
+ * Print a measurement.
+ *
+ * \param [in] name The label to print.
+ * \param [in] ms The elapsed time.
+ * \param [in] allocations The number of heap allocations.
+ * \param [in] count The number of operations.
+ */
+void
+Print (const std::string &name, uint64_t ms, uint64_t allocations, uint32_t count)
+{
+  double rate = ms ? (count / (ms / 1000.0)) : 0.0;
+  std::cout << std::left << std::setw (12) << name
+            << " ms=" << ms
+            << " ops/s=" << rate
+            << " allocs/op=" << (double) allocations / count
+            << std::endl;
+}
+
+/**
+ * Time \p count MakeCallback, invoke and release.
+ * \param [in] receiver The receiver.
+ * \param [in] count The number of callbacks.
+ */
+void
+RunMakeCallback (BenchReceiver *receiver, uint32_t count)
+{
+  SystemWallClockMs time;
+  uint64_t allocations = g_allocations;
+  time.Start ();
+  for (uint32_t i = 0; i < count; i++)
+    {
+      Callback<void, uint32_t> cb = MakeCallback (&BenchReceiver::Receive, receiver);
+      cb (i);
+    }
+  Print ("make", time.End (), g_allocations - allocations, count);
+}
+
+/**
+ * Time \p count Bind, invoke and release.
+ * \param [in] receiver The receiver.
+ * \param [in] count The number of callbacks.
+ */
+void
+RunBind (BenchReceiver *receiver, uint32_t count)
+{
+  Callback<void, uint32_t, uint32_t> base = MakeCallback (&BenchReceiver::ReceiveFrom, receiver);
+  SystemWallClockMs time;
+  uint64_t allocations = g_allocations;
+  time.Start ();
+  Callback<void, uint32_t> cb;
+  for (uint32_t i = 0; i < count; i++)
+    {
+      cb = base.Bind (i);
+      cb (i);
+    }
+  Print ("bind", time.End (), g_allocations - allocations, count);
+}
+
+/**
+ * Time \p count events, forwarded from hop to hop.
+ * \param [in] receiver The receiver.
+ * \param [in] count The number of events.
+ */
+void
+RunSchedule (BenchReceiver *receiver, uint32_t count)
+{
+  // warm up the event list
+  Simulator::Schedule (MicroSeconds (1), &BenchReceiver::Hop, receiver, 1000);
+  Simulator::Run ();
+
+  SystemWallClockMs time;
+  uint64_t allocations = g_allocations;
+  time.Start ();
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &BenchReceiver::Hop, receiver, count / 16);
+    }
+  Simulator::Run ();
+  Print ("schedule", time.End (), g_allocations - allocations, count);
+  Simulator::Destroy ();
+}
+
+} // unnamed namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t count = 10000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("count", "number of operations per measurement", count);
+  cmd.Parse (argc, argv);
+
+  BenchReceiver receiver;
+  RunMakeCallback (&receiver, count);
+  RunBind (&receiver, count);
+  RunSchedule (&receiver, count);
+  std::cout << "checksum=" << receiver.m_sum << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Measure the cost of the header manipulations a packet goes through
+ * when it is forwarded by routers and rewritten by a NAT node: each hop
+ * removes and adds the IPv4 header, and the NAT node also removes and
+ * adds the transport header.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/tcp-header.h"
+
+using namespace ns3;
+
+namespace {
+
+/** Source address of the packets. */
+const Ipv4Address g_source ("10.1.1.1");
+/** Destination address of the packets. */
+const Ipv4Address g_destination ("10.2.2.2");
+/** Public address of the NAT node. */
+const Ipv4Address g_public ("192.168.1.1");
+
+/**
+ * Print a measurement.
+ *
+ * \param [in] name The label to print.
+ * \param [in] ms The elapsed time.
+ * \param [in] count The number of packets.
+ */
+void
+Print (const std::string &name, uint64_t ms, uint32_t count)
+{
+  double rate = ms ? (count / (ms / 1000.0)) : 0.0;
+  std::cout << std::left << std::setw (12) << name
+            << " ms=" << ms
+            << " packets/s=" << rate
+            << std::endl;
+}
+
+/**
+ * Forward a packet through a router.
+ * \param [in] p The packet.
+ * \param [in] checksum Whether checksums are enabled.
+ */
+void
+Forward (Ptr<Packet> p, bool checksum)
+{
+  Ipv4Header ipv4;
+  if (checksum)
+    {
+      ipv4.EnableChecksum ();
+    }
+  p->RemoveHeader (ipv4);
+  NS_ABORT_IF (checksum && !ipv4.IsChecksumOk ());
+  ipv4.SetTtl (ipv4.GetTtl () - 1);
+  p->AddHeader (ipv4);
+}
+
+/**
+ * Clear the received checksum of a header, so that it is computed
+ * again when the header is added back.
+ * \param [in,out] udp The header.
+ */
+void
+ClearChecksum (UdpHeader &udp)
+{
+  udp.ForceChecksum (0);
+}
+
+/**
+ * Clear the received checksum of a header; TcpHeader never keeps it.
+ */
+void
+ClearChecksum (TcpHeader &)
+{
+}
+
+/**
+ * Rewrite the source of a packet through a NAT node.
+ * \tparam H The transport header.
+ * \param [in] p The packet.
+ * \param [in] checksum Whether checksums are enabled.
+ */
+template <typename H>
+void
+Translate (Ptr<Packet> p, bool checksum)
+{
+  Ipv4Header ipv4;
+  H l4;
+  if (checksum)
+    {
+      ipv4.EnableChecksum ();
+      l4.EnableChecksums ();
+    }
+  p->RemoveHeader (ipv4);
+  l4.InitializeChecksum (ipv4.GetSource (), ipv4.GetDestination (), ipv4.GetProtocol ());
+  p->RemoveHeader (l4);
+  NS_ABORT_IF (checksum && !l4.IsChecksumOk ());
+  ClearChecksum (l4);
+  ipv4.SetSource (g_public);
+  l4.SetSourcePort (l4.GetSourcePort () + 1);
+  l4.InitializeChecksum (ipv4.GetSource (), ipv4.GetDestination (), ipv4.GetProtocol ());
+  p->AddHeader (l4);
+  p->AddHeader (ipv4);
+}
+
+/**
+ * Time \p count packets through a NAT node and \p hops routers.
+ *
+ * \tparam H The transport header.
+ * \param [in] name The label to print.
+ * \param [in] protocol The IP protocol number of \p H.
+ * \param [in] count The number of packets.
+ * \param [in] hops The number of routers.
+ * \param [in] size The payload size.
+ * \param [in] checksum Whether checksums are enabled.
+ */
+template <typename H>
+void
+Run (const std::string &name, uint8_t protocol, uint32_t count, uint32_t hops, uint32_t size, bool checksum)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < count; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (size);
+      H l4;
+      l4.SetSourcePort (1000);
+      l4.SetDestinationPort (2000);
+      Ipv4Header ipv4;
+      ipv4.SetSource (g_source);
+      ipv4.SetDestination (g_destination);
+      ipv4.SetProtocol (protocol);
+      ipv4.SetTtl (64);
+      if (checksum)
+        {
+          l4.EnableChecksums ();
+          l4.InitializeChecksum (g_source, g_destination, protocol);
+          ipv4.EnableChecksum ();
+        }
+      p->AddHeader (l4);
+      ipv4.SetPayloadSize (p->GetSize ());
+      p->AddHeader (ipv4);
+
+      Translate<H> (p, checksum);
+      for (uint32_t j = 0; j < hops; j++)
+        {
+          Forward (p, checksum);
+        }
+    }
+  Print (name, time.End (), count);
+}
+
+} // unnamed namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t count = 1000000;
+  uint32_t hops = 4;
+  uint32_t size = 512;
+
+  CommandLine cmd;
+  cmd.AddValue ("count", "number of packets per measurement", count);
+  cmd.AddValue ("hops", "number of routers after the NAT node", hops);
+  cmd.AddValue ("size", "payload size", size);
+  cmd.Parse (argc, argv);
+
+  Run<UdpHeader> ("udp", 17, count, hops, size, false);
+  Run<UdpHeader> ("udp-cksum", 17, count, hops, size, true);
+  Run<TcpHeader> ("tcp", 6, count, hops, size, false);
+  Run<TcpHeader> ("tcp-cksum", 6, count, hops, size, true);
+
+  return 0;
+}
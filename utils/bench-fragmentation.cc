@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Measure the throughput of IPv4 fragmentation and reassembly: UDP
+ * datagrams larger than the MTU are sent between two nodes, fragmented
+ * by the sender and reassembled by the receiver.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+namespace {
+
+uint32_t g_received = 0; //!< Number of datagrams received.
+
+/**
+ * Receive the datagrams of a socket.
+ * \param [in] socket The socket.
+ */
+void
+Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      g_received++;
+    }
+}
+
+/**
+ * Send a datagram.
+ * \param [in] socket The socket.
+ * \param [in] packet The datagram.
+ */
+void
+Send (Ptr<Socket> socket, Ptr<Packet> packet)
+{
+  socket->Send (packet->Copy ());
+}
+
+/**
+ * Time the transfer of \p count datagrams.
+ *
+ * \param [in] name The label to print.
+ * \param [in] count The number of datagrams.
+ * \param [in] size The datagram size.
+ * \param [in] mtu The MTU of the link.
+ * \param [in] fill Whether the payload holds real bytes rather than zeros.
+ */
+void
+Run (const std::string &name, uint32_t count, uint32_t size, uint16_t mtu, bool fill)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper link;
+  link.SetNetDevicePointToPointMode (true);
+  link.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (1000));
+  NetDeviceContainer devices = link.Install (nodes);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      devices.Get (i)->SetMtu (mtu);
+    }
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper addresses ("10.0.0.0", "255.255.255.0");
+  addresses.Assign (devices);
+
+  TypeId tid = UdpSocketFactory::GetTypeId ();
+  Ptr<Socket> server = Socket::CreateSocket (nodes.Get (0), tid);
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+  server->SetRecvCallback (MakeCallback (&Receive));
+  Ptr<Socket> client = Socket::CreateSocket (nodes.Get (1), tid);
+  client->Connect (InetSocketAddress (Ipv4Address ("10.0.0.1"), 9));
+
+  Ptr<Packet> packet;
+  if (fill)
+    {
+      std::vector<uint8_t> data (size);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          data[i] = i;
+        }
+      packet = Create<Packet> (&data[0], size);
+    }
+  else
+    {
+      packet = Create<Packet> (size);
+    }
+  // the first datagram resolves the address of the server.
+  Simulator::Schedule (Seconds (0), &Send, client, packet);
+  for (uint32_t i = 0; i < count; i++)
+    {
+      Simulator::Schedule (Seconds (1) + MicroSeconds (i), &Send, client, packet);
+    }
+
+  g_received = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  uint64_t ms = time.End ();
+  Simulator::Destroy ();
+
+  double rate = ms ? (count / (ms / 1000.0)) : 0.0;
+  std::cout << std::left << std::setw (12) << name
+            << " ms=" << ms
+            << " datagrams/s=" << rate
+            << " received=" << g_received - 1
+            << std::endl;
+}
+
+} // unnamed namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t count = 20000;
+  uint32_t size = 9000;
+  uint16_t mtu = 1500;
+
+  CommandLine cmd;
+  cmd.AddValue ("count", "number of datagrams per measurement", count);
+  cmd.AddValue ("size", "datagram size", size);
+  cmd.AddValue ("mtu", "MTU of the link", mtu);
+  cmd.Parse (argc, argv);
+
+  Run ("zeros", count, size, mtu, false);
+  Run ("bytes", count, size, mtu, true);
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (true));
+  Run ("bytes-cksum", count, size, mtu, true);
+
+  return 0;
+}
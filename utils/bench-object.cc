@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Measure the cost of Object::GetObject<T> () on an aggregate which
+ * looks like a typical node: a handful of aggregated objects, some of
+ * them with a deep TypeId parent chain.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <sstream>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+namespace {
+
+/** Common base, so that lookups have a parent chain to climb. */
+class BenchBase : public Object
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("BenchBase")
+      .SetParent<Object> ()
+      .SetGroupName ("Core")
+    ;
+    return tid;
+  }
+};
+
+/**
+ * A distinct aggregate type.
+ *
+ * \tparam N Distinguishes the instantiations.
+ */
+template <int N>
+class BenchObject : public BenchBase
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId (("BenchObject" + IntToString (N)).c_str ())
+      .SetParent<BenchBase> ()
+      .SetGroupName ("Core")
+      .AddConstructor<BenchObject<N> > ()
+    ;
+    return tid;
+  }
+  static std::string IntToString (int n)
+  {
+    std::ostringstream oss;
+    oss << n;
+    return oss.str ();
+  }
+};
+
+/** A type which is never aggregated. */
+class BenchMissing : public BenchBase
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("BenchMissing")
+      .SetParent<BenchBase> ()
+      .SetGroupName ("Core")
+    ;
+    return tid;
+  }
+};
+
+/**
+ * Time \p count lookups of \c T on \p root and print the rate.
+ *
+ * \param [in] name The label to print.
+ * \param [in] root The object to query.
+ * \param [in] count The number of lookups.
+ */
+template <typename T>
+void
+Run (const std::string &name, Ptr<Object> root, uint32_t count)
+{
+  SystemWallClockMs time;
+  uint32_t found = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < count; i++)
+    {
+      if (root->GetObject<T> () != 0)
+        {
+          found++;
+        }
+    }
+  uint64_t ms = time.End ();
+  double rate = ms ? (count / (ms / 1000.0)) : 0.0;
+  std::cout << std::left << std::setw (12) << name
+            << " found=" << found
+            << " ms=" << ms
+            << " lookups/s=" << rate
+            << std::endl;
+}
+
+/**
+ * Time \p count rounds of lookups of four different types on \p root,
+ * which defeats the most-recently-used ordering of the aggregates.
+ *
+ * \param [in] root The object to query.
+ * \param [in] count The number of rounds.
+ */
+void
+RunMixed (Ptr<Object> root, uint32_t count)
+{
+  SystemWallClockMs time;
+  uint32_t found = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < count; i++)
+    {
+      found += (root->GetObject<BenchObject<1> > () != 0);
+      found += (root->GetObject<BenchObject<3> > () != 0);
+      found += (root->GetObject<BenchObject<5> > () != 0);
+      found += (root->GetObject<BenchObject<7> > () != 0);
+    }
+  uint64_t ms = time.End ();
+  double rate = ms ? (4.0 * count / (ms / 1000.0)) : 0.0;
+  std::cout << std::left << std::setw (12) << "mixed"
+            << " found=" << found
+            << " ms=" << ms
+            << " lookups/s=" << rate
+            << std::endl;
+}
+
+} // unnamed namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t count = 10000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("count", "number of lookups per measurement", count);
+  cmd.Parse (argc, argv);
+
+  Ptr<Object> root = CreateObject<BenchObject<0> > ();
+  root->AggregateObject (CreateObject<BenchObject<1> > ());
+  root->AggregateObject (CreateObject<BenchObject<2> > ());
+  root->AggregateObject (CreateObject<BenchObject<3> > ());
+  root->AggregateObject (CreateObject<BenchObject<4> > ());
+  root->AggregateObject (CreateObject<BenchObject<5> > ());
+  root->AggregateObject (CreateObject<BenchObject<6> > ());
+  root->AggregateObject (CreateObject<BenchObject<7> > ());
+
+  Run<BenchObject<0> > ("first", root, count);
+  Run<BenchObject<7> > ("last", root, count);
+  Run<BenchMissing> ("missing", root, count);
+  RunMixed (root, count / 4);
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Measure the cost of drawing random values one at a time with
+ * GetValue () and in bulk with GetValues ().
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+namespace {
+
+/** Sink which keeps the compiler from discarding the values. */
+double g_sum = 0;
+
+/**
+ * Print a measurement.
+ *
+ * \param [in] name The label to print.
+ * \param [in] ms The elapsed time.
+ * \param [in] count The number of values.
+ */
+void
+Print (const std::string &name, uint64_t ms, uint32_t count)
+{
+  double rate = ms ? (count / (ms / 1000.0)) : 0.0;
+  std::cout << std::left << std::setw (20) << name
+            << " ms=" << ms
+            << " values/s=" << rate
+            << std::endl;
+}
+
+/**
+ * Time \p count values drawn from \p rng, one at a time and then in
+ * batches of \p batch values.
+ *
+ * \param [in] name The distribution name.
+ * \param [in] rng The random variable.
+ * \param [in] count The number of values.
+ * \param [in] batch The batch size.
+ */
+void
+Run (const std::string &name, Ptr<RandomVariableStream> rng, uint32_t count, uint32_t batch)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < count; i++)
+    {
+      g_sum += rng->GetValue ();
+    }
+  Print (name + "-scalar", time.End (), count);
+
+  std::vector<double> values (batch);
+  time.Start ();
+  for (uint32_t i = 0; i < count; i += batch)
+    {
+      rng->GetValues (&values[0], batch);
+      for (uint32_t j = 0; j < batch; j++)
+        {
+          g_sum += values[j];
+        }
+    }
+  Print (name + "-batch", time.End (), count);
+}
+
+} // unnamed namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t count = 20000000;
+  uint32_t batch = 256;
+
+  CommandLine cmd;
+  cmd.AddValue ("count", "number of values per measurement", count);
+  cmd.AddValue ("batch", "number of values per GetValues call", batch);
+  cmd.Parse (argc, argv);
+
+  Run ("uniform", CreateObject<UniformRandomVariable> (), count, batch);
+  Run ("exponential", CreateObject<ExponentialRandomVariable> (), count, batch);
+  Run ("normal", CreateObject<NormalRandomVariable> (), count, batch);
+  std::cout << "checksum=" << g_sum << std::endl;
+
+  return 0;
+}
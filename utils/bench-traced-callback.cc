@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Measure the cost of firing a TracedCallback with no, one or two
+ * sinks, and of skipping a costly argument with IsEmpty().
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+namespace {
+
+/** Sink which keeps the compiler from discarding the calls. */
+uint64_t g_sum = 0;
+
+/**
+ * A trace sink.
+ * \param [in] ptr The traced object.
+ * \param [in] value The traced value.
+ */
+void
+Sink (Ptr<Object> ptr, uint32_t value)
+{
+  g_sum += value;
+}
+
+/** A trace source, as found in a model. */
+class BenchSource : public Object
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("BenchSource")
+      .SetParent<Object> ()
+      .SetGroupName ("Core")
+      .AddConstructor<BenchSource> ()
+    ;
+    return tid;
+  }
+  /** The trace. */
+  TracedCallback<Ptr<Object>, uint32_t> m_trace;
+};
+
+/**
+ * Print a measurement.
+ *
+ * \param [in] name The label to print.
+ * \param [in] ms The elapsed time.
+ * \param [in] count The number of calls.
+ */
+void
+Print (const std::string &name, uint64_t ms, uint32_t count)
+{
+  double rate = ms ? (count / (ms / 1000.0)) : 0.0;
+  std::cout << std::left << std::setw (12) << name
+            << " ms=" << ms
+            << " calls/s=" << rate
+            << std::endl;
+}
+
+/**
+ * Time \p count trace calls with \p sinks sinks connected.
+ *
+ * \param [in] name The label to print.
+ * \param [in] sinks The number of sinks.
+ * \param [in] count The number of calls.
+ */
+void
+Run (const std::string &name, uint32_t sinks, uint32_t count)
+{
+  Ptr<BenchSource> source = CreateObject<BenchSource> ();
+  for (uint32_t i = 0; i < sinks; i++)
+    {
+      source->m_trace.ConnectWithoutContext (MakeCallback (&Sink));
+    }
+  Ptr<Object> object = source;
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < count; i++)
+    {
+      source->m_trace (object, i);
+    }
+  Print (name, time.End (), count);
+}
+
+/**
+ * Time \p count unconnected trace calls whose argument needs an
+ * aggregate lookup, with and without an IsEmpty() guard.
+ *
+ * \param [in] count The number of calls.
+ */
+void
+RunCostlyArgument (uint32_t count)
+{
+  Ptr<BenchSource> source = CreateObject<BenchSource> ();
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < count; i++)
+    {
+      source->m_trace (source->GetObject<Object> (), i);
+    }
+  Print ("unguarded", time.End (), count);
+
+  time.Start ();
+  for (uint32_t i = 0; i < count; i++)
+    {
+      if (!source->m_trace.IsEmpty ())
+        {
+          source->m_trace (source->GetObject<Object> (), i);
+        }
+    }
+  Print ("guarded", time.End (), count);
+}
+
+} // unnamed namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t count = 100000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("count", "number of calls per measurement", count);
+  cmd.Parse (argc, argv);
+
+  Run ("no-sink", 0, count);
+  Run ("one-sink", 1, count);
+  Run ("two-sinks", 2, count);
+  RunCostlyArgument (count / 10);
+  std::cout << "checksum=" << g_sum << std::endl;
+
+  return 0;
+}